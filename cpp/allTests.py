@@ -33,6 +33,11 @@ tests = [
     ("IceUtil/timer", ["once"]),
     ("IceUtil/sha1", ["once"]),
     ("IceUtil/stacktrace", ["once", "noc++11"]),
+    ("IceDB/growth", ["once", "nowin32", "noc++11"]),
+    ("IceDB/groupCommit", ["once", "nowin32", "noc++11"]),
+    ("IceDB/view", ["once", "nowin32", "noc++11"]),
+    ("IcePatch2/calc", ["once", "nowin32", "noc++11"]),
+    ("IcePatch2/chunks", ["once", "nowin32", "noc++11"]),
     ("Slice/errorDetection", ["once"]),
     ("Slice/keyword", ["once"]),
     ("Slice/structure", ["once"]),
@@ -84,8 +89,10 @@ tests = [
     ("IceBox/configuration", ["core", "noipv6", "novc100", "nomingw", "nomx"]),
     ("IceBox/admin", ["core", "noipv6", "novc100", "nomingw", "nomx", "noc++11"]),
     ("IceStorm/single", ["service", "novc100", "noappverifier", "nomingw", "noc++11"]), # This test doesn't work with appverifier
+    ("IceStorm/qos", ["service", "novc100", "nomingw", "noc++11"]),
     ("IceStorm/federation", ["service", "novc100", "nomingw", "noc++11"]),
     ("IceStorm/federation2", ["service", "novc100", "nomingw", "noc++11"]),
+    ("IceStorm/shards", ["service", "novc100", "nomingw", "nowin32", "noc++11"]),
     ("IceStorm/stress", ["service", "stress", "novc100", "nomingw", "noc++11"]), # Too slow with appverifier.
     ("IceStorm/rep1", ["service", "novc100", "nomingw", "noc++11"]),
     ("IceStorm/repgrid", ["service", "novc100", "nomingw", "noc++11"]),
@@ -106,6 +113,7 @@ tests = [
     ("Glacier2/router", ["service", "novc100", "nomingw", "noc++11"]),
     ("Glacier2/attack", ["service", "novc100", "nomingw", "nomx", "noc++11"]),
     ("Glacier2/override", ["service", "novc100", "nomingw", "noc++11"]),
+    ("Glacier2/rateLimit", ["service", "novc100", "nomingw", "nowin32", "noc++11"]),
     ("Glacier2/sessionControl", ["service", "novc100", "nomingw", "noc++11"]),
     ("Glacier2/ssl", ["service", "novalgrind", "novc100", "nomingw", "noc++11"]), # valgrind doesn't work well with openssl
     ("Glacier2/dynamicFiltering", ["service", "novc100", "nomingw", "noc++11"]),
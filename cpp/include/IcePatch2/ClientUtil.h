@@ -131,6 +131,10 @@ public:
     // - IcePatch2.Thorough
     // - IcePatch2.ChunkSize
     // - IcePatch2.Remove
+    // - IcePatch2Client.Chunks
+    // - IcePatch2Client.MaxInFlight
+    // - IcePatch2Client.Parallelism
+    // - IcePatch2Client.Zstd
     //
     // See the Ice manual for more information on these properties.
     //
@@ -27,6 +27,12 @@ const string serverTraceRequest = "Glacier2.Server.Trace.Request";
 const string clientTraceRequest = "Glacier2.Client.Trace.Request";
 const string serverTraceOverride = "Glacier2.Server.Trace.Override";
 const string clientTraceOverride = "Glacier2.Client.Trace.Override";
+const string serverRateLimit = "Glacier2.Server.RateLimit";
+const string clientRateLimit = "Glacier2.Client.RateLimit";
+const string serverRateLimitBurst = "Glacier2.Server.RateLimit.Burst";
+const string clientRateLimitBurst = "Glacier2.Client.RateLimit.Burst";
+const string serverQuantum = "Glacier2.Server.FairQueue.Quantum";
+const string clientQuantum = "Glacier2.Client.FairQueue.Quantum";
 
 }
 
@@ -52,7 +58,12 @@ Glacier2::Blobject::Blobject(const InstancePtr& instance, const ConnectionPtr& r
                                                    _instance->clientRequestQueueThread();
     if(t)
     {
-        const_cast<RequestQueuePtr&>(_requestQueue) = new RequestQueue(t, _instance, _reverseConnection);
+        Ice::PropertiesPtr properties = _instance->properties();
+        int rateLimit = properties->getPropertyAsInt(_reverseConnection ? serverRateLimit : clientRateLimit);
+        int burst = properties->getPropertyAsInt(_reverseConnection ? serverRateLimitBurst : clientRateLimitBurst);
+        int quantum = properties->getPropertyAsInt(_reverseConnection ? serverQuantum : clientQuantum);
+        const_cast<RequestQueuePtr&>(_requestQueue) = new RequestQueue(t, _instance, _reverseConnection, rateLimit,
+                                                                       burst, quantum);
     }
 }
 
@@ -172,6 +172,19 @@ SessionObserverI::overridden(bool client)
     }
 }
 
+void
+SessionObserverI::throttled(bool client)
+{
+    if(client)
+    {
+        forEach(inc(&SessionMetrics::throttledClient));
+    }
+    else
+    {
+        forEach(inc(&SessionMetrics::throttledServer));
+    }
+}
+
 void
 SessionObserverI::routingTableSize(int delta)
 {
@@ -26,6 +26,7 @@ public:
     virtual void forwarded(bool);
     virtual void queued(bool);
     virtual void overridden(bool);
+    virtual void throttled(bool);
     virtual void routingTableSize(int);
 };
 
@@ -189,15 +189,56 @@ Glacier2::Request::queued()
     }
 }
 
+Glacier2::TokenBucket::TokenBucket(int rate, int burst) :
+    _rate(rate > 0 ? rate : 0),
+    _burst(burst > 0 ? burst : (rate > 0 ? rate : 1)),
+    _tokens(_burst),
+    _last(IceUtil::Time::now(IceUtil::Time::Monotonic))
+{
+}
+
+size_t
+Glacier2::TokenBucket::refill(const IceUtil::Time& now)
+{
+    assert(enabled());
+    if(now > _last)
+    {
+        _tokens = min(_burst, _tokens + (now - _last).toSecondsDouble() * _rate);
+        _last = now;
+    }
+    return static_cast<size_t>(_tokens);
+}
+
+void
+Glacier2::TokenBucket::consume(size_t count)
+{
+    _tokens = max(0.0, _tokens - static_cast<double>(count));
+}
+
+IceUtil::Time
+Glacier2::TokenBucket::nextToken() const
+{
+    if(_tokens >= 1.0)
+    {
+        return IceUtil::Time();
+    }
+    return IceUtil::Time::microSeconds(static_cast<IceUtil::Int64>((1.0 - _tokens) / _rate * 1000000.0) + 1);
+}
+
 Glacier2::RequestQueue::RequestQueue(const RequestQueueThreadPtr& requestQueueThread,
                                      const InstancePtr& instance,
-                                     const Ice::ConnectionPtr& connection) :
+                                     const Ice::ConnectionPtr& connection,
+                                     int rateLimit,
+                                     int rateLimitBurst,
+                                     int quantum) :
     _requestQueueThread(requestQueueThread),
     _instance(instance),
     _connection(connection),
     _callback(newCallback_Object_ice_invoke(this, &RequestQueue::response, &RequestQueue::exception,
                                             &RequestQueue::sent)),
     _flushCallback(newCallback_Connection_flushBatchRequests(this, &RequestQueue::exception, &RequestQueue::sent)),
+    _quantum(quantum > 0 ? static_cast<size_t>(quantum) : 0),
+    _tokenBucket(rateLimit, rateLimitBurst),
     _pendingSend(false),
     _destroyed(false)
 {
@@ -259,7 +300,7 @@ Glacier2::RequestQueue::addRequest(const RequestPtr& request)
 }
 
 void
-Glacier2::RequestQueue::flushRequests()
+Glacier2::RequestQueue::flushRequests(bool throttle)
 {
     IceUtil::Mutex::Lock lock(*this);
     if(_connection)
@@ -268,33 +309,55 @@ Glacier2::RequestQueue::flushRequests()
         {
             return;
         }
-        flush();
+        flush(throttle);
     }
     else
     {
-        for(deque<RequestPtr>::const_iterator p = _requests.begin(); p != _requests.end(); ++p)
+        while(true)
         {
-            try
+            deque<RequestPtr>::iterator end = _requests.begin() + available(throttle);
+            for(deque<RequestPtr>::const_iterator p = _requests.begin(); p != end; ++p)
             {
-                if(_observer)
+                try
                 {
-                    _observer->forwarded(!_connection);
+                    if(_observer)
+                    {
+                        _observer->forwarded(!_connection);
+                    }
+                    assert(_callback);
+                    (*p)->invoke(_callback);
+                }
+                catch(const Ice::LocalException&)
+                {
+                    // Ignore, this can occur for batch requests.
                 }
-                assert(_callback);
-                (*p)->invoke(_callback);
             }
-            catch(const Ice::LocalException&)
+            if(_tokenBucket.enabled())
             {
-                // Ignore, this can occur for batch requests.
+                _tokenBucket.consume(static_cast<size_t>(end - _requests.begin()));
             }
-        }
-        _requests.clear();
+            _requests.erase(_requests.begin(), end);
 
-        for(set<Ice::ObjectPrx>::const_iterator q = _batchProxies.begin(); q != _batchProxies.end(); ++q)
-        {
-            (*q)->begin_ice_flushBatchRequests();
+            for(set<Ice::ObjectPrx>::const_iterator q = _batchProxies.begin(); q != _batchProxies.end(); ++q)
+            {
+                (*q)->begin_ice_flushBatchRequests();
+            }
+
+            //
+            // Remaining requests might still be queued on the batch
+            // proxies, we only clear them once the queue is empty.
+            //
+            if(_requests.empty())
+            {
+                _batchProxies.clear();
+                break;
+            }
+            else if(reschedule())
+            {
+                break;
+            }
+            throttle = false;
         }
-        _batchProxies.clear();
     }
 
     if(_destroyed && _requests.empty())
@@ -328,15 +391,16 @@ Glacier2::RequestQueue::updateObserver(const Glacier2::Instrumentation::SessionO
 }
 
 void
-Glacier2::RequestQueue::flush()
+Glacier2::RequestQueue::flush(bool throttle)
 {
     assert(_connection);
     _pendingSend = false;
     _pendingSendRequest = 0;
 
     bool flushBatchRequests = false;
+    deque<RequestPtr>::iterator end = _requests.begin() + available(throttle);
     deque<RequestPtr>::iterator p;
-    for(p = _requests.begin(); p != _requests.end(); ++p)
+    for(p = _requests.begin(); p != end; ++p)
     {
         try
         {
@@ -363,6 +427,11 @@ Glacier2::RequestQueue::flush()
         }
     }
 
+    if(_tokenBucket.enabled())
+    {
+        _tokenBucket.consume(static_cast<size_t>(p - _requests.begin()));
+    }
+
     if(p == _requests.end())
     {
         _requests.clear();
@@ -381,6 +450,61 @@ Glacier2::RequestQueue::flush()
             _pendingSendRequest = 0;
         }
     }
+
+    //
+    // If requests are left because of the fair queuing quantum or the
+    // rate limit and there's no pending send to trigger the next flush,
+    // give the queue back to the request queue thread.
+    //
+    if(!_pendingSend && !_requests.empty() && !reschedule())
+    {
+        flush(false);
+    }
+}
+
+size_t
+Glacier2::RequestQueue::available(bool throttle)
+{
+    //
+    // Must be called with the mutex locked.
+    //
+    size_t count = _requests.size();
+    if(throttle)
+    {
+        if(_quantum > 0)
+        {
+            count = min(count, _quantum);
+        }
+        if(_tokenBucket.enabled())
+        {
+            count = min(count, _tokenBucket.refill(IceUtil::Time::now(IceUtil::Time::Monotonic)));
+        }
+    }
+    return count;
+}
+
+bool
+Glacier2::RequestQueue::reschedule()
+{
+    //
+    // Must be called with the mutex locked.
+    //
+    IceUtil::Time delay;
+    if(_tokenBucket.enabled())
+    {
+        delay = _tokenBucket.nextToken();
+        if(delay > IceUtil::Time() && _observer)
+        {
+            _observer->throttled(!_connection);
+        }
+    }
+
+    //
+    // This returns false if the request queue thread is being
+    // destroyed, in which case the remaining requests are sent right
+    // away.
+    //
+    return _requestQueueThread->requeue(this, delay);
 }
 
 void
@@ -428,7 +552,7 @@ Glacier2::RequestQueue::exception(const Ice::Exception& ex, const RequestPtr& re
         IceUtil::Mutex::Lock lock(*this);
         if(request == _pendingSendRequest)
         {
-            flush();
+            flush(true);
         }
     }
 
@@ -446,7 +570,7 @@ Glacier2::RequestQueue::sent(bool sentSynchronously, const RequestPtr& request)
         IceUtil::Mutex::Lock lock(*this);
         if(request == _pendingSendRequest)
         {
-            flush();
+            flush(true);
         }
     }
 }
@@ -463,6 +587,7 @@ Glacier2::RequestQueueThread::~RequestQueueThread()
 {
     assert(_destroy);
     assert(_queues.empty());
+    assert(_delayed.empty());
 }
 
 void
@@ -474,6 +599,15 @@ Glacier2::RequestQueueThread::destroy()
         assert(!_destroy);
         _destroy = true;
         _sleep = false;
+
+        //
+        // Flush the queues delayed by their rate limit right away.
+        //
+        for(multimap<IceUtil::Time, RequestQueuePtr>::const_iterator p = _delayed.begin(); p != _delayed.end(); ++p)
+        {
+            _queues.push_back(p->second);
+        }
+        _delayed.clear();
         notify();
     }
 
@@ -503,12 +637,42 @@ Glacier2::RequestQueueThread::flushRequestQueue(const RequestQueuePtr& queue)
     _queues.push_back(queue);
 }
 
+bool
+Glacier2::RequestQueueThread::requeue(const RequestQueuePtr& queue, const IceUtil::Time& delay)
+{
+    IceUtil::Monitor<IceUtil::Mutex>::Lock lock(*this);
+    if(_destroy)
+    {
+        return false;
+    }
+
+    if(delay > IceUtil::Time())
+    {
+        _delayed.insert(make_pair(IceUtil::Time::now(IceUtil::Time::Monotonic) + delay, queue));
+        notify(); // Wake up the thread to recompute its timeout.
+    }
+    else
+    {
+        //
+        // The queue is added at the end of the list of queues to flush,
+        // after the queues of other sessions which are waiting.
+        //
+        if(_queues.empty() && !_sleep)
+        {
+            notify();
+        }
+        _queues.push_back(queue);
+    }
+    return true;
+}
+
 void
 Glacier2::RequestQueueThread::run()
 {
     while(true)
     {
         vector<RequestQueuePtr> queues;
+        bool destroy;
 
         {
             IceUtil::Monitor<IceUtil::Mutex>::Lock lock(*this);
@@ -521,21 +685,43 @@ Glacier2::RequestQueueThread::run()
             //
             while(!_destroy && (_queues.empty() || _sleep))
             {
-                if(_sleep)
+                IceUtil::Time now = IceUtil::Time::now(IceUtil::Time::Monotonic);
+
+                //
+                // Queues delayed by their rate limit are flushed again
+                // once their delay expired.
+                //
+                while(!_delayed.empty() && _delayed.begin()->first <= now)
                 {
-                    IceUtil::Time now = IceUtil::Time::now(IceUtil::Time::Monotonic);
-                    if(!timedWait(_sleepDuration))
-                    {
-                        _sleepDuration = IceUtil::Time();
-                    }
-                    else
+                    _queues.push_back(_delayed.begin()->second);
+                    _delayed.erase(_delayed.begin());
+                }
+
+                if(!_queues.empty() && !_sleep)
+                {
+                    break;
+                }
+
+                IceUtil::Time timeout = _sleep ? _sleepDuration : IceUtil::Time();
+                if(!_delayed.empty())
+                {
+                    IceUtil::Time delay = _delayed.begin()->first - now;
+                    if(timeout == IceUtil::Time() || delay < timeout)
                     {
-                        _sleepDuration -= IceUtil::Time::now(IceUtil::Time::Monotonic) - now;
+                        timeout = delay;
                     }
+                }
 
-                    if(_sleepDuration <= IceUtil::Time())
+                if(timeout > IceUtil::Time())
+                {
+                    timedWait(timeout);
+                    if(_sleep)
                     {
-                        _sleep = false;
+                        _sleepDuration -= IceUtil::Time::now(IceUtil::Time::Monotonic) - now;
+                        if(_sleepDuration <= IceUtil::Time())
+                        {
+                            _sleep = false;
+                        }
                     }
                 }
                 else
@@ -556,6 +742,7 @@ Glacier2::RequestQueueThread::run()
             assert(!_queues.empty() && !_sleep);
 
             queues.swap(_queues);
+            destroy = _destroy;
 
             if(_sleepTime > IceUtil::Time())
             {
@@ -566,7 +753,7 @@ Glacier2::RequestQueueThread::run()
 
         for(vector<RequestQueuePtr>::const_iterator p = queues.begin(); p != queues.end(); ++p)
         {
-            (*p)->flushRequests();
+            (*p)->flushRequests(!destroy);
         }
     }
 }
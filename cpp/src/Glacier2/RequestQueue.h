@@ -17,6 +17,7 @@
 #include <Glacier2/Instrumentation.h>
 
 #include <deque>
+#include <map>
 
 namespace Glacier2
 {
@@ -58,14 +59,39 @@ private:
     const Ice::AMD_Object_ice_invokePtr _amdCB;
 };
 
+//
+// Token bucket used to limit the rate at which the requests of a
+// session are forwarded. The bucket isn't thread safe, it's protected
+// by the mutex of the request queue which owns it.
+//
+class TokenBucket
+{
+public:
+
+    TokenBucket(int, int);
+
+    bool enabled() const { return _rate > 0; }
+
+    size_t refill(const IceUtil::Time&);
+    void consume(size_t);
+    IceUtil::Time nextToken() const;
+
+private:
+
+    const double _rate;
+    const double _burst;
+    double _tokens;
+    IceUtil::Time _last;
+};
+
 class RequestQueue : public IceUtil::Mutex, public IceUtil::Shared
 {
 public:
 
-    RequestQueue(const RequestQueueThreadPtr&, const InstancePtr&, const Ice::ConnectionPtr&);
+    RequestQueue(const RequestQueueThreadPtr&, const InstancePtr&, const Ice::ConnectionPtr&, int, int, int);
 
     bool addRequest(const RequestPtr&);
-    void flushRequests();
+    void flushRequests(bool);
 
     void destroy();
 
@@ -75,7 +101,9 @@ private:
 
     void destroyInternal();
 
-    void flush();
+    void flush(bool);
+    size_t available(bool);
+    bool reschedule();
 
     void response(bool, const std::pair<const Ice::Byte*, const Ice::Byte*>&, const RequestPtr&);
     void exception(const Ice::Exception&, const RequestPtr&);
@@ -86,7 +114,9 @@ private:
     const Ice::ConnectionPtr _connection;
     const Ice::Callback_Object_ice_invokePtr _callback;
     const Ice::Callback_Connection_flushBatchRequestsPtr _flushCallback;
+    const size_t _quantum;
 
+    TokenBucket _tokenBucket;
     std::deque<RequestPtr> _requests;
     std::set<Ice::ObjectPrx> _batchProxies;
     bool _pendingSend;
@@ -105,6 +135,7 @@ public:
     virtual ~RequestQueueThread();
 
     void flushRequestQueue(const RequestQueuePtr&);
+    bool requeue(const RequestQueuePtr&, const IceUtil::Time&);
     void destroy();
 
     virtual void run();
@@ -116,6 +147,7 @@ private:
     bool _sleep;
     IceUtil::Time _sleepDuration;
     std::vector<RequestQueuePtr> _queues;
+    std::multimap<IceUtil::Time, RequestQueuePtr> _delayed;
 };
 
 }
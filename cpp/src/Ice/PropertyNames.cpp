@@ -608,6 +608,7 @@ const IceInternal::Property IceGridPropsData[] =
     IceInternal::Property("IceGrid.Node.CollocateRegistry", false, 0),
     IceInternal::Property("IceGrid.Node.Data", false, 0),
     IceInternal::Property("IceGrid.Node.DisableOnFailure", false, 0),
+    IceInternal::Property("IceGrid.Node.LoadUpdatePeriod", false, 0),
     IceInternal::Property("IceGrid.Node.Name", false, 0),
     IceInternal::Property("IceGrid.Node.Output", false, 0),
     IceInternal::Property("IceGrid.Node.ProcessorSocketCount", false, 0),
@@ -729,6 +730,7 @@ const IceInternal::Property IceGridPropsData[] =
     IceInternal::Property("IceGrid.Registry.Client.MessageSizeMax", false, 0),
     IceInternal::Property("IceGrid.Registry.CryptPasswords", false, 0),
     IceInternal::Property("IceGrid.Registry.DefaultTemplates", false, 0),
+    IceInternal::Property("IceGrid.Registry.DeploymentParallelism", false, 0),
     IceInternal::Property("IceGrid.Registry.Discovery.ACM.Timeout", false, 0),
     IceInternal::Property("IceGrid.Registry.Discovery.ACM.Heartbeat", false, 0),
     IceInternal::Property("IceGrid.Registry.Discovery.ACM.Close", false, 0),
@@ -808,8 +810,14 @@ const IceInternal::Property IceGridPropsData[] =
     IceInternal::Property("IceGrid.Registry.Internal.ThreadPool.ThreadIdleTime", false, 0),
     IceInternal::Property("IceGrid.Registry.Internal.ThreadPool.ThreadPriority", false, 0),
     IceInternal::Property("IceGrid.Registry.Internal.MessageSizeMax", false, 0),
+    IceInternal::Property("IceGrid.Registry.LMDB.GroupCommitDelay", false, 0),
+    IceInternal::Property("IceGrid.Registry.LMDB.GroupCommitSize", false, 0),
     IceInternal::Property("IceGrid.Registry.LMDB.MapSize", false, 0),
+    IceInternal::Property("IceGrid.Registry.LMDB.MapSizeMax", false, 0),
     IceInternal::Property("IceGrid.Registry.LMDB.Path", false, 0),
+    IceInternal::Property("IceGrid.Registry.LoadInfoTimeout", false, 0),
+    IceInternal::Property("IceGrid.Registry.LocatorCacheSize", false, 0),
+    IceInternal::Property("IceGrid.Registry.NodeObserverBatchDelay", false, 0),
     IceInternal::Property("IceGrid.Registry.NodeSessionTimeout", false, 0),
     IceInternal::Property("IceGrid.Registry.PermissionsVerifier.EndpointSelection", false, 0),
     IceInternal::Property("IceGrid.Registry.PermissionsVerifier.ConnectionCached", false, 0),
@@ -911,6 +919,7 @@ const IceInternal::Property IceGridPropsData[] =
     IceInternal::Property("IceGrid.Registry.SSLPermissionsVerifier.CollocationOptimized", false, 0),
     IceInternal::Property("IceGrid.Registry.SSLPermissionsVerifier.Context.*", false, 0),
     IceInternal::Property("IceGrid.Registry.SSLPermissionsVerifier", false, 0),
+    IceInternal::Property("IceGrid.Registry.StandbyReplicas", false, 0),
     IceInternal::Property("IceGrid.Registry.Trace.Application", false, 0),
     IceInternal::Property("IceGrid.Registry.Trace.Adapter", false, 0),
     IceInternal::Property("IceGrid.Registry.Trace.Locator", false, 0),
@@ -970,6 +979,7 @@ const IceInternal::Property IcePatch2PropsData[] =
     IceInternal::Property("IcePatch2.ThreadPool.ThreadPriority", false, 0),
     IceInternal::Property("IcePatch2.MessageSizeMax", false, 0),
     IceInternal::Property("IcePatch2.Directory", false, 0),
+    IceInternal::Property("IcePatch2.FileCacheSize", false, 0),
     IceInternal::Property("IcePatch2.InstanceName", false, 0),
 };
 
@@ -979,11 +989,15 @@ const IceInternal::PropertyArray
 
 const IceInternal::Property IcePatch2ClientPropsData[] = 
 {
+    IceInternal::Property("IcePatch2Client.Chunks", false, 0),
     IceInternal::Property("IcePatch2Client.ChunkSize", false, 0),
     IceInternal::Property("IcePatch2Client.Directory", false, 0),
+    IceInternal::Property("IcePatch2Client.MaxInFlight", false, 0),
+    IceInternal::Property("IcePatch2Client.Parallelism", false, 0),
     IceInternal::Property("IcePatch2Client.Proxy", false, 0),
     IceInternal::Property("IcePatch2Client.Remove", false, 0),
     IceInternal::Property("IcePatch2Client.Thorough", false, 0),
+    IceInternal::Property("IcePatch2Client.Zstd", false, 0),
 };
 
 const IceInternal::PropertyArray
@@ -1103,7 +1117,10 @@ const IceInternal::Property Glacier2PropsData[] =
     IceInternal::Property("Glacier2.Client.MessageSizeMax", false, 0),
     IceInternal::Property("Glacier2.Client.AlwaysBatch", false, 0),
     IceInternal::Property("Glacier2.Client.Buffered", false, 0),
+    IceInternal::Property("Glacier2.Client.FairQueue.Quantum", false, 0),
     IceInternal::Property("Glacier2.Client.ForwardContext", false, 0),
+    IceInternal::Property("Glacier2.Client.RateLimit", false, 0),
+    IceInternal::Property("Glacier2.Client.RateLimit.Burst", false, 0),
     IceInternal::Property("Glacier2.Client.SleepTime", false, 0),
     IceInternal::Property("Glacier2.Client.Trace.Override", false, 0),
     IceInternal::Property("Glacier2.Client.Trace.Reject", false, 0),
@@ -1178,7 +1195,10 @@ const IceInternal::Property Glacier2PropsData[] =
     IceInternal::Property("Glacier2.Server.MessageSizeMax", false, 0),
     IceInternal::Property("Glacier2.Server.AlwaysBatch", false, 0),
     IceInternal::Property("Glacier2.Server.Buffered", false, 0),
+    IceInternal::Property("Glacier2.Server.FairQueue.Quantum", false, 0),
     IceInternal::Property("Glacier2.Server.ForwardContext", false, 0),
+    IceInternal::Property("Glacier2.Server.RateLimit", false, 0),
+    IceInternal::Property("Glacier2.Server.RateLimit.Burst", false, 0),
     IceInternal::Property("Glacier2.Server.SleepTime", false, 0),
     IceInternal::Property("Glacier2.Server.Trace.Override", false, 0),
     IceInternal::Property("Glacier2.Server.Trace.Request", false, 0),
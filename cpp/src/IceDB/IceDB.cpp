@@ -9,9 +9,13 @@
 
 #include <IceDB/IceDB.h>
 #include <Ice/Initialize.h>
+#include <Ice/LocalException.h>
 
 #include <lmdb.h>
 
+#include <algorithm>
+#include <cstring>
+
 using namespace IceDB;
 using namespace std;
 
@@ -144,8 +148,40 @@ BadEnvException::ice_throw() const
     throw *this;
 }
 
+namespace
+{
+
+//
+// The maximum time a new transaction waits for the growth of the map.
+//
+const IceUtil::Time growthWait = IceUtil::Time::milliSeconds(100);
+
+size_t
+roundToPageSize(size_t size)
+{
+    size_t pageSize;
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    pageSize = si.dwPageSize;
+#else
+    pageSize = sysconf(_SC_PAGESIZE);
+#endif
+    size_t remainder = size % pageSize;
+    if(remainder != 0)
+    {
+        size = size + pageSize - remainder;
+    }
+    return size;
+}
+
+}
 
-Env::Env(const string& path, MDB_dbi maxDbs, size_t mapSize, unsigned int maxReaders)
+Env::Env(const string& path, MDB_dbi maxDbs, size_t mapSize, unsigned int maxReaders, size_t maxMapSize) :
+    _maxMapSize(roundToPageSize(maxMapSize)),
+    _txns(0),
+    _grow(false),
+    _full(false)
 {
     int rc = mdb_env_create(&_menv);
     if(rc != MDB_SUCCESS)
@@ -165,20 +201,7 @@ Env::Env(const string& path, MDB_dbi maxDbs, size_t mapSize, unsigned int maxRea
     if(mapSize != 0)
     {
         // Make sure the map size is a multiple of the page size
-        size_t pageSize;
-#ifdef _WIN32
-        SYSTEM_INFO si;
-        GetSystemInfo(&si);
-        pageSize = si.dwPageSize;
-#else
-        pageSize = sysconf(_SC_PAGESIZE);
-#endif
-        size_t remainder = mapSize % pageSize;
-        if(remainder != 0)
-        {
-            mapSize = mapSize + pageSize - remainder;
-        }
-        rc = mdb_env_set_mapsize(_menv, mapSize);
+        rc = mdb_env_set_mapsize(_menv, roundToPageSize(mapSize));
         if(rc != MDB_SUCCESS)
         {
             throw LMDBException(__FILE__, __LINE__, rc);
@@ -222,17 +245,166 @@ Env::close()
     }
 }
 
+void
+Env::copy(const string& path, bool compact) const
+{
+    //
+    // The copy uses a read-only transaction, the map must not be
+    // resized until it completes.
+    //
+    beginTxn(false);
+    const int rc = mdb_env_copy2(_menv, path.c_str(), compact ? MDB_CP_COMPACT : 0);
+    endTxn();
+    if(rc != MDB_SUCCESS)
+    {
+        throw LMDBException(__FILE__, __LINE__, rc);
+    }
+}
+
+void
+Env::requestGrowth(bool full) const
+{
+    IceUtil::Monitor<IceUtil::Mutex>::Lock sync(_monitor);
+    _grow = true;
+    _full = _full || full;
+}
+
 MDB_env*
 Env::menv() const
 {
     return _menv;
 }
 
-Txn::Txn(const Env& env, unsigned int flags)
+void
+Env::beginTxn(bool write) const
+{
+    IceUtil::Monitor<IceUtil::Mutex>::Lock sync(_monitor);
+    if(write && !_grow && needsGrowth())
+    {
+        _grow = true;
+    }
+
+    if(_grow)
+    {
+        if(_txns == 0)
+        {
+            grow();
+        }
+        else
+        {
+            //
+            // Wait for the active transactions to complete, the last one
+            // grows the map. The wait is bounded since the calling thread
+            // might itself hold one of these transactions.
+            //
+            const IceUtil::Time timeout = IceUtil::Time::now(IceUtil::Time::Monotonic) + growthWait;
+            while(_grow)
+            {
+                IceUtil::Time delay = timeout - IceUtil::Time::now(IceUtil::Time::Monotonic);
+                if(delay <= IceUtil::Time())
+                {
+                    break;
+                }
+                _monitor.timedWait(delay);
+            }
+
+            //
+            // A write transaction can't succeed until the full map is
+            // grown, it fails rather than proceeding. Other transactions
+            // proceed, the map grows once they complete.
+            //
+            if(_grow && _full && write)
+            {
+                throw LMDBException(__FILE__, __LINE__, MDB_MAP_FULL);
+            }
+        }
+    }
+    ++_txns;
+}
+
+void
+Env::endTxn() const
+{
+    IceUtil::Monitor<IceUtil::Mutex>::Lock sync(_monitor);
+    assert(_txns > 0);
+    if(--_txns == 0 && _grow)
+    {
+        grow();
+    }
+}
+
+bool
+Env::needsGrowth() const
 {
-    const int rc = mdb_txn_begin(env.menv(), 0, flags, &_mtxn);
+    MDB_envinfo info;
+    MDB_stat stat;
+    if(mdb_env_info(_menv, &info) != MDB_SUCCESS || mdb_env_stat(_menv, &stat) != MDB_SUCCESS)
+    {
+        return false;
+    }
+
+    if(_maxMapSize != 0 && info.me_mapsize >= _maxMapSize)
+    {
+        return false;
+    }
+
+    const size_t used = (info.me_last_pgno + 1) * stat.ms_psize;
+    return used > info.me_mapsize / 5 * 4;
+}
+
+void
+Env::grow() const
+{
+    //
+    // Called with the monitor locked and no active transactions. Errors
+    // are ignored, the growth is requested again if the map is full.
+    //
+    // First adopt the map size set by other processes using the
+    // environment, if any.
+    //
+    mdb_env_set_mapsize(_menv, 0);
+
+    // A full map is grown regardless of its usage.
+    MDB_envinfo info;
+    if((_full || needsGrowth()) && mdb_env_info(_menv, &info) == MDB_SUCCESS)
+    {
+        size_t mapSize = info.me_mapsize * 2;
+        if(_maxMapSize != 0 && mapSize > _maxMapSize)
+        {
+            mapSize = _maxMapSize;
+        }
+        if(mapSize > info.me_mapsize)
+        {
+            mdb_env_set_mapsize(_menv, mapSize);
+        }
+    }
+
+    _grow = false;
+    _full = false;
+    _monitor.notifyAll();
+}
+
+Txn::Txn(const Env& env, unsigned int flags, MDB_txn* parent) :
+    _env(env),
+    _nested(parent != 0)
+{
+    //
+    // Nested transactions are covered by their parent transaction.
+    //
+    if(!_nested)
+    {
+        _env.beginTxn((flags & MDB_RDONLY) == 0);
+    }
+
+    const int rc = mdb_txn_begin(env.menv(), parent, flags, &_mtxn);
     if(rc != MDB_SUCCESS)
     {
+        _mtxn = 0;
+        end();
+        if(rc == MDB_MAP_RESIZED)
+        {
+            _env.requestGrowth(false);
+        }
         throw LMDBException(__FILE__, __LINE__, rc);
     }
 }
@@ -246,9 +418,14 @@ void
 Txn::commit()
 {
     const int rc = mdb_txn_commit(_mtxn);
+    end();
     _mtxn = 0;
     if(rc != MDB_SUCCESS)
     {
+        if(rc == MDB_MAP_FULL)
+        {
+            _env.requestGrowth();
+        }
         throw LMDBException(__FILE__, __LINE__, rc);
     }
 }
@@ -259,6 +436,7 @@ Txn::rollback()
     if(_mtxn != 0)
     {
         mdb_txn_abort(_mtxn);
+        end();
         _mtxn = 0;
     }
 }
@@ -269,6 +447,21 @@ Txn::mtxn() const
     return _mtxn;
 }
 
+const Env&
+Txn::env() const
+{
+    return _env;
+}
+
+void
+Txn::end()
+{
+    if(!_nested)
+    {
+        _env.endTxn();
+    }
+}
+
 ReadOnlyTxn::~ReadOnlyTxn()
 {
     // Out of line to avoid weak vtable
@@ -305,6 +498,195 @@ ReadWriteTxn::ReadWriteTxn(const Env& env) :
 {
 }
 
+ReadWriteTxn::ReadWriteTxn(const Env& env, const ReadWriteTxn& parent) :
+    Txn(env, 0, parent.mtxn())
+{
+}
+
+GroupCommit::Operation::Operation() :
+    _done(false)
+{
+}
+
+GroupCommit::Operation::~Operation()
+{
+    // Out of line to avoid weak vtable
+}
+
+void
+GroupCommit::Operation::failed()
+{
+    //
+    // Called from a catch block.
+    //
+    try
+    {
+        throw;
+    }
+    catch(const IceUtil::Exception& ex)
+    {
+        failed(ex);
+    }
+    catch(const std::exception& ex)
+    {
+        failed(Ice::UnknownException(__FILE__, __LINE__, ex.what()));
+    }
+    catch(...)
+    {
+        failed(Ice::UnknownException(__FILE__, __LINE__, "unknown c++ exception"));
+    }
+}
+
+void
+GroupCommit::Operation::failed(const IceUtil::Exception& ex)
+{
+    if(!_exception.get())
+    {
+        _exception.reset(ex.ice_clone());
+    }
+}
+
+GroupCommit::GroupCommit(const Env& env, const IceUtil::Time& delay, size_t maxSize) :
+    _env(env),
+    _delay(delay),
+    _maxSize(maxSize > 0 ? maxSize : 1),
+    _committing(false)
+{
+}
+
+void
+GroupCommit::submit(const OperationPtr& op)
+{
+    IceUtil::Monitor<IceUtil::Mutex>::Lock sync(_monitor);
+    _pending.push_back(op);
+    if(_pending.size() == _maxSize)
+    {
+        _monitor.notifyAll();
+    }
+}
+
+void
+GroupCommit::waitForCommit(const OperationPtr& op)
+{
+    IceUtil::Monitor<IceUtil::Mutex>::Lock sync(_monitor);
+    while(!op->_done)
+    {
+        //
+        // If another thread is committing or if the operation is part
+        // of the transaction being committed, wait.
+        //
+        if(_committing || _pending.empty())
+        {
+            _monitor.wait();
+            continue;
+        }
+
+        _committing = true;
+        if(_delay > IceUtil::Time())
+        {
+            const IceUtil::Time timeout = IceUtil::Time::now(IceUtil::Time::Monotonic) + _delay;
+            while(_pending.size() < _maxSize)
+            {
+                IceUtil::Time now = IceUtil::Time::now(IceUtil::Time::Monotonic);
+                if(now >= timeout)
+                {
+                    break;
+                }
+                _monitor.timedWait(timeout - now);
+            }
+        }
+
+        vector<OperationPtr> ops;
+        while(!_pending.empty() && ops.size() < _maxSize)
+        {
+            ops.push_back(_pending.front());
+            _pending.pop_front();
+        }
+
+        sync.release();
+        try
+        {
+            commit(ops);
+        }
+        catch(...)
+        {
+            //
+            // Don't leave the other threads waiting forever for their
+            // operations if the commit raised an exception.
+            //
+            sync.acquire();
+            for(vector<OperationPtr>::const_iterator p = ops.begin(); p != ops.end(); ++p)
+            {
+                (*p)->failed();
+            }
+            committed(ops);
+            throw;
+        }
+        sync.acquire();
+        committed(ops);
+    }
+
+    if(op->_exception.get())
+    {
+        op->_exception->ice_throw();
+    }
+}
+
+void
+GroupCommit::committed(const vector<OperationPtr>& ops)
+{
+    //
+    // Called with _monitor locked.
+    //
+    for(vector<OperationPtr>::const_iterator p = ops.begin(); p != ops.end(); ++p)
+    {
+        (*p)->_done = true;
+    }
+    _committing = false;
+    _monitor.notifyAll();
+}
+
+void
+GroupCommit::execute(const OperationPtr& op)
+{
+    submit(op);
+    waitForCommit(op);
+}
+
+void
+GroupCommit::commit(const vector<OperationPtr>& ops)
+{
+    try
+    {
+        ReadWriteTxn txn(_env);
+        for(vector<OperationPtr>::const_iterator p = ops.begin(); p != ops.end(); ++p)
+        {
+            try
+            {
+                ReadWriteTxn nested(_env, txn);
+                (*p)->execute(nested);
+                nested.commit();
+            }
+            catch(...)
+            {
+                (*p)->failed();
+            }
+        }
+        txn.commit();
+    }
+    catch(...)
+    {
+        //
+        // The transaction couldn't be committed, all the operations
+        // failed.
+        //
+        for(vector<OperationPtr>::const_iterator p = ops.begin(); p != ops.end(); ++p)
+        {
+            (*p)->failed();
+        }
+    }
+}
+
 DbiBase::DbiBase(const Txn& txn, const std::string& name, unsigned int flags, MDB_cmp_func* cmp)
 {
     int rc = mdb_dbi_open(txn.mtxn(), name.c_str(), flags, &_mdbi);
@@ -368,6 +750,10 @@ DbiBase::put(const ReadWriteTxn& txn, MDB_val* key, MDB_val* data, unsigned int
     const int rc = mdb_put(txn.mtxn(), _mdbi, key, data, flags);
     if(rc != MDB_SUCCESS)
     {
+        if(rc == MDB_MAP_FULL)
+        {
+            txn.env().requestGrowth();
+        }
         throw LMDBException(__FILE__, __LINE__, rc);
     }
 }
@@ -486,6 +872,89 @@ CursorBase::renew(const ReadOnlyTxn& txn)
     }
 }
 
+Decoder::Decoder(const IceContext& ctx) :
+    _stream(ctx.communicator, ctx.encoding)
+{
+}
+
+Ice::InputStream&
+Decoder::start(const View& view)
+{
+    //
+    // Swap the view in without copying it, the buffer previously
+    // used by the stream doesn't own its memory.
+    //
+    IceInternal::Buffer buffer(view.begin(), view.end());
+    _stream.swapBuffer(buffer);
+    return _stream;
+}
+
+DecoderPool::DecoderPool(const IceContext& ctx) :
+    _ctx(ctx)
+{
+}
+
+DecoderPool::~DecoderPool()
+{
+    for(vector<Decoder*>::const_iterator p = _decoders.begin(); p != _decoders.end(); ++p)
+    {
+        delete *p;
+    }
+}
+
+Decoder*
+DecoderPool::acquire()
+{
+    {
+        IceUtil::Mutex::Lock sync(_mutex);
+        if(!_decoders.empty())
+        {
+            Decoder* decoder = _decoders.back();
+            _decoders.pop_back();
+            return decoder;
+        }
+    }
+    return new Decoder(_ctx);
+}
+
+void
+DecoderPool::release(Decoder* decoder)
+{
+    IceUtil::Mutex::Lock sync(_mutex);
+    _decoders.push_back(decoder);
+}
+
+int
+IceDB::compareStrings(const MDB_val* a, const MDB_val* b)
+{
+    //
+    // Skip the encoded size: one byte, or 255 followed by the size
+    // on four bytes.
+    //
+    const unsigned char* pa = static_cast<const unsigned char*>(a->mv_data);
+    const unsigned char* pb = static_cast<const unsigned char*>(b->mv_data);
+    size_t sa = a->mv_size;
+    size_t sb = b->mv_size;
+    if(sa > 0)
+    {
+        size_t skip = pa[0] == 255 && sa >= 5 ? 5 : 1;
+        pa += skip;
+        sa -= skip;
+    }
+    if(sb > 0)
+    {
+        size_t skip = pb[0] == 255 && sb >= 5 ? 5 : 1;
+        pb += skip;
+        sb -= skip;
+    }
+
+    int rc = memcmp(pa, pb, min(sa, sb));
+    if(rc != 0)
+    {
+        return rc;
+    }
+    return sa < sb ? -1 : (sa > sb ? 1 : 0);
+}
 
 //
 // On Windows, we use a default LMDB map size of 10MB, whereas on other platforms
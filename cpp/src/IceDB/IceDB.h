@@ -12,12 +12,18 @@
 
 #include <IceUtil/Exception.h>
 #include <IceUtil/FileUtil.h>
+#include <IceUtil/Monitor.h>
+#include <IceUtil/Mutex.h>
+#include <IceUtil/UniquePtr.h>
 #include <Ice/Initialize.h>
 #include <Ice/OutputStream.h>
 #include <Ice/InputStream.h>
 
 #include <lmdb.h>
 
+#include <deque>
+#include <vector>
+
 #ifndef ICE_DB_API
 #   if defined(ICE_STATIC_LIBS)
 #       define ICE_DB_API /**/
@@ -148,15 +154,38 @@ private:
 template<typename T, typename C, typename H>
 struct Codec;
 
+//
+// The map of an Env grows automatically: once more than 80% of the
+// map is used, or after a write failed with MDB_MAP_FULL, the map size
+// is doubled as soon as no transactions are active. A write
+// transaction started while a full map can't be grown, because other
+// transactions remain active, fails with MDB_MAP_FULL. The last
+// argument of the constructor is the maximum map size, 0 for no
+// maximum.
+//
 class ICE_DB_API Env
 {
 public:
 
-    explicit Env(const std::string&, MDB_dbi = 0, size_t = 0, unsigned int = 0);
+    explicit Env(const std::string&, MDB_dbi = 0, size_t = 0, unsigned int = 0, size_t = 0);
     ~Env();
 
     void close();
 
+    //
+    // Copy the environment to the given directory, which must exist
+    // and be empty. The environment can be used during the copy. With
+    // compaction, the free pages are omitted from the copy.
+    //
+    void copy(const std::string&, bool = false) const;
+
+    //
+    // Request the growth of the map. The map is grown even if less
+    // than 80% of it is used when full is true, otherwise the growth
+    // only adopts the map size set by other processes.
+    //
+    void requestGrowth(bool = true) const;
+
     MDB_env* menv() const;
 
 private:
@@ -165,7 +194,24 @@ private:
     Env(const Env&);
     void operator=(const Env&);
 
+    friend class Txn;
+
+    void beginTxn(bool) const;
+    void endTxn() const;
+    bool needsGrowth() const;
+    void grow() const;
+
     MDB_env* _menv;
+    size_t _maxMapSize;
+
+    //
+    // The map can only be resized when no transactions are active,
+    // the active transactions are counted to coordinate the growth.
+    //
+    mutable IceUtil::Monitor<IceUtil::Mutex> _monitor;
+    mutable int _txns;
+    mutable bool _grow;
+    mutable bool _full; // The growth was requested because the map is full.
 };
 
 class ICE_DB_API Txn
@@ -178,11 +224,16 @@ public:
     void rollback();
 
     MDB_txn* mtxn() const;
+    const Env& env() const;
 
 protected:
 
-    explicit Txn(const Env&, unsigned int);
+    Txn(const Env&, unsigned int, MDB_txn* = 0);
+
+    void end();
 
+    const Env& _env;
+    const bool _nested;
     MDB_txn* _mtxn;
 
 private:
@@ -211,6 +262,126 @@ public:
     virtual ~ReadWriteTxn();
 
     explicit ReadWriteTxn(const Env&);
+
+    // Nested transaction
+    ReadWriteTxn(const Env&, const ReadWriteTxn&);
+};
+
+//
+// GroupCommit merges the write operations submitted concurrently by
+// several threads into a single read-write transaction, to pay the
+// cost of the commit once for all of them.
+//
+// The first thread waiting for the commit of an operation executes
+// the pending operations of all the threads, each in its own nested
+// transaction, so a failed operation doesn't abort the others. The
+// operations must only use the given transaction.
+//
+class ICE_DB_API GroupCommit : public IceUtil::Shared
+{
+public:
+
+    class ICE_DB_API Operation : public virtual IceUtil::Shared
+    {
+    public:
+
+        Operation();
+        virtual ~Operation();
+
+        virtual void execute(const ReadWriteTxn&) = 0;
+
+    private:
+
+        friend class GroupCommit;
+
+        void failed();
+        void failed(const IceUtil::Exception&);
+
+        bool _done;
+        IceUtil::UniquePtr<IceUtil::Exception> _exception;
+    };
+    typedef IceUtil::Handle<Operation> OperationPtr;
+
+    //
+    // The delay is the time the committing thread waits for other
+    // operations before starting the transaction, unless the maximum
+    // number of operations of a transaction is reached.
+    //
+    GroupCommit(const Env&, const IceUtil::Time&, size_t);
+
+    // Queue the operation for the next transaction.
+    void submit(const OperationPtr&);
+
+    //
+    // Wait for the operation to be committed. Raises the exception
+    // raised by the operation or by the commit if the operation
+    // failed.
+    //
+    void waitForCommit(const OperationPtr&);
+
+    // Submit the operation and wait for its commit.
+    void execute(const OperationPtr&);
+
+private:
+
+    void commit(const std::vector<OperationPtr>&);
+    void committed(const std::vector<OperationPtr>&);
+
+    const Env& _env;
+    const IceUtil::Time _delay;
+    const size_t _maxSize;
+
+    IceUtil::Monitor<IceUtil::Mutex> _monitor;
+    std::deque<OperationPtr> _pending;
+    bool _committing;
+};
+typedef IceUtil::Handle<GroupCommit> GroupCommitPtr;
+
+//
+// A View refers to the data of a record in the memory map of the
+// environment, without copying it. A view is only valid until the end
+// of the transaction used to retrieve it, or until the next update
+// made with this transaction.
+//
+class View
+{
+public:
+
+    View() :
+        _begin(0), _end(0)
+    {
+    }
+
+    explicit View(const MDB_val& val) :
+        _begin(static_cast<const Ice::Byte*>(val.mv_data)),
+        _end(static_cast<const Ice::Byte*>(val.mv_data) + val.mv_size)
+    {
+    }
+
+    const Ice::Byte* begin() const
+    {
+        return _begin;
+    }
+
+    const Ice::Byte* end() const
+    {
+        return _end;
+    }
+
+    size_t size() const
+    {
+        return static_cast<size_t>(_end - _begin);
+    }
+
+    bool empty() const
+    {
+        return _begin == _end;
+    }
+
+private:
+
+    const Ice::Byte* _begin;
+    const Ice::Byte* _end;
 };
 
 class ICE_DB_API DbiBase
@@ -271,6 +442,27 @@ public:
         return false;
     }
 
+    //
+    // Get a view of the data instead of unmarshaling it, see View
+    // for the lifetime of the view.
+    //
+    bool getView(const Txn& txn, const K& key, View& data) const
+    {
+        unsigned char kbuf[maxKeySize];
+        MDB_val mkey = {maxKeySize, kbuf};
+
+        if(Codec<K, C, H>::write(key, mkey, _marshalingContext))
+        {
+            MDB_val mdata;
+            if(DbiBase::get(txn, &mkey, &mdata))
+            {
+                data = View(mdata);
+                return true;
+            }
+        }
+        return false;
+    }
+
     void put(const ReadWriteTxn& txn, const K& key, const D& data, unsigned int flags = 0)
     {
         unsigned char kbuf[maxKeySize];
@@ -410,6 +602,22 @@ public:
         return false;
     }
 
+    //
+    // Same as get but only unmarshals the key, see View for the
+    // lifetime of the data view.
+    //
+    bool getView(K& key, View& data, MDB_cursor_op op)
+    {
+        MDB_val mkey, mdata;
+        if(CursorBase::get(&mkey, &mdata, op))
+        {
+            Codec<K, C, H>::read(key, mkey, _marshalingContext);
+            data = View(mdata);
+            return true;
+        }
+        return false;
+    }
+
     bool find(const K& key)
     {
         unsigned char kbuf[maxKeySize];
@@ -440,6 +648,27 @@ public:
         return false;
     }
 
+    //
+    // Position the cursor on the first key greater or equal to the
+    // given key, and read this key and its data.
+    //
+    bool findRange(K& key, D& data)
+    {
+        unsigned char kbuf[maxKeySize];
+        MDB_val mkey = {maxKeySize, kbuf};
+        if(Codec<K, C, H>::write(key, mkey, _marshalingContext))
+        {
+            MDB_val mdata;
+            if(CursorBase::get(&mkey, &mdata, MDB_SET_RANGE))
+            {
+                Codec<K, C, H>::read(key, mkey, _marshalingContext);
+                Codec<D, C, H>::read(data, mdata, _marshalingContext);
+                return true;
+            }
+        }
+        return false;
+    }
+
 protected:
 
     C _marshalingContext;
@@ -535,6 +764,108 @@ struct Codec<T, IceContext, Ice::OutputStream>
     }
 };
 
+//
+// A Decoder unmarshals views with the Ice encoding. It reuses the
+// same input stream for all the views it decodes: hot read paths
+// should keep a decoder for the duration of a transaction rather than
+// unmarshaling each record with a new stream.
+//
+// start() lets the caller only unmarshal the leading members of a
+// record. Values containing classes must be unmarshaled with Dbi::get
+// or Cursor::get.
+//
+class ICE_DB_API Decoder
+{
+public:
+
+    explicit Decoder(const IceContext&);
+
+    // Returns the stream positioned at the start of the view.
+    Ice::InputStream& start(const View&);
+
+    template<typename T> void decode(const View& view, T& t)
+    {
+        start(view).read(t);
+    }
+
+private:
+
+    // Not implemented: class is not copyable
+    Decoder(const Decoder&);
+    void operator=(const Decoder&);
+
+    Ice::InputStream _stream;
+};
+
+//
+// A pool of decoders shared by the threads reading the same databases.
+// A thread takes a decoder from the pool for the duration of its reads
+// with PooledDecoder, the decoders are created once and reused.
+//
+class ICE_DB_API DecoderPool
+{
+public:
+
+    explicit DecoderPool(const IceContext&);
+    ~DecoderPool();
+
+    Decoder* acquire();
+    void release(Decoder*);
+
+private:
+
+    // Not implemented: class is not copyable
+    DecoderPool(const DecoderPool&);
+    void operator=(const DecoderPool&);
+
+    const IceContext _ctx;
+    IceUtil::Mutex _mutex;
+    std::vector<Decoder*> _decoders;
+};
+
+class PooledDecoder
+{
+public:
+
+    explicit PooledDecoder(DecoderPool& pool) :
+        _pool(pool),
+        _decoder(pool.acquire())
+    {
+    }
+
+    ~PooledDecoder()
+    {
+        _pool.release(_decoder);
+    }
+
+    Decoder& operator*() const
+    {
+        return *_decoder;
+    }
+
+    Decoder* operator->() const
+    {
+        return _decoder;
+    }
+
+private:
+
+    // Not implemented: class is not copyable
+    PooledDecoder(const PooledDecoder&);
+    void operator=(const PooledDecoder&);
+
+    DecoderPool& _pool;
+    Decoder* const _decoder;
+};
+
+//
+// Compares keys holding Ice-encoded strings by their characters
+// rather than by their encoded size first. Databases opened with this
+// comparison keep their string keys sorted, which allows to look up
+// the keys with a given prefix with Cursor::findRange.
+//
+ICE_DB_API int compareStrings(const MDB_val*, const MDB_val*);
+
 //
 // Returns computed mapSize in bytes.
 // When the input parameter is <= 0, returns a platform-dependent default
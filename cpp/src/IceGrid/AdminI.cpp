@@ -649,6 +649,12 @@ AdminI::getAllAdapterIds(const Current&) const
     return _database->getAllAdapters();
 }
 
+StringSeq
+AdminI::getAdapterIdsPage(const string& expression, const string& after, int max, const Current&) const
+{
+    return _database->getAdapterIdsPage(expression, after, max);
+}
+
 void
 AdminI::addObject(const Ice::ObjectPrx& proxy, const ::Ice::Current& current)
 {
@@ -734,6 +740,72 @@ AdminI::removeObject(const Ice::Identity& id, const Ice::Current&)
     _database->removeObject(id);
 }
 
+void
+AdminI::addObjects(const ObjectInfoSeq& infos, const Ice::Current&)
+{
+    checkIsReadOnly();
+
+    for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+    {
+        if(!p->proxy)
+        {
+            throw DeploymentException("proxy is null");
+        }
+
+        const Ice::Identity id = p->proxy->ice_getIdentity();
+        if(id.category == _database->getInstanceName())
+        {
+            DeploymentException ex;
+            ex.reason = "adding object `" + identityToString(id) + "' is not allowed:\n";
+            ex.reason += "objects with identity category `" + id.category + "' are managed by IceGrid";
+            throw ex;
+        }
+    }
+    _database->addObjects(infos);
+}
+
+void
+AdminI::updateObjects(const Ice::ObjectProxySeq& proxies, const Ice::Current&)
+{
+    checkIsReadOnly();
+
+    for(Ice::ObjectProxySeq::const_iterator p = proxies.begin(); p != proxies.end(); ++p)
+    {
+        if(!*p)
+        {
+            throw DeploymentException("proxy is null");
+        }
+
+        const Ice::Identity id = (*p)->ice_getIdentity();
+        if(id.category == _database->getInstanceName())
+        {
+            DeploymentException ex;
+            ex.reason = "updating object `" + identityToString(id) + "' is not allowed:\n";
+            ex.reason += "objects with identity category `" + id.category + "' are managed by IceGrid";
+            throw ex;
+        }
+    }
+    _database->updateObjects(proxies);
+}
+
+void
+AdminI::removeObjects(const Ice::IdentitySeq& ids, const Ice::Current&)
+{
+    checkIsReadOnly();
+
+    for(Ice::IdentitySeq::const_iterator p = ids.begin(); p != ids.end(); ++p)
+    {
+        if(p->category == _database->getInstanceName())
+        {
+            DeploymentException ex;
+            ex.reason = "removing object `" + identityToString(*p) + "' is not allowed:\n";
+            ex.reason += "objects with identity category `" + p->category + "' are managed by IceGrid";
+            throw ex;
+        }
+    }
+    _database->removeObjects(ids);
+}
+
 ObjectInfo
 AdminI::getObjectInfo(const Ice::Identity& id, const Ice::Current&) const
 {
@@ -752,6 +824,12 @@ AdminI::getAllObjectInfos(const string& expression, const Ice::Current&) const
     return _database->getAllObjectInfos(expression);
 }
 
+ObjectInfoSeq
+AdminI::getObjectInfosPage(const string& expression, const string& after, int max, const Ice::Current&) const
+{
+    return _database->getObjectInfosPage(expression, after, max);
+}
+
 NodeInfo
 AdminI::getNodeInfo(const string& name, const Ice::Current&) const
 {
@@ -64,14 +64,19 @@ public:
     virtual AdapterInfoSeq getAdapterInfo(const ::std::string&, const ::Ice::Current&) const;
     virtual void removeAdapter(const std::string&, const Ice::Current&);
     virtual Ice::StringSeq getAllAdapterIds(const ::Ice::Current&) const;
+    virtual Ice::StringSeq getAdapterIdsPage(const std::string&, const std::string&, int, const ::Ice::Current&) const;
 
     virtual void addObject(const ::Ice::ObjectPrx&, const ::Ice::Current&);
     virtual void updateObject(const ::Ice::ObjectPrx&, const ::Ice::Current&);
     virtual void addObjectWithType(const ::Ice::ObjectPrx&, const ::std::string&, const ::Ice::Current&);
     virtual void removeObject(const ::Ice::Identity&, const ::Ice::Current&);
+    virtual void addObjects(const ObjectInfoSeq&, const ::Ice::Current&);
+    virtual void updateObjects(const ::Ice::ObjectProxySeq&, const ::Ice::Current&);
+    virtual void removeObjects(const ::Ice::IdentitySeq&, const ::Ice::Current&);
     virtual ObjectInfo getObjectInfo(const Ice::Identity&, const ::Ice::Current&) const;
     virtual ObjectInfoSeq getObjectInfosByType(const std::string&, const ::Ice::Current&) const;
     virtual ObjectInfoSeq getAllObjectInfos(const std::string&, const ::Ice::Current&) const;
+    virtual ObjectInfoSeq getObjectInfosPage(const std::string&, const std::string&, int, const ::Ice::Current&) const;
 
     virtual NodeInfo getNodeInfo(const std::string&, const Ice::Current&) const;
     virtual Ice::ObjectPrx getNodeAdmin(const std::string&, const Ice::Current&) const;
@@ -74,24 +74,98 @@ private:
     const Ice::Callback_Object_ice_invokePtr _callback;
 };
 
+//
+// The observer called by the file reader with the lines appended to
+// a followed file, the lines are forwarded to the observer of the
+// file iterator.
+//
+class InternalFileObserverI : public InternalFileObserver
+{
+public:
+
+    InternalFileObserverI(const FileIteratorIPtr& iterator) : _iterator(iterator)
+    {
+    }
+
+    virtual void
+    linesAdded_async(const AMD_InternalFileObserver_linesAddedPtr& amdCB,
+                     const Ice::StringSeq& lines,
+                     Ice::Long newPos,
+                     const Ice::Current& current)
+    {
+        _iterator->linesAdded(amdCB, lines, newPos, current);
+    }
+
+private:
+
+    const FileIteratorIPtr _iterator;
+};
+
+class LinesAddedCB : public virtual IceUtil::Shared
+{
+public:
+
+    LinesAddedCB(const FileIteratorIPtr& iterator,
+                 const AMD_InternalFileObserver_linesAddedPtr& amdCB,
+                 const Ice::Identity& id,
+                 Ice::Long pos) :
+        _iterator(iterator), _amdCB(amdCB), _id(id), _pos(pos)
+    {
+    }
+
+    void
+    response()
+    {
+        _amdCB->ice_response(_iterator->linesSent(_id, _pos, true));
+    }
+
+    void
+    exception(const Ice::Exception&)
+    {
+        _amdCB->ice_response(_iterator->linesSent(_id, _pos, false));
+    }
+
+private:
+
+    const FileIteratorIPtr _iterator;
+    const AMD_InternalFileObserver_linesAddedPtr _amdCB;
+    const Ice::Identity _id;
+    const Ice::Long _pos;
+};
+
 }
 
 FileIteratorI::FileIteratorI(const AdminSessionIPtr& session,
+                             const RegistryIPtr& registry,
                              const FileReaderPrx& reader,
                              const string& filename,
                              Ice::Long offset,
-                             int messageSizeMax) :
+                             int messageSizeMax,
+                             int timeout) :
     _session(session),
+    _registry(registry),
     _reader(reader),
     _filename(filename),
     _offset(offset),
-    _messageSizeMax(messageSizeMax - 256) // Room for the header
+    _messageSizeMax(messageSizeMax - 256), // Room for the header
+    _timeout(timeout),
+    _sending(false)
 {
 }
 
 bool
 FileIteratorI::read(int size, Ice::StringSeq& lines, const Ice::Current&)
 {
+    Lock sync(*this);
+    if(_observer)
+    {
+        //
+        // The lines are sent to the observer while the file is followed.
+        //
+        lines = Ice::StringSeq();
+        return true;
+    }
+
     try
     {
         return _reader->read(_filename, _offset, size > _messageSizeMax ? _messageSizeMax : size, _offset, lines);
@@ -105,12 +179,158 @@ FileIteratorI::read(int size, Ice::StringSeq& lines, const Ice::Current&)
     return false; // Keep the compiler happy.
 }
 
+void
+FileIteratorI::follow(const FileObserverPrx& observer, const Ice::Current&)
+{
+    Lock sync(*this);
+    unfollow();
+    if(!observer)
+    {
+        return;
+    }
+
+    //
+    // The internal observer is added to the internal registry adapter
+    // to be reachable from the node. The lines are read by the node
+    // from the current offset of the iterator.
+    //
+    const Ice::ObjectAdapterPtr adapter = _registry->getRegistryAdapter();
+    InternalFileObserverPrx internalObserver =
+        InternalFileObserverPrx::uncheckedCast(adapter->addWithUUID(new InternalFileObserverI(this)));
+    try
+    {
+        _reader->followFile(_filename, _offset, internalObserver);
+    }
+    catch(const FileNotAvailableException&)
+    {
+        adapter->remove(internalObserver->ice_getIdentity());
+        throw;
+    }
+    catch(const Ice::OperationNotExistException&)
+    {
+        adapter->remove(internalObserver->ice_getIdentity());
+        throw FileNotAvailableException("following the file is not supported by this node");
+    }
+    catch(const Ice::LocalException& ex)
+    {
+        adapter->remove(internalObserver->ice_getIdentity());
+        ostringstream os;
+        os << ex;
+        throw FileNotAvailableException(os.str());
+    }
+
+    _observer = observer->ice_timeout(_timeout)->ice_locator(_registry->getLocator());
+    _internalObserver = internalObserver;
+}
+
 void
 FileIteratorI::destroy(const Ice::Current& current)
 {
+    stopFollowing();
     _session->removeFileIterator(current.id, current);
 }
 
+void
+FileIteratorI::linesAdded(const AMD_InternalFileObserver_linesAddedPtr& amdCB,
+                          const Ice::StringSeq& lines,
+                          Ice::Long newPos,
+                          const Ice::Current& current)
+{
+    FileObserverPrx observer;
+    {
+        Lock sync(*this);
+        if(!_internalObserver || _internalObserver->ice_getIdentity() != current.id)
+        {
+            amdCB->ice_response(false);
+            return;
+        }
+        observer = _observer;
+        _sending = true;
+    }
+
+    //
+    // The response is sent to the node once the observer received
+    // the lines, the node doesn't send the next lines before.
+    //
+    try
+    {
+        observer->begin_linesAdded(lines, newCallback_FileObserver_linesAdded(new LinesAddedCB(this, amdCB, current.id,
+                                                                                               newPos),
+                                                                              &LinesAddedCB::response,
+                                                                              &LinesAddedCB::exception));
+    }
+    catch(const Ice::LocalException&)
+    {
+        amdCB->ice_response(linesSent(current.id, newPos, false));
+    }
+}
+
+bool
+FileIteratorI::linesSent(const Ice::Identity& id, Ice::Long newPos, bool sent)
+{
+    Lock sync(*this);
+    _sending = false;
+    notifyAll();
+
+    if(!_internalObserver || _internalObserver->ice_getIdentity() != id)
+    {
+        return false;
+    }
+
+    if(!sent)
+    {
+        unfollow(); // The observer is unreachable, stop following the file.
+        return false;
+    }
+
+    _offset = newPos;
+    return true;
+}
+
+void
+FileIteratorI::stopFollowing()
+{
+    Lock sync(*this);
+    unfollow();
+}
+
+void
+FileIteratorI::unfollow()
+{
+    //
+    // Wait for the lines being sent to the observer, the offset of
+    // the iterator is updated once they're received.
+    //
+    while(_sending)
+    {
+        wait();
+    }
+
+    if(!_internalObserver)
+    {
+        return;
+    }
+
+    try
+    {
+        _reader->begin_unfollowFile(_internalObserver);
+    }
+    catch(const Ice::LocalException&)
+    {
+    }
+
+    try
+    {
+        _registry->getRegistryAdapter()->remove(_internalObserver->ice_getIdentity());
+    }
+    catch(const Ice::LocalException&)
+    {
+    }
+
+    _observer = 0;
+    _internalObserver = 0;
+}
+
 AdminSessionI::AdminSessionI(const string& id, const DatabasePtr& db, int timeout, const RegistryIPtr& registry) :
     BaseSessionI(id, "admin", db),
     _timeout(timeout),
@@ -454,7 +674,10 @@ AdminSessionI::addFileIterator(const FileReaderPrx& reader, const string& filena
     Ice::PropertiesPtr properties = reader->ice_getCommunicator()->getProperties();
     int messageSizeMax = properties->getPropertyAsIntWithDefault("Ice.MessageSizeMax", 1024) * 1024;
 
-    Ice::ObjectPrx obj = _servantManager->add(new FileIteratorI(this, reader, filename, offset, messageSizeMax), this);
+    FileIteratorIPtr iterator = new FileIteratorI(this, _registry, reader, filename, offset, messageSizeMax,
+                                                  _timeout * 1000);
+    Ice::ObjectPrx obj = _servantManager->add(iterator, this);
+    _fileIterators.insert(make_pair(obj->ice_getIdentity(), iterator));
     return FileIteratorPrx::uncheckedCast(obj);
 }
 
@@ -463,6 +686,7 @@ AdminSessionI::removeFileIterator(const Ice::Identity& id, const Ice::Current&)
 {
     Lock sync(*this);
     _servantManager->remove(id);
+    _fileIterators.erase(id);
 }
 
 void
@@ -472,6 +696,19 @@ AdminSessionI::destroyImpl(bool shutdown)
 
     _servantManager->removeSession(this);
 
+    //
+    // Stop following the files followed by the file iterators.
+    //
+    map<Ice::Identity, FileIteratorIPtr> fileIterators;
+    {
+        Lock sync(*this);
+        _fileIterators.swap(fileIterators);
+    }
+    for(map<Ice::Identity, FileIteratorIPtr>::const_iterator p = fileIterators.begin(); p != fileIterators.end(); ++p)
+    {
+        p->second->stopFollowing();
+    }
+
     try
     {
         _database->unlock(this);
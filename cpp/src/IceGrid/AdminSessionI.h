@@ -78,6 +78,7 @@ private:
     std::map<TopicName, std::pair<Ice::ObjectPrx, bool> > _observers;
     RegistryIPtr _registry;
     Ice::ObjectPrx _adminCallbackTemplate;
+    std::map<Ice::Identity, FileIteratorIPtr> _fileIterators;
 };
 typedef IceUtil::Handle<AdminSessionI> AdminSessionIPtr;
 
@@ -129,22 +130,36 @@ private:
     const AdminSessionFactoryPtr _factory;
 };
 
-class FileIteratorI : public FileIterator
+class FileIteratorI : public FileIterator, public IceUtil::Monitor<IceUtil::Mutex>
 {
 public:
 
-    FileIteratorI(const AdminSessionIPtr&, const FileReaderPrx&, const std::string&, Ice::Long, int);
+    FileIteratorI(const AdminSessionIPtr&, const RegistryIPtr&, const FileReaderPrx&, const std::string&, Ice::Long,
+                  int, int);
 
     virtual bool read(int, Ice::StringSeq&, const Ice::Current&);
+    virtual void follow(const FileObserverPrx&, const Ice::Current&);
     virtual void destroy(const Ice::Current&);
 
+    void linesAdded(const AMD_InternalFileObserver_linesAddedPtr&, const Ice::StringSeq&, Ice::Long,
+                    const Ice::Current&);
+    bool linesSent(const Ice::Identity&, Ice::Long, bool);
+    void stopFollowing();
+
 private:
 
+    void unfollow();
+
     const AdminSessionIPtr _session;
+    const RegistryIPtr _registry;
     const FileReaderPrx _reader;
     const std::string _filename;
     Ice::Long _offset;
     const int _messageSizeMax;
+    const int _timeout;
+    FileObserverPrx _observer;
+    InternalFileObserverPrx _internalObserver;
+    bool _sending;
 };
 
 };
@@ -30,11 +30,44 @@
 using namespace std;
 using namespace IceGrid;
 
+namespace IceGrid
+{
+
+//
+// Group commit operation setting the direct proxy of an adapter.
+//
+class SetAdapterDirectProxyOperation : public IceDB::GroupCommit::Operation
+{
+public:
+
+    SetAdapterDirectProxyOperation(Database* database, const AdapterInfo& info, Ice::Long dbSerial) :
+        found(false), dbSerial(dbSerial), _database(database), _info(info)
+    {
+    }
+
+    virtual void execute(const IceDB::ReadWriteTxn&);
+
+    bool found;
+    Ice::Long dbSerial;
+
+private:
+
+    Database* _database;
+    const AdapterInfo _info;
+};
+typedef IceUtil::Handle<SetAdapterDirectProxyOperation> SetAdapterDirectProxyOperationPtr;
+
+}
+
 typedef IceDB::ReadWriteCursor<string, ApplicationInfo, IceDB::IceContext, Ice::OutputStream> ApplicationMapRWCursor;
 typedef IceDB::ReadOnlyCursor<string, AdapterInfo, IceDB::IceContext, Ice::OutputStream> AdapterMapROCursor;
 typedef IceDB::Cursor<string, string, IceDB::IceContext, Ice::OutputStream> AdaptersByGroupMapCursor;
 typedef IceDB::ReadOnlyCursor<string, Ice::Identity, IceDB::IceContext, Ice::OutputStream> ObjectsByTypeMapROCursor;
 typedef IceDB::ReadOnlyCursor<Ice::Identity, ObjectInfo, IceDB::IceContext, Ice::OutputStream> ObjectsMapROCursor;
+typedef IceDB::Cursor<string, AdapterInfo, IceDB::IceContext, Ice::OutputStream> AdapterMapCursor;
+typedef IceDB::Cursor<Ice::Identity, ObjectInfo, IceDB::IceContext, Ice::OutputStream> ObjectsMapCursor;
+typedef IceDB::ReadOnlyCursor<string, string, IceDB::IceContext, Ice::OutputStream> AdapterIndexROCursor;
+typedef IceDB::ReadOnlyCursor<string, Ice::Identity, IceDB::IceContext, Ice::OutputStream> ObjectIndexROCursor;
 
 namespace
 {
@@ -42,11 +75,14 @@ namespace
 const string applicationsDbName = "applications";
 const string adaptersDbName = "adapters";
 const string adaptersByReplicaGroupIdDbName = "adaptersByReplicaGroupId";
+const string adapterIndexDbName = "adapterIndex";
 const string objectsDbName = "objects";
 const string objectsByTypeDbName = "objectsByType";
+const string objectIndexDbName = "objectIndex";
 const string internalObjectsDbName = "internal-objects";
 const string internalObjectsByTypeDbName = "internal-objectsByType";
 const string serialsDbName = "serials";
+const string indexSerialsDbName = "indexSerials";
 
 struct ObjectLoadCI : binary_function<pair<Ice::ObjectPrx, float>&, pair<Ice::ObjectPrx, float>&, bool>
 {
@@ -56,6 +92,35 @@ struct ObjectLoadCI : binary_function<pair<Ice::ObjectPrx, float>&, pair<Ice::Ob
     }
 };
 
+//
+// The literal prefix of an expression, keys without this prefix can't
+// match the expression.
+//
+string
+getPrefix(const string& expression)
+{
+    return expression.substr(0, expression.find('*'));
+}
+
+bool
+hasPrefix(const string& key, const string& prefix)
+{
+    return key.compare(0, prefix.size(), prefix) == 0;
+}
+
+//
+// Remove the last entries of a sorted page to keep at most the given
+// number of entries, 0 or less for no limit.
+//
+template<typename T> void
+truncatePage(T& page, int limit)
+{
+    while(limit > 0 && page.size() > static_cast<size_t>(limit))
+    {
+        page.erase(--page.end());
+    }
+}
+
 template<typename K, typename V, typename C, typename H> vector<V>
 toVector(const IceDB::ReadOnlyTxn& txn, const IceDB::Dbi<K, V, C, H>& m)
 {
@@ -211,9 +276,20 @@ Database::Database(const Ice::ObjectAdapterPtr& registryAdapter,
     _objectCache(_communicator),
     _allocatableObjectCache(_communicator),
     _serverCache(_communicator, _instanceName, _nodeCache, _adapterCache, _objectCache, _allocatableObjectCache),
+    _locatorCache(static_cast<size_t>(max(_communicator->getProperties()->getPropertyAsIntWithDefault(
+                                              "IceGrid.Registry.LocatorCacheSize", 10000), 0))),
     _dbLock(_communicator->getProperties()->getProperty("IceGrid.Registry.LMDB.Path") + "/icedb.lock"),
-    _env(_communicator->getProperties()->getProperty("IceGrid.Registry.LMDB.Path"), 8,
-         IceDB::getMapSize(_communicator->getProperties()->getPropertyAsInt("IceGrid.Registry.LMDB.MapSize"))),
+    _env(_communicator->getProperties()->getProperty("IceGrid.Registry.LMDB.Path"), 10,
+         IceDB::getMapSize(_communicator->getProperties()->getPropertyAsInt("IceGrid.Registry.LMDB.MapSize")), 0,
+         static_cast<size_t>(max(_communicator->getProperties()->getPropertyAsInt("IceGrid.Registry.LMDB.MapSizeMax"),
+                                 0)) * 1024 * 1024),
+    _groupCommit(new IceDB::GroupCommit(_env,
+                                        IceUtil::Time::milliSeconds(_communicator->getProperties()->getPropertyAsInt(
+                                            "IceGrid.Registry.LMDB.GroupCommitDelay")),
+                                        static_cast<size_t>(_communicator->getProperties()->getPropertyAsIntWithDefault(
+                                            "IceGrid.Registry.LMDB.GroupCommitSize", 100)))),
+    _adapterUpdates(0),
+    _adapterUpdatesDone(0),
     _pluginFacade(RegistryPluginFacadeIPtr::dynamicCast(getRegistryPluginFacade())),
     _lock(0)
 {
@@ -228,14 +304,21 @@ Database::Database(const Ice::ObjectAdapterPtr& registryAdapter,
 
     _adapters = StringAdapterInfoMap(txn, adaptersDbName, context, MDB_CREATE);
     _adaptersByGroupId = StringStringMap(txn, adaptersByReplicaGroupIdDbName, context, MDB_CREATE|MDB_DUPSORT);
+    _adapterIndex = StringStringMap(txn, adapterIndexDbName, context, MDB_CREATE|MDB_DUPSORT, IceDB::compareStrings);
 
     _objects = IdentityObjectInfoMap(txn, objectsDbName, context, MDB_CREATE);
     _objectsByType = StringIdentityMap(txn, objectsByTypeDbName, context, MDB_CREATE|MDB_DUPSORT);
+    _objectIndex = StringIdentityMap(txn, objectIndexDbName, context, MDB_CREATE, IceDB::compareStrings);
 
     _internalObjects = IdentityObjectInfoMap(txn, internalObjectsDbName, context, MDB_CREATE);
     _internalObjectsByType = StringIdentityMap(txn, internalObjectsByTypeDbName, context, MDB_CREATE|MDB_DUPSORT);
 
     _serials = StringLongMap(txn, serialsDbName, context, MDB_CREATE);
+    _indexSerials = StringLongMap(txn, indexSerialsDbName, context, MDB_CREATE);
+
+    _decoders.reset(new IceDB::DecoderPool(context));
+
+    buildIndexes(txn);
 
     ServerEntrySeq entries;
 
@@ -305,6 +388,17 @@ Database::destroy()
 {
     _pluginFacade->setDatabase(0);
 
+    if(_traceLevels->locator > 0)
+    {
+        Ice::Long hits;
+        Ice::Long misses;
+        Ice::Long evictions;
+        Ice::Long size;
+        _locatorCache.getStats(hits, misses, evictions, size);
+        Ice::Trace out(_traceLevels->logger, _traceLevels->locatorCat);
+        out << "locator cache: " << hits << " hits, " << misses << " misses, " << evictions << " evictions";
+    }
+
     _registryObserverTopic->destroy();
     _nodeObserverTopic->destroy();
     _applicationObserverTopic->destroy();
@@ -380,6 +474,13 @@ Database::syncApplications(const ApplicationInfoSeq& newApplications, Ice::Long
     {
         Lock sync(*this);
 
+        //
+        // The adapter direct proxies committed with the group commit
+        // must be registered before the application adapters are
+        // loaded, the mutex prevents new registrations until then.
+        //
+        waitForAdapterUpdates();
+
         map<string, ApplicationInfo> oldApplications;
         try
         {
@@ -456,12 +557,14 @@ Database::syncAdapters(const AdapterInfoSeq& adapters, Ice::Long dbSerial)
     int serial = 0;
     {
         Lock sync(*this);
+        waitForAdapterUpdates();
         try
         {
             IceDB::ReadWriteTxn txn(_env);
 
             _adapters.clear(txn);
             _adaptersByGroupId.clear(txn);
+            _adapterIndex.clear(txn);
             for(AdapterInfoSeq::const_iterator r = adapters.begin(); r != adapters.end(); ++r)
             {
                 addAdapter(txn, *r);
@@ -486,6 +589,7 @@ Database::syncAdapters(const AdapterInfoSeq& adapters, Ice::Long dbSerial)
             out << "synchronized adapters (serial = `" << dbSerial << "')";
         }
 
+        _locatorCache.clear();
         serial = _adapterObserverTopic->adapterInit(dbSerial, adapters);
     }
     _adapterObserverTopic->waitForSyncedSubscribers(serial);
@@ -504,6 +608,7 @@ Database::syncObjects(const ObjectInfoSeq& objects, Ice::Long dbSerial)
 
             _objects.clear(txn);
             _objectsByType.clear(txn);
+            _objectIndex.clear(txn);
             for(ObjectInfoSeq::const_iterator q = objects.begin(); q != objects.end(); ++q)
             {
                 addObject(txn, *q, false);
@@ -524,6 +629,7 @@ Database::syncObjects(const ObjectInfoSeq& objects, Ice::Long dbSerial)
             out << "synchronized objects (serial = `" << dbSerial << "')";
         }
 
+        _locatorCache.clear();
         serial = _objectObserverTopic->objectInit(dbSerial, objects);
     }
     _objectObserverTopic->waitForSyncedSubscribers(serial);
@@ -607,6 +713,13 @@ Database::addApplication(const ApplicationInfo& info, AdminSessionI* session, Ic
 
         waitForUpdate(info.descriptor.name);
 
+        //
+        // Wait for the adapter direct proxies committed with the group
+        // commit to be registered, the mutex prevents new
+        // registrations until the application adapters are loaded.
+        //
+        waitForAdapterUpdates();
+
         IceDB::ReadWriteTxn txn(_env);
 
         if(_applications.find(txn, info.descriptor.name))
@@ -1010,34 +1123,28 @@ Database::setAdapterDirectProxy(const string& adapterId, const string& replicaGr
         info.proxy = proxy;
         info.replicaGroupId = replicaGroupId;
 
-        bool updated = false;
+        //
+        // The update is committed together with the concurrent adapter
+        // updates. The mutex is released while waiting for the commit
+        // and the observers are notified in the order of the updates.
+        //
+        SetAdapterDirectProxyOperationPtr op = new SetAdapterDirectProxyOperation(this, info, dbSerial);
+        _groupCommit->submit(op);
+        Ice::Long update = _adapterUpdates++;
+        sync.release();
         try
         {
-            IceDB::ReadWriteTxn txn(_env);
-
-            AdapterInfo oldInfo;
-            bool found = _adapters.get(txn, adapterId, oldInfo);
-            if(proxy)
+            try
             {
-                updated = found;
-
-                if(replicaGroupId != oldInfo.replicaGroupId)
-                {
-                    _adaptersByGroupId.del(txn, oldInfo.replicaGroupId, adapterId);
-                }
-                addAdapter(txn, info);
+                _groupCommit->waitForCommit(op);
             }
-            else
+            catch(...)
             {
-                if(!found)
-                {
-                    return;
-                }
-                deleteAdapter(txn, oldInfo);
+                sync.acquire();
+                waitForAdapterUpdate(update);
+                finishAdapterUpdate();
+                throw;
             }
-            dbSerial = updateSerial(txn, adaptersDbName, dbSerial);
-
-            txn.commit();
         }
         catch(const IceDB::KeyTooLongException&)
         {
@@ -1048,6 +1155,18 @@ Database::setAdapterDirectProxy(const string& adapterId, const string& replicaGr
             logError(_communicator, ex);
             throw;
         }
+        sync.acquire();
+        waitForAdapterUpdate(update);
+
+        if(!proxy && !op->found)
+        {
+            finishAdapterUpdate();
+            return;
+        }
+        bool updated = op->found;
+        dbSerial = op->dbSerial;
+
+        _locatorCache.removeAdapter(adapterId);
 
         if(_traceLevels->adapter > 0)
         {
@@ -1075,6 +1194,7 @@ Database::setAdapterDirectProxy(const string& adapterId, const string& replicaGr
         {
             serial = _adapterObserverTopic->adapterRemoved(dbSerial, adapterId);
         }
+        finishAdapterUpdate();
     }
     _adapterObserverTopic->waitForSyncedSubscribers(serial);
 }
@@ -1083,11 +1203,22 @@ Ice::ObjectPrx
 Database::getAdapterDirectProxy(const string& id, const Ice::EncodingVersion& encoding, const Ice::ConnectionPtr& con,
                                 const Ice::Context& ctx)
 {
+    Ice::ObjectPrx proxy;
+    Ice::Long version = 0; // Initialize to prevent warning.
+    if(_locatorCache.getAdapter(id, proxy, version))
+    {
+        return proxy;
+    }
+
     IceDB::ReadOnlyTxn txn(_env);
 
-    AdapterInfo info;
-    if(_adapters.get(txn, id, info))
+    IceDB::View view;
+    if(_adapters.getView(txn, id, view))
     {
+        AdapterInfo info;
+        IceDB::PooledDecoder decoder(*_decoders);
+        decoder->decode(view, info);
+        _locatorCache.addAdapter(id, info.proxy, version);
         return info.proxy;
     }
 
@@ -1110,6 +1241,19 @@ Database::getAdapterDirectProxy(const string& id, const Ice::EncodingVersion& en
     throw AdapterNotExistException(id);
 }
 
+bool
+Database::getCachedAdapterDirectProxy(const string& id, Ice::ObjectPrx& proxy)
+{
+    Ice::Long version = 0; // Initialize to prevent warning.
+    return _locatorCache.getAdapter(id, proxy, version);
+}
+
+void
+Database::getLocatorCacheStats(Ice::Long& hits, Ice::Long& misses, Ice::Long& evictions, Ice::Long& size) const
+{
+    _locatorCache.getStats(hits, misses, evictions, size);
+}
+
 void
 Database::removeAdapter(const string& adapterId)
 {
@@ -1127,6 +1271,8 @@ Database::removeAdapter(const string& adapterId)
             throw ex;
         }
 
+        waitForAdapterUpdates();
+
         AdapterInfoSeq infos;
         Ice::Long dbSerial = 0;
         try
@@ -1172,6 +1318,7 @@ Database::removeAdapter(const string& adapterId)
             out << "removed " << (infos.empty() ? "adapter" : "replica group") << " `" << adapterId << "' (serial = `" << dbSerial << "')";
         }
 
+        _locatorCache.clear();
         if(infos.empty())
         {
             serial = _adapterObserverTopic->adapterRemoved(dbSerial, adapterId);
@@ -1406,41 +1553,58 @@ Database::getAdapterNode(const string& id) const
 
 Ice::StringSeq
 Database::getAllAdapters(const string& expression)
+{
+    return getAdapterIdsPage(expression, "", 0);
+}
+
+Ice::StringSeq
+Database::getAdapterIdsPage(const string& expression, const string& after, int limit)
 {
     Lock sync(*this);
-    vector<string> result;
+
+    //
+    // The page holds the ids greater than after in order, the ids of
+    // the application adapters and replica groups are merged with the
+    // ids of the adapter index.
+    //
+    set<string> page;
     vector<string> ids = _adapterCache.getAll(expression);
-    result.swap(ids);
-    set<string> groups;
+    for(vector<string>::const_iterator p = ids.begin(); p != ids.end(); ++p)
+    {
+        if(*p > after)
+        {
+            page.insert(*p);
+        }
+    }
+    truncatePage(page, limit);
 
     IceDB::ReadOnlyTxn txn(_env);
 
-    string name;
-    AdapterInfo info;
-    AdapterMapROCursor cursor(_adapters, txn);
-    while(cursor.get(name, info, MDB_NEXT))
+    //
+    // Only visit the index keys with the literal prefix of the
+    // expression, and stop once the page is full.
+    //
+    const string prefix = getPrefix(expression);
+    string id = max(prefix, after);
+    string adapterId;
+    AdapterIndexROCursor cursor(_adapterIndex, txn);
+    bool found = cursor.findRange(id, adapterId);
+    while(found && hasPrefix(id, prefix))
     {
-        if(expression.empty() || IceUtilInternal::match(name, expression, true))
+        if(limit > 0 && page.size() >= static_cast<size_t>(limit) && id > *page.rbegin())
         {
-            result.push_back(name);
+            break;
         }
-        string replicaGroupId = info.replicaGroupId;
-        if(!replicaGroupId.empty() && (expression.empty() || IceUtilInternal::match(replicaGroupId, expression, true)))
+        if(id != after && (expression.empty() || IceUtilInternal::match(id, expression, true)))
         {
-            groups.insert(replicaGroupId);
+            page.insert(id);
+            truncatePage(page, limit);
         }
+        found = cursor.get(id, adapterId, MDB_NEXT_NODUP);
     }
     cursor.close();
 
-    //
-    // COMPILERFIX: We're not using result.insert() here, this doesn't compile on Sun.
-    //
-    //result.insert(result.end(), groups.begin(), groups.end())
-    for(set<string>::const_iterator q = groups.begin(); q != groups.end(); ++q)
-    {
-        result.push_back(*q);
-    }
-    return result;
+    return Ice::StringSeq(page.begin(), page.end());
 }
 
 void
@@ -1478,6 +1642,7 @@ Database::addObject(const ObjectInfo& info)
             throw;
         }
 
+        _locatorCache.removeObject(id);
         serial = _objectObserverTopic->objectAdded(dbSerial, info);
 
         if(_traceLevels->object > 0)
@@ -1527,6 +1692,7 @@ Database::addOrUpdateObject(const ObjectInfo& info, Ice::Long dbSerial)
             throw;
         }
 
+        _locatorCache.removeObject(id);
         if(update)
         {
             serial = _objectObserverTopic->objectUpdated(dbSerial, info);
@@ -1585,6 +1751,7 @@ Database::removeObject(const Ice::Identity& id, Ice::Long dbSerial)
             throw;
         }
 
+        _locatorCache.removeObject(id);
         serial = _objectObserverTopic->objectRemoved(dbSerial, id);
 
         if(_traceLevels->object > 0)
@@ -1640,6 +1807,7 @@ Database::updateObject(const Ice::ObjectPrx& proxy)
             throw;
         }
 
+        _locatorCache.removeObject(id);
         serial = _objectObserverTopic->objectUpdated(dbSerial, info);
         if(_traceLevels->object > 0)
         {
@@ -1650,6 +1818,319 @@ Database::updateObject(const Ice::ObjectPrx& proxy)
     _objectObserverTopic->waitForSyncedSubscribers(serial);
 }
 
+void
+Database::addObjects(const ObjectInfoSeq& infos)
+{
+    assert(_master);
+
+    if(infos.empty())
+    {
+        return;
+    }
+
+    int serial = 0;
+    {
+        Lock sync(*this);
+
+        set<Ice::Identity> ids;
+        for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+        {
+            const Ice::Identity id = p->proxy->ice_getIdentity();
+            if(_objectCache.has(id) || !ids.insert(id).second)
+            {
+                throw ObjectExistsException(id);
+            }
+        }
+
+        Ice::Long dbSerial = 0;
+        try
+        {
+            IceDB::ReadWriteTxn txn(_env);
+
+            for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+            {
+                if(_objects.find(txn, p->proxy->ice_getIdentity()))
+                {
+                    throw ObjectExistsException(p->proxy->ice_getIdentity());
+                }
+                addObject(txn, *p, false);
+            }
+            dbSerial = updateSerial(txn, objectsDbName);
+
+            txn.commit();
+        }
+        catch(const IceDB::LMDBException& ex)
+        {
+            logError(_communicator, ex);
+            throw;
+        }
+
+        for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+        {
+            _locatorCache.removeObject(p->proxy->ice_getIdentity());
+        }
+        serial = _objectObserverTopic->objectsAdded(dbSerial, infos);
+
+        if(_traceLevels->object > 0)
+        {
+            Ice::Trace out(_traceLevels->logger, _traceLevels->objectCat);
+            out << "added " << infos.size() << " objects (serial = `" << dbSerial << "')";
+            if(_traceLevels->object > 1)
+            {
+                for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+                {
+                    out << "\nobject `" << identityToString(p->proxy->ice_getIdentity()) << "'";
+                }
+            }
+        }
+    }
+    _objectObserverTopic->publishBulkUpdates();
+    _objectObserverTopic->waitForSyncedSubscribers(serial);
+}
+
+void
+Database::addOrUpdateObjects(const ObjectInfoSeq& infos, Ice::Long dbSerial)
+{
+    assert(dbSerial != 0);
+
+    int serial = 0;
+    {
+        Lock sync(*this);
+
+        for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+        {
+            if(_objectCache.has(p->proxy->ice_getIdentity()))
+            {
+                throw ObjectExistsException(p->proxy->ice_getIdentity());
+            }
+        }
+
+        ObjectInfoSeq added;
+        ObjectInfoSeq updated;
+        try
+        {
+            IceDB::ReadWriteTxn txn(_env);
+
+            for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+            {
+                ObjectInfo info;
+                if(_objects.get(txn, p->proxy->ice_getIdentity(), info))
+                {
+                    _objectsByType.del(txn, info.type, info.proxy->ice_getIdentity());
+                    updated.push_back(*p);
+                }
+                else
+                {
+                    added.push_back(*p);
+                }
+                addObject(txn, *p, false);
+            }
+            dbSerial = updateSerial(txn, objectsDbName, dbSerial);
+
+            txn.commit();
+        }
+        catch(const IceDB::LMDBException& ex)
+        {
+            logError(_communicator, ex);
+            throw;
+        }
+
+        for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+        {
+            _locatorCache.removeObject(p->proxy->ice_getIdentity());
+        }
+        if(!added.empty())
+        {
+            serial = _objectObserverTopic->objectsAdded(dbSerial, added);
+        }
+        if(!updated.empty())
+        {
+            serial = _objectObserverTopic->objectsUpdated(dbSerial, updated);
+        }
+
+        if(_traceLevels->object > 0)
+        {
+            Ice::Trace out(_traceLevels->logger, _traceLevels->objectCat);
+            out << "added " << added.size() << " and updated " << updated.size() << " objects (serial = `"
+                << dbSerial << "')";
+            if(_traceLevels->object > 1)
+            {
+                for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+                {
+                    out << "\nobject `" << identityToString(p->proxy->ice_getIdentity()) << "'";
+                }
+            }
+        }
+    }
+    _objectObserverTopic->publishBulkUpdates();
+    _objectObserverTopic->waitForSyncedSubscribers(serial);
+}
+
+void
+Database::updateObjects(const Ice::ObjectProxySeq& proxies)
+{
+    assert(_master);
+
+    if(proxies.empty())
+    {
+        return;
+    }
+
+    int serial = 0;
+    {
+        Lock sync(*this);
+
+        for(Ice::ObjectProxySeq::const_iterator p = proxies.begin(); p != proxies.end(); ++p)
+        {
+            const Ice::Identity id = (*p)->ice_getIdentity();
+            if(_objectCache.has(id))
+            {
+                DeploymentException ex;
+                ex.reason = "updating object `" + identityToString(id) + "' is not allowed:\n";
+                ex.reason += "the object was added with the application descriptor `";
+                ex.reason += _objectCache.get(id)->getApplication();
+                ex.reason += "'";
+                throw ex;
+            }
+        }
+
+        ObjectInfoSeq infos;
+        infos.reserve(proxies.size());
+        Ice::Long dbSerial = 0;
+        try
+        {
+            IceDB::ReadWriteTxn txn(_env);
+
+            for(Ice::ObjectProxySeq::const_iterator p = proxies.begin(); p != proxies.end(); ++p)
+            {
+                ObjectInfo info;
+                if(!_objects.get(txn, (*p)->ice_getIdentity(), info))
+                {
+                    ObjectNotRegisteredException ex;
+                    ex.id = (*p)->ice_getIdentity();
+                    throw ex;
+                }
+                info.proxy = *p;
+                addObject(txn, info, false);
+                infos.push_back(info);
+            }
+            dbSerial = updateSerial(txn, objectsDbName);
+
+            txn.commit();
+        }
+        catch(const IceDB::LMDBException& ex)
+        {
+            logError(_communicator, ex);
+            throw;
+        }
+
+        for(Ice::ObjectProxySeq::const_iterator p = proxies.begin(); p != proxies.end(); ++p)
+        {
+            _locatorCache.removeObject((*p)->ice_getIdentity());
+        }
+        serial = _objectObserverTopic->objectsUpdated(dbSerial, infos);
+
+        if(_traceLevels->object > 0)
+        {
+            Ice::Trace out(_traceLevels->logger, _traceLevels->objectCat);
+            out << "updated " << infos.size() << " objects (serial = `" << dbSerial << "')";
+            if(_traceLevels->object > 1)
+            {
+                for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+                {
+                    out << "\nobject `" << identityToString(p->proxy->ice_getIdentity()) << "'";
+                }
+            }
+        }
+    }
+    _objectObserverTopic->publishBulkUpdates();
+    _objectObserverTopic->waitForSyncedSubscribers(serial);
+}
+
+void
+Database::removeObjects(const Ice::IdentitySeq& ids, Ice::Long dbSerial)
+{
+    assert(dbSerial != 0 || _master);
+
+    if(ids.empty())
+    {
+        return;
+    }
+
+    int serial = 0;
+    {
+        Lock sync(*this);
+
+        for(Ice::IdentitySeq::const_iterator p = ids.begin(); p != ids.end(); ++p)
+        {
+            if(_objectCache.has(*p))
+            {
+                DeploymentException ex;
+                ex.reason = "removing object `" + identityToString(*p) + "' is not allowed:\n";
+                ex.reason += "the object was added with the application descriptor `";
+                ex.reason += _objectCache.get(*p)->getApplication();
+                ex.reason += "'";
+                throw ex;
+            }
+        }
+
+        try
+        {
+            IceDB::ReadWriteTxn txn(_env);
+
+            //
+            // An identity listed twice isn't registered anymore when
+            // it's looked up the second time. The replicas skip the
+            // objects which aren't registered.
+            //
+            for(Ice::IdentitySeq::const_iterator p = ids.begin(); p != ids.end(); ++p)
+            {
+                ObjectInfo info;
+                if(!_objects.get(txn, *p, info))
+                {
+                    if(dbSerial != 0)
+                    {
+                        continue;
+                    }
+                    ObjectNotRegisteredException ex;
+                    ex.id = *p;
+                    throw ex;
+                }
+                deleteObject(txn, info, false);
+            }
+            dbSerial = updateSerial(txn, objectsDbName, dbSerial);
+
+            txn.commit();
+        }
+        catch(const IceDB::LMDBException& ex)
+        {
+            logError(_communicator, ex);
+            throw;
+        }
+
+        for(Ice::IdentitySeq::const_iterator p = ids.begin(); p != ids.end(); ++p)
+        {
+            _locatorCache.removeObject(*p);
+        }
+        serial = _objectObserverTopic->objectsRemoved(dbSerial, ids);
+
+        if(_traceLevels->object > 0)
+        {
+            Ice::Trace out(_traceLevels->logger, _traceLevels->objectCat);
+            out << "removed " << ids.size() << " objects (serial = `" << dbSerial << "')";
+            if(_traceLevels->object > 1)
+            {
+                for(Ice::IdentitySeq::const_iterator p = ids.begin(); p != ids.end(); ++p)
+                {
+                    out << "\nobject `" << identityToString(*p) << "'";
+                }
+            }
+        }
+    }
+    _objectObserverTopic->publishBulkUpdates();
+    _objectObserverTopic->waitForSyncedSubscribers(serial);
+}
+
 int
 Database::addOrUpdateRegistryWellKnownObjects(const ObjectInfoSeq& objects)
 {
@@ -1675,6 +2156,10 @@ Database::addOrUpdateRegistryWellKnownObjects(const ObjectInfoSeq& objects)
         throw;
     }
 
+    for(ObjectInfoSeq::const_iterator p = objects.begin(); p != objects.end(); ++p)
+    {
+        _locatorCache.removeObject(p->proxy->ice_getIdentity());
+    }
     return _objectObserverTopic->wellKnownObjectsAddedOrUpdated(objects);
 }
 
@@ -1702,32 +2187,49 @@ Database::removeRegistryWellKnownObjects(const ObjectInfoSeq& objects)
         throw;
     }
 
+    for(ObjectInfoSeq::const_iterator p = objects.begin(); p != objects.end(); ++p)
+    {
+        _locatorCache.removeObject(p->proxy->ice_getIdentity());
+    }
     return _objectObserverTopic->wellKnownObjectsRemoved(objects);
 }
 
 Ice::ObjectPrx
 Database::getObjectProxy(const Ice::Identity& id)
 {
+    Ice::ObjectPrx proxy;
+    Ice::Long version = 0; // Initialize to prevent warning.
+    if(_locatorCache.getObject(id, proxy, version))
+    {
+        return proxy;
+    }
+
     try
     {
         //
         // Only return proxies for non allocatable objects.
         //
-        return _objectCache.get(id)->getProxy();
+        proxy = _objectCache.get(id)->getProxy();
     }
     catch(const ObjectNotRegisteredException&)
     {
-    }
+        IceDB::ReadOnlyTxn txn(_env);
+        IceDB::View view;
+        if(!_objects.getView(txn, id, view))
+        {
+            ObjectNotRegisteredException ex;
+            ex.id = id;
+            throw ex;
+        }
 
-    IceDB::ReadOnlyTxn txn(_env);
-    ObjectInfo info;
-    if(!_objects.get(txn, id, info))
-    {
-        ObjectNotRegisteredException ex;
-        ex.id = id;
-        throw ex;
+        ObjectInfo info;
+        IceDB::PooledDecoder decoder(*_decoders);
+        decoder->decode(view, info);
+        proxy = info.proxy;
     }
-    return info.proxy;
+
+    _locatorCache.addObject(id, proxy, version);
+    return proxy;
 }
 
 Ice::ObjectPrx
@@ -1824,21 +2326,68 @@ Database::getObjectInfo(const Ice::Identity& id)
 ObjectInfoSeq
 Database::getAllObjectInfos(const string& expression)
 {
+    return getObjectInfosPage(expression, "", 0);
+}
+
+ObjectInfoSeq
+Database::getObjectInfosPage(const string& expression, const string& after, int limit)
+{
+    //
+    // The page holds the object infos with a stringified identity
+    // greater than after in order, the application objects are merged
+    // with the objects of the object index.
+    //
+    map<string, ObjectInfo> page;
     ObjectInfoSeq infos = _objectCache.getAll(expression);
+    for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+    {
+        string name = identityToString(p->proxy->ice_getIdentity());
+        if(name > after)
+        {
+            page.insert(make_pair(name, *p));
+        }
+    }
+    truncatePage(page, limit);
 
     IceDB::ReadOnlyTxn txn(_env);
 
+    //
+    // Only visit the index keys with the literal prefix of the
+    // expression, and only unmarshal the object infos added to the
+    // page.
+    //
+    const string prefix = getPrefix(expression);
+    string name = max(prefix, after);
     Ice::Identity id;
-    ObjectInfo info;
-    ObjectsMapROCursor cursor(_objects, txn);
-    while(cursor.get(id, info, MDB_NEXT))
+    IceDB::View view;
+    IceDB::PooledDecoder decoder(*_decoders);
+    ObjectIndexROCursor cursor(_objectIndex, txn);
+    bool found = cursor.findRange(name, id);
+    while(found && hasPrefix(name, prefix))
     {
-        if(expression.empty() || IceUtilInternal::match(identityToString(id), expression, true))
+        if(limit > 0 && page.size() >= static_cast<size_t>(limit) && name > page.rbegin()->first)
         {
-            infos.push_back(info);
+            break;
         }
+        if(name != after && (expression.empty() || IceUtilInternal::match(name, expression, true)) &&
+           _objects.getView(txn, id, view))
+        {
+            ObjectInfo info;
+            decoder->decode(view, info);
+            page.insert(make_pair(name, info));
+            truncatePage(page, limit);
+        }
+        found = cursor.get(name, id, MDB_NEXT);
     }
-    return infos;
+    cursor.close();
+
+    ObjectInfoSeq result;
+    result.reserve(page.size());
+    for(map<string, ObjectInfo>::const_iterator p = page.begin(); p != page.end(); ++p)
+    {
+        result.push_back(p->second);
+    }
+    return result;
 }
 
 ObjectInfoSeq
@@ -2171,6 +2720,11 @@ Database::load(const ApplicationHelper& app, ServerEntrySeq& entries, const stri
     {
         entries.push_back(_serverCache.add(p->second));
     }
+
+    //
+    // The application objects and adapters changed.
+    //
+    _locatorCache.clear();
 }
 
 void
@@ -2198,6 +2752,11 @@ Database::unload(const ApplicationHelper& app, ServerEntrySeq& entries)
     {
         _nodeCache.get(n->first)->removeDescriptor(application);
     }
+
+    //
+    // The application objects and adapters changed.
+    //
+    _locatorCache.clear();
 }
 
 void
@@ -2323,6 +2882,11 @@ Database::reload(const ApplicationHelper& oldApp,
             entries.push_back(_serverCache.add(q->second));
         }
     }
+
+    //
+    // The application objects and adapters changed.
+    //
+    _locatorCache.clear();
 }
 
 Ice::Long
@@ -2556,6 +3120,12 @@ Database::finishApplicationUpdate(const ApplicationUpdateInfo& update,
 
         Lock sync(*this);
 
+        //
+        // Wait for the adapter direct proxies committed with the group
+        // commit to be registered before checking the added adapters.
+        //
+        waitForAdapterUpdates();
+
         IceDB::ReadWriteTxn txn(_env);
 
         checkForUpdate(previous, helper, txn);
@@ -2716,24 +3286,101 @@ Database::updateSerial(const IceDB::ReadWriteTxn& txn, const string& dbName, Ice
     // If a serial number is set, just update the serial number from the database,
     // otherwise if the serial is 0, we increment the serial from the database.
     //
-    if(serial > 0)
+    if(serial <= 0)
+    {
+        serial = getSerial(txn, dbName) + 1;
+    }
+    _serials.put(txn, dbName, serial);
+
+    //
+    // The indexes are updated in the same transaction as the indexed
+    // databases, their serial follows the serial of the database.
+    //
+    if(dbName == adaptersDbName)
+    {
+        _indexSerials.put(txn, adapterIndexDbName, serial);
+    }
+    else if(dbName == objectsDbName)
     {
-        _serials.put(txn, dbName, serial);
-        return serial;
+        _indexSerials.put(txn, objectIndexDbName, serial);
+    }
+    return serial;
+}
+
+void
+SetAdapterDirectProxyOperation::execute(const IceDB::ReadWriteTxn& txn)
+{
+    AdapterInfo oldInfo;
+    found = _database->_adapters.get(txn, _info.id, oldInfo);
+    if(_info.proxy)
+    {
+        if(_info.replicaGroupId != oldInfo.replicaGroupId)
+        {
+            _database->_adaptersByGroupId.del(txn, oldInfo.replicaGroupId, _info.id);
+            if(!oldInfo.replicaGroupId.empty())
+            {
+                _database->_adapterIndex.del(txn, oldInfo.replicaGroupId, _info.id);
+            }
+        }
+        _database->addAdapter(txn, _info);
     }
     else
     {
-        Ice::Long dbSerial = getSerial(txn, dbName) + 1;
-        _serials.put(txn, dbName, dbSerial);
-        return dbSerial;
+        if(!found)
+        {
+            return;
+        }
+        _database->deleteAdapter(txn, oldInfo);
+    }
+    dbSerial = _database->updateSerial(txn, adaptersDbName, dbSerial);
+}
+
+void
+Database::waitForAdapterUpdates()
+{
+    //
+    // Called with the mutex locked. Wait for the adapter updates
+    // committed with the group commit to be done.
+    //
+    while(_adapterUpdatesDone != _adapterUpdates)
+    {
+        wait();
+    }
+}
+
+void
+Database::waitForAdapterUpdate(Ice::Long update)
+{
+    //
+    // Called with the mutex locked. Wait for the previous adapter
+    // updates to be done.
+    //
+    while(_adapterUpdatesDone != update)
+    {
+        wait();
     }
 }
 
+void
+Database::finishAdapterUpdate()
+{
+    //
+    // Called with the mutex locked.
+    //
+    ++_adapterUpdatesDone;
+    notifyAll();
+}
+
 void
 Database::addAdapter(const IceDB::ReadWriteTxn& txn, const AdapterInfo& info)
 {
     _adapters.put(txn, info.id, info);
     _adaptersByGroupId.put(txn, info.replicaGroupId, info.id);
+    _adapterIndex.put(txn, info.id, "");
+    if(!info.replicaGroupId.empty())
+    {
+        _adapterIndex.put(txn, info.replicaGroupId, info.id);
+    }
 }
 
 void
@@ -2742,6 +3389,11 @@ Database::deleteAdapter(const IceDB::ReadWriteTxn& txn, const AdapterInfo& info)
 
     _adapters.del(txn, info.id);
     _adaptersByGroupId.del(txn, info.replicaGroupId, info.id);
+    _adapterIndex.del(txn, info.id, "");
+    if(!info.replicaGroupId.empty())
+    {
+        _adapterIndex.del(txn, info.replicaGroupId, info.id);
+    }
 }
 
 void
@@ -2757,6 +3409,7 @@ Database::addObject(const IceDB::ReadWriteTxn& txn, const ObjectInfo& info, bool
         try
         {
             _objects.put(txn, info.proxy->ice_getIdentity(), info);
+            _objectIndex.put(txn, identityToString(info.proxy->ice_getIdentity()), info.proxy->ice_getIdentity());
         }
         catch(const IceDB::KeyTooLongException& ex)
         {
@@ -2787,5 +3440,65 @@ Database::deleteObject(const IceDB::ReadWriteTxn& txn, const ObjectInfo& info, b
     {
         _objects.del(txn, info.proxy->ice_getIdentity());
         _objectsByType.del(txn, info.type, info.proxy->ice_getIdentity());
+        _objectIndex.del(txn, identityToString(info.proxy->ice_getIdentity()));
+    }
+}
+
+void
+Database::buildIndexes(const IceDB::ReadWriteTxn& txn)
+{
+    //
+    // An index is rebuilt if its serial doesn't match the serial of
+    // the indexed database: the index is missing if the database was
+    // created by a previous version and it's stale if the database was
+    // updated without the index, for example by an icegriddb import.
+    //
+    Ice::Long serial = getSerial(txn, adaptersDbName);
+    Ice::Long indexSerial = 0;
+    if(!_indexSerials.get(txn, adapterIndexDbName, indexSerial) || indexSerial != serial)
+    {
+        _adapterIndex.clear(txn);
+
+        string id;
+        AdapterInfo info;
+        AdapterMapCursor adapterCursor(_adapters, txn);
+        while(adapterCursor.get(id, info, MDB_NEXT))
+        {
+            _adapterIndex.put(txn, info.id, "");
+            if(!info.replicaGroupId.empty())
+            {
+                _adapterIndex.put(txn, info.replicaGroupId, info.id);
+            }
+        }
+        adapterCursor.close();
+        _indexSerials.put(txn, adapterIndexDbName, serial);
+
+        if(_traceLevels->adapter > 0)
+        {
+            Ice::Trace out(_traceLevels->logger, _traceLevels->adapterCat);
+            out << "rebuilt adapter index (serial = `" << serial << "')";
+        }
+    }
+
+    serial = getSerial(txn, objectsDbName);
+    if(!_indexSerials.get(txn, objectIndexDbName, indexSerial) || indexSerial != serial)
+    {
+        _objectIndex.clear(txn);
+
+        Ice::Identity identity;
+        IceDB::View view;
+        ObjectsMapCursor objectCursor(_objects, txn);
+        while(objectCursor.getView(identity, view, MDB_NEXT))
+        {
+            _objectIndex.put(txn, identityToString(identity), identity);
+        }
+        objectCursor.close();
+        _indexSerials.put(txn, objectIndexDbName, serial);
+
+        if(_traceLevels->object > 0)
+        {
+            Ice::Trace out(_traceLevels->logger, _traceLevels->objectCat);
+            out << "rebuilt object index (serial = `" << serial << "')";
+        }
     }
 }
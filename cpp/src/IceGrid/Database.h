@@ -20,6 +20,7 @@
 #include <IceGrid/NodeCache.h>
 #include <IceGrid/ReplicaCache.h>
 #include <IceGrid/ObjectCache.h>
+#include <IceGrid/LocatorCache.h>
 #include <IceGrid/AllocatableObjectCache.h>
 #include <IceGrid/AdapterCache.h>
 #include <IceGrid/Topics.h>
@@ -117,6 +118,8 @@ public:
     void setAdapterDirectProxy(const std::string&, const std::string&, const Ice::ObjectPrx&, Ice::Long = 0);
     Ice::ObjectPrx getAdapterDirectProxy(const std::string&, const Ice::EncodingVersion&, const Ice::ConnectionPtr&,
                                          const Ice::Context&);
+    bool getCachedAdapterDirectProxy(const std::string&, Ice::ObjectPrx&);
+    void getLocatorCacheStats(Ice::Long&, Ice::Long&, Ice::Long&, Ice::Long&) const;
 
     void removeAdapter(const std::string&);
     AdapterPrx getAdapterProxy(const std::string&, const std::string&, bool);
@@ -134,11 +137,16 @@ public:
     std::string getAdapterApplication(const std::string&) const;
     std::string getAdapterNode(const std::string&) const;
     Ice::StringSeq getAllAdapters(const std::string& = std::string());
+    Ice::StringSeq getAdapterIdsPage(const std::string&, const std::string&, int);
 
     void addObject(const ObjectInfo&);
     void addOrUpdateObject(const ObjectInfo&, Ice::Long = 0);
     void removeObject(const Ice::Identity&, Ice::Long = 0);
     void updateObject(const Ice::ObjectPrx&);
+    void addObjects(const ObjectInfoSeq&);
+    void addOrUpdateObjects(const ObjectInfoSeq&, Ice::Long);
+    void updateObjects(const Ice::ObjectProxySeq&);
+    void removeObjects(const Ice::IdentitySeq&, Ice::Long = 0);
     int addOrUpdateRegistryWellKnownObjects(const ObjectInfoSeq&);
     int removeRegistryWellKnownObjects(const ObjectInfoSeq&);
 
@@ -155,6 +163,7 @@ public:
     ObjectInfo getObjectInfo(const Ice::Identity&);
     ObjectInfoSeq getObjectInfosByType(const std::string&);
     ObjectInfoSeq getAllObjectInfos(const std::string& = std::string());
+    ObjectInfoSeq getObjectInfosPage(const std::string&, const std::string&, int);
 
     void addInternalObject(const ObjectInfo&, bool = false);
     void removeInternalObject(const Ice::Identity&);
@@ -199,7 +208,14 @@ private:
     void addObject(const IceDB::ReadWriteTxn&, const ObjectInfo&, bool);
     void deleteObject(const IceDB::ReadWriteTxn&, const ObjectInfo&, bool);
 
+    void buildIndexes(const IceDB::ReadWriteTxn&);
+
+    void waitForAdapterUpdates();
+    void waitForAdapterUpdate(Ice::Long);
+    void finishAdapterUpdate();
+
     friend struct AddComponent;
+    friend class SetAdapterDirectProxyOperation;
 
     static const std::string _applicationDbName;
     static const std::string _objectDbName;
@@ -221,6 +237,7 @@ private:
     ObjectCache _objectCache;
     AllocatableObjectCache _allocatableObjectCache;
     ServerCache _serverCache;
+    LocatorCache _locatorCache;
 
     RegistryObserverTopicPtr _registryObserverTopic;
     NodeObserverTopicPtr _nodeObserverTopic;
@@ -230,20 +247,48 @@ private:
 
     IceUtilInternal::FileLock _dbLock;
     IceDB::Env _env;
+    const IceDB::GroupCommitPtr _groupCommit;
+
+    //
+    // The adapter updates committed with the group commit, observers
+    // are notified in the order of the updates.
+    //
+    Ice::Long _adapterUpdates;
+    Ice::Long _adapterUpdatesDone;
 
     StringApplicationInfoMap _applications;
 
     StringAdapterInfoMap _adapters;
     StringStringMap _adaptersByGroupId;
 
+    //
+    // The adapter ids, the replica group ids (with the ids of their
+    // adapters) and the stringified object identities, sorted to look
+    // up the ids matching an expression from its literal prefix.
+    //
+    StringStringMap _adapterIndex;
+
     IdentityObjectInfoMap _objects;
     StringIdentityMap _objectsByType;
+    StringIdentityMap _objectIndex;
 
     IdentityObjectInfoMap _internalObjects;
     StringIdentityMap _internalObjectsByType;
 
     StringLongMap _serials;
 
+    //
+    // The serials of the indexed databases when their index was last
+    // updated, an index is rebuilt if its serial doesn't match.
+    //
+    StringLongMap _indexSerials;
+
+    //
+    // The decoders used by the locator lookups to unmarshal the
+    // records without copying them.
+    //
+    IceUtil::UniquePtr<IceDB::DecoderPool> _decoders;
+
     RegistryPluginFacadeIPtr _pluginFacade;
 
     AdminSessionI* _lock;
@@ -18,30 +18,180 @@
 #include <deque>
 #include <fstream>
 
+#ifdef __linux
+#  include <sys/inotify.h>
+#  include <unistd.h>
+#  include <cstring>
+#endif
+
 using namespace std;
 using namespace IceGrid;
 
-FileCache::FileCache(const Ice::CommunicatorPtr& com) : 
-    _messageSizeMax(com->getProperties()->getPropertyAsIntWithDefault("Ice.MessageSizeMax", 1024) * 1024 - 256)
+namespace
+{
+
+//
+// The maximum number of open files and the time after which an
+// unused file is closed.
+//
+const size_t maxOpenFiles = 128;
+const IceUtil::Time openFileTimeout = IceUtil::Time::seconds(60);
+
+//
+// The maximum size of a batch of lines sent to a file observer, the
+// delay between the checks of the watched files (the lines appended
+// during this delay are sent together) and the interval between the
+// checks of the polled files.
+//
+const int maxBatchSize = 64 * 1024;
+const IceUtil::Time followDelay = IceUtil::Time::milliSeconds(200);
+const IceUtil::Time pollInterval = IceUtil::Time::seconds(1);
+
+#ifdef __linux
+const uint32_t watchEvents = IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF;
+#endif
+
+class FollowTask : public IceUtil::TimerTask
+{
+public:
+
+    FollowTask(const FileCachePtr& cache) : _cache(cache)
+    {
+    }
+
+    virtual void
+    runTimerTask()
+    {
+        _cache->checkFollowers();
+    }
+
+private:
+
+    const FileCachePtr _cache;
+};
+
+class LinesAddedCB : public virtual IceUtil::Shared
+{
+public:
+
+    LinesAddedCB(const FileCachePtr& cache, const Ice::Identity& id, Ice::Long pos, bool more) :
+        _cache(cache), _id(id), _pos(pos), _more(more)
+    {
+    }
+
+    void
+    response(bool follow)
+    {
+        _cache->linesSent(_id, _pos, follow, _more);
+    }
+
+    void
+    exception(const Ice::Exception&)
+    {
+        _cache->linesSent(_id, _pos, false, false);
+    }
+
+private:
+
+    const FileCachePtr _cache;
+    const Ice::Identity _id;
+    const Ice::Long _pos;
+    const bool _more;
+};
+
+}
+
+class FileCache::OpenFile : public IceUtil::Shared, public IceUtil::Mutex
 {
+public:
+
+    OpenFile(const string& file, const IceUtilInternal::structstat& buf) :
+        stream(IceUtilInternal::streamFilename(file).c_str()), // file is a UTF-8 string
+        position(-1),
+        _buf(buf)
+    {
+        if(stream.fail())
+        {
+            throw FileNotAvailableException("failed to open file `" + file + "'");
+        }
+    }
+
+    //
+    // Returns true if the file is still the open file, the file is
+    // re-opened if it was replaced (e.g.: by a log rotation).
+    //
+    bool
+    matches(const IceUtilInternal::structstat& buf) const
+    {
+#ifdef _WIN32
+        return buf.st_ctime == _buf.st_ctime;
+#else
+        return buf.st_ino == _buf.st_ino && buf.st_dev == _buf.st_dev;
+#endif
+    }
+
+    //
+    // Move the stream to the given position, the stream is only moved
+    // if it's not already at this position to keep its buffer.
+    //
+    void
+    seek(Ice::Long pos)
+    {
+        stream.clear();
+        if(position != pos)
+        {
+            stream.seekg(static_cast<streamoff>(pos), ios::beg);
+        }
+        position = -1;
+    }
+
+    ifstream stream;
+    Ice::Long position; // The position of the stream or -1 if unknown.
+
+private:
+
+    const IceUtilInternal::structstat _buf;
+};
+
+FileCache::FileCache(const Ice::CommunicatorPtr& com, const IceUtil::TimerPtr& timer) :
+    _messageSizeMax(com->getProperties()->getPropertyAsIntWithDefault("Ice.MessageSizeMax", 1024) * 1024 - 256),
+    _timer(timer),
+    _followTaskScheduled(false)
+{
+#ifdef __linux
+    //
+    // If inotify isn't available, the followed files are polled.
+    //
+    _inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
 }
 
-Ice::Long
-FileCache::getOffsetFromEnd(const string& file, int originalCount)
+FileCache::~FileCache()
 {
-    ifstream is(IceUtilInternal::streamFilename(file).c_str()); // file is a UTF-8 string
-    if(is.fail())
+#ifdef __linux
+    if(_inotifyFd >= 0)
     {
-        throw FileNotAvailableException("failed to open file `" + file + "'");
+        close(_inotifyFd);
     }
+#endif
+}
+
+Ice::Long
+FileCache::getOffsetFromEnd(const string& file, int originalCount)
+{
+    Ice::Long size;
+    OpenFilePtr openFile = open(file, size);
+    IceUtil::Mutex::Lock sync(*openFile);
+    ifstream& is = openFile->stream;
+    is.clear();
+    openFile->position = -1;
 
     if(originalCount < 0)
     {
         return 0;
     }
 
-    is.seekg(0, ios::end);
-    streampos endOfFile = is.tellg();
+    streampos endOfFile = static_cast<streamoff>(size);
     if(originalCount == 0)
     {
         return endOfFile;
@@ -141,21 +291,17 @@ FileCache::read(const string& file, Ice::Long offset, int size, Ice::Long& newOf
         throw FileNotAvailableException("maximum bytes per read request is too low");
     }
 
-    ifstream is(IceUtilInternal::streamFilename(file).c_str()); // file is a UTF-8 string
-    if(is.fail())
-    {
-        throw FileNotAvailableException("failed to open file `" + file + "'");
-    }
+    Ice::Long fileSize;
+    OpenFilePtr openFile = open(file, fileSize);
 
     //
     // Check if the requested offset is past the end of the file, if
     // that's the case return an empty sequence of lines and indicate
     // the EOF.
     //
-    is.seekg(0, ios::end);
-    if(offset >= is.tellg())
+    if(offset >= fileSize)
     {
-        newOffset = is.tellg();
+        newOffset = fileSize;
         lines = Ice::StringSeq();
         return true;
     }
@@ -163,9 +309,11 @@ FileCache::read(const string& file, Ice::Long offset, int size, Ice::Long& newOf
     //
     // Read lines from the file until we read enough or reached EOF.
     // 
+    IceUtil::Mutex::Lock sync(*openFile);
+    ifstream& is = openFile->stream;
     newOffset = offset;
     lines = Ice::StringSeq();
-    is.seekg(static_cast<streamoff>(offset), ios::beg);
+    openFile->seek(offset);
     int totalSize = 0;
     string line;
 
@@ -187,6 +335,12 @@ FileCache::read(const string& file, Ice::Long offset, int size, Ice::Long& newOf
             {
                 lines.push_back("");
             }
+
+            //
+            // The stream read the whole line, it's no longer at the
+            // returned offset.
+            //
+            openFile->position = -1;
             return false; // We didn't reach the end of file, we've just reached the size limit!
         }
 
@@ -205,6 +359,7 @@ FileCache::read(const string& file, Ice::Long offset, int size, Ice::Long& newOf
         else
         {
             newOffset = is.tellg();
+            openFile->position = newOffset;
         }
     }
 
@@ -216,3 +371,385 @@ FileCache::read(const string& file, Ice::Long offset, int size, Ice::Long& newOf
     return is.eof();
 }
 
+FileCache::OpenFilePtr
+FileCache::open(const string& file, Ice::Long& size)
+{
+    IceUtilInternal::structstat buf;
+    if(IceUtilInternal::stat(file, &buf) == -1)
+    {
+        throw FileNotAvailableException("failed to open file `" + file + "'");
+    }
+    size = static_cast<Ice::Long>(buf.st_size);
+
+#ifdef _WIN32
+    //
+    // An open stream doesn't share delete access on Windows, keeping
+    // the file open would prevent its rotation or removal.
+    //
+    return new OpenFile(file, buf);
+#else
+    const IceUtil::Time now = IceUtil::Time::now(IceUtil::Time::Monotonic);
+    {
+        IceUtil::Mutex::Lock sync(_mutex);
+
+        //
+        // Close the files which weren't used recently.
+        //
+        while(!_lru.empty() && now - _files[_lru.back()].lastUsed > openFileTimeout)
+        {
+            _files.erase(_lru.back());
+            _lru.pop_back();
+        }
+
+        map<string, Entry>::iterator p = _files.find(file);
+        if(p != _files.end())
+        {
+            if(p->second.file->matches(buf))
+            {
+                _lru.splice(_lru.begin(), _lru, p->second.lru);
+                p->second.lastUsed = now;
+                return p->second.file;
+            }
+            _lru.erase(p->second.lru);
+            _files.erase(p);
+        }
+    }
+
+    OpenFilePtr openFile = new OpenFile(file, buf);
+
+    IceUtil::Mutex::Lock sync(_mutex);
+    map<string, Entry>::iterator p = _files.find(file);
+    if(p == _files.end())
+    {
+        _lru.push_front(file);
+        Entry entry;
+        entry.lru = _lru.begin();
+        p = _files.insert(make_pair(file, entry)).first;
+
+        while(_files.size() > maxOpenFiles)
+        {
+            _files.erase(_lru.back());
+            _lru.pop_back();
+        }
+    }
+    else
+    {
+        _lru.splice(_lru.begin(), _lru, p->second.lru);
+    }
+    p->second.file = openFile;
+    p->second.lastUsed = now;
+    return openFile;
+#endif
+}
+
+void
+FileCache::follow(const string& file, Ice::Long pos, const InternalFileObserverPrx& observer)
+{
+    if(!observer)
+    {
+        throw FileNotAvailableException("no observer to follow file `" + file + "'");
+    }
+
+    Ice::Long size;
+    open(file, size); // Raises FileNotAvailableException if the file can't be opened.
+
+    IceUtil::Mutex::Lock sync(_mutex);
+    FollowerMap::iterator p = _followers.find(observer->ice_getIdentity());
+    if(p != _followers.end())
+    {
+        removeFollower(p);
+    }
+
+    //
+    // The follower is marked as changed to send the lines appended
+    // to the file since the given position.
+    //
+    Follower follower;
+    follower.path = file;
+    follower.pos = pos;
+    follower.observer = observer;
+    follower.changed = true;
+    follower.sending = false;
+    p = _followers.insert(make_pair(observer->ice_getIdentity(), follower)).first;
+    watch(file);
+
+    if(!_followTaskScheduled)
+    {
+        try
+        {
+            scheduleFollowTask();
+        }
+        catch(const IceUtil::Exception&)
+        {
+            removeFollower(p);
+            throw FileNotAvailableException("failed to follow file `" + file + "': shutting down");
+        }
+    }
+}
+
+void
+FileCache::unfollow(const InternalFileObserverPrx& observer)
+{
+    if(!observer)
+    {
+        return;
+    }
+
+    IceUtil::Mutex::Lock sync(_mutex);
+    FollowerMap::iterator p = _followers.find(observer->ice_getIdentity());
+    if(p != _followers.end())
+    {
+        removeFollower(p);
+    }
+}
+
+void
+FileCache::checkFollowers()
+{
+    vector<pair<Ice::Identity, Follower> > followers;
+    {
+        IceUtil::Mutex::Lock sync(_mutex);
+#ifdef __linux
+        if(_inotifyFd >= 0)
+        {
+            readWatchEvents();
+        }
+        else
+#endif
+        {
+            for(FollowerMap::iterator p = _followers.begin(); p != _followers.end(); ++p)
+            {
+                p->second.changed = true;
+            }
+        }
+
+        //
+        // Only one batch of lines is sent at a time to an observer,
+        // the next batch is read once the observer received it.
+        //
+        for(FollowerMap::iterator p = _followers.begin(); p != _followers.end(); ++p)
+        {
+            if(p->second.changed && !p->second.sending)
+            {
+                p->second.changed = false;
+                p->second.sending = true;
+                followers.push_back(*p);
+            }
+        }
+    }
+
+    for(vector<pair<Ice::Identity, Follower> >::const_iterator p = followers.begin(); p != followers.end(); ++p)
+    {
+        Ice::Long newPos = p->second.pos;
+        Ice::StringSeq lines;
+        bool eof = true;
+        try
+        {
+            eof = read(p->second.path, p->second.pos, maxBatchSize, newPos, lines);
+        }
+        catch(const FileNotAvailableException&)
+        {
+            //
+            // The file was removed, it's read again once re-created.
+            //
+        }
+
+        if(lines.empty())
+        {
+            linesSent(p->first, newPos, true, false);
+            continue;
+        }
+
+        try
+        {
+            p->second.observer->begin_linesAdded(lines, newPos,
+                newCallback_InternalFileObserver_linesAdded(new LinesAddedCB(this, p->first, newPos, !eof),
+                                                            &LinesAddedCB::response,
+                                                            &LinesAddedCB::exception));
+        }
+        catch(const Ice::LocalException&)
+        {
+            linesSent(p->first, newPos, false, false);
+        }
+    }
+
+    IceUtil::Mutex::Lock sync(_mutex);
+    _followTaskScheduled = false;
+    if(!_followers.empty())
+    {
+        try
+        {
+            scheduleFollowTask();
+        }
+        catch(const IceUtil::Exception&)
+        {
+            // Ignore, the timer is destroyed on shutdown.
+        }
+    }
+}
+
+void
+FileCache::linesSent(const Ice::Identity& id, Ice::Long pos, bool follow, bool more)
+{
+    IceUtil::Mutex::Lock sync(_mutex);
+    FollowerMap::iterator p = _followers.find(id);
+    if(p == _followers.end() || !p->second.sending)
+    {
+        return;
+    }
+
+    if(!follow)
+    {
+        removeFollower(p);
+        return;
+    }
+
+    p->second.pos = pos;
+    p->second.sending = false;
+    if(more)
+    {
+        p->second.changed = true; // The lines weren't all sent, send the next batch.
+    }
+}
+
+void
+FileCache::removeFollower(FollowerMap::iterator p)
+{
+    string path = p->second.path;
+    _followers.erase(p);
+    for(p = _followers.begin(); p != _followers.end(); ++p)
+    {
+        if(p->second.path == path)
+        {
+            return;
+        }
+    }
+    unwatch(path);
+}
+
+void
+FileCache::scheduleFollowTask()
+{
+#ifdef __linux
+    _timer->schedule(new FollowTask(this), _inotifyFd >= 0 ? followDelay : pollInterval);
+#else
+    _timer->schedule(new FollowTask(this), pollInterval);
+#endif
+    _followTaskScheduled = true;
+}
+
+#ifdef __linux
+
+void
+FileCache::watch(const string& path)
+{
+    if(_inotifyFd < 0 || _watchedPaths.find(path) != _watchedPaths.end())
+    {
+        return;
+    }
+
+    int wd = inotify_add_watch(_inotifyFd, path.c_str(), watchEvents);
+    _watchedPaths[path] = wd;
+    if(wd >= 0)
+    {
+        _watches[wd].insert(path);
+    }
+}
+
+void
+FileCache::unwatch(const string& path)
+{
+    map<string, int>::iterator p = _watchedPaths.find(path);
+    if(p == _watchedPaths.end())
+    {
+        return;
+    }
+
+    map<int, set<string> >::iterator q = _watches.find(p->second);
+    if(q != _watches.end())
+    {
+        q->second.erase(path);
+        if(q->second.empty())
+        {
+            inotify_rm_watch(_inotifyFd, q->first);
+            _watches.erase(q);
+        }
+    }
+    _watchedPaths.erase(p);
+}
+
+void
+FileCache::readWatchEvents()
+{
+    set<string> changed;
+    char buffer[4096];
+    ssize_t n;
+    while((n = ::read(_inotifyFd, buffer, sizeof(buffer))) > 0)
+    {
+        for(const char* p = buffer; p < buffer + n;)
+        {
+            struct inotify_event event;
+            memcpy(&event, p, sizeof(event)); // The buffer isn't aligned.
+            p += sizeof(event) + event.len;
+
+            map<int, set<string> >::iterator q = _watches.find(event.wd);
+            if(q == _watches.end())
+            {
+                continue;
+            }
+
+            changed.insert(q->second.begin(), q->second.end());
+            if(event.mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED))
+            {
+                //
+                // The file was rotated or removed, the path is
+                // watched again once the file is re-created.
+                //
+                if(!(event.mask & IN_IGNORED))
+                {
+                    inotify_rm_watch(_inotifyFd, event.wd);
+                }
+                for(set<string>::const_iterator r = q->second.begin(); r != q->second.end(); ++r)
+                {
+                    _watchedPaths[*r] = -1;
+                }
+                _watches.erase(q);
+            }
+        }
+    }
+
+    for(map<string, int>::iterator p = _watchedPaths.begin(); p != _watchedPaths.end(); ++p)
+    {
+        if(p->second < 0)
+        {
+            p->second = inotify_add_watch(_inotifyFd, p->first.c_str(), watchEvents);
+            if(p->second >= 0)
+            {
+                _watches[p->second].insert(p->first);
+            }
+            changed.insert(p->first); // Poll the file until it's watched.
+        }
+    }
+
+    for(FollowerMap::iterator p = _followers.begin(); p != _followers.end(); ++p)
+    {
+        if(changed.find(p->second.path) != changed.end())
+        {
+            p->second.changed = true;
+        }
+    }
+}
+
+#else
+
+void
+FileCache::watch(const string&)
+{
+}
+
+void
+FileCache::unwatch(const string&)
+{
+}
+
+#endif
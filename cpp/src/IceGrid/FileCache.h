@@ -11,24 +11,95 @@
 #define ICE_GRID_FILE_CACHE_H
 
 #include <IceUtil/Shared.h>
+#include <IceUtil/Handle.h>
+#include <IceUtil/Mutex.h>
+#include <IceUtil/Time.h>
+#include <IceUtil/Timer.h>
 #include <Ice/BuiltinSequences.h>
 #include <Ice/CommunicatorF.h>
+#include <IceGrid/Internal.h>
+
+#include <list>
+#include <map>
+#include <set>
 
 namespace IceGrid
 {
 
+//
+// The file cache keeps the most recently read files open with their
+// read position, so that the clients following a file (such as the
+// admin tools tailing the server output) don't re-open and seek the
+// file on each read. A read costs a single stat of the file if
+// nothing was appended to the file since the last read. The files
+// aren't kept open on Windows.
+//
+// The cache also sends the lines appended to the followed files in
+// batches to their observers. The files are watched with inotify on
+// Linux and polled on the other platforms.
+//
 class FileCache : public IceUtil::Shared
 {
 public:
 
-    FileCache(const Ice::CommunicatorPtr&);
+    FileCache(const Ice::CommunicatorPtr&, const IceUtil::TimerPtr&);
+    virtual ~FileCache();
 
     Ice::Long getOffsetFromEnd(const std::string&, int);
     bool read(const std::string&, Ice::Long, int, Ice::Long&, Ice::StringSeq&);
 
+    void follow(const std::string&, Ice::Long, const InternalFileObserverPrx&);
+    void unfollow(const InternalFileObserverPrx&);
+
+    void checkFollowers();
+    void linesSent(const Ice::Identity&, Ice::Long, bool, bool);
+
 private:
 
+    class OpenFile;
+    typedef IceUtil::Handle<OpenFile> OpenFilePtr;
+
+    OpenFilePtr open(const std::string&, Ice::Long&);
+
+    struct Follower
+    {
+        std::string path;
+        Ice::Long pos;
+        InternalFileObserverPrx observer;
+        bool changed; // True if the file might have changed since the last read.
+        bool sending; // True if lines are being sent to the observer.
+    };
+    typedef std::map<Ice::Identity, Follower> FollowerMap;
+
+    void removeFollower(FollowerMap::iterator);
+    void scheduleFollowTask();
+    void watch(const std::string&);
+    void unwatch(const std::string&);
+#ifdef __linux
+    void readWatchEvents();
+#endif
+
+    struct Entry
+    {
+        OpenFilePtr file;
+        IceUtil::Time lastUsed;
+        std::list<std::string>::iterator lru;
+    };
+
     const int _messageSizeMax;
+
+    IceUtil::Mutex _mutex;
+    std::map<std::string, Entry> _files;
+    std::list<std::string> _lru; // The most recently used file first.
+
+    const IceUtil::TimerPtr _timer;
+    FollowerMap _followers;
+    bool _followTaskScheduled;
+#ifdef __linux
+    int _inotifyFd;
+    std::map<int, std::set<std::string> > _watches;
+    std::map<std::string, int> _watchedPaths; // The watch descriptor or -1 if the file isn't watched.
+#endif
 };
 typedef IceUtil::Handle<FileCache> FileCachePtr;
 
@@ -29,13 +29,14 @@ using namespace IceGrid;
 InternalRegistryI::InternalRegistryI(const RegistryIPtr& registry,
                                      const DatabasePtr& database, 
                                      const ReapThreadPtr& reaper,
+                                     const IceUtil::TimerPtr& timer,
                                      const WellKnownObjectsManagerPtr& wellKnownObjects,
                                      ReplicaSessionManager& session) : 
     _registry(registry),
     _database(database),
     _reaper(reaper),
     _wellKnownObjects(wellKnownObjects),
-    _fileCache(new FileCache(database->getCommunicator())),
+    _fileCache(new FileCache(database->getCommunicator(), timer)),
     _session(session)
 {
     Ice::PropertiesPtr properties = database->getCommunicator()->getProperties();
@@ -251,6 +252,18 @@ InternalRegistryI::read(const string& filename, Ice::Long pos, int size, Ice::Lo
     return _fileCache->read(getFilePath(filename), pos, size, newPos, lines);
 }
 
+void
+InternalRegistryI::followFile(const string& filename, Ice::Long pos, const InternalFileObserverPrx& observer, const Ice::Current&)
+{
+    _fileCache->follow(getFilePath(filename), pos, observer);
+}
+
+void
+InternalRegistryI::unfollowFile(const InternalFileObserverPrx& observer, const Ice::Current&)
+{
+    _fileCache->unfollow(observer);
+}
+
 string
 InternalRegistryI::getFilePath(const string& filename) const
 {
@@ -10,6 +10,7 @@
 #ifndef ICE_GRID_INTERNALREGISTRYI_H
 #define ICE_GRID_INTERNALREGISTRYI_H
 
+#include <IceUtil/Timer.h>
 #include <IceGrid/Registry.h>
 #include <IceGrid/Internal.h>
 
@@ -37,7 +38,7 @@ class InternalRegistryI : public InternalRegistry
 {
 public:
 
-    InternalRegistryI(const RegistryIPtr&, const DatabasePtr&, const ReapThreadPtr&, 
+    InternalRegistryI(const RegistryIPtr&, const DatabasePtr&, const ReapThreadPtr&, const IceUtil::TimerPtr&,
                       const WellKnownObjectsManagerPtr&, ReplicaSessionManager&);
     virtual ~InternalRegistryI();
 
@@ -59,6 +60,8 @@ public:
 
     virtual Ice::Long getOffsetFromEnd(const std::string&, int, const Ice::Current&) const;
     virtual bool read(const std::string&, Ice::Long, int, Ice::Long&, Ice::StringSeq&, const Ice::Current&) const;
+    virtual void followFile(const std::string&, Ice::Long, const InternalFileObserverPrx&, const Ice::Current&);
+    virtual void unfollowFile(const InternalFileObserverPrx&, const Ice::Current&);
 
 private:    
 
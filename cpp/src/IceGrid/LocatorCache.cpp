@@ -0,0 +1,171 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#include <IceGrid/LocatorCache.h>
+
+using namespace std;
+using namespace IceGrid;
+
+LocatorCache::LocatorCache(size_t size) :
+    _shardSize(size > 0 ? (size + shardCount - 1) / shardCount : 0)
+{
+}
+
+bool
+LocatorCache::getObject(const Ice::Identity& id, Ice::ObjectPrx& proxy, Ice::Long& version)
+{
+    if(_shardSize == 0)
+    {
+        return false;
+    }
+
+    Shard& shard = getShard(id.name);
+    IceUtil::Mutex::Lock sync(shard.mutex);
+    if(!shard.objects.get(id, proxy))
+    {
+        ++shard.misses;
+        version = shard.version;
+        return false;
+    }
+    ++shard.hits;
+    return true;
+}
+
+void
+LocatorCache::addObject(const Ice::Identity& id, const Ice::ObjectPrx& proxy, Ice::Long version)
+{
+    if(_shardSize == 0)
+    {
+        return;
+    }
+
+    Shard& shard = getShard(id.name);
+    IceUtil::Mutex::Lock sync(shard.mutex);
+    if(shard.version != version)
+    {
+        return; // The proxy might be stale.
+    }
+    if(shard.objects.add(id, proxy, _shardSize))
+    {
+        ++shard.evictions;
+    }
+}
+
+void
+LocatorCache::removeObject(const Ice::Identity& id)
+{
+    if(_shardSize == 0)
+    {
+        return;
+    }
+
+    Shard& shard = getShard(id.name);
+    IceUtil::Mutex::Lock sync(shard.mutex);
+    shard.objects.remove(id);
+    ++shard.version;
+}
+
+bool
+LocatorCache::getAdapter(const string& id, Ice::ObjectPrx& proxy, Ice::Long& version)
+{
+    if(_shardSize == 0)
+    {
+        return false;
+    }
+
+    Shard& shard = getShard(id);
+    IceUtil::Mutex::Lock sync(shard.mutex);
+    if(!shard.adapters.get(id, proxy))
+    {
+        ++shard.misses;
+        version = shard.version;
+        return false;
+    }
+    ++shard.hits;
+    return true;
+}
+
+void
+LocatorCache::addAdapter(const string& id, const Ice::ObjectPrx& proxy, Ice::Long version)
+{
+    if(_shardSize == 0)
+    {
+        return;
+    }
+
+    Shard& shard = getShard(id);
+    IceUtil::Mutex::Lock sync(shard.mutex);
+    if(shard.version != version)
+    {
+        return; // The proxy might be stale.
+    }
+    if(shard.adapters.add(id, proxy, _shardSize))
+    {
+        ++shard.evictions;
+    }
+}
+
+void
+LocatorCache::removeAdapter(const string& id)
+{
+    if(_shardSize == 0)
+    {
+        return;
+    }
+
+    Shard& shard = getShard(id);
+    IceUtil::Mutex::Lock sync(shard.mutex);
+    shard.adapters.remove(id);
+    ++shard.version;
+}
+
+void
+LocatorCache::clear()
+{
+    if(_shardSize == 0)
+    {
+        return;
+    }
+
+    for(size_t i = 0; i < shardCount; ++i)
+    {
+        IceUtil::Mutex::Lock sync(_shards[i].mutex);
+        _shards[i].objects.clear();
+        _shards[i].adapters.clear();
+        ++_shards[i].version;
+    }
+}
+
+void
+LocatorCache::getStats(Ice::Long& hits, Ice::Long& misses, Ice::Long& evictions, Ice::Long& size) const
+{
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+    size = 0;
+    for(size_t i = 0; i < shardCount; ++i)
+    {
+        IceUtil::Mutex::Lock sync(_shards[i].mutex);
+        hits += _shards[i].hits;
+        misses += _shards[i].misses;
+        evictions += _shards[i].evictions;
+        size += static_cast<Ice::Long>(_shards[i].objects.size() + _shards[i].adapters.size());
+    }
+}
+
+LocatorCache::Shard&
+LocatorCache::getShard(const string& key)
+{
+    size_t h = 0;
+    for(string::const_iterator p = key.begin(); p != key.end(); ++p)
+    {
+        h = h * 31 + static_cast<unsigned char>(*p);
+    }
+    return _shards[h % shardCount];
+}
@@ -0,0 +1,179 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#ifndef ICE_GRID_LOCATORCACHE_H
+#define ICE_GRID_LOCATORCACHE_H
+
+#include <IceUtil/Mutex.h>
+#include <Ice/Identity.h>
+#include <Ice/Proxy.h>
+
+#include <list>
+#include <map>
+
+namespace IceGrid
+{
+
+//
+// The locator cache keeps the proxies of the well-known objects and
+// of the dynamically registered adapters resolved by the locator, to
+// avoid the database lookups.
+//
+// The cache is split in shards with their own mutex and version. The
+// version of a shard is incremented each time an entry is removed:
+// a proxy is only added to the cache if the shard version didn't
+// change since the lookup that missed, so a proxy resolved before an
+// update is never added after the update. Once a shard is full, its
+// least recently used entry is evicted to add a new entry.
+//
+class LocatorCache : public IceUtil::noncopyable
+{
+public:
+
+    //
+    // The maximum number of entries of the cache, 0 disables the
+    // cache.
+    //
+    LocatorCache(size_t);
+
+    //
+    // Get the cached proxy. On a miss, the version to provide to
+    // addObject/addAdapter is returned.
+    //
+    bool getObject(const Ice::Identity&, Ice::ObjectPrx&, Ice::Long&);
+    void addObject(const Ice::Identity&, const Ice::ObjectPrx&, Ice::Long);
+    void removeObject(const Ice::Identity&);
+
+    bool getAdapter(const std::string&, Ice::ObjectPrx&, Ice::Long&);
+    void addAdapter(const std::string&, const Ice::ObjectPrx&, Ice::Long);
+    void removeAdapter(const std::string&);
+
+    void clear();
+
+    //
+    // Get the number of hits, misses and evictions and the number of
+    // cached entries.
+    //
+    void getStats(Ice::Long&, Ice::Long&, Ice::Long&, Ice::Long&) const;
+
+private:
+
+    //
+    // The entries of a shard, ordered from the most recently used to
+    // the least recently used.
+    //
+    template<typename K> class Entries
+    {
+    public:
+
+        bool
+        get(const K& key, Ice::ObjectPrx& proxy)
+        {
+            typename std::map<K, Entry>::iterator p = _entries.find(key);
+            if(p == _entries.end())
+            {
+                return false;
+            }
+            _lru.splice(_lru.begin(), _lru, p->second.lru);
+            proxy = p->second.proxy;
+            return true;
+        }
+
+        //
+        // Returns true if the least recently used entry was evicted
+        // to add the entry.
+        //
+        bool
+        add(const K& key, const Ice::ObjectPrx& proxy, size_t max)
+        {
+            typename std::map<K, Entry>::iterator p = _entries.find(key);
+            if(p != _entries.end())
+            {
+                _lru.splice(_lru.begin(), _lru, p->second.lru);
+                p->second.proxy = proxy;
+                return false;
+            }
+
+            bool evicted = false;
+            if(_entries.size() >= max)
+            {
+                _entries.erase(_lru.back());
+                _lru.pop_back();
+                evicted = true;
+            }
+            _lru.push_front(key);
+            Entry entry;
+            entry.proxy = proxy;
+            entry.lru = _lru.begin();
+            _entries.insert(std::make_pair(key, entry));
+            return evicted;
+        }
+
+        void
+        remove(const K& key)
+        {
+            typename std::map<K, Entry>::iterator p = _entries.find(key);
+            if(p != _entries.end())
+            {
+                _lru.erase(p->second.lru);
+                _entries.erase(p);
+            }
+        }
+
+        void
+        clear()
+        {
+            _entries.clear();
+            _lru.clear();
+        }
+
+        size_t
+        size() const
+        {
+            return _entries.size();
+        }
+
+    private:
+
+        struct Entry
+        {
+            Ice::ObjectPrx proxy;
+            typename std::list<K>::iterator lru;
+        };
+
+        std::map<K, Entry> _entries;
+        std::list<K> _lru;
+    };
+
+    struct Shard
+    {
+        Shard() : version(0), hits(0), misses(0), evictions(0)
+        {
+        }
+
+        IceUtil::Mutex mutex;
+        Entries<Ice::Identity> objects;
+        Entries<std::string> adapters;
+        Ice::Long version;
+        Ice::Long hits;
+        Ice::Long misses;
+        Ice::Long evictions;
+    };
+
+    static const size_t shardCount = 16;
+
+    Shard& getShard(const std::string&);
+
+    const size_t _shardSize;
+    Shard _shards[shardCount];
+};
+
+}
+
+#endif
@@ -17,6 +17,23 @@
 using namespace std;
 using namespace IceGrid;
 
+namespace
+{
+
+//
+// The period over which the on-demand activations of a replica group
+// members are counted to size its standby replicas.
+//
+const IceUtil::Time standbyPeriod = IceUtil::Time::seconds(60);
+
+//
+// The minimum period between two activations of the standby replicas
+// of a replica group when it's resolved.
+//
+const IceUtil::Time standbyCheckPeriod = IceUtil::Time::seconds(1);
+
+}
+
 namespace IceGrid
 {
 
@@ -302,8 +319,10 @@ public:
     }
 
     virtual void
-    activating(const string&)
+    activating(const string& id)
     {
+        _locator->activateStandbyReplicas(_id, id, _adapters);
+
         //
         // An adapter is being activated. Don't wait for the activation to complete. Instead,
         // we query the next adapter which might be already active.
@@ -457,6 +476,57 @@ private:
     IceUtil::UniquePtr<Ice::Exception> _exception;
 };
 
+//
+// Request used to activate the standby replicas of a replica group:
+// no client waits for the replicas.
+//
+class StandbyRequest : public LocatorI::Request
+{
+public:
+
+    StandbyRequest(const TraceLevelsPtr& traceLevels, const string& id) :
+        _traceLevels(traceLevels),
+        _id(id)
+    {
+    }
+
+    virtual void
+    execute()
+    {
+    }
+
+    virtual void
+    activating(const string& id)
+    {
+        if(_traceLevels->locator > 1)
+        {
+            Ice::Trace out(_traceLevels->logger, _traceLevels->locatorCat);
+            out << "activating standby replica `" << id << "' of replica group `" << _id << "'";
+        }
+    }
+
+    virtual void
+    response(const string&, const Ice::ObjectPrx&)
+    {
+    }
+
+    virtual void
+    exception(const string& id, const Ice::Exception& ex)
+    {
+        if(_traceLevels->locator > 1)
+        {
+            Ice::Trace out(_traceLevels->logger, _traceLevels->locatorCat);
+            out << "couldn't activate standby replica `" << id << "' of replica group `" << _id << "':\n";
+            out << toString(ex);
+        }
+    }
+
+private:
+
+    const TraceLevelsPtr _traceLevels;
+    const string _id;
+};
+
 class RoundRobinRequest : public LocatorI::Request, SynchronizationCallback, public IceUtil::Mutex
 {
 public:
@@ -508,6 +578,13 @@ public:
     virtual void
     activating(const string& id)
     {
+        LocatorAdapterInfoSeq adapters;
+        {
+            Lock sync(*this);
+            adapters = _adapters;
+        }
+        _locator->activateStandbyReplicas(_id, id, adapters);
+
         LocatorAdapterInfo adapter;
         adapter.id = id;
         do
@@ -821,7 +898,8 @@ LocatorI::LocatorI(const Ice::CommunicatorPtr& communicator,
     _database(database),
     _wellKnownObjects(wellKnownObjects),
     _localRegistry(registry),
-    _localQuery(query)
+    _localQuery(query),
+    _standbyReplicas(communicator->getProperties()->getPropertyAsInt("IceGrid.Registry.StandbyReplicas"))
 {
 }
 
@@ -853,6 +931,17 @@ LocatorI::findAdapterById_async(const Ice::AMD_Locator_findAdapterByIdPtr& cb,
                                 const string& id,
                                 const Ice::Current& current) const
 {
+    //
+    // The direct proxies of the adapters registered with the locator
+    // registry are cached.
+    //
+    Ice::ObjectPrx proxy;
+    if(_database->getCachedAdapterDirectProxy(id, proxy))
+    {
+        cb->ice_response(proxy);
+        return;
+    }
+
     LocatorIPtr self = const_cast<LocatorI*>(this);
     bool replicaGroup = false;
     try
@@ -897,6 +986,11 @@ LocatorI::findAdapterById_async(const Ice::AMD_Locator_findAdapterByIdPtr& cb,
             request = new AdapterRequest(cb, self, current.encoding, adapters[0]);
         }
         request->execute();
+
+        if(roundRobin || replicaGroup)
+        {
+            self->activateStandbyReplicas(id, "", adapters);
+        }
         return;
     }
     catch(const AdapterNotExistException&)
@@ -995,6 +1089,7 @@ LocatorI::getDirectProxyResponse(const LocatorAdapterInfo& adapter, const Ice::O
         requests.swap(p->second);
         _pendingRequests.erase(p);
         _activating.erase(adapter.id);
+        _counted.erase(adapter.id);
     }
 
     if(proxy)
@@ -1044,6 +1139,7 @@ LocatorI::getDirectProxyException(const LocatorAdapterInfo& adapter, const Ice::
             requests.swap(p->second);
             _pendingRequests.erase(p);
             _activating.erase(adapter.id);
+            _counted.erase(adapter.id);
         }
     }
 
@@ -1068,3 +1164,86 @@ LocatorI::getDirectProxyException(const LocatorAdapterInfo& adapter, const Ice::
         }
     }
 }
+
+void
+LocatorI::activateStandbyReplicas(const string& replicaGroup, const string& id, const LocatorAdapterInfoSeq& adapters)
+{
+    if(_standbyReplicas <= 0)
+    {
+        return;
+    }
+
+    //
+    // Each on-demand activation of a replica group member over the
+    // standby period requires another standby replica, up to the
+    // configured maximum. The standby replicas are activated with each
+    // on-demand activation of a member, given by its adapter id, and
+    // when the replica group is resolved, at most once per check
+    // period, to activate again the standby replicas which were
+    // deactivated since.
+    //
+    size_t standby;
+    set<string> excludes;
+    {
+        Lock sync(*this);
+        IceUtil::Time now = IceUtil::Time::now(IceUtil::Time::Monotonic);
+
+        //
+        // Count the activation once, the adapter activation is
+        // reported to each request waiting for the adapter.
+        //
+        map<string, StandbyInfo>::iterator p = _standby.find(replicaGroup);
+        if(!id.empty() && _activating.find(id) != _activating.end() && _counted.insert(id).second)
+        {
+            if(p == _standby.end())
+            {
+                p = _standby.insert(make_pair(replicaGroup, StandbyInfo())).first;
+            }
+            p->second.activations.push_back(now);
+        }
+        else if(p == _standby.end() || now - p->second.activated < standbyCheckPeriod)
+        {
+            return;
+        }
+
+        deque<IceUtil::Time>& activations = p->second.activations;
+        while(!activations.empty() && now - activations.front() > standbyPeriod)
+        {
+            activations.pop_front();
+        }
+        if(activations.empty())
+        {
+            _standby.erase(p);
+            return;
+        }
+        p->second.activated = now;
+        standby = min(activations.size(), static_cast<size_t>(_standbyReplicas));
+
+        if(!id.empty())
+        {
+            excludes.insert(id);
+        }
+        for(PendingRequestsMap::const_iterator q = _pendingRequests.begin(); q != _pendingRequests.end(); ++q)
+        {
+            excludes.insert(q->first);
+        }
+    }
+
+    //
+    // Activate the next replicas of the replica group which aren't
+    // already being queried or activated. The replicas which are
+    // already active just return their proxy.
+    //
+    RequestPtr request = new StandbyRequest(getTraceLevels(), replicaGroup);
+    for(LocatorAdapterInfoSeq::const_iterator p = adapters.begin(); p != adapters.end() && standby > 0; ++p)
+    {
+        if(p->proxy && excludes.find(p->id) == excludes.end())
+        {
+            if(getDirectProxy(*p, request))
+            {
+                request->activating(p->id);
+            }
+            --standby;
+        }
+    }
+}
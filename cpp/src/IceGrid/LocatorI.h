@@ -13,6 +13,7 @@
 #include <IceGrid/Internal.h>
 #include <IceGrid/Registry.h>
 
+#include <deque>
 #include <set>
 
 namespace IceGrid
@@ -68,6 +69,8 @@ public:
     void getDirectProxyResponse(const LocatorAdapterInfo&, const Ice::ObjectPrx&);
     void getDirectProxyException(const LocatorAdapterInfo&, const Ice::Exception&);
 
+    void activateStandbyReplicas(const std::string&, const std::string&, const LocatorAdapterInfoSeq&);
+
 protected:
 
     const Ice::CommunicatorPtr _communicator;
@@ -80,6 +83,26 @@ protected:
     typedef std::map<std::string, PendingRequests> PendingRequestsMap;
     PendingRequestsMap _pendingRequests;
     std::set<std::string> _activating;
+
+    //
+    // The times of the on-demand activations of the members of a
+    // replica group over the standby period and the last time its
+    // standby replicas were activated.
+    //
+    struct StandbyInfo
+    {
+        std::deque<IceUtil::Time> activations;
+        IceUtil::Time activated;
+    };
+
+    //
+    // The maximum number of standby replicas of a replica group, the
+    // standby information by replica group and the activating adapters
+    // whose activation is already counted.
+    //
+    const int _standbyReplicas;
+    std::map<std::string, StandbyInfo> _standby;
+    std::set<std::string> _counted;
 };
 
 }
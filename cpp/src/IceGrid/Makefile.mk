@@ -33,6 +33,7 @@ local_registry_srcs 	= Internal.ice \
 			  DescriptorHelper.cpp \
 			  FileUserAccountMapperI.cpp \
 			  InternalRegistryI.cpp \
+			  LocatorCache.cpp \
 			  LocatorI.cpp \
 			  LocatorRegistryI.cpp \
 			  NodeCache.cpp \
@@ -182,8 +182,10 @@ class LoadCB : public virtual IceUtil::Shared
 {
 public:
 
-    LoadCB(const TraceLevelsPtr& traceLevels, const ServerEntryPtr& server, const string& node, int timeout) :
-        _traceLevels(traceLevels), _server(server), _id(server->getId()), _node(node), _timeout(timeout)
+    LoadCB(const TraceLevelsPtr& traceLevels, const NodeEntryPtr& entry, const ServerEntryPtr& server,
+           const string& node, int timeout) :
+        _traceLevels(traceLevels), _entry(entry), _server(server), _id(server->getId()), _node(node),
+        _timeout(timeout)
     {
     }
 
@@ -201,6 +203,7 @@ public:
         // timeout is large enough.
         //
         _server->loadCallback(server, adapters, at + _timeout, dt + _timeout);
+        _entry->finishedServerCommand(false);
     }
 
     void
@@ -234,11 +237,13 @@ public:
             os << ex;
             _server->exception(NodeUnreachableException(_node, os.str()));
         }
+        _entry->finishedServerCommand(false);
     }
 
 private:
 
     const TraceLevelsPtr _traceLevels;
+    const NodeEntryPtr _entry;
     const ServerEntryPtr _server;
     const string _id;
     const string _node;
@@ -249,8 +254,9 @@ class DestroyCB : public virtual IceUtil::Shared
 {
 public:
 
-    DestroyCB(const TraceLevelsPtr& traceLevels, const ServerEntryPtr& server, const string& node) :
-        _traceLevels(traceLevels), _server(server), _id(server->getId()), _node(node)
+    DestroyCB(const TraceLevelsPtr& traceLevels, const NodeEntryPtr& entry, const ServerEntryPtr& server,
+              const string& node) :
+        _traceLevels(traceLevels), _entry(entry), _server(server), _id(server->getId()), _node(node)
     {
     }
 
@@ -263,6 +269,7 @@ public:
             out << "unloaded `" << _id << "' on node `" << _node << "'";
         }
         _server->destroyCallback();
+        _entry->finishedServerCommand(true);
     }
 
     void
@@ -295,11 +302,13 @@ public:
             os << ex;
             _server->exception(NodeUnreachableException(_node, os.str()));
         }
+        _entry->finishedServerCommand(true);
     }
 
 private:
 
     const TraceLevelsPtr _traceLevels;
+    const NodeEntryPtr _entry;
     const ServerEntryPtr _server;
     const string _id;
     const string _node;
@@ -312,6 +321,20 @@ NodeCache::NodeCache(const Ice::CommunicatorPtr& communicator, ReplicaCache& rep
     _replicaName(replicaName),
     _replicaCache(replicaCache)
 {
+    //
+    // The load samples pushed by the nodes with their keep alive
+    // messages are considered unknown once older than this timeout.
+    //
+    Ice::PropertiesPtr properties = communicator->getProperties();
+    int timeout = properties->getPropertyAsIntWithDefault("IceGrid.Registry.NodeSessionTimeout", 30);
+    timeout = properties->getPropertyAsIntWithDefault("IceGrid.Registry.LoadInfoTimeout", timeout);
+    _loadInfoTimeout = IceUtil::Time::seconds(timeout);
+
+    //
+    // The maximum number of load or destroy commands sent to a node
+    // and not completed yet, 0 or less for no limit.
+    //
+    _deploymentParallelism = properties->getPropertyAsIntWithDefault("IceGrid.Registry.DeploymentParallelism", 16);
 }
 
 NodeEntryPtr
@@ -338,6 +361,8 @@ NodeEntry::NodeEntry(NodeCache& cache, const std::string& name) :
     _cache(cache),
     _ref(0),
     _name(name),
+    _inFlight(0),
+    _destroying(0),
     _registering(false)
 {
 }
@@ -350,7 +375,19 @@ void
 NodeEntry::addDescriptor(const string& application, const NodeDescriptor& descriptor)
 {
     Lock sync(*this);
-    _descriptors.insert(make_pair(application, descriptor));
+    if(_descriptors.insert(make_pair(application, descriptor)).second)
+    {
+        float loadFactor = -1.0f;
+        if(!descriptor.loadFactor.empty())
+        {
+            istringstream is(descriptor.loadFactor);
+            if(!(is >> loadFactor))
+            {
+                loadFactor = -1.0f;
+            }
+        }
+        _loadFactors[application] = loadFactor;
+    }
 }
 
 void
@@ -358,6 +395,7 @@ NodeEntry::removeDescriptor(const string& application)
 {
     Lock sync(*this);
     _descriptors.erase(application);
+    _loadFactors.erase(application);
 }
 
 void
@@ -488,22 +526,13 @@ NodeEntry::getLoadInfoAndLoadFactor(const string& application, float& loadFactor
     Lock sync(*this);
     checkSession();
 
-    map<string, NodeDescriptor>::const_iterator p = _descriptors.find(application);
-    if(p == _descriptors.end())
+    map<string, float>::const_iterator p = _loadFactors.find(application);
+    if(p == _loadFactors.end())
     {
         throw NodeNotExistException(); // The node doesn't exist in the given application.
     }
 
-    //
-    // TODO: Cache the load factors? Parsing the load factor for each
-    // call could be costly.
-    //
-    loadFactor = -1.0f;
-    if(!p->second.loadFactor.empty())
-    {
-        istringstream is(p->second.loadFactor);
-        is >> loadFactor;
-    }
+    loadFactor = p->second;
     if(loadFactor < 0.0f)
     {
         if(_session->getInfo()->os != "Windows")
@@ -527,7 +556,20 @@ NodeEntry::getLoadInfoAndLoadFactor(const string& application, float& loadFactor
         }
     }
 
-    return _session->getLoadInfo();
+    //
+    // The load is the last sample pushed by the node with its keep
+    // alive message, it's unknown if the sample is too old.
+    //
+    IceUtil::Time timestamp;
+    LoadInfo load = _session->getLoadInfo(timestamp);
+    const IceUtil::Time& timeout = _cache.getLoadInfoTimeout();
+    if(timeout > IceUtil::Time() && IceUtil::Time::now(IceUtil::Time::Monotonic) - timestamp > timeout)
+    {
+        load.avg1 = -1.0f;
+        load.avg5 = -1.0f;
+        load.avg15 = -1.0f;
+    }
+    return load;
 }
 
 NodeSessionIPtr
@@ -559,6 +601,146 @@ NodeEntry::canRemove()
 void
 NodeEntry::loadServer(const ServerEntryPtr& entry, const ServerInfo& server, const SessionIPtr& session, int timeout,
                       bool noRestart)
+{
+    ServerCommand command;
+    command.entry = entry;
+    command.server = server;
+    command.session = session;
+    command.timeout = timeout;
+    command.noRestart = noRestart;
+    command.destroy = false;
+    queueServerCommand(command);
+}
+
+void
+NodeEntry::destroyServer(const ServerEntryPtr& entry, const ServerInfo& info, int timeout, bool noRestart)
+{
+    ServerCommand command;
+    command.entry = entry;
+    command.server = info;
+    command.timeout = timeout;
+    command.noRestart = noRestart;
+    command.destroy = true;
+    queueServerCommand(command);
+}
+
+void
+NodeEntry::finishedServerCommand(bool destroy)
+{
+    {
+        Lock sync(*this);
+        --_inFlight;
+        if(destroy)
+        {
+            --_destroying;
+        }
+    }
+    dispatchServerCommands();
+}
+
+void
+NodeEntry::queueServerCommand(const ServerCommand& command)
+{
+    {
+        Lock sync(*this);
+        _commands.push_back(command);
+
+        int max = _cache.getDeploymentParallelism();
+        if((_commands.size() > 1 || (max > 0 && _inFlight >= max) || (!command.destroy && _destroying > 0)) &&
+           _cache.getTraceLevels() && _cache.getTraceLevels()->server > 2)
+        {
+            Ice::Trace out(_cache.getTraceLevels()->logger, _cache.getTraceLevels()->serverCat);
+            out << "queued " << (command.destroy ? "unloading" : "loading") << " of `" << command.entry->getId()
+                << "' on node `" << _name << "' (" << _commands.size() << " queued)";
+        }
+    }
+    dispatchServerCommands();
+}
+
+void
+NodeEntry::dispatchServerCommands()
+{
+    //
+    // Server descriptors don't depend on each other, the deployment
+    // only orders the commands of a node: a load command depends on
+    // all the destroy commands queued before it, the destroyed servers
+    // might release resources such as endpoints used by the loaded
+    // servers. The commands are sent in queuing order and a load
+    // command is only sent once no destroy command is in flight, so a
+    // load waits for the destroy commands queued before it but not
+    // for the ones queued after it. The commands of a given server
+    // on different nodes are already ordered by its server entry,
+    // which doesn't load the server on its new node until it's
+    // destroyed on its previous node.
+    //
+    while(true)
+    {
+        vector<ServerCommand> commands;
+        {
+            Lock sync(*this);
+            int max = _cache.getDeploymentParallelism();
+            while(!_commands.empty() && (max <= 0 || _inFlight < max))
+            {
+                if(_commands.front().destroy)
+                {
+                    ++_destroying;
+                }
+                else if(_destroying > 0)
+                {
+                    break;
+                }
+                commands.push_back(_commands.front());
+                _commands.pop_front();
+                ++_inFlight;
+            }
+        }
+
+        if(commands.empty())
+        {
+            return;
+        }
+
+        //
+        // Commands which fail without being sent release their slot
+        // right away, the next queued commands are then dispatched.
+        //
+        bool failed = false;
+        for(vector<ServerCommand>::const_iterator p = commands.begin(); p != commands.end(); ++p)
+        {
+            if(!sendServerCommand(*p))
+            {
+                Lock sync(*this);
+                --_inFlight;
+                if(p->destroy)
+                {
+                    --_destroying;
+                }
+                failed = true;
+            }
+        }
+        if(!failed)
+        {
+            return;
+        }
+    }
+}
+
+bool
+NodeEntry::sendServerCommand(const ServerCommand& command)
+{
+    if(command.destroy)
+    {
+        return sendDestroyServer(command.entry, command.server, command.timeout, command.noRestart);
+    }
+    else
+    {
+        return sendLoadServer(command.entry, command.server, command.session, command.timeout, command.noRestart);
+    }
+}
+
+bool
+NodeEntry::sendLoadServer(const ServerEntryPtr& entry, const ServerInfo& server, const SessionIPtr& session,
+                          int timeout, bool noRestart)
 {
     try
     {
@@ -614,7 +796,8 @@ NodeEntry::loadServer(const ServerEntryPtr& entry, const ServerInfo& server, con
         {
             node->begin_loadServerWithoutRestart(desc, _cache.getReplicaName(),
                                                  newCallback_Node_loadServerWithoutRestart(
-                                                     new LoadCB(_cache.getTraceLevels(), entry, _name, sessionTimeout),
+                                                     new LoadCB(_cache.getTraceLevels(), this, entry, _name,
+                                                                sessionTimeout),
                                                      &LoadCB::response,
                                                      &LoadCB::exception));
         }
@@ -622,7 +805,7 @@ NodeEntry::loadServer(const ServerEntryPtr& entry, const ServerInfo& server, con
         {
             node->begin_loadServer(desc, _cache.getReplicaName(),
                                    newCallback_Node_loadServer(
-                                       new LoadCB(_cache.getTraceLevels(), entry, _name, sessionTimeout),
+                                       new LoadCB(_cache.getTraceLevels(), this, entry, _name, sessionTimeout),
                                        &LoadCB::response,
                                        &LoadCB::exception));
         }
@@ -630,11 +813,13 @@ NodeEntry::loadServer(const ServerEntryPtr& entry, const ServerInfo& server, con
     catch(const NodeUnreachableException& ex)
     {
         entry->exception(ex);
+        return false;
     }
+    return true;
 }
 
-void
-NodeEntry::destroyServer(const ServerEntryPtr& entry, const ServerInfo& info, int timeout, bool noRestart)
+bool
+NodeEntry::sendDestroyServer(const ServerEntryPtr& entry, const ServerInfo& info, int timeout, bool noRestart)
 {
     try
     {
@@ -667,7 +852,7 @@ NodeEntry::destroyServer(const ServerEntryPtr& entry, const ServerInfo& info, in
             node->begin_destroyServerWithoutRestart(info.descriptor->id, info.uuid, info.revision,
                                                     _cache.getReplicaName(),
                                                     newCallback_Node_destroyServerWithoutRestart(
-                                                        new DestroyCB(_cache.getTraceLevels(), entry, _name),
+                                                        new DestroyCB(_cache.getTraceLevels(), this, entry, _name),
                                                         &DestroyCB::response,
                                                         &DestroyCB::exception));
         }
@@ -675,7 +860,7 @@ NodeEntry::destroyServer(const ServerEntryPtr& entry, const ServerInfo& info, in
         {
             node->begin_destroyServer(info.descriptor->id, info.uuid, info.revision, _cache.getReplicaName(),
                                       newCallback_Node_destroyServer(
-                                          new DestroyCB(_cache.getTraceLevels(), entry, _name),
+                                          new DestroyCB(_cache.getTraceLevels(), this, entry, _name),
                                           &DestroyCB::response,
                                           &DestroyCB::exception));
         }
@@ -683,7 +868,9 @@ NodeEntry::destroyServer(const ServerEntryPtr& entry, const ServerInfo& info, in
     catch(const NodeUnreachableException& ex)
     {
         entry->exception(ex);
+        return false;
     }
+    return true;
 }
 
 ServerInfo
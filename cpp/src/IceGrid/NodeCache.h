@@ -15,6 +15,8 @@
 #include <IceGrid/Cache.h>
 #include <IceGrid/Internal.h>
 
+#include <deque>
+
 namespace IceGrid
 {
 
@@ -70,8 +72,26 @@ public:
     void finishedRegistration();
     void finishedRegistration(const Ice::Exception&);
 
+    void finishedServerCommand(bool);
+
 private:
-    
+
+    struct ServerCommand
+    {
+        ServerEntryPtr entry;
+        ServerInfo server;
+        SessionIPtr session;
+        int timeout;
+        bool noRestart;
+        bool destroy;
+    };
+
+    void queueServerCommand(const ServerCommand&);
+    void dispatchServerCommands();
+    bool sendServerCommand(const ServerCommand&);
+    bool sendLoadServer(const ServerEntryPtr&, const ServerInfo&, const SessionIPtr&, int, bool);
+    bool sendDestroyServer(const ServerEntryPtr&, const ServerInfo&, int, bool);
+
     ServerDescriptorPtr getServerDescriptor(const ServerInfo&, const SessionIPtr&);
     InternalServerDescriptorPtr getInternalServerDescriptor(const ServerInfo&) const;
 
@@ -82,6 +102,16 @@ private:
     NodeSessionIPtr _session;
     std::map<std::string, ServerEntryPtr> _servers;
     std::map<std::string, NodeDescriptor> _descriptors;
+    std::map<std::string, float> _loadFactors; // The parsed load factors of _descriptors.
+
+    //
+    // The number of load or destroy commands sent to the node and not
+    // completed yet, the number of destroy commands among them, and
+    // the commands waiting to be sent in queuing order.
+    //
+    int _inFlight;
+    int _destroying;
+    std::deque<ServerCommand> _commands;
 
     mutable bool _registering;
     mutable NodePrx _proxy;
@@ -99,12 +129,16 @@ public:
     const Ice::CommunicatorPtr& getCommunicator() const { return _communicator; }
     const std::string& getReplicaName() const { return _replicaName; }
     ReplicaCache& getReplicaCache() const { return _replicaCache; }
+    const IceUtil::Time& getLoadInfoTimeout() const { return _loadInfoTimeout; }
+    int getDeploymentParallelism() const { return _deploymentParallelism; }
 
 private:
     
     const Ice::CommunicatorPtr _communicator;
     const std::string _replicaName;
     ReplicaCache& _replicaCache;
+    IceUtil::Time _loadInfoTimeout;
+    int _deploymentParallelism;
 };
 
 };
@@ -226,6 +226,18 @@ public:
     {
     }
 
+    virtual string
+    getKey() const
+    {
+        return "server " + _info.id;
+    }
+
+    virtual void
+    merge(const NodeI::UpdatePtr& update)
+    {
+        _info = dynamic_cast<UpdateServer*>(update.get())->_info;
+    }
+
     virtual bool
     send()
     {
@@ -256,6 +268,18 @@ public:
     {
     }
 
+    virtual string
+    getKey() const
+    {
+        return "adapter " + _info.id;
+    }
+
+    virtual void
+    merge(const NodeI::UpdatePtr& update)
+    {
+        _info = dynamic_cast<UpdateAdapter*>(update.get())->_info;
+    }
+
     virtual bool
     send()
     {
@@ -287,6 +311,18 @@ NodeI::Update::~Update()
 {
 }
 
+string
+NodeI::Update::getKey() const
+{
+    return string();
+}
+
+void
+NodeI::Update::merge(const UpdatePtr&)
+{
+    assert(false);
+}
+
 void
 NodeI::Update::finished(bool success)
 {
@@ -316,7 +352,7 @@ NodeI::NodeI(const Ice::ObjectAdapterPtr& adapter,
     _instanceName(instanceName),
     _userAccountMapper(mapper),
     _platform("IceGrid.Node", _communicator, _traceLevels),
-    _fileCache(new FileCache(_communicator)),
+    _fileCache(new FileCache(_communicator, _timer)),
     _serial(1),
     _consistencyCheckDone(false)
 {
@@ -748,6 +784,18 @@ NodeI::read(const string& filename, Ice::Long pos, int size, Ice::Long& newPos,
     return _fileCache->read(getFilePath(filename), pos, size, newPos, lines);
 }
 
+void
+NodeI::followFile(const string& filename, Ice::Long pos, const InternalFileObserverPrx& observer, const Ice::Current&)
+{
+    _fileCache->follow(getFilePath(filename), pos, observer);
+}
+
+void
+NodeI::unfollowFile(const InternalFileObserverPrx& observer, const Ice::Current&)
+{
+    _fileCache->unfollow(observer);
+}
+
 void
 NodeI::shutdown()
 {
@@ -914,6 +962,7 @@ NodeI::addObserver(const NodeSessionPrx& session, const NodeObserverPrx& observe
     _observers.insert(make_pair(session, observer));
 
     _observerUpdates.erase(observer); // Remove any updates from the previous session.
+    _queuedUpdates.erase(observer);
 
     ServerDynamicInfoSeq serverInfos;
     AdapterDynamicInfoSeq adapterInfos;
@@ -1019,6 +1068,23 @@ NodeI::queueUpdate(const NodeObserverPrx& proxy, const UpdatePtr& update)
     }
     else
     {
+        //
+        // If an update of the same server or adapter is already
+        // queued, it's updated with the latest state instead of
+        // queuing another update: only the final state is sent.
+        //
+        string key = update->getKey();
+        if(!key.empty())
+        {
+            map<string, UpdatePtr>& queued = _queuedUpdates[proxy];
+            map<string, UpdatePtr>::const_iterator q = queued.find(key);
+            if(q != queued.end())
+            {
+                q->second->merge(update);
+                return;
+            }
+            queued.insert(make_pair(key, update));
+        }
         p->second.push_back(update);
     }
 }
@@ -1035,6 +1101,18 @@ NodeI::dequeueUpdate(const NodeObserverPrx& proxy, const UpdatePtr& update, bool
 
     p->second.pop_front();
 
+    //
+    // The next update is sent, it can no longer be merged.
+    //
+    if(!all && !p->second.empty())
+    {
+        string key = p->second.front()->getKey();
+        if(!key.empty())
+        {
+            _queuedUpdates[proxy].erase(key);
+        }
+    }
+
     if(all || (!p->second.empty() && !p->second.front()->send()))
     {
         p->second.clear();
@@ -1043,6 +1121,7 @@ NodeI::dequeueUpdate(const NodeObserverPrx& proxy, const UpdatePtr& update, bool
     if(p->second.empty())
     {
         _observerUpdates.erase(p);
+        _queuedUpdates.erase(proxy);
     }
 }
 
@@ -51,6 +51,13 @@ public:
 
         virtual bool send() = 0;
 
+        //
+        // The key of the server or adapter updated, updates with the
+        // same key can be merged while they are queued.
+        //
+        virtual std::string getKey() const;
+        virtual void merge(const IceUtil::Handle<Update>&);
+
         void finished(bool);
         
         void completed(const Ice::AsyncResultPtr&);
@@ -107,6 +114,8 @@ public:
 
     virtual Ice::Long getOffsetFromEnd(const std::string&, int, const Ice::Current&) const;
     virtual bool read(const std::string&, Ice::Long, int, Ice::Long&, Ice::StringSeq&, const Ice::Current&) const;
+    virtual void followFile(const std::string&, Ice::Long, const InternalFileObserverPrx&, const Ice::Current&);
+    virtual void unfollowFile(const InternalFileObserverPrx&, const Ice::Current&);
 
     void shutdown();
     
@@ -189,6 +198,7 @@ private:
     std::map<std::string, AdapterDynamicInfo> _adaptersDynamicInfo;
 
     std::map<NodeObserverPrx, std::deque<UpdatePtr> > _observerUpdates;
+    std::map<NodeObserverPrx, std::map<std::string, UpdatePtr> > _queuedUpdates; // Queued updates by key.
 
     IceUtil::Mutex _serversLock;
     std::map<std::string, std::set<ServerIPtr> > _serversByApplication;
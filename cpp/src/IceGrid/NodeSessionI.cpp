@@ -340,13 +340,21 @@ NodeSessionI::getInfo() const
     return _info;
 }
 
-const LoadInfo&
+LoadInfo
 NodeSessionI::getLoadInfo() const
 {
     Lock sync(*this);
     return _load;
 }
 
+LoadInfo
+NodeSessionI::getLoadInfo(IceUtil::Time& timestamp) const
+{
+    Lock sync(*this);
+    timestamp = _timestamp;
+    return _load;
+}
+
 NodeSessionPrx
 NodeSessionI::getProxy() const
 {
@@ -75,7 +75,8 @@ public:
 
     const NodePrx& getNode() const;
     const InternalNodeInfoPtr& getInfo() const;
-    const LoadInfo& getLoadInfo() const;
+    LoadInfo getLoadInfo() const;
+    LoadInfo getLoadInfo(IceUtil::Time&) const;
     NodeSessionPrx getProxy() const;
 
     bool isDestroyed() const;
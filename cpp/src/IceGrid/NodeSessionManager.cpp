@@ -29,6 +29,17 @@ NodeSessionKeepAliveThread::NodeSessionKeepAliveThread(const InternalRegistryPrx
         name = name.substr(prefix.size());
     }
     const_cast<string&>(_name) = name;
+
+    //
+    // The load samples are pushed to the registry with the keep alive
+    // messages, the load update period allows to push them more often
+    // than the session timeout requires.
+    //
+    int period = node->getCommunicator()->getProperties()->getPropertyAsInt("IceGrid.Node.LoadUpdatePeriod");
+    if(period > 0)
+    {
+        _loadUpdatePeriod = IceUtil::Time::seconds(period);
+    }
 }
 
 NodeSessionPrx
@@ -171,6 +182,16 @@ NodeSessionKeepAliveThread::createSessionImpl(const InternalRegistryPrx& registr
     }
 }
 
+IceUtil::Time
+NodeSessionKeepAliveThread::keepAlivePeriod(const IceUtil::Time& timeout) const
+{
+    if(_loadUpdatePeriod > IceUtil::Time() && _loadUpdatePeriod < timeout)
+    {
+        return _loadUpdatePeriod;
+    }
+    return timeout;
+}
+
 void 
 NodeSessionKeepAliveThread::destroySession(const NodeSessionPrx& session)
 {
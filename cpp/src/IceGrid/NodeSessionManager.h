@@ -42,9 +42,11 @@ public:
 protected:
 
     virtual NodeSessionPrx createSessionImpl(const InternalRegistryPrx&, IceUtil::Time&);
+    virtual IceUtil::Time keepAlivePeriod(const IceUtil::Time&) const;
 
     const NodeIPtr _node;
     const std::string _name;
+    IceUtil::Time _loadUpdatePeriod;
     NodeSessionManager& _manager;
 };
 typedef IceUtil::Handle<NodeSessionKeepAliveThread> NodeSessionKeepAliveThreadPtr;
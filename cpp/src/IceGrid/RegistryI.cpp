@@ -118,6 +118,58 @@ private:
     ProcessPtr _origProcess;
 };
 
+//
+// The LocatorCache admin facet provides the locator cache statistics
+// as read-only properties.
+//
+class LocatorCacheI : public PropertiesAdmin
+{
+public:
+
+    LocatorCacheI(const DatabasePtr& database) : _database(database)
+    {
+    }
+
+    virtual string
+    getProperty(const string& key, const Current& current)
+    {
+        PropertyDict properties = getPropertiesForPrefix(key, current);
+        PropertyDict::const_iterator p = properties.find(key);
+        return p != properties.end() ? p->second : string();
+    }
+
+    virtual PropertyDict
+    getPropertiesForPrefix(const string& prefix, const Current&)
+    {
+        Ice::Long values[4];
+        _database->getLocatorCacheStats(values[0], values[1], values[2], values[3]);
+
+        static const char* names[] = { "Hits", "Misses", "Evictions", "Size" };
+        PropertyDict properties;
+        for(size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+        {
+            string key = string("IceGrid.Registry.LocatorCache.") + names[i];
+            if(key.compare(0, prefix.size(), prefix) == 0)
+            {
+                ostringstream os;
+                os << values[i];
+                properties[key] = os.str();
+            }
+        }
+        return properties;
+    }
+
+    virtual void
+    setProperties(const PropertyDict&, const Current& current)
+    {
+        throw OperationNotExistException(__FILE__, __LINE__, current.id, current.facet, current.operation);
+    }
+
+private:
+
+    const DatabasePtr _database;
+};
+
 Ice::IPConnectionInfoPtr
 getIPConnectionInfo(const Ice::ConnectionInfoPtr& info)
 {
@@ -381,6 +433,12 @@ RegistryI::startImpl()
     _reaper = new ReapThread();
     _reaper->start();
 
+    //
+    // Create the timer, used for the session allocation timeout and
+    // to follow the log files.
+    //
+    _timer = new IceUtil::Timer();
+
     //
     // Create the internal registry object adapter.
     //
@@ -718,8 +776,8 @@ RegistryI::setupInternalRegistry()
     Identity internalRegistryId;
     internalRegistryId.category = _instanceName;
     internalRegistryId.name = "InternalRegistry-" + _replicaName;
-    assert(_reaper);
-    ObjectPtr internalRegistry = new InternalRegistryI(this, _database, _reaper, _wellKnownObjects, *_session);
+    assert(_reaper && _timer);
+    ObjectPtr internalRegistry = new InternalRegistryI(this, _database, _reaper, _timer, _wellKnownObjects, *_session);
     Ice::ObjectPrx proxy = _registryAdapter->add(internalRegistry, internalRegistryId);
     _wellKnownObjects->add(proxy, InternalRegistry::ice_staticId());
 
@@ -731,6 +789,7 @@ RegistryI::setupInternalRegistry()
         // Replace Admin facet
         ProcessPtr origProcess = ProcessPtr::dynamicCast(_communicator->removeAdminFacet("Process"));
         _communicator->addAdminFacet(new ProcessI(this, origProcess), "Process");
+        _communicator->addAdminFacet(new LocatorCacheI(_database), "LocatorCache");
 
         Identity adminId;
         adminId.name = "RegistryAdmin-" + _replicaName;
@@ -790,8 +849,7 @@ RegistryI::setupClientSessionFactory(const IceGrid::LocatorPrx& locator)
         adapter->addServantLocator(servantManager, "");
     }
 
-    assert(_reaper);
-    _timer = new IceUtil::Timer();  // Used for session allocation timeout.
+    assert(_reaper && _timer);
     _clientSessionFactory = new ClientSessionFactory(servantManager, _database, _timer, _reaper);
 
     if(servantManager && _master) // Slaves don't support client session manager objects.
@@ -28,6 +28,25 @@ operator==(const ObjectInfo& info, const Ice::Identity& id)
 
 }
 
+namespace
+{
+
+Ice::Long
+getSerial(const IceUtil::Optional<StringLongDict>& serials, const string& name)
+{
+    if(serials)
+    {
+        StringLongDict::const_iterator p = serials->find(name);
+        if(p != serials->end())
+        {
+            return p->second;
+        }
+    }
+    return 0;
+}
+
+}
+
 ReplicaSessionI::ReplicaSessionI(const DatabasePtr& database,
                                  const WellKnownObjectsManagerPtr& wellKnownObjects,
                                  const InternalReplicaInfoPtr& info,
@@ -163,9 +182,14 @@ ReplicaSessionI::setDatabaseObserver(const DatabaseObserverPrx& observer,
         }
         _observer = observer;
 
-        serialApplicationObserver = applicationObserver->subscribe(_observer, _info->name);
-        serialAdapterObserver = adapterObserver->subscribe(_observer, _info->name);
-        serialObjectObserver = objectObserver->subscribe(_observer, _info->name);
+        //
+        // The observers are only sent the updates since the serials
+        // of the replica database, if the master still has them.
+        //
+        serialApplicationObserver = applicationObserver->subscribe(_observer, _info->name,
+                                                                   getSerial(slaveSerials, "applications"));
+        serialAdapterObserver = adapterObserver->subscribe(_observer, _info->name, getSerial(slaveSerials, "adapters"));
+        serialObjectObserver = objectObserver->subscribe(_observer, _info->name, getSerial(slaveSerials, "objects"));
     }
 
     applicationObserver->waitForSyncedSubscribers(serialApplicationObserver, _info->name);
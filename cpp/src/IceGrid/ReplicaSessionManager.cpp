@@ -121,7 +121,7 @@ public:
         {
             failure = "adapter `" + info.id + "' already exists and belongs to an application";
         }
-        receivedUpdate(AdapterObserverTopicName, serial, failure);
+        receivedUpdate(AdapterObserverTopicName, serial, failure, current.ctx);
     }
 
     virtual void 
@@ -137,7 +137,7 @@ public:
         {
             failure = "adapter `" + info.id + "' already exists and belongs to an application";
         }
-        receivedUpdate(AdapterObserverTopicName, serial, failure);
+        receivedUpdate(AdapterObserverTopicName, serial, failure, current.ctx);
     }
 
     virtual void 
@@ -153,7 +153,7 @@ public:
         {
             failure = "adapter `" + id + "' already exists and belongs to an application";
         }
-        receivedUpdate(AdapterObserverTopicName, serial, failure);
+        receivedUpdate(AdapterObserverTopicName, serial, failure, current.ctx);
     }
 
     virtual void
@@ -180,7 +180,7 @@ public:
             os << "id: " << identityToString(info.proxy->ice_getIdentity());
             failure = os.str();
         }
-        receivedUpdate(ObjectObserverTopicName, serial, failure);
+        receivedUpdate(ObjectObserverTopicName, serial, failure, current.ctx);
     }
 
     virtual void 
@@ -205,7 +205,7 @@ public:
             os << ex << ":\n" << ex.reason;
             failure = os.str();
         }
-        receivedUpdate(ObjectObserverTopicName, serial, failure);
+        receivedUpdate(ObjectObserverTopicName, serial, failure, current.ctx);
     }
 
     virtual void 
@@ -226,7 +226,69 @@ public:
         catch(const ObjectNotRegisteredException&)
         {
         }
-        receivedUpdate(ObjectObserverTopicName, serial, failure);
+        receivedUpdate(ObjectObserverTopicName, serial, failure, current.ctx);
+    }
+
+    virtual void
+    objectsAdded(const ObjectInfoSeq& infos, const Ice::Current& current)
+    {
+        int serial;
+        string failure;
+        try
+        {
+            _database->addOrUpdateObjects(infos, getSerials(current.ctx, serial));
+        }
+        catch(const ObjectExistsException& ex)
+        {
+            ostringstream os;
+            os << ex << ":\n";
+            os << "id: " << identityToString(ex.id);
+            failure = os.str();
+        }
+        receivedUpdate(ObjectObserverTopicName, serial, failure, current.ctx);
+    }
+
+    virtual void
+    objectsUpdated(const ObjectInfoSeq& infos, const Ice::Current& current)
+    {
+        int serial;
+        string failure;
+        try
+        {
+            _database->addOrUpdateObjects(infos, getSerials(current.ctx, serial));
+        }
+        catch(const ObjectExistsException& ex)
+        {
+            ostringstream os;
+            os << ex << ":\n";
+            os << "id: " << identityToString(ex.id);
+            failure = os.str();
+        }
+        catch(const DeploymentException& ex)
+        {
+            ostringstream os;
+            os << ex << ":\n" << ex.reason;
+            failure = os.str();
+        }
+        receivedUpdate(ObjectObserverTopicName, serial, failure, current.ctx);
+    }
+
+    virtual void
+    objectsRemoved(const Ice::IdentitySeq& ids, const Ice::Current& current)
+    {
+        int serial;
+        string failure;
+        try
+        {
+            _database->removeObjects(ids, getSerials(current.ctx, serial));
+        }
+        catch(const DeploymentException& ex)
+        {
+            ostringstream os;
+            os << ex << ":\n" << ex.reason;
+            failure = os.str();
+        }
+        receivedUpdate(ObjectObserverTopicName, serial, failure, current.ctx);
     }
 
 private:
@@ -260,16 +322,44 @@ private:
     }
     
     void 
-    receivedUpdate(TopicName name, int serial, const string& failure = string())
+    receivedUpdate(TopicName name, int serial, const string& failure = string(),
+                   const Ice::Context& context = Ice::Context())
     {
+        //
+        // The updates sent with a -1 serial are followed by the update
+        // carrying the serial waited for by the master (the objects of
+        // a bulk update or the updates sent to bring us up to date).
+        // Their failures are reported with this last update, the master
+        // ignores the failures of updates it doesn't wait for.
+        //
+        string failures = failure;
+        {
+            Lock sync(*this);
+            if(serial < 0 && context.find("serial") != context.end())
+            {
+                if(!failure.empty())
+                {
+                    _failures.insert(make_pair(name, failure));
+                }
+                return;
+            }
+
+            map<TopicName, string>::iterator p = _failures.find(name);
+            if(p != _failures.end())
+            {
+                failures = failure.empty() ? p->second : p->second + "\n" + failure;
+                _failures.erase(p);
+            }
+        }
+
         try
         {
-            _session->receivedUpdate(name, serial, failure);
+            _session->receivedUpdate(name, serial, failures);
         }
         catch(const Ice::LocalException&)
         {
         }
-        if(!failure.empty())
+        if(!failures.empty())
         {
             _thread->destroyActiveSession();
         }
@@ -278,6 +368,7 @@ private:
     const ReplicaSessionManager::ThreadPtr _thread;
     const DatabasePtr _database;
     const ReplicaSessionPrx _session;
+    map<TopicName, string> _failures; // The first failure of the updates without serial.
 };
 
 };
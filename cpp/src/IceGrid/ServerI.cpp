@@ -1053,6 +1053,18 @@ ServerI::read(const string& filename, Ice::Long pos, int size, Ice::Long& newPos
     return _node->getFileCache()->read(getFilePath(filename), pos, size, newPos, lines);
 }
 
+void
+ServerI::followFile(const string& filename, Ice::Long pos, const InternalFileObserverPrx& observer, const Ice::Current&)
+{
+    _node->getFileCache()->follow(getFilePath(filename), pos, observer);
+}
+
+void
+ServerI::unfollowFile(const InternalFileObserverPrx& observer, const Ice::Current&)
+{
+    _node->getFileCache()->unfollow(observer);
+}
+
 bool
 ServerI::isAdapterActivatable(const string& id) const
 {
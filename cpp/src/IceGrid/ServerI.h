@@ -87,6 +87,8 @@ public:
 
     virtual Ice::Long getOffsetFromEnd(const std::string&, int, const Ice::Current&) const;
     virtual bool read(const std::string&, Ice::Long, int, Ice::Long&, Ice::StringSeq&, const Ice::Current&) const;
+    virtual void followFile(const std::string&, Ice::Long, const InternalFileObserverPrx&, const Ice::Current&);
+    virtual void unfollowFile(const InternalFileObserverPrx&, const Ice::Current&);
 
     bool isAdapterActivatable(const std::string&) const;
     const std::string& getId() const;
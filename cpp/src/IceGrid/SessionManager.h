@@ -107,7 +107,7 @@ public:
                         if(_state == Connected || action == Connect || action == KeepAlive)
                         {
                             IceUtil::Time now = IceUtil::Time::now(IceUtil::Time::Monotonic);
-                            IceUtil::Time wakeTime = now + timeout;
+                            IceUtil::Time wakeTime = now + (_state == Connected ? keepAlivePeriod(timeout) : timeout);
                             while(_state != Destroyed && _nextAction == None && wakeTime > now)
                             {
                                 timedWait(wakeTime - now);
@@ -310,6 +310,17 @@ public:
 
 protected:
 
+    //
+    // The period of the keep alive messages sent while connected,
+    // subclasses can send them more often than the session timeout
+    // requires.
+    //
+    virtual IceUtil::Time
+    keepAlivePeriod(const IceUtil::Time& timeout) const
+    {
+        return timeout;
+    }
+
     InternalRegistryPrx _registry;
     Ice::LoggerPtr _logger;
     TPrx _session;
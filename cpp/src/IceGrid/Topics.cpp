@@ -27,33 +27,36 @@ Ice::EncodingVersion encodings[] = {
     { 1, 1 }
 };
 
-}
+//
+// The maximum number of removed entries kept by the update logs.
+//
+const size_t maxRemovedUpdates = 10000;
 
-ObserverTopic::ObserverTopic(const IceStorm::TopicManagerPrx& topicManager, const string& name, Ice::Long dbSerial) :
-    _logger(topicManager->ice_getCommunicator()->getLogger()), _serial(0), _dbSerial(dbSerial)
+class FlushUpdatesTask : public IceUtil::TimerTask
 {
-    for(int i = 0; i < static_cast<int>(sizeof(encodings) / sizeof(Ice::EncodingVersion)); ++i)
+public:
+
+    FlushUpdatesTask(const NodeObserverTopicPtr& topic) : _topic(topic)
     {
-        ostringstream os;
-        os << name << "-" << Ice::encodingVersionToString(encodings[i]);
-        IceStorm::TopicPrx t;
-        try
-        {
-            t = topicManager->create(os.str());
-        }
-        catch(const IceStorm::TopicExists&)
-        {
-            t = topicManager->retrieve(os.str());
-        }
+    }
 
-        //
-        // NOTE: collocation optimization needs to be turned on for the
-        // topic because the subscribe() method is given a fixed proxy
-        // which can't be marshalled.
-        //
-        _topics[encodings[i]] = t;
-        _basePublishers.push_back(t->getPublisher()->ice_encodingVersion(encodings[i]));
+    virtual void
+    runTimerTask()
+    {
+        _topic->flushUpdates();
     }
+
+private:
+
+    const NodeObserverTopicPtr _topic;
+};
+
+}
+
+ObserverTopic::ObserverTopic(const IceStorm::TopicManagerPrx& topicManager, const string& name, Ice::Long dbSerial) :
+    _logger(topicManager->ice_getCommunicator()->getLogger()), _serial(0), _dbSerial(dbSerial), _pendingPublishes(0)
+{
+    createTopics(topicManager, name, _topics, _basePublishers);
 }
 
 ObserverTopic::~ObserverTopic()
@@ -61,28 +64,40 @@ ObserverTopic::~ObserverTopic()
 }
 
 int
-ObserverTopic::subscribe(const Ice::ObjectPrx& obsv, const string& name)
+ObserverTopic::subscribe(const Ice::ObjectPrx& obsv, const string& name, Ice::Long dbSerial)
 {
     Lock sync(*this);
+    waitForPendingPublishesNoSync();
     if(_topics.empty())
     {
         return -1;
     }
 
     assert(obsv);
+    bool updated = true;
     try
     {
         IceStorm::QoS qos;
         qos["reliability"] = "ordered";
         Ice::EncodingVersion v = IceInternal::getCompatibleEncoding(obsv->ice_getEncodingVersion());
-        map<Ice::EncodingVersion, IceStorm::TopicPrx>::const_iterator p = _topics.find(v);
-        if(p == _topics.end())
+        const map<Ice::EncodingVersion, IceStorm::TopicPrx>& topics =
+            name.empty() || _syncTopics.empty() ? _topics : _syncTopics;
+        map<Ice::EncodingVersion, IceStorm::TopicPrx>::const_iterator p = topics.find(v);
+        if(p == topics.end())
         {
             Ice::Warning out(_logger);
             out << "unsupported encoding version for observer `" << obsv << "'";
             return -1;
         }
-        initObserver(p->second->subscribeAndGetPublisher(qos, obsv->ice_twoway()));
+        Ice::ObjectPrx publisher = p->second->subscribeAndGetPublisher(qos, obsv->ice_twoway());
+        if(dbSerial > 0)
+        {
+            updated = updateObserver(publisher, dbSerial);
+        }
+        else
+        {
+            initObserver(publisher);
+        }
     }
     catch(const IceStorm::AlreadySubscribed&)
     {
@@ -93,8 +108,11 @@ ObserverTopic::subscribe(const Ice::ObjectPrx& obsv, const string& name)
     {
         assert(_syncSubscribers.find(name) == _syncSubscribers.end());
         _syncSubscribers.insert(name);
-        addExpectedUpdate(_serial, name);
-        return _serial;
+        if(updated)
+        {
+            addExpectedUpdate(_serial, name);
+            return _serial;
+        }
     }
     return -1;
 }
@@ -104,8 +122,10 @@ ObserverTopic::unsubscribe(const Ice::ObjectPrx& observer, const string& name)
 {
     Lock sync(*this);
     Ice::EncodingVersion v = IceInternal::getCompatibleEncoding(observer->ice_getEncodingVersion());
-    map<Ice::EncodingVersion, IceStorm::TopicPrx>::const_iterator p = _topics.find(v);
-    if(p == _topics.end())
+    const map<Ice::EncodingVersion, IceStorm::TopicPrx>& topics =
+        name.empty() || _syncTopics.empty() ? _topics : _syncTopics;
+    map<Ice::EncodingVersion, IceStorm::TopicPrx>::const_iterator p = topics.find(v);
+    if(p == topics.end())
     {
         return;
     }
@@ -147,11 +167,23 @@ ObserverTopic::unsubscribe(const Ice::ObjectPrx& observer, const string& name)
     }
 }
 
+bool
+ObserverTopic::updateObserver(const Ice::ObjectPrx& obsv, Ice::Long dbSerial)
+{
+    if(dbSerial == _dbSerial)
+    {
+        return false;
+    }
+    initObserver(obsv);
+    return true;
+}
+
 void
 ObserverTopic::destroy()
 {
     Lock sync(*this);
     _topics.clear();
+    _syncTopics.clear();
     notifyAll();
 }
 
@@ -260,6 +292,48 @@ ObserverTopic::waitForSyncedSubscribersNoSync(int serial, const string& name)
     }
 }
 
+void
+ObserverTopic::waitForPendingPublishesNoSync()
+{
+    //
+    // The updates must be published in order, wait for the updates
+    // which are still published without the topic lock.
+    //
+    while(_pendingPublishes > 0 && !_topics.empty())
+    {
+        wait();
+    }
+}
+
+void
+ObserverTopic::createTopics(const IceStorm::TopicManagerPrx& topicManager, const string& name,
+                            map<Ice::EncodingVersion, IceStorm::TopicPrx>& topics,
+                            vector<Ice::ObjectPrx>& publishers)
+{
+    for(int i = 0; i < static_cast<int>(sizeof(encodings) / sizeof(Ice::EncodingVersion)); ++i)
+    {
+        ostringstream os;
+        os << name << "-" << Ice::encodingVersionToString(encodings[i]);
+        IceStorm::TopicPrx t;
+        try
+        {
+            t = topicManager->create(os.str());
+        }
+        catch(const IceStorm::TopicExists&)
+        {
+            t = topicManager->retrieve(os.str());
+        }
+
+        //
+        // NOTE: collocation optimization needs to be turned on for the
+        // topic because the subscribe() method is given a fixed proxy
+        // which can't be marshalled.
+        //
+        topics[encodings[i]] = t;
+        publishers.push_back(t->getPublisher()->ice_encodingVersion(encodings[i]));
+    }
+}
+
 void
 ObserverTopic::updateSerial(Ice::Long dbSerial)
 {
@@ -363,9 +437,24 @@ RegistryObserverTopic::initObserver(const Ice::ObjectPrx& obsv)
 
 NodeObserverTopic::NodeObserverTopic(const IceStorm::TopicManagerPrx& topicManager, 
                                      const Ice::ObjectAdapterPtr& adapter) : 
-    ObserverTopic(topicManager, "NodeObserver")
+    ObserverTopic(topicManager, "NodeObserver"),
+    _flushScheduled(false)
 {
     _publishers = getPublishers<NodeObserverPrx>();
+
+    //
+    // The server and adapter updates can be batched: only the last
+    // update of each server or adapter received during the batch
+    // delay is published.
+    //
+    Ice::PropertiesPtr properties = adapter->getCommunicator()->getProperties();
+    int delay = properties->getPropertyAsInt("IceGrid.Registry.NodeObserverBatchDelay");
+    if(delay > 0)
+    {
+        _batchDelay = IceUtil::Time::milliSeconds(delay);
+        _timer = new IceUtil::Timer();
+    }
+
     try
     {
         const_cast<NodeObserverPrx&>(_externalPublisher) = NodeObserverPrx::uncheckedCast(adapter->addWithUUID(this));
@@ -389,6 +478,7 @@ NodeObserverTopic::nodeUp(const NodeDynamicInfo& info, const Ice::Current&)
     {
         return;
     }
+    flushUpdatesNoSync();
     updateSerial();
     _nodes.insert(make_pair(info.info.name, info));
     try
@@ -453,6 +543,13 @@ NodeObserverTopic::updateServer(const string& node, const ServerDynamicInfo& ser
         servers.push_back(server);
     }
 
+    if(_timer)
+    {
+        _serverUpdates[node][server.id] = server;
+        scheduleFlush();
+        return;
+    }
+
     try
     {
         for(vector<NodeObserverPrx>::const_iterator p = _publishers.begin(); p != _publishers.end(); ++p)
@@ -508,6 +605,13 @@ NodeObserverTopic::updateAdapter(const string& node, const AdapterDynamicInfo& a
     {
         adapters.push_back(adapter);
     }
+
+    if(_timer)
+    {
+        _adapterUpdates[node][adapter.id] = adapter;
+        scheduleFlush();
+        return;
+    }
     
     try
     {
@@ -532,6 +636,14 @@ NodeObserverTopic::nodeDown(const string& name)
         return;
     }
 
+    //
+    // The updates of the node are no longer relevant, the updates of
+    // the other nodes are published before the node is removed.
+    //
+    _serverUpdates.erase(name);
+    _adapterUpdates.erase(name);
+    flushUpdatesNoSync();
+
     updateSerial();
 
     if(_nodes.find(name) != _nodes.end())
@@ -565,6 +677,83 @@ NodeObserverTopic::initObserver(const Ice::ObjectPrx& obsv)
     observer->nodeInit(nodes, getContext(_serial));
 }
 
+void
+NodeObserverTopic::destroy()
+{
+    ObserverTopic::destroy();
+
+    //
+    // The timer is destroyed without the lock, a flush might be
+    // waiting for it.
+    //
+    if(_timer)
+    {
+        _timer->destroy();
+    }
+}
+
+void
+NodeObserverTopic::flushUpdates()
+{
+    Lock sync(*this);
+    _flushScheduled = false;
+    if(_topics.empty())
+    {
+        return;
+    }
+    flushUpdatesNoSync();
+}
+
+void
+NodeObserverTopic::scheduleFlush()
+{
+    if(!_flushScheduled)
+    {
+        _timer->schedule(new FlushUpdatesTask(this), _batchDelay);
+        _flushScheduled = true;
+    }
+}
+
+void
+NodeObserverTopic::flushUpdatesNoSync()
+{
+    if(_serverUpdates.empty() && _adapterUpdates.empty())
+    {
+        return;
+    }
+
+    try
+    {
+        for(vector<NodeObserverPrx>::const_iterator p = _publishers.begin(); p != _publishers.end(); ++p)
+        {
+            map<string, map<string, ServerDynamicInfo> >::const_iterator q;
+            for(q = _serverUpdates.begin(); q != _serverUpdates.end(); ++q)
+            {
+                for(map<string, ServerDynamicInfo>::const_iterator r = q->second.begin(); r != q->second.end(); ++r)
+                {
+                    (*p)->updateServer(q->first, r->second);
+                }
+            }
+
+            map<string, map<string, AdapterDynamicInfo> >::const_iterator s;
+            for(s = _adapterUpdates.begin(); s != _adapterUpdates.end(); ++s)
+            {
+                for(map<string, AdapterDynamicInfo>::const_iterator r = s->second.begin(); r != s->second.end(); ++r)
+                {
+                    (*p)->updateAdapter(s->first, r->second);
+                }
+            }
+        }
+    }
+    catch(const Ice::LocalException& ex)
+    {
+        Ice::Warning out(_logger);
+        out << "unexpected exception while publishing batched `updateServer' and `updateAdapter' updates:\n" << ex;
+    }
+    _serverUpdates.clear();
+    _adapterUpdates.clear();
+}
+
 ApplicationObserverTopic::ApplicationObserverTopic(const IceStorm::TopicManagerPrx& topicManager,
                                                    const map<string, ApplicationInfo>& applications, Ice::Long serial) :
     ObserverTopic(topicManager, "ApplicationObserver", serial),
@@ -733,7 +922,8 @@ ApplicationObserverTopic::initObserver(const Ice::ObjectPrx& obsv)
 AdapterObserverTopic::AdapterObserverTopic(const IceStorm::TopicManagerPrx& topicManager,
                                            const map<string, AdapterInfo>& adapters, Ice::Long serial) :
     ObserverTopic(topicManager, "AdapterObserver", serial),
-    _adapters(adapters)
+    _adapters(adapters),
+    _updateLog(serial, maxRemovedUpdates)
 {
     _publishers = getPublishers<AdapterObserverPrx>();
 }
@@ -748,6 +938,7 @@ AdapterObserverTopic::adapterInit(Ice::Long dbSerial, const AdapterInfoSeq& adpt
     }
     updateSerial(dbSerial);
     _adapters.clear();
+    _updateLog.reset(_dbSerial);
     for(AdapterInfoSeq::const_iterator q = adpts.begin(); q != adpts.end(); ++q)
     {
         _adapters.insert(make_pair(q->id, *q));
@@ -778,6 +969,7 @@ AdapterObserverTopic::adapterAdded(Ice::Long dbSerial, const AdapterInfo& info)
     }
     updateSerial(dbSerial);
     _adapters.insert(make_pair(info.id, info));
+    _updateLog.updated(info.id, dbSerial);
     try
     {
         for(vector<AdapterObserverPrx>::const_iterator p = _publishers.begin(); p != _publishers.end(); ++p)
@@ -804,6 +996,7 @@ AdapterObserverTopic::adapterUpdated(Ice::Long dbSerial, const AdapterInfo& info
     }
     updateSerial(dbSerial);
     _adapters[info.id] = info;
+    _updateLog.updated(info.id, dbSerial);
     try
     {
         for(vector<AdapterObserverPrx>::const_iterator p = _publishers.begin(); p != _publishers.end(); ++p)
@@ -830,6 +1023,7 @@ AdapterObserverTopic::adapterRemoved(Ice::Long dbSerial, const string& id)
     }
     updateSerial(dbSerial);
     _adapters.erase(id);
+    _updateLog.removed(id, dbSerial);
     try
     {
         for(vector<AdapterObserverPrx>::const_iterator p = _publishers.begin(); p != _publishers.end(); ++p)
@@ -858,24 +1052,75 @@ AdapterObserverTopic::initObserver(const Ice::ObjectPrx& obsv)
     observer->adapterInit(adapters, getContext(_serial, _dbSerial));
 }
 
+bool
+AdapterObserverTopic::updateObserver(const Ice::ObjectPrx& obsv, Ice::Long dbSerial)
+{
+    vector<pair<Ice::Long, string> > updates;
+    if(!_updateLog.getUpdates(dbSerial, updates))
+    {
+        initObserver(obsv);
+        return true;
+    }
+    else if(updates.empty())
+    {
+        return false;
+    }
+
+    //
+    // Send the adapters updated since the observer database serial.
+    // Only the last update carries the serial waited for by the
+    // subscriber.
+    //
+    AdapterObserverPrx observer = AdapterObserverPrx::uncheckedCast(obsv);
+    for(vector<pair<Ice::Long, string> >::const_iterator p = updates.begin(); p != updates.end(); ++p)
+    {
+        Ice::Context context = getContext(p + 1 == updates.end() ? _serial : -1, p->first);
+        map<string, AdapterInfo>::const_iterator q = _adapters.find(p->second);
+        if(q != _adapters.end())
+        {
+            observer->adapterUpdated(q->second, context);
+        }
+        else
+        {
+            observer->adapterRemoved(p->second, context);
+        }
+    }
+    return true;
+}
+
 ObjectObserverTopic::ObjectObserverTopic(const IceStorm::TopicManagerPrx& topicManager,
                                          const map<Ice::Identity, ObjectInfo>& objects, Ice::Long serial) :
     ObserverTopic(topicManager, "ObjectObserver", serial),
-    _objects(objects)
+    _objects(objects),
+    _updateLog(serial, maxRemovedUpdates),
+    _publishingBulkUpdates(false)
 {
-    _publishers = getPublishers<ObjectObserverPrx>();
+    //
+    // The replicas subscribe to their own topics. They're sent a bulk
+    // update with a single call while the other observers are sent an
+    // update for each object.
+    //
+    vector<Ice::ObjectPrx> replicaPublishers;
+    createTopics(topicManager, "ObjectReplicaObserver", _syncTopics, replicaPublishers);
+    _observerPublishers = getPublishers<ObjectObserverPrx>();
+    _replicaPublishers = getPublishers<DatabaseObserverPrx>(replicaPublishers);
+    _publishers = _observerPublishers;
+    vector<ObjectObserverPrx> publishers = getPublishers<ObjectObserverPrx>(replicaPublishers);
+    _publishers.insert(_publishers.end(), publishers.begin(), publishers.end());
 }
 
 int 
 ObjectObserverTopic::objectInit(Ice::Long dbSerial, const ObjectInfoSeq& objects)
 {
     Lock sync(*this);
+    waitForPendingPublishesNoSync();
     if(_topics.empty())
     {
         return -1;
     }
     updateSerial(dbSerial);
     _objects.clear();
+    _updateLog.reset(_dbSerial);
     for(ObjectInfoSeq::const_iterator r = objects.begin(); r != objects.end(); ++r)
     {
         _objects.insert(make_pair(r->proxy->ice_getIdentity(), *r));
@@ -900,12 +1145,14 @@ int
 ObjectObserverTopic::objectAdded(Ice::Long dbSerial, const ObjectInfo& info)
 {
     Lock sync(*this);
+    waitForPendingPublishesNoSync();
     if(_topics.empty())
     {
         return -1;
     }
     updateSerial(dbSerial);
     _objects.insert(make_pair(info.proxy->ice_getIdentity(), info));
+    _updateLog.updated(info.proxy->ice_getIdentity(), dbSerial);
     try
     {
         for(vector<ObjectObserverPrx>::const_iterator p = _publishers.begin(); p != _publishers.end(); ++p)
@@ -926,12 +1173,14 @@ int
 ObjectObserverTopic::objectUpdated(Ice::Long dbSerial, const ObjectInfo& info)
 {
     Lock sync(*this);
+    waitForPendingPublishesNoSync();
     if(_topics.empty())
     {
         return -1;
     }
     updateSerial(dbSerial);
     _objects[info.proxy->ice_getIdentity()] = info;
+    _updateLog.updated(info.proxy->ice_getIdentity(), dbSerial);
     try
     {
         for(vector<ObjectObserverPrx>::const_iterator p = _publishers.begin(); p != _publishers.end(); ++p)
@@ -952,12 +1201,14 @@ int
 ObjectObserverTopic::objectRemoved(Ice::Long dbSerial, const Ice::Identity& id)
 {
     Lock sync(*this);
+    waitForPendingPublishesNoSync();
     if(_topics.empty())
     {
         return -1;
     }
     updateSerial(dbSerial);
     _objects.erase(id);
+    _updateLog.removed(id, dbSerial);
     try
     {
         for(vector<ObjectObserverPrx>::const_iterator p = _publishers.begin(); p != _publishers.end(); ++p)
@@ -974,10 +1225,197 @@ ObjectObserverTopic::objectRemoved(Ice::Long dbSerial, const Ice::Identity& id)
     return _serial;
 }
 
+//
+// The bulk updates below are published as a single topic update: the
+// replicas are sent all the objects with a single call carrying the
+// topic and database serials, which they apply in a single database
+// transaction. The updates are queued and published by
+// publishBulkUpdates once the database lock is released.
+//
+int
+ObjectObserverTopic::objectsAdded(Ice::Long dbSerial, const ObjectInfoSeq& infos)
+{
+    Lock sync(*this);
+    if(_topics.empty())
+    {
+        return -1;
+    }
+    updateSerial(dbSerial);
+    for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+    {
+        _objects.insert(make_pair(p->proxy->ice_getIdentity(), *p));
+        _updateLog.updated(p->proxy->ice_getIdentity(), dbSerial);
+    }
+    queueBulkUpdate(ObjectsAdded, infos, Ice::IdentitySeq(), dbSerial);
+    addExpectedUpdate(_serial);
+    return _serial;
+}
+
+int
+ObjectObserverTopic::objectsUpdated(Ice::Long dbSerial, const ObjectInfoSeq& infos)
+{
+    Lock sync(*this);
+    if(_topics.empty())
+    {
+        return -1;
+    }
+    updateSerial(dbSerial);
+    for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+    {
+        _objects[p->proxy->ice_getIdentity()] = *p;
+        _updateLog.updated(p->proxy->ice_getIdentity(), dbSerial);
+    }
+    queueBulkUpdate(ObjectsUpdated, infos, Ice::IdentitySeq(), dbSerial);
+    addExpectedUpdate(_serial);
+    return _serial;
+}
+
+int
+ObjectObserverTopic::objectsRemoved(Ice::Long dbSerial, const Ice::IdentitySeq& ids)
+{
+    Lock sync(*this);
+    if(_topics.empty())
+    {
+        return -1;
+    }
+    updateSerial(dbSerial);
+    for(Ice::IdentitySeq::const_iterator p = ids.begin(); p != ids.end(); ++p)
+    {
+        _objects.erase(*p);
+        _updateLog.removed(*p, dbSerial);
+    }
+    queueBulkUpdate(ObjectsRemoved, ObjectInfoSeq(), ids, dbSerial);
+    addExpectedUpdate(_serial);
+    return _serial;
+}
+
+void
+ObjectObserverTopic::publishBulkUpdates()
+{
+    Lock sync(*this);
+    if(_publishingBulkUpdates)
+    {
+        return; // Another thread publishes the queued updates in order.
+    }
+
+    _publishingBulkUpdates = true;
+    while(!_bulkUpdates.empty())
+    {
+        BulkUpdate update;
+        update.operation = _bulkUpdates.front().operation;
+        update.infos.swap(_bulkUpdates.front().infos);
+        update.ids.swap(_bulkUpdates.front().ids);
+        update.serial = _bulkUpdates.front().serial;
+        update.dbSerial = _bulkUpdates.front().dbSerial;
+        _bulkUpdates.pop_front();
+
+        if(!_topics.empty())
+        {
+            sync.release();
+            publishBulkUpdate(update);
+            sync.acquire();
+        }
+
+        --_pendingPublishes;
+        notifyAll();
+    }
+    _publishingBulkUpdates = false;
+}
+
+void
+ObjectObserverTopic::queueBulkUpdate(BulkOperation operation, const ObjectInfoSeq& infos,
+                                     const Ice::IdentitySeq& ids, Ice::Long dbSerial)
+{
+    _bulkUpdates.push_back(BulkUpdate());
+    BulkUpdate& update = _bulkUpdates.back();
+    update.operation = operation;
+    update.infos = infos;
+    update.ids = ids;
+    update.serial = _serial;
+    update.dbSerial = dbSerial;
+    ++_pendingPublishes;
+}
+
+void
+ObjectObserverTopic::publishBulkUpdate(const BulkUpdate& update)
+{
+    //
+    // Called without the topic lock, the publishers don't change.
+    //
+    const Ice::Context context = getContext(update.serial, update.dbSerial);
+    const char* operation = 0;
+    try
+    {
+        switch(update.operation)
+        {
+        case ObjectsAdded:
+        {
+            operation = "objectsAdded";
+            for(vector<DatabaseObserverPrx>::const_iterator p = _replicaPublishers.begin();
+                p != _replicaPublishers.end(); ++p)
+            {
+                (*p)->objectsAdded(update.infos, context);
+            }
+            for(ObjectInfoSeq::const_iterator p = update.infos.begin(); p != update.infos.end(); ++p)
+            {
+                for(vector<ObjectObserverPrx>::const_iterator q = _observerPublishers.begin();
+                    q != _observerPublishers.end(); ++q)
+                {
+                    (*q)->objectAdded(*p, context);
+                }
+            }
+            break;
+        }
+        case ObjectsUpdated:
+        {
+            operation = "objectsUpdated";
+            for(vector<DatabaseObserverPrx>::const_iterator p = _replicaPublishers.begin();
+                p != _replicaPublishers.end(); ++p)
+            {
+                (*p)->objectsUpdated(update.infos, context);
+            }
+            for(ObjectInfoSeq::const_iterator p = update.infos.begin(); p != update.infos.end(); ++p)
+            {
+                for(vector<ObjectObserverPrx>::const_iterator q = _observerPublishers.begin();
+                    q != _observerPublishers.end(); ++q)
+                {
+                    (*q)->objectUpdated(*p, context);
+                }
+            }
+            break;
+        }
+        case ObjectsRemoved:
+        {
+            operation = "objectsRemoved";
+            for(vector<DatabaseObserverPrx>::const_iterator p = _replicaPublishers.begin();
+                p != _replicaPublishers.end(); ++p)
+            {
+                (*p)->objectsRemoved(update.ids, context);
+            }
+            for(Ice::IdentitySeq::const_iterator p = update.ids.begin(); p != update.ids.end(); ++p)
+            {
+                for(vector<ObjectObserverPrx>::const_iterator q = _observerPublishers.begin();
+                    q != _observerPublishers.end(); ++q)
+                {
+                    (*q)->objectRemoved(*p, context);
+                }
+            }
+            break;
+        }
+        }
+    }
+    catch(const Ice::LocalException& ex)
+    {
+        Ice::Warning out(_logger);
+        out << "unexpected exception while publishing `" << operation << "' update:\n" << ex;
+    }
+}
+
 int
 ObjectObserverTopic::wellKnownObjectsAddedOrUpdated(const ObjectInfoSeq& infos)
 {
     Lock sync(*this);
+    waitForPendingPublishesNoSync();
     if(_topics.empty())
     {
         return -1;
@@ -986,6 +1424,7 @@ ObjectObserverTopic::wellKnownObjectsAddedOrUpdated(const ObjectInfoSeq& infos)
     for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
     {
         updateSerial();
+        _updateLog.updated(p->proxy->ice_getIdentity(), 0);
         map<Ice::Identity, ObjectInfo>::iterator q = _objects.find(p->proxy->ice_getIdentity());
         if(q != _objects.end())
         {
@@ -1034,6 +1473,7 @@ int
 ObjectObserverTopic::wellKnownObjectsRemoved(const ObjectInfoSeq& infos)
 {
     Lock sync(*this);
+    waitForPendingPublishesNoSync();
     if(_topics.empty())
     {
         return -1;
@@ -1043,6 +1483,7 @@ ObjectObserverTopic::wellKnownObjectsRemoved(const ObjectInfoSeq& infos)
     {
         updateSerial();
         _objects.erase(p->proxy->ice_getIdentity());
+        _updateLog.removed(p->proxy->ice_getIdentity(), 0);
         try
         {
             for(vector<ObjectObserverPrx>::const_iterator q = _publishers.begin(); q != _publishers.end(); ++q)
@@ -1078,3 +1519,41 @@ ObjectObserverTopic::initObserver(const Ice::ObjectPrx& obsv)
     }
     observer->objectInit(objects, getContext(_serial, _dbSerial));
 }
+
+bool
+ObjectObserverTopic::updateObserver(const Ice::ObjectPrx& obsv, Ice::Long dbSerial)
+{
+    vector<pair<Ice::Long, Ice::Identity> > updates;
+    if(!_updateLog.getUpdates(dbSerial, updates))
+    {
+        initObserver(obsv);
+        return true;
+    }
+    else if(updates.empty())
+    {
+        return false;
+    }
+
+    //
+    // Send the objects updated since the observer database serial.
+    // Only the last update carries the serial waited for by the
+    // subscriber, and only the last object of a bulk update carries
+    // the database serial of the update.
+    //
+    ObjectObserverPrx observer = ObjectObserverPrx::uncheckedCast(obsv);
+    for(vector<pair<Ice::Long, Ice::Identity> >::const_iterator p = updates.begin(); p != updates.end(); ++p)
+    {
+        const bool last = p + 1 == updates.end();
+        Ice::Context context = getContext(last ? _serial : -1, last || (p + 1)->first != p->first ? p->first : 0);
+        map<Ice::Identity, ObjectInfo>::const_iterator q = _objects.find(p->second);
+        if(q != _objects.end())
+        {
+            observer->objectUpdated(q->second, context);
+        }
+        else
+        {
+            observer->objectRemoved(p->second, context);
+        }
+    }
+    return true;
+}
@@ -11,14 +11,123 @@
 #define ICEGRID_TOPICS_H
 
 #include <IceUtil/Mutex.h>
+#include <IceUtil/Timer.h>
 #include <IceStorm/IceStorm.h>
 #include <IceGrid/Internal.h>
 #include <IceGrid/Registry.h>
+#include <algorithm>
+#include <deque>
 #include <set>
 
 namespace IceGrid
 {
 
+//
+// The update log of a database topic records the database serial of
+// the last update of each entry. It allows to initialize a replica
+// with only the entries updated since the serial of its database.
+//
+// Entries updated without a database serial (the registry well-known
+// objects) are always part of the updates. The log only keeps a
+// bounded number of removed entries: once the oldest removal is
+// dropped, the replicas with an older serial are fully initialized.
+//
+template<typename K> class UpdateLog
+{
+public:
+
+    UpdateLog(Ice::Long serial, size_t maxRemoved) : _start(serial), _maxRemoved(maxRemoved)
+    {
+    }
+
+    void
+    reset(Ice::Long serial)
+    {
+        _start = serial;
+        _serials.clear();
+        _updates.clear();
+        _removed.clear();
+        _unserialized.clear();
+    }
+
+    void
+    updated(const K& key, Ice::Long serial)
+    {
+        erase(key);
+        if(serial > 0)
+        {
+            _serials.insert(std::make_pair(key, serial));
+            _updates.insert(std::make_pair(serial, key));
+        }
+        else
+        {
+            _unserialized.insert(key);
+        }
+    }
+
+    void
+    removed(const K& key, Ice::Long serial)
+    {
+        updated(key, serial);
+        if(serial > 0)
+        {
+            _removed.insert(std::make_pair(serial, key));
+            while(_removed.size() > _maxRemoved)
+            {
+                std::pair<Ice::Long, K> oldest = *_removed.begin();
+                erase(oldest.second);
+                _start = std::max(_start, oldest.first);
+            }
+        }
+    }
+
+    //
+    // Get the entries updated since the given serial with the serial
+    // of their last update (0 if unknown), in update order. Returns
+    // false if the log doesn't go back to the given serial.
+    //
+    bool
+    getUpdates(Ice::Long serial, std::vector<std::pair<Ice::Long, K> >& updates) const
+    {
+        if(serial < _start)
+        {
+            return false;
+        }
+        typename std::set<std::pair<Ice::Long, K> >::const_iterator p;
+        for(p = _updates.lower_bound(std::make_pair(serial + 1, K())); p != _updates.end(); ++p)
+        {
+            updates.push_back(*p);
+        }
+        for(typename std::set<K>::const_iterator q = _unserialized.begin(); q != _unserialized.end(); ++q)
+        {
+            updates.push_back(std::make_pair(Ice::Long(0), *q));
+        }
+        return true;
+    }
+
+private:
+
+    void
+    erase(const K& key)
+    {
+        typename std::map<K, Ice::Long>::iterator p = _serials.find(key);
+        if(p != _serials.end())
+        {
+            _updates.erase(std::make_pair(p->second, key));
+            _removed.erase(std::make_pair(p->second, key));
+            _serials.erase(p);
+        }
+        _unserialized.erase(key);
+    }
+
+    Ice::Long _start; // The log holds the updates after this serial.
+    const size_t _maxRemoved;
+    std::map<K, Ice::Long> _serials;
+    std::set<std::pair<Ice::Long, K> > _updates;
+    std::set<std::pair<Ice::Long, K> > _removed;
+    std::set<K> _unserialized;
+};
+
 class ObserverTopic : public IceUtil::Monitor<IceUtil::Mutex>, public virtual Ice::Object
 {
 public:
@@ -26,14 +135,22 @@ public:
     ObserverTopic(const IceStorm::TopicManagerPrx&, const std::string&, Ice::Long = 0);
     virtual ~ObserverTopic();
 
-    int subscribe(const Ice::ObjectPrx&, const std::string& = std::string());
+    int subscribe(const Ice::ObjectPrx&, const std::string& = std::string(), Ice::Long = 0);
     void unsubscribe(const Ice::ObjectPrx&, const std::string& = std::string());
-    void destroy();
+    virtual void destroy();
 
     void receivedUpdate(const std::string&, int, const std::string&);
 
     virtual void initObserver(const Ice::ObjectPrx&) = 0;
 
+    //
+    // Initialize an observer whose database is at the given serial.
+    // Returns false if the observer is up to date and wasn't sent any
+    // update. The default implementation sends the whole state unless
+    // the serial is the serial of the topic.
+    //
+    virtual bool updateObserver(const Ice::ObjectPrx&, Ice::Long);
+
     void waitForSyncedSubscribers(int, const std::string& = std::string());
 
     int getSerial() const;
@@ -42,13 +159,21 @@ protected:
 
     void addExpectedUpdate(int, const std::string& = std::string());
     void waitForSyncedSubscribersNoSync(int, const std::string& = std::string());
+    void waitForPendingPublishesNoSync();
     void updateSerial(Ice::Long = 0);
     Ice::Context getContext(int, Ice::Long = 0) const;
+    void createTopics(const IceStorm::TopicManagerPrx&, const std::string&,
+                      std::map<Ice::EncodingVersion, IceStorm::TopicPrx>&, std::vector<Ice::ObjectPrx>&);
 
     template<typename T> std::vector<T> getPublishers() const
+    {
+        return getPublishers<T>(_basePublishers);
+    }
+
+    template<typename T> std::vector<T> getPublishers(const std::vector<Ice::ObjectPrx>& basePublishers) const
     {
         std::vector<T> publishers;
-        for(std::vector<Ice::ObjectPrx>::const_iterator p = _basePublishers.begin(); p != _basePublishers.end(); ++p)
+        for(std::vector<Ice::ObjectPrx>::const_iterator p = basePublishers.begin(); p != basePublishers.end(); ++p)
         {
             publishers.push_back(T::uncheckedCast(*p));
         }
@@ -61,6 +186,18 @@ protected:
     int _serial;
     Ice::Long _dbSerial;
 
+    //
+    // The topics of the synced subscribers (the replicas), if they
+    // don't subscribe to the same topics as the other observers.
+    //
+    std::map<Ice::EncodingVersion, IceStorm::TopicPrx> _syncTopics;
+
+    //
+    // The number of updates not published yet, they're published
+    // without the topic lock once the database lock is released.
+    //
+    int _pendingPublishes;
+
     std::set<std::string> _syncSubscribers;
     std::map<int, std::set<std::string> > _waitForUpdates;
     std::map<int, std::map<std::string, std::string> > _updateFailures;
@@ -101,12 +238,28 @@ public:
 
     void nodeDown(const std::string&);
     virtual void initObserver(const Ice::ObjectPrx&);
+    virtual void destroy();
+
+    void flushUpdates();
 
 private:
 
+    void scheduleFlush();
+    void flushUpdatesNoSync();
+
     const NodeObserverPrx _externalPublisher;
     std::vector<NodeObserverPrx> _publishers;
     std::map<std::string, NodeDynamicInfo> _nodes;
+
+    //
+    // If the updates are batched, the server and adapter updates not
+    // published yet, by node and server or adapter id.
+    //
+    IceUtil::Time _batchDelay;
+    IceUtil::TimerPtr _timer;
+    bool _flushScheduled;
+    std::map<std::string, std::map<std::string, ServerDynamicInfo> > _serverUpdates;
+    std::map<std::string, std::map<std::string, AdapterDynamicInfo> > _adapterUpdates;
 };
 typedef IceUtil::Handle<NodeObserverTopic> NodeObserverTopicPtr;
 
@@ -142,11 +295,13 @@ public:
     int adapterRemoved(Ice::Long, const std::string&);
 
     virtual void initObserver(const Ice::ObjectPrx&);
+    virtual bool updateObserver(const Ice::ObjectPrx&, Ice::Long);
 
 private:
 
     std::vector<AdapterObserverPrx> _publishers;
     std::map<std::string, AdapterInfo> _adapters;
+    UpdateLog<std::string> _updateLog;
 };
 typedef IceUtil::Handle<AdapterObserverTopic> AdapterObserverTopicPtr;
 
@@ -160,16 +315,46 @@ public:
     int objectAdded(Ice::Long, const ObjectInfo&);
     int objectUpdated(Ice::Long, const ObjectInfo&);
     int objectRemoved(Ice::Long, const Ice::Identity&);
+    int objectsAdded(Ice::Long, const ObjectInfoSeq&);
+    int objectsUpdated(Ice::Long, const ObjectInfoSeq&);
+    int objectsRemoved(Ice::Long, const Ice::IdentitySeq&);
 
     int wellKnownObjectsAddedOrUpdated(const ObjectInfoSeq&);
     int wellKnownObjectsRemoved(const ObjectInfoSeq&);
 
+    void publishBulkUpdates();
+
     virtual void initObserver(const Ice::ObjectPrx&);
+    virtual bool updateObserver(const Ice::ObjectPrx&, Ice::Long);
 
 private:
 
-    std::vector<ObjectObserverPrx> _publishers;
+    enum BulkOperation
+    {
+        ObjectsAdded,
+        ObjectsUpdated,
+        ObjectsRemoved
+    };
+
+    struct BulkUpdate
+    {
+        BulkOperation operation;
+        ObjectInfoSeq infos;
+        Ice::IdentitySeq ids;
+        int serial;
+        Ice::Long dbSerial;
+    };
+
+    void queueBulkUpdate(BulkOperation, const ObjectInfoSeq&, const Ice::IdentitySeq&, Ice::Long);
+    void publishBulkUpdate(const BulkUpdate&);
+
+    std::vector<ObjectObserverPrx> _publishers; // The publishers of the observers and replicas topics.
+    std::vector<ObjectObserverPrx> _observerPublishers;
+    std::vector<DatabaseObserverPrx> _replicaPublishers;
     std::map<Ice::Identity, ObjectInfo> _objects;
+    UpdateLog<Ice::Identity> _updateLog;
+    std::deque<BulkUpdate> _bulkUpdates;
+    bool _publishingBulkUpdates;
 };
 typedef IceUtil::Handle<ObjectObserverTopic> ObjectObserverTopicPtr;
 
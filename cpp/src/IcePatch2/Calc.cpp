@@ -12,6 +12,7 @@
 #include <IceUtil/FileUtil.h>
 #include <IcePatch2Lib/Util.h>
 #include <iterator>
+#include <sstream>
 
 using namespace std;
 using namespace Ice;
@@ -106,7 +107,11 @@ usage(const string& appName)
         "-v, --version           Display the Ice version.\n"
         "-z, --compress          Always compress files.\n"
         "-Z, --no-compress       Never compress files.\n"
+        "--zstd                  Also compress files with Zstandard.\n"
         "-i, --case-insensitive  Files must not differ in case only.\n"
+        "-j, --threads N         Compute the checksums with N threads.\n"
+        "-I, --incremental       Only compute the checksums of the files updated\n"
+        "                        since the last run.\n"
         "-V, --verbose           Verbose mode.\n"
         ;
 }
@@ -131,14 +136,20 @@ main(int argc, char* argv[])
     int compress = 1;
     bool verbose;
     bool caseInsensitive;
+    bool incremental;
+    bool zstd;
+    int threads = 1;
 
     IceUtilInternal::Options opts;
     opts.addOpt("h", "help");
     opts.addOpt("v", "version");
     opts.addOpt("z", "compress");
     opts.addOpt("Z", "no-compress");
+    opts.addOpt("", "zstd");
     opts.addOpt("V", "verbose");
     opts.addOpt("i", "case-insensitive");
+    opts.addOpt("j", "threads", IceUtilInternal::Options::NeedArg);
+    opts.addOpt("I", "incremental");
     
     vector<string> args;
     try
@@ -180,6 +191,29 @@ main(int argc, char* argv[])
     }
     verbose = opts.isSet("verbose");
     caseInsensitive = opts.isSet("case-insensitive");
+    incremental = opts.isSet("incremental");
+    zstd = opts.isSet("zstd");
+    if(zstd && !hasZstd())
+    {
+        cerr << appName << ": Zstandard support is not available" << endl;
+        return EXIT_FAILURE;
+    }
+    if(zstd && dontCompress)
+    {
+        cerr << appName << ": --zstd and -Z are mutually exclusive" << endl;
+        usage(appName);
+        return EXIT_FAILURE;
+    }
+    if(opts.isSet("threads"))
+    {
+        istringstream is(opts.optArg("threads"));
+        if(!(is >> threads) || !is.eof() || threads < 1)
+        {
+            cerr << appName << ": invalid number of threads `" << opts.optArg("threads") << "'" << endl;
+            usage(appName);
+            return EXIT_FAILURE;
+        }
+    }
 
     if(args.empty())
     {
@@ -239,7 +273,7 @@ main(int argc, char* argv[])
         if(fileSeq.empty())
         {
             CalcCB calcCB;
-            if(!getFileInfoSeq(absDataDir, compress, verbose ? &calcCB : 0, infoSeq))
+            if(!getFileInfoSeq(absDataDir, compress, verbose ? &calcCB : 0, infoSeq, threads, incremental, zstd))
             {
                 return EXIT_FAILURE;
             }
@@ -253,7 +287,8 @@ main(int argc, char* argv[])
                 LargeFileInfoSeq partialInfoSeq;
 
                 CalcCB calcCB;
-                if(!getFileInfoSeqSubDir(absDataDir, *p, compress, verbose ? &calcCB : 0, partialInfoSeq))
+                if(!getFileInfoSeqSubDir(absDataDir, *p, compress, verbose ? &calcCB : 0, partialInfoSeq, threads,
+                                         incremental, zstd))
                 {
                     return EXIT_FAILURE;
                 }
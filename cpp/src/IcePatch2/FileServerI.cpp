@@ -10,12 +10,15 @@
 #include <IceUtil/DisableWarnings.h>
 #include <IceUtil/FileUtil.h>
 #include <IceUtil/StringUtil.h>
+#include <IceUtil/StringConverter.h>
 #include <IcePatch2/FileServerI.h>
 
 #ifdef _WIN32
 #   include <io.h>
+#   include <windows.h>
 #else
 #   include <unistd.h>
+#   include <sys/mman.h>
 #endif
 
 using namespace std;
@@ -23,8 +26,226 @@ using namespace Ice;
 using namespace IcePatch2;
 using namespace IcePatch2Internal;
 
-IcePatch2::FileServerI::FileServerI(const std::string& dataDir, const LargeFileInfoSeq& infoSeq) :
-    _dataDir(dataDir), _tree0(FileTree0())
+namespace
+{
+
+string
+checkPath(const string& pa)
+{
+    if(IceUtilInternal::isAbsolutePath(pa))
+    {
+        throw FileAccessException(string("illegal absolute path `") + pa + "'");
+    }
+
+    string path = simplify(pa);
+    
+    if(path == ".." ||
+       path.find("/../") != string::npos ||
+       (path.size() >= 3 && (path.substr(0, 3) == "../" || path.substr(path.size() - 3, 3) == "/..")))
+    {
+        throw FileAccessException(string("illegal `..' component in path `") + path + "'");
+    }
+    return path;
+}
+
+}
+
+IcePatch2::MappedFile::MappedFile(const string& path, const IceUtilInternal::structstat& buf) :
+    _path(path),
+    _size(static_cast<Long>(buf.st_size)),
+    _buf(buf),
+#ifdef _WIN32
+    _file(INVALID_HANDLE_VALUE),
+    _mapping(0),
+#else
+    _fd(-1),
+#endif
+    _data(0)
+{
+    if(static_cast<Long>(static_cast<size_t>(_size)) != _size)
+    {
+        throw "cannot map `" + _path + "': file too large";
+    }
+
+    if(_size == 0)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    const wstring wpath = IceUtil::stringToWstring(_path, IceUtil::getProcessStringConverter());
+    _file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if(_file == INVALID_HANDLE_VALUE)
+    {
+        throw "cannot open `" + _path + "' for reading:\n" + IceUtilInternal::lastErrorToString();
+    }
+
+    _mapping = CreateFileMappingW(_file, 0, PAGE_READONLY, 0, 0, 0);
+    if(_mapping)
+    {
+        _data = static_cast<Byte*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, static_cast<SIZE_T>(_size)));
+    }
+    if(!_data)
+    {
+        string ex = "cannot map `" + _path + "':\n" + IceUtilInternal::lastErrorToString();
+        if(_mapping)
+        {
+            CloseHandle(_mapping);
+        }
+        CloseHandle(_file);
+        throw ex;
+    }
+#else
+    _fd = IceUtilInternal::open(_path, O_RDONLY);
+    if(_fd == -1)
+    {
+        throw "cannot open `" + _path + "' for reading:\n" + IceUtilInternal::lastErrorToString();
+    }
+
+    void* data = ::mmap(0, static_cast<size_t>(_size), PROT_READ, MAP_SHARED, _fd, 0);
+    if(data == MAP_FAILED)
+    {
+        string ex = "cannot map `" + _path + "':\n" + IceUtilInternal::lastErrorToString();
+        IceUtilInternal::close(_fd);
+        throw ex;
+    }
+    _data = static_cast<Byte*>(data);
+
+    //
+    // The files are mostly read sequentially by the clients.
+    //
+    ::madvise(data, static_cast<size_t>(_size), MADV_SEQUENTIAL);
+#endif
+}
+
+IcePatch2::MappedFile::~MappedFile()
+{
+    if(!_data)
+    {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(_data);
+    CloseHandle(_mapping);
+    CloseHandle(_file);
+#else
+    ::munmap(_data, static_cast<size_t>(_size));
+    IceUtilInternal::close(_fd);
+#endif
+}
+
+bool
+IcePatch2::MappedFile::matches(const IceUtilInternal::structstat& buf) const
+{
+    return buf.st_size == _buf.st_size && buf.st_mtime == _buf.st_mtime
+#ifndef _WIN32
+        && buf.st_ino == _buf.st_ino && buf.st_dev == _buf.st_dev
+#endif
+        ;
+}
+
+void
+IcePatch2::MappedFile::prefetch(Long pos, Long num) const
+{
+#ifndef _WIN32
+    if(pos >= _size || num <= 0)
+    {
+        return;
+    }
+
+    static const Long pageSize = sysconf(_SC_PAGESIZE);
+    const Long start = pos - pos % pageSize;
+    const Long end = min(pos + num, _size);
+    ::madvise(_data + start, static_cast<size_t>(end - start), MADV_WILLNEED);
+#else
+    (void)pos;
+    (void)num;
+#endif
+}
+
+IcePatch2::FileCache::FileCache(size_t size) : _size(size)
+{
+}
+
+MappedFilePtr
+IcePatch2::FileCache::get(const string& path)
+{
+    if(_size == 0)
+    {
+        return 0;
+    }
+
+    const IceUtil::Time now = IceUtil::Time::now(IceUtil::Time::Monotonic);
+    MappedFilePtr file;
+    {
+        Lock sync(*this);
+        map<string, Entry>::iterator p = _files.find(path);
+        if(p != _files.end())
+        {
+            _lru.splice(_lru.begin(), _lru, p->second.lru);
+            if(now - p->second.checked < IceUtil::Time::seconds(1))
+            {
+                return p->second.file;
+            }
+            file = p->second.file;
+        }
+    }
+
+    //
+    // Check if the cached file is still up-to-date or map the file,
+    // this is done without holding the lock.
+    //
+    IceUtilInternal::structstat buf;
+    if(IceUtilInternal::stat(path, &buf) == -1)
+    {
+        return 0; // The caller reports the error.
+    }
+
+    if(!file || !file->matches(buf))
+    {
+        try
+        {
+            file = new MappedFile(path, buf);
+        }
+        catch(const string&)
+        {
+            file = 0; // The caller falls back to reading the file.
+        }
+    }
+
+    Lock sync(*this);
+    map<string, Entry>::iterator p = _files.find(path);
+    if(!file)
+    {
+        if(p != _files.end())
+        {
+            _lru.erase(p->second.lru);
+            _files.erase(p);
+        }
+        return 0;
+    }
+
+    if(p == _files.end())
+    {
+        _lru.push_front(path);
+        Entry entry;
+        entry.lru = _lru.begin();
+        p = _files.insert(make_pair(path, entry)).first;
+
+        while(_files.size() > _size)
+        {
+            _files.erase(_lru.back());
+            _lru.pop_back();
+        }
+    }
+    p->second.file = file;
+    p->second.checked = now;
+    return file;
+}
+
+IcePatch2::FileServerI::FileServerI(const std::string& dataDir, const LargeFileInfoSeq& infoSeq, size_t cacheSize) :
+    _dataDir(dataDir), _tree0(FileTree0()), _cache(new FileCache(cacheSize))
 {
     FileTree0& tree0 = const_cast<FileTree0&>(_tree0);
     getFileTree0(infoSeq, tree0);
@@ -77,15 +298,8 @@ IcePatch2::FileServerI::getFileCompressed_async(const AMD_FileServer_getFileComp
     try
     {
         vector<Byte> buffer;
-        getFileCompressedInternal(pa, pos, num, buffer, false);
-        if(buffer.empty())
-        {
-            cb->ice_response(make_pair<const Byte*, const Byte*>(0, 0));
-        }
-        else
-        {
-            cb->ice_response(make_pair<const Byte*, const Byte*>(&buffer[0], &buffer[0] + buffer.size()));
-        }
+        MappedFilePtr file;
+        cb->ice_response(getFileCompressedInternal(pa, pos, num, buffer, file, false));
     }
     catch(const std::exception& ex)
     {
@@ -100,16 +314,8 @@ IcePatch2::FileServerI::getLargeFileCompressed_async(const AMD_FileServer_getLar
     try
     {
         vector<Byte> buffer;
-        getFileCompressedInternal(pa, pos, num, buffer, true);
-        if(buffer.empty())
-        {
-            cb->ice_response(make_pair<const Byte*, const Byte*>(0, 0));
-        }
-        else
-        {
-            cb->ice_response(make_pair<const Byte*, const Byte*>(&buffer[0], &buffer[0] + buffer.size()));
-        }
-        
+        MappedFilePtr file;
+        cb->ice_response(getFileCompressedInternal(pa, pos, num, buffer, file, true));
     }
     catch(const std::exception& ex)
     {
@@ -117,30 +323,150 @@ IcePatch2::FileServerI::getLargeFileCompressed_async(const AMD_FileServer_getLar
     }
 }
 
+FileChunkInfoSeq
+IcePatch2::FileServerI::getFileChunks(const string& pa, const Current&) const
+{
+    string path = checkPath(pa);
+    string absolutePath = _dataDir + '/' + path;
+
+    //
+    // The chunks are only returned if they are up-to-date with the
+    // file, otherwise the client downloads the whole file.
+    //
+    IceUtilInternal::structstat buf;
+    IceUtilInternal::structstat bufChunks;
+    if(IceUtilInternal::stat(absolutePath, &buf) == -1 ||
+       IceUtilInternal::stat(absolutePath + ".chunks", &bufChunks) == -1 ||
+       buf.st_mtime > bufChunks.st_mtime)
+    {
+        return FileChunkInfoSeq();
+    }
+
+    FileChunkInfoSeq chunks;
+    try
+    {
+        loadFileChunks(absolutePath + ".chunks", chunks);
+    }
+    catch(const string& ex)
+    {
+        throw FileAccessException(ex);
+    }
+
+    if(chunks.empty() || chunks.back().offset + chunks.back().size != static_cast<Long>(buf.st_size))
+    {
+        return FileChunkInfoSeq();
+    }
+    return chunks;
+}
+
 void
-IcePatch2::FileServerI::getFileCompressedInternal(const std::string& pa, Ice::Long pos, Ice::Int num, 
-                                                  vector<Byte>& buffer, bool largeFile) const
+IcePatch2::FileServerI::getFileRange_async(const AMD_FileServer_getFileRangePtr& cb,
+                                           const string& pa, Long pos, Int num, const Current&) const
 {
-    if(IceUtilInternal::isAbsolutePath(pa))
+    try
     {
-        throw FileAccessException(string("illegal absolute path `") + pa + "'");
+        vector<Byte> buffer;
+        MappedFilePtr file;
+        cb->ice_response(getFileCompressedInternal(pa, pos, num, buffer, file, true, ""));
+    }
+    catch(const std::exception& ex)
+    {
+        cb->ice_exception(ex);
+    }
+}
+
+LongSeq
+IcePatch2::FileServerI::getZstdFileSizes(const StringSeq& paths, const Current&) const
+{
+    LongSeq sizes;
+    sizes.reserve(paths.size());
+    for(StringSeq::const_iterator p = paths.begin(); p != paths.end(); ++p)
+    {
+        string absolutePath = _dataDir + '/' + checkPath(*p);
+
+        //
+        // The Zstandard-compressed file is only used if it is
+        // up-to-date with the file, like the chunks, otherwise the
+        // client downloads the bzip2-compressed file.
+        //
+        IceUtilInternal::structstat buf;
+        IceUtilInternal::structstat bufZstd;
+        if(IceUtilInternal::stat(absolutePath, &buf) == -1 ||
+           IceUtilInternal::stat(absolutePath + ".zst", &bufZstd) == -1 ||
+           buf.st_mtime > bufZstd.st_mtime)
+        {
+            sizes.push_back(-1);
+        }
+        else
+        {
+            sizes.push_back(static_cast<Long>(bufZstd.st_size));
+        }
     }
+    return sizes;
+}
 
-    string path = simplify(pa);
-    
-    if(path == ".." ||
-       path.find("/../") != string::npos ||
-       (path.size() >= 3 && (path.substr(0, 3) == "../" || path.substr(path.size() - 3, 3) == "/..")))
+void
+IcePatch2::FileServerI::getFileZstd_async(const AMD_FileServer_getFileZstdPtr& cb,
+                                          const string& pa, Long pos, Int num, const Current&) const
+{
+    try
     {
-        throw FileAccessException(string("illegal `..' component in path `") + path + "'");
+        vector<Byte> buffer;
+        MappedFilePtr file;
+        cb->ice_response(getFileCompressedInternal(pa, pos, num, buffer, file, true, ".zst"));
+    }
+    catch(const std::exception& ex)
+    {
+        cb->ice_exception(ex);
     }
+}
+
+pair<const Byte*, const Byte*>
+IcePatch2::FileServerI::getFileCompressedInternal(const std::string& pa, Ice::Long pos, Ice::Int num, 
+                                                  vector<Byte>& buffer, MappedFilePtr& file, bool largeFile,
+                                                  const char* suffix) const
+{
+    string path = checkPath(pa);
     
     if(num <= 0 || pos < 0)
     {   
-        return;
+        return make_pair<const Byte*, const Byte*>(0, 0);
     }
     
-    string absolutePath = _dataDir + '/' + path + ".bz2";
+    string absolutePath = _dataDir + '/' + path + suffix;
+
+    //
+    // If the file is mapped, the response is marshaled directly from
+    // the mapping and the next range of the file is read ahead. Only
+    // the compressed files are mapped: IcePatch2Calc writes them to a
+    // temporary file which is renamed once complete, so they are never
+    // truncated or rewritten while mapped, which would raise SIGBUS
+    // when the mapping is read. The uncompressed files might be
+    // updated in place and are always read.
+    //
+    if(*suffix != '\0')
+    {
+        file = _cache->get(absolutePath);
+    }
+    if(file)
+    {
+        if(!largeFile && file->size() > 0x7FFFFFFF)
+        {
+            ostringstream os;
+            os << "cannot encode size `" << file->size() << "' for file `" << path << "' as Ice::Int" << endl;
+            throw FileAccessException(os.str());
+        }
+
+        if(pos >= file->size())
+        {
+            return make_pair<const Byte*, const Byte*>(0, 0);
+        }
+
+        const Long end = min(pos + num, file->size());
+        file->prefetch(end, num);
+        return make_pair(file->data() + pos, file->data() + end);
+    }
+
     int fd = IceUtilInternal::open(absolutePath, O_RDONLY|O_BINARY);
     if(fd == -1)
     {
@@ -192,6 +518,13 @@ IcePatch2::FileServerI::getFileCompressedInternal(const std::string& pa, Ice::Lo
         IceUtilInternal::close(fd);
         throw FileAccessException("cannot read `" + path + "': " + strerror(errno));
     }
+    buffer.resize(static_cast<size_t>(r));
 
     IceUtilInternal::close(fd);
+
+    if(buffer.empty())
+    {
+        return make_pair<const Byte*, const Byte*>(0, 0);
+    }
+    return make_pair<const Byte*, const Byte*>(&buffer[0], &buffer[0] + buffer.size());
 }
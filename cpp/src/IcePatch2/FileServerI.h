@@ -10,17 +10,95 @@
 #ifndef ICE_PATCH2_FILE_SERVER_I_H
 #define ICE_PATCH2_FILE_SERVER_I_H
 
+#include <IceUtil/Mutex.h>
+#include <IceUtil/Time.h>
 #include <IcePatch2Lib/Util.h>
 #include <IcePatch2/FileServer.h>
 
+#include <list>
+#include <map>
+
 namespace IcePatch2
 {
 
+//
+// A read-only memory mapping of a file served by the file server.
+//
+class MappedFile : public IceUtil::Shared
+{
+public:
+
+    MappedFile(const std::string&, const IceUtilInternal::structstat&);
+    ~MappedFile();
+
+    const Ice::Byte* data() const { return _data; }
+    Ice::Long size() const { return _size; }
+
+    //
+    // Returns true if the file is still the mapped file.
+    //
+    bool matches(const IceUtilInternal::structstat&) const;
+
+    //
+    // Advise the system that the given range of the file will be
+    // read soon.
+    //
+    void prefetch(Ice::Long, Ice::Long) const;
+
+private:
+
+    const std::string _path;
+    const Ice::Long _size;
+    const IceUtilInternal::structstat _buf;
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#else
+    int _fd;
+#endif
+    Ice::Byte* _data;
+};
+typedef IceUtil::Handle<MappedFile> MappedFilePtr;
+
+//
+// A LRU cache of the files mapped by the file server. A cached file
+// is checked against the file system at most once per second, files
+// replaced since they were mapped are mapped again. The files must
+// be replaced by renaming a new file over them: a mapped file which
+// is truncated raises SIGBUS when its mapping is read.
+//
+class FileCache : public IceUtil::Shared, public IceUtil::Mutex
+{
+public:
+
+    FileCache(size_t);
+
+    //
+    // Get the mapping of the given file, returns a null handle if the
+    // cache is disabled or if the file can't be mapped.
+    //
+    MappedFilePtr get(const std::string&);
+
+private:
+
+    struct Entry
+    {
+        MappedFilePtr file;
+        IceUtil::Time checked;
+        std::list<std::string>::iterator lru;
+    };
+
+    const size_t _size;
+    std::map<std::string, Entry> _files;
+    std::list<std::string> _lru; // The most recently used file first.
+};
+typedef IceUtil::Handle<FileCache> FileCachePtr;
+
 class FileServerI : public FileServer
 {
 public:
 
-    FileServerI(const std::string&, const LargeFileInfoSeq&);
+    FileServerI(const std::string&, const LargeFileInfoSeq&, size_t);
 
     FileInfoSeq getFileInfoSeq(Ice::Int, const Ice::Current&) const;
     
@@ -43,17 +121,36 @@ public:
                                       Ice::Int, 
                                       const Ice::Current&) const;
 
+    FileChunkInfoSeq getFileChunks(const std::string&, const Ice::Current&) const;
+
+    void getFileRange_async(const AMD_FileServer_getFileRangePtr&,
+                            const std::string&,
+                            Ice::Long,
+                            Ice::Int,
+                            const Ice::Current&) const;
+
+    Ice::LongSeq getZstdFileSizes(const Ice::StringSeq&, const Ice::Current&) const;
+
+    void getFileZstd_async(const AMD_FileServer_getFileZstdPtr&,
+                           const std::string&,
+                           Ice::Long,
+                           Ice::Int,
+                           const Ice::Current&) const;
+
 private:
     
-    void
+    std::pair<const Ice::Byte*, const Ice::Byte*>
     getFileCompressedInternal(const std::string&,
                               Ice::Long,
                               Ice::Int, 
                               std::vector<Ice::Byte>&,
-                              bool) const;
+                              MappedFilePtr&,
+                              bool,
+                              const char* = ".bz2") const;
 
     const std::string _dataDir;
     const IcePatch2Internal::FileTree0 _tree0;
+    const FileCachePtr _cache;
 };
 
 }
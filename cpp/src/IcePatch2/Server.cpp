@@ -141,7 +141,12 @@ IcePatch2::PatcherService::start(int argc, char* argv[], int& status)
     Identity id;
     id.category = instanceName;
     id.name = "server";
-    adapter->add(new FileServerI(dataDir, infoSeq), id);
+    //
+    // The number of files kept open and mapped by the file server.
+    //
+    const int cacheSize = properties->getPropertyAsIntWithDefault("IcePatch2.FileCacheSize", 32);
+
+    adapter->add(new FileServerI(dataDir, infoSeq, static_cast<size_t>(max(cacheSize, 0))), id);
 
     adapter->activate();
 
@@ -9,11 +9,20 @@
 
 #include <IceUtil/StringUtil.h>
 #include <IceUtil/FileUtil.h>
+#include <IceUtil/SHA1.h>
 #include <IcePatch2/ClientUtil.h>
 #include <IcePatch2Lib/Util.h>
 #include <list>
+#include <deque>
+#include <set>
 #include <iterator>
 
+#ifdef _WIN32
+#   include <io.h>
+#else
+#   include <unistd.h>
+#endif
+
 using namespace std;
 using namespace Ice;
 using namespace IceUtil;
@@ -42,7 +51,7 @@ public:
     virtual ~Decompressor();
 
     void destroy();
-    void add(const LargeFileInfo&);
+    void add(const LargeFileInfo&, bool);
     void exception() const;
     void log(FILE* fp);
     virtual void run();
@@ -52,12 +61,63 @@ private:
     const string _dataDir;
 
     string _exception;
-    list<LargeFileInfo> _files;
+    list<pair<LargeFileInfo, bool> > _files; // The files and whether they are Zstandard-compressed.
     LargeFileInfoSeq _filesDone;
     bool _destroy;
 };
 typedef IceUtil::Handle<Decompressor> DecompressorPtr;
 
+//
+// The number of bytes to download for the given file, the size of
+// its Zstandard-compressed file if it's downloaded instead of the
+// bzip2-compressed file.
+//
+Long
+getDownloadSize(const LargeFileInfo& info, const map<string, Long>& zstdFiles)
+{
+    map<string, Long>::const_iterator p = zstdFiles.find(info.path);
+    return p != zstdFiles.end() ? p->second : info.size;
+}
+
+//
+// The number of bytes to download to patch a file from its chunks,
+// the size of the chunks which aren't available in the local file.
+//
+Long
+getDeltaSize(const FileChunkInfoSeq& chunks, const FileChunkInfoSeq& localChunks)
+{
+    set<ByteSeq> local;
+    for(FileChunkInfoSeq::const_iterator p = localChunks.begin(); p != localChunks.end(); ++p)
+    {
+        local.insert(p->checksum);
+    }
+
+    Long size = 0;
+    for(FileChunkInfoSeq::const_iterator p = chunks.begin(); p != chunks.end(); ++p)
+    {
+        if(local.find(p->checksum) == local.end())
+        {
+            size += p->size;
+        }
+    }
+    return size;
+}
+
+//
+// A part of a file patched from its chunks, copied from the local
+// file or downloaded from the server.
+//
+struct FileSegment
+{
+    FileSegment(bool l, Long o, Int s) : local(l), offset(o), size(s)
+    {
+    }
+
+    bool local;
+    Long offset;
+    Int size;
+};
+
 class PatcherI : public Patcher
 {
 public:
@@ -75,7 +135,11 @@ private:
     void init(const FileServerPrx&);
     bool removeFiles(const LargeFileInfoSeq&);
     bool updateFiles(const LargeFileInfoSeq&);
-    bool updateFilesInternal(const LargeFileInfoSeq&, const DecompressorPtr&);
+    bool updateFilesInternal(const LargeFileInfoSeq&, const vector<DecompressorPtr>&);
+    void sendFileRequests(deque<AsyncResultPtr>&, const LargeFileInfoSeq&, LargeFileInfoSeq::const_iterator&,
+                          Ice::Long&, const map<string, FileChunkInfoSeq>&, const map<string, Ice::Long>&);
+    bool updateFileChunks(const LargeFileInfo&, const FileChunkInfoSeq&, const FileChunkInfoSeq&, Ice::Int,
+                          Ice::Long&, Ice::Long);
     bool updateFlags(const LargeFileInfoSeq&);
 
     const PatcherFeedbackPtr _feedback;
@@ -83,6 +147,8 @@ private:
     const bool _thorough;
     const Ice::Int _chunkSize;
     const Ice::Int _remove;
+    const Ice::Int _maxInFlight;
+    const Ice::Int _parallelism;
     const FileServerPrx _serverCompress;
     const FileServerPrx _serverNoCompress;
 
@@ -93,6 +159,8 @@ private:
 
     FILE* _log;
     bool _useSmallFileAPI;
+    bool _useChunks;
+    bool _useZstd;
 };
 
 Decompressor::Decompressor(const string& dataDir) :
@@ -115,14 +183,14 @@ Decompressor::destroy()
 }
 
 void
-Decompressor::add(const LargeFileInfo& info)
+Decompressor::add(const LargeFileInfo& info, bool zstd)
 {
     IceUtil::Monitor<IceUtil::Mutex>::Lock sync(*this);
     if(!_exception.empty())
     {
         throw _exception;
     }
-    _files.push_back(info);
+    _files.push_back(make_pair(info, zstd));
     notify();
 }
 
@@ -156,6 +224,7 @@ void
 Decompressor::run()
 {
     LargeFileInfo info;
+    bool zstd = false;
 
     while(true)
     {
@@ -174,7 +243,8 @@ Decompressor::run()
 
             if(!_files.empty())
             {
-                info = _files.front();
+                info = _files.front().first;
+                zstd = _files.front().second;
                 _files.pop_front();
             }
             else
@@ -185,9 +255,17 @@ Decompressor::run()
 
         try
         {
-            decompressFile(_dataDir + '/' + info.path);
-            setFileFlags(_dataDir + '/' + info.path, info);
-            remove(_dataDir + '/' + info.path + ".bz2");
+            const string path = _dataDir + '/' + info.path;
+            if(zstd)
+            {
+                decompressFileZstd(path);
+            }
+            else
+            {
+                decompressFile(path);
+            }
+            setFileFlags(path, info);
+            remove(path + (zstd ? ".zst" : ".bz2"));
         }
         catch(const string& ex)
         {
@@ -206,8 +284,12 @@ PatcherI::PatcherI(const CommunicatorPtr& communicator, const PatcherFeedbackPtr
     _thorough(communicator->getProperties()->getPropertyAsIntWithDefault("IcePatch2Client.Thorough", 0) > 0),
     _chunkSize(communicator->getProperties()->getPropertyAsIntWithDefault("IcePatch2Client.ChunkSize", 100)),
     _remove(communicator->getProperties()->getPropertyAsIntWithDefault("IcePatch2Client.Remove", 1)),
+    _maxInFlight(communicator->getProperties()->getPropertyAsIntWithDefault("IcePatch2Client.MaxInFlight", 4)),
+    _parallelism(communicator->getProperties()->getPropertyAsIntWithDefault("IcePatch2Client.Parallelism", 1)),
     _log(0),
-    _useSmallFileAPI(false)
+    _useSmallFileAPI(false),
+    _useChunks(communicator->getProperties()->getPropertyAsIntWithDefault("IcePatch2Client.Chunks", 1) > 0),
+    _useZstd(hasZstd() && communicator->getProperties()->getPropertyAsIntWithDefault("IcePatch2Client.Zstd", 1) > 0)
 {
     const char* clientProxyProperty = "IcePatch2Client.Proxy";
     string clientProxy = communicator->getProperties()->getProperty(clientProxyProperty);
@@ -236,7 +318,11 @@ PatcherI::PatcherI(const FileServerPrx& server,
     _thorough(thorough),
     _chunkSize(chunkSize),
     _remove(remove),
-    _useSmallFileAPI(false)
+    _maxInFlight(4),
+    _parallelism(1),
+    _useSmallFileAPI(false),
+    _useChunks(true),
+    _useZstd(hasZstd())
 {
     init(server);
 }
@@ -312,8 +398,12 @@ PatcherI::prepare()
             return false;
         }
 
+        //
+        // The checksums of the local files are computed by
+        // _parallelism threads.
+        //
         PatcherGetFileInfoSeqCB cb(_feedback);
-        if(!getFileInfoSeq(_dataDir, 0, &cb, _localFiles))
+        if(!getFileInfoSeq(_dataDir, 0, &cb, _localFiles, _parallelism))
         {
             return false;
         }
@@ -465,6 +555,33 @@ PatcherI::prepare()
         }
     }
 
+    //
+    // The local files whose contents was updated are patched from
+    // their chunks by updateFiles, they must not be removed before.
+    // updateFiles overwrites them if they can't be patched.
+    //
+    if(_useChunks && !_useSmallFileAPI)
+    {
+        set<string> updated;
+        for(LargeFileInfoSeq::const_iterator p = _updateFiles.begin(); p != _updateFiles.end(); ++p)
+        {
+            if(p->size > 0)
+            {
+                updated.insert(p->path);
+            }
+        }
+
+        LargeFileInfoSeq removeFiles;
+        for(LargeFileInfoSeq::const_iterator p = _removeFiles.begin(); p != _removeFiles.end(); ++p)
+        {
+            if(p->size < 0 || updated.find(p->path) == updated.end())
+            {
+                removeFiles.push_back(*p);
+            }
+        }
+        _removeFiles.swap(removeFiles);
+    }
+
     sort(_removeFiles.begin(), _removeFiles.end(), FileInfoLess());
     sort(_updateFiles.begin(), _updateFiles.end(), FileInfoLess());
     sort(_updateFlags.begin(), _updateFlags.end(), FileInfoLess());
@@ -629,6 +746,15 @@ PatcherI::init(const FileServerPrx& server)
         const_cast<Int&>(_chunkSize) *= 1024;
     }
 
+    if(_maxInFlight < 1)
+    {
+        const_cast<Int&>(_maxInFlight) = 1;
+    }
+    if(_parallelism < 1)
+    {
+        const_cast<Int&>(_parallelism) = 1;
+    }
+
     if(!IceUtilInternal::isAbsolutePath(_dataDir))
     {
         string cwd;
@@ -699,41 +825,216 @@ PatcherI::removeFiles(const LargeFileInfoSeq& files)
 bool
 PatcherI::updateFiles(const LargeFileInfoSeq& files)
 {
-    DecompressorPtr decompressor = new Decompressor(_dataDir);
-#if defined(__hppa)
     //
-    // The thread stack size is only 64KB only HP-UX and that's not
-    // enough for this thread.
+    // The downloaded files are decompressed by _parallelism threads.
     //
-    decompressor->start(256 * 1024); // 256KB
-#else
-    decompressor->start();
-#endif
+    vector<DecompressorPtr> decompressors;
     bool result;
 
     try
     {
-        result = updateFilesInternal(files, decompressor);
+        for(int i = 0; i < _parallelism; ++i)
+        {
+            DecompressorPtr decompressor = new Decompressor(_dataDir);
+#if defined(__hppa)
+            //
+            // The thread stack size is only 64KB only HP-UX and that's not
+            // enough for this thread.
+            //
+            decompressor->start(256 * 1024); // 256KB
+#else
+            decompressor->start();
+#endif
+            decompressors.push_back(decompressor);
+        }
+
+        result = updateFilesInternal(files, decompressors);
     }
     catch(...)
     {
-        decompressor->destroy();
-        decompressor->getThreadControl().join();
-        decompressor->log(_log);
+        for(vector<DecompressorPtr>::const_iterator p = decompressors.begin(); p != decompressors.end(); ++p)
+        {
+            (*p)->destroy();
+            (*p)->getThreadControl().join();
+            (*p)->log(_log);
+        }
         throw;
     }
 
-    decompressor->destroy();
-    decompressor->getThreadControl().join();
-    decompressor->log(_log);
-    decompressor->exception();
+    for(vector<DecompressorPtr>::const_iterator p = decompressors.begin(); p != decompressors.end(); ++p)
+    {
+        (*p)->destroy();
+        (*p)->getThreadControl().join();
+        (*p)->log(_log);
+    }
+    for(vector<DecompressorPtr>::const_iterator p = decompressors.begin(); p != decompressors.end(); ++p)
+    {
+        (*p)->exception();
+    }
 
     return result;
 }
 
+void
+PatcherI::sendFileRequests(deque<AsyncResultPtr>& requests, const LargeFileInfoSeq& files,
+                           LargeFileInfoSeq::const_iterator& file, Long& pos,
+                           const map<string, FileChunkInfoSeq>& fileChunks, const map<string, Long>& zstdFiles)
+{
+    //
+    // Send the requests for the next chunks of the files to download
+    // until _maxInFlight requests are pending. The requests are sent
+    // in the order the chunks are written, across files.
+    //
+    while(static_cast<Int>(requests.size()) < _maxInFlight)
+    {
+        while(file != files.end() &&
+              (file->size <= 0 || pos >= getDownloadSize(*file, zstdFiles) ||
+               fileChunks.find(file->path) != fileChunks.end()))
+        {
+            ++file;
+            pos = 0;
+        }
+
+        if(file == files.end())
+        {
+            return;
+        }
+
+        if(zstdFiles.find(file->path) != zstdFiles.end())
+        {
+            requests.push_back(_serverNoCompress->begin_getFileZstd(file->path, pos, _chunkSize));
+        }
+        else
+        {
+            requests.push_back(_useSmallFileAPI ?
+                               _serverNoCompress->begin_getFileCompressed(file->path, static_cast<Ice::Int>(pos),
+                                                                          _chunkSize) :
+                               _serverNoCompress->begin_getLargeFileCompressed(file->path, pos, _chunkSize));
+        }
+        pos += _chunkSize;
+    }
+}
+
 bool
-PatcherI::updateFilesInternal(const LargeFileInfoSeq& files, const DecompressorPtr& decompressor)
+PatcherI::updateFilesInternal(const LargeFileInfoSeq& files, const vector<DecompressorPtr>& decompressors)
 {
+    //
+    // Get the chunks of the updated files which already exist
+    // locally. These files are patched by only downloading the chunks
+    // which aren't already available in the local file.
+    //
+    map<string, FileChunkInfoSeq> fileChunks;
+    map<string, FileChunkInfoSeq> localFileChunks;
+    if(_useChunks && !_useSmallFileAPI)
+    {
+        for(LargeFileInfoSeq::const_iterator p = files.begin(); p != files.end(); ++p)
+        {
+            IceUtilInternal::structstat buf;
+            if(p->size <= 0 || IceUtilInternal::stat(_dataDir + '/' + p->path, &buf) == -1 ||
+               !S_ISREG(buf.st_mode) || buf.st_size == 0)
+            {
+                continue;
+            }
+
+            try
+            {
+                FileChunkInfoSeq chunks = _serverNoCompress->getFileChunks(p->path);
+                if(!chunks.empty())
+                {
+                    //
+                    // Only patch the file from its chunks if the chunks
+                    // to download are smaller than the compressed file,
+                    // otherwise the compressed file is downloaded.
+                    //
+                    FileChunkInfoSeq localChunks;
+                    getFileChunks(simplify(_dataDir + '/' + p->path), localChunks);
+                    if(getDeltaSize(chunks, localChunks) < p->size)
+                    {
+                        fileChunks[p->path].swap(chunks);
+                        localFileChunks[p->path].swap(localChunks);
+                    }
+                }
+            }
+            catch(const Ice::OperationNotExistException&)
+            {
+                _useChunks = false; // The server doesn't support chunks.
+                break;
+            }
+            catch(const FileAccessException&)
+            {
+            }
+        }
+    }
+
+    //
+    // Get the sizes of the Zstandard-compressed files of the other
+    // files. These files are downloaded instead of the bzip2-compressed
+    // files since they are much faster to decompress.
+    //
+    map<string, Long> zstdFiles;
+    if(_useZstd && !_useSmallFileAPI)
+    {
+        StringSeq paths;
+        for(LargeFileInfoSeq::const_iterator p = files.begin(); p != files.end(); ++p)
+        {
+            if(p->size > 0 && fileChunks.find(p->path) == fileChunks.end())
+            {
+                paths.push_back(p->path);
+            }
+        }
+
+        try
+        {
+            const StringSeq::size_type batchSize = 1000; // Limit the size of the requests.
+            for(StringSeq::size_type i = 0; i < paths.size(); i += batchSize)
+            {
+                StringSeq batch(paths.begin() + i, paths.begin() + min(i + batchSize, paths.size()));
+                LongSeq sizes = _serverNoCompress->getZstdFileSizes(batch);
+                for(StringSeq::size_type j = 0; j < batch.size() && j < sizes.size(); ++j)
+                {
+                    if(sizes[j] > 0)
+                    {
+                        zstdFiles[batch[j]] = sizes[j];
+                    }
+                }
+            }
+        }
+        catch(const Ice::OperationNotExistException&)
+        {
+            _useZstd = false; // The server doesn't support Zstandard.
+        }
+        catch(const FileAccessException&)
+        {
+        }
+    }
+
+    //
+    // The local files kept by prepare to be patched from their chunks
+    // are overwritten, remove them from the summary.
+    //
+    {
+        set<string> paths;
+        for(LargeFileInfoSeq::const_iterator p = files.begin(); p != files.end(); ++p)
+        {
+            paths.insert(p->path);
+        }
+
+        LargeFileInfoSeq newLocalFiles;
+        newLocalFiles.reserve(_localFiles.size());
+        for(LargeFileInfoSeq::const_iterator p = _localFiles.begin(); p != _localFiles.end(); ++p)
+        {
+            if(paths.find(p->path) == paths.end())
+            {
+                newLocalFiles.push_back(*p);
+            }
+            else if(fputc('-', _log) == EOF || !writeFileInfo(_log, *p))
+            {
+                throw "error writing log file:\n" + IceUtilInternal::lastErrorToString();
+            }
+        }
+        _localFiles.swap(newLocalFiles);
+    }
+
     Long total = 0;
     Long updated = 0;
 
@@ -741,12 +1042,14 @@ PatcherI::updateFilesInternal(const LargeFileInfoSeq& files, const DecompressorP
     {
         if(p->size > 0) // Regular, non-empty file?
         {
-            total += p->size;
+            total += getDownloadSize(*p, zstdFiles);
         }
     }
 
-    AsyncResultPtr curCB;
-    AsyncResultPtr nxtCB;
+    deque<AsyncResultPtr> requests;
+    LargeFileInfoSeq::const_iterator requestFile = files.begin();
+    Long requestPos = 0;
+    size_t nextDecompressor = 0;
 
     for(LargeFileInfoSeq::const_iterator p = files.begin(); p != files.end(); ++p)
     {
@@ -760,7 +1063,10 @@ PatcherI::updateFilesInternal(const LargeFileInfoSeq& files, const DecompressorP
         }
         else // Regular file.
         {
-            if(!_feedback->patchStart(p->path, p->size, updated, total))
+            const bool zstd = zstdFiles.find(p->path) != zstdFiles.end();
+            const Long size = getDownloadSize(*p, zstdFiles);
+
+            if(!_feedback->patchStart(p->path, size, updated, total))
             {
                 return false;
             }
@@ -775,11 +1081,34 @@ PatcherI::updateFilesInternal(const LargeFileInfoSeq& files, const DecompressorP
                 }
                 fclose(fp);
             }
+            else if(fileChunks.find(p->path) != fileChunks.end())
+            {
+                for(vector<DecompressorPtr>::const_iterator q = decompressors.begin(); q != decompressors.end(); ++q)
+                {
+                    (*q)->log(_log);
+                }
+                if(!updateFileChunks(*p, fileChunks[p->path], localFileChunks[p->path],
+                                     static_cast<Int>(requests.size()), updated, total))
+                {
+                    return false;
+                }
+            }
             else
             {
-                string pathBZ2 = simplify(_dataDir + '/' + p->path + ".bz2");
+                //
+                // Remove the local file kept to be patched from its
+                // chunks, it might be in use.
+                //
+                string path = simplify(_dataDir + '/' + p->path);
+                IceUtilInternal::structstat buf;
+                if(IceUtilInternal::stat(path, &buf) != -1 && S_ISREG(buf.st_mode))
+                {
+                    remove(path);
+                }
+
+                string pathCompressed = simplify(_dataDir + '/' + p->path + (zstd ? ".zst" : ".bz2"));
 
-                string dir = getDirname(pathBZ2);
+                string dir = getDirname(pathCompressed);
                 if(!dir.empty())
                 {
                     createDirectoryRecursive(dir);
@@ -787,67 +1116,43 @@ PatcherI::updateFilesInternal(const LargeFileInfoSeq& files, const DecompressorP
 
                 try
                 {
-                    removeRecursive(pathBZ2);
+                    removeRecursive(pathCompressed);
                 }
                 catch(...)
                 {
                 }
 
-                FILE* fileBZ2 = IceUtilInternal::fopen(pathBZ2, "wb");
-                if(fileBZ2 == 0)
+                FILE* fileCompressed = IceUtilInternal::fopen(pathCompressed, "wb");
+                if(fileCompressed == 0)
                 {
-                    throw "cannot open `" + pathBZ2 + "' for writing:\n" + IceUtilInternal::lastErrorToString();
+                    throw "cannot open `" + pathCompressed + "' for writing:\n" + IceUtilInternal::lastErrorToString();
                 }
 
                 try
                 {
                     Ice::Long pos = 0;
 
-                    while(pos < p->size)
+                    while(pos < size)
                     {
-                        if(!curCB)
-                        {
-                            assert(!nxtCB);
-                            curCB = _useSmallFileAPI ?
-                                _serverNoCompress->begin_getFileCompressed(p->path, static_cast<Ice::Int>(pos), _chunkSize) :
-                                _serverNoCompress->begin_getLargeFileCompressed(p->path, pos, _chunkSize);
-                        }
-                        else
-                        {
-                            assert(nxtCB);
-                            swap(nxtCB, curCB);
-                        }
+                        sendFileRequests(requests, files, requestFile, requestPos, fileChunks, zstdFiles);
+                        assert(!requests.empty());
+                        AsyncResultPtr curCB = requests.front();
+                        requests.pop_front();
 
-                        if(pos + _chunkSize < p->size)
-                        {
-                            nxtCB = _useSmallFileAPI ?
-                                _serverNoCompress->begin_getFileCompressed(p->path, static_cast<Ice::Int>(pos + _chunkSize), _chunkSize) :
-                                _serverNoCompress->begin_getLargeFileCompressed(p->path, pos + _chunkSize, _chunkSize);
-                        }
-                        else
-                        {
-                            LargeFileInfoSeq::const_iterator q = p + 1;
+                        ByteSeq bytes;
 
-                            while(q != files.end() && q->size <= 0)
+                        try
+                        {
+                            if(zstd)
                             {
-                                ++q;
+                                bytes = _serverNoCompress->end_getFileZstd(curCB);
                             }
-
-                            if(q != files.end())
+                            else
                             {
-                                nxtCB = _useSmallFileAPI ?
-                                    _serverNoCompress->begin_getFileCompressed(q->path, 0, _chunkSize) :
-                                    _serverNoCompress->begin_getLargeFileCompressed(q->path, 0, _chunkSize);
+                                bytes = _useSmallFileAPI ? _serverNoCompress->end_getFileCompressed(curCB) :
+                                                           _serverNoCompress->end_getLargeFileCompressed(curCB);
                             }
                         }
-
-                        ByteSeq bytes;
-
-                        try
-                        {
-                            bytes = _useSmallFileAPI ? _serverNoCompress->end_getFileCompressed(curCB) :
-                                                       _serverNoCompress->end_getLargeFileCompressed(curCB);
-                        }
                         catch(const FileAccessException& ex)
                         {
                             throw "error from IcePatch2 server for `" + p->path + "': " + ex.reason;
@@ -858,31 +1163,34 @@ PatcherI::updateFilesInternal(const LargeFileInfoSeq& files, const DecompressorP
                             throw "size mismatch for `" + p->path + "'";
                         }
 
-                        if(fwrite(reinterpret_cast<char*>(&bytes[0]), bytes.size(), 1, fileBZ2) != 1)
+                        if(fwrite(reinterpret_cast<char*>(&bytes[0]), bytes.size(), 1, fileCompressed) != 1)
                         {
-                            throw ": cannot write `" + pathBZ2 + "':\n" + IceUtilInternal::lastErrorToString();
+                            throw ": cannot write `" + pathCompressed + "':\n" + IceUtilInternal::lastErrorToString();
                         }
 
                         pos += bytes.size();
                         updated += bytes.size();
 
-                        if(!_feedback->patchProgress(pos, p->size, updated, total))
+                        if(!_feedback->patchProgress(pos, size, updated, total))
                         {
-                            fclose(fileBZ2);
+                            fclose(fileCompressed);
                             return false;
                         }
                     }
                 }
                 catch(...)
                 {
-                    fclose(fileBZ2);
+                    fclose(fileCompressed);
                     throw;
                 }
 
-                fclose(fileBZ2);
+                fclose(fileCompressed);
 
-                decompressor->log(_log);
-                decompressor->add(*p);
+                for(vector<DecompressorPtr>::const_iterator q = decompressors.begin(); q != decompressors.end(); ++q)
+                {
+                    (*q)->log(_log);
+                }
+                decompressors[nextDecompressor++ % decompressors.size()]->add(*p, zstd);
             }
 
             if(!_feedback->patchEnd())
@@ -918,6 +1226,191 @@ PatcherI::updateFilesInternal(const LargeFileInfoSeq& files, const DecompressorP
     return true;
 }
 
+bool
+PatcherI::updateFileChunks(const LargeFileInfo& info, const FileChunkInfoSeq& chunks,
+                           const FileChunkInfoSeq& localChunks, Int inFlight, Long& updated, Long total)
+{
+    const string path = simplify(_dataDir + '/' + info.path);
+    const string pathTemp = path + ".chunkstemp";
+
+    //
+    // Split the new file in the segments copied from the local file
+    // and the ranges downloaded from the server: the consecutive
+    // chunks which aren't available locally are downloaded together,
+    // up to the chunk size.
+    //
+    map<ByteSeq, FileChunkInfo> local;
+    for(FileChunkInfoSeq::const_iterator p = localChunks.begin(); p != localChunks.end(); ++p)
+    {
+        local.insert(make_pair(p->checksum, *p));
+    }
+
+    vector<FileSegment> segments;
+    FileChunkInfoSeq::const_iterator p = chunks.begin();
+    while(p != chunks.end())
+    {
+        map<ByteSeq, FileChunkInfo>::const_iterator q = local.find(p->checksum);
+        if(q != local.end())
+        {
+            segments.push_back(FileSegment(true, q->second.offset, q->second.size));
+            ++p;
+        }
+        else
+        {
+            Long offset = p->offset;
+            Int num = 0;
+            do
+            {
+                num += p->size;
+                ++p;
+            }
+            while(p != chunks.end() && num + p->size <= _chunkSize && local.find(p->checksum) == local.end());
+            segments.push_back(FileSegment(false, offset, num));
+        }
+    }
+
+    const Long size = chunks.back().offset + chunks.back().size;
+
+    int fd = IceUtilInternal::open(path, O_RDONLY|O_BINARY);
+    if(fd == -1)
+    {
+        throw "cannot open `" + path + "' for reading:\n" + IceUtilInternal::lastErrorToString();
+    }
+
+    FILE* fileTemp = IceUtilInternal::fopen(pathTemp, "wb");
+    if(fileTemp == 0)
+    {
+        IceUtilInternal::close(fd);
+        throw "cannot open `" + pathTemp + "' for writing:\n" + IceUtilInternal::lastErrorToString();
+    }
+
+    try
+    {
+        IceUtilInternal::SHA1 hasher;
+        hasher.update(reinterpret_cast<const IceUtil::Byte*>(info.path.c_str()), info.path.size());
+
+        //
+        // The range requests are sent ahead of the writes, like the
+        // requests of the files downloaded entirely, and share the
+        // in-flight window with the requests already sent for these
+        // files.
+        //
+        const size_t window = static_cast<size_t>(max(_maxInFlight - inFlight, 1));
+        deque<AsyncResultPtr> requests;
+        vector<FileSegment>::const_iterator next = segments.begin();
+
+        Long pos = 0;
+        for(vector<FileSegment>::const_iterator s = segments.begin(); s != segments.end(); ++s)
+        {
+            while(next != segments.end() && requests.size() < window)
+            {
+                if(!next->local)
+                {
+                    requests.push_back(_serverCompress->begin_getFileRange(info.path, next->offset, next->size));
+                }
+                ++next;
+            }
+
+            ByteSeq bytes;
+            if(s->local)
+            {
+                //
+                // Copy the chunk from the local file.
+                //
+                bytes.resize(s->size);
+                if(
+#if defined(_MSC_VER)
+                    _lseek(fd, static_cast<off_t>(s->offset), SEEK_SET)
+#else
+                    lseek(fd, static_cast<off_t>(s->offset), SEEK_SET)
+#endif
+                    != static_cast<off_t>(s->offset) ||
+#if defined(_MSC_VER)
+                    _read(fd, &bytes[0], static_cast<unsigned int>(bytes.size()))
+#else
+                    read(fd, &bytes[0], bytes.size())
+#endif
+                    != static_cast<int>(bytes.size()))
+                {
+                    throw "cannot read from `" + path + "':\n" + IceUtilInternal::lastErrorToString();
+                }
+            }
+            else
+            {
+                assert(!requests.empty());
+                AsyncResultPtr result = requests.front();
+                requests.pop_front();
+                try
+                {
+                    bytes = _serverCompress->end_getFileRange(result);
+                }
+                catch(const FileAccessException& ex)
+                {
+                    throw "error from IcePatch2 server for `" + info.path + "': " + ex.reason;
+                }
+
+                if(bytes.size() != static_cast<size_t>(s->size))
+                {
+                    throw "size mismatch for `" + info.path + "'";
+                }
+            }
+
+            if(fwrite(reinterpret_cast<char*>(&bytes[0]), bytes.size(), 1, fileTemp) != 1)
+            {
+                throw ": cannot write `" + pathTemp + "':\n" + IceUtilInternal::lastErrorToString();
+            }
+            hasher.update(&bytes[0], bytes.size());
+
+            //
+            // The progress is reported relative to the compressed file
+            // size, like for the files downloaded entirely.
+            //
+            pos += bytes.size();
+            Long progress = static_cast<Long>(static_cast<double>(info.size) * pos / size);
+            if(!_feedback->patchProgress(progress, info.size, updated + progress, total))
+            {
+                fclose(fileTemp);
+                IceUtilInternal::close(fd);
+                remove(pathTemp);
+                return false;
+            }
+        }
+
+        ByteSeq checksum;
+        hasher.finalize(checksum);
+        if(checksum != info.checksum)
+        {
+            throw "checksum mismatch for `" + info.path + "'";
+        }
+    }
+    catch(...)
+    {
+        fclose(fileTemp);
+        IceUtilInternal::close(fd);
+        try
+        {
+            remove(pathTemp);
+        }
+        catch(...)
+        {
+        }
+        throw;
+    }
+
+    fclose(fileTemp);
+    IceUtilInternal::close(fd);
+
+    rename(pathTemp, path);
+    setFileFlags(path, info);
+    if(fputc('+', _log) == EOF || !writeFileInfo(_log, info))
+    {
+        throw "error writing log file:\n" + IceUtilInternal::lastErrorToString();
+    }
+
+    updated += info.size;
+    return true;
+}
+
 bool
 PatcherI::updateFlags(const LargeFileInfoSeq& files)
 {
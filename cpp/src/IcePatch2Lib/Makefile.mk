@@ -15,4 +15,9 @@ IcePatch2_libs		:= bz2
 IcePatch2_sliceflags	:= --include-dir IcePatch2 --dll-export ICE_PATCH2_API
 IcePatch2_cppflags	:= $(nodeprecatedwarnings-cppflags)
 
+ifeq ($(ICE_PATCH2_ZSTD),yes)
+IcePatch2_libs		+= zstd
+IcePatch2_cppflags	+= -DICE_PATCH2_HAS_ZSTD
+endif
+
 projects += $(project)
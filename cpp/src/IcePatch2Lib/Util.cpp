@@ -20,9 +20,13 @@
 #include <IceUtil/FileUtil.h>
 #include <IceUtil/SHA1.h>
 #include <IceUtil/Exception.h>
+#include <IceUtil/UniquePtr.h>
 #include <IcePatch2Lib/Util.h>
 #include <IcePatch2/FileServer.h>
 #include <bzlib.h>
+#ifdef ICE_PATCH2_HAS_ZSTD
+#   include <zstd.h>
+#endif
 #include <iomanip>
 
 #ifdef _WIN32
@@ -33,6 +37,7 @@
 #endif
 
 #include <iterator>
+#include <map>
 
 // Ignore OS X OpenSSL deprecation warnings
 #ifdef __APPLE__
@@ -41,6 +46,7 @@
 
 const char* IcePatch2Internal::checksumFile = "IcePatch2.sum";
 const char* IcePatch2Internal::logFile = "IcePatch2.log";
+const Ice::Long IcePatch2Internal::minChunkedFileSize = 1024 * 1024;
 
 using namespace std;
 using namespace Ice;
@@ -323,6 +329,13 @@ IcePatch2Internal::getWithoutSuffix(const string& pa)
     return path.substr(0, dotPos);
 }
 
+//
+// The files with these suffixes are internal files of IcePatch2 and
+// of the legacy IcePatch, they're not distributed. In particular, the
+// files ending with .chunks or .chunkstemp are chunk lists saved by
+// IcePatch2Calc: such files are removed if they don't belong to
+// another file and are otherwise ignored.
+//
 bool
 IcePatch2Internal::ignoreSuffix(const string& path)
 {
@@ -330,7 +343,11 @@ IcePatch2Internal::ignoreSuffix(const string& path)
     return suffix == "md5" // For legacy IcePatch.
         || suffix == "tot" // For legacy IcePatch.
         || suffix == "bz2"
-        || suffix == "bz2temp";
+        || suffix == "bz2temp"
+        || suffix == "chunks"
+        || suffix == "chunkstemp"
+        || suffix == "zst"
+        || suffix == "zsttemp";
 }
 
 string
@@ -725,6 +742,246 @@ IcePatch2Internal::decompressFile(const string& pa)
     fclose(fp);
 }
 
+#ifdef ICE_PATCH2_HAS_ZSTD
+
+namespace
+{
+
+//
+// The Zstandard compression level, the decompression speed doesn't
+// depend on the compression level.
+//
+const int zstdLevel = 9;
+
+string
+zstdError(const string& function, size_t r)
+{
+    return function + " failed: " + ZSTD_getErrorName(r);
+}
+
+//
+// Writes a Zstandard-compressed file, the file and the compression
+// stream are released if the writer is destroyed before close() is
+// called.
+//
+class ZstdWriter : public IceUtil::noncopyable
+{
+public:
+
+    ZstdWriter(const string& path) :
+        _path(path),
+        _fp(0),
+        _stream(0),
+        _buffer(ZSTD_CStreamOutSize())
+    {
+        _fp = IceUtilInternal::fopen(_path, "wb");
+        if(!_fp)
+        {
+            throw "cannot open `" + _path + "' for writing:\n" + IceUtilInternal::lastErrorToString();
+        }
+
+        _stream = ZSTD_createCStream();
+        if(!_stream)
+        {
+            fclose(_fp);
+            throw string("ZSTD_createCStream failed");
+        }
+
+        size_t r = ZSTD_initCStream(_stream, zstdLevel);
+        if(ZSTD_isError(r))
+        {
+            ZSTD_freeCStream(_stream);
+            fclose(_fp);
+            throw zstdError("ZSTD_initCStream", r);
+        }
+    }
+
+    ~ZstdWriter()
+    {
+        if(_stream)
+        {
+            ZSTD_freeCStream(_stream);
+        }
+        if(_fp)
+        {
+            fclose(_fp);
+        }
+    }
+
+    void
+    write(const Byte* bytes, size_t size)
+    {
+        ZSTD_inBuffer input = { bytes, size, 0 };
+        while(input.pos < input.size)
+        {
+            ZSTD_outBuffer output = { &_buffer[0], _buffer.size(), 0 };
+            size_t r = ZSTD_compressStream(_stream, &output, &input);
+            if(ZSTD_isError(r))
+            {
+                throw zstdError("ZSTD_compressStream", r);
+            }
+            flush(output);
+        }
+    }
+
+    void
+    close()
+    {
+        size_t r;
+        do
+        {
+            ZSTD_outBuffer output = { &_buffer[0], _buffer.size(), 0 };
+            r = ZSTD_endStream(_stream, &output);
+            if(ZSTD_isError(r))
+            {
+                throw zstdError("ZSTD_endStream", r);
+            }
+            flush(output);
+        }
+        while(r > 0);
+
+        ZSTD_freeCStream(_stream);
+        _stream = 0;
+
+        FILE* fp = _fp;
+        _fp = 0;
+        if(fclose(fp) != 0)
+        {
+            throw "cannot write `" + _path + "':\n" + IceUtilInternal::lastErrorToString();
+        }
+    }
+
+private:
+
+    void
+    flush(const ZSTD_outBuffer& output)
+    {
+        if(output.pos > 0 && fwrite(output.dst, output.pos, 1, _fp) != 1)
+        {
+            throw "cannot write `" + _path + "':\n" + IceUtilInternal::lastErrorToString();
+        }
+    }
+
+    const string _path;
+    FILE* _fp;
+    ZSTD_CStream* _stream;
+    vector<Byte> _buffer;
+};
+
+}
+
+bool
+IcePatch2Internal::hasZstd()
+{
+    return true;
+}
+
+void
+IcePatch2Internal::decompressFileZstd(const string& pa)
+{
+    const string path = simplify(pa);
+    const string pathZstd = path + ".zst";
+
+    FILE* fp = 0;
+    FILE* fpZstd = 0;
+    ZSTD_DStream* stream = 0;
+
+    try
+    {
+        fp = IceUtilInternal::fopen(path, "wb");
+        if(!fp)
+        {
+            throw "cannot open `" + path + "' for writing:\n" + IceUtilInternal::lastErrorToString();
+        }
+
+        fpZstd = IceUtilInternal::fopen(pathZstd, "rb");
+        if(!fpZstd)
+        {
+            throw "cannot open `" + pathZstd + "' for reading:\n" + IceUtilInternal::lastErrorToString();
+        }
+
+        stream = ZSTD_createDStream();
+        if(!stream)
+        {
+            throw string("ZSTD_createDStream failed");
+        }
+
+        size_t r = ZSTD_initDStream(stream);
+        if(ZSTD_isError(r))
+        {
+            throw zstdError("ZSTD_initDStream", r);
+        }
+
+        vector<Byte> input(ZSTD_DStreamInSize());
+        vector<Byte> output(ZSTD_DStreamOutSize());
+        size_t sz;
+        while((sz = fread(&input[0], 1, input.size(), fpZstd)) > 0)
+        {
+            ZSTD_inBuffer in = { &input[0], sz, 0 };
+            while(in.pos < in.size)
+            {
+                ZSTD_outBuffer out = { &output[0], output.size(), 0 };
+                r = ZSTD_decompressStream(stream, &out, &in);
+                if(ZSTD_isError(r))
+                {
+                    throw zstdError("ZSTD_decompressStream", r);
+                }
+
+                if(out.pos > 0 && fwrite(&output[0], out.pos, 1, fp) != 1)
+                {
+                    throw "cannot write to `" + path + "':\n" + IceUtilInternal::lastErrorToString();
+                }
+            }
+        }
+
+        if(ferror(fpZstd))
+        {
+            throw "cannot read from `" + pathZstd + "':\n" + IceUtilInternal::lastErrorToString();
+        }
+
+        if(r != 0)
+        {
+            throw "unexpected end of file in `" + pathZstd + "'";
+        }
+    }
+    catch(...)
+    {
+        if(stream != 0)
+        {
+            ZSTD_freeDStream(stream);
+        }
+        if(fpZstd != 0)
+        {
+            fclose(fpZstd);
+        }
+        if(fp != 0)
+        {
+            fclose(fp);
+        }
+        throw;
+    }
+
+    ZSTD_freeDStream(stream);
+    fclose(fpZstd);
+    fclose(fp);
+}
+
+#else
+
+bool
+IcePatch2Internal::hasZstd()
+{
+    return false;
+}
+
+void
+IcePatch2Internal::decompressFileZstd(const string& pa)
+{
+    throw "cannot decompress `" + simplify(pa) + ".zst':\nZstandard support is not available";
+}
+
+#endif
+
 #ifndef _WIN32
 void
 IcePatch2Internal::setFileFlags(const string& pa, const LargeFileInfo& info)
@@ -747,9 +1004,616 @@ IcePatch2Internal::setFileFlags(const string&, const LargeFileInfo&)
 namespace
 {
 
-static bool
+//
+// The chunk boundaries are found with a gear rolling hash: a boundary
+// is found when the high bits of the hash of the last 32 bytes are
+// zero, which gives chunks of 64KB on average. The table of the
+// random values of the gear hash must be the same for the IcePatch2
+// servers and clients.
+//
+const size_t minChunkSize = 16 * 1024;
+const size_t maxChunkSize = 256 * 1024;
+const unsigned int chunkMask = 0xFFFF0000;
+
+class GearTable
+{
+public:
+
+    GearTable()
+    {
+        unsigned int x = 0x9E3779B9;
+        for(int i = 0; i < 256; ++i)
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            _values[i] = x;
+        }
+    }
+
+    unsigned int
+    operator[](Byte b) const
+    {
+        return _values[b];
+    }
+
+private:
+
+    unsigned int _values[256];
+};
+const GearTable gearTable;
+
+//
+// Add the chunk hashed by the given hasher, the hasher is reset for
+// the next chunk.
+//
+void
+addFileChunk(FileChunkInfoSeq& chunks, Ice::Long offset, size_t size,
+             IceUtil::UniquePtr<IceUtilInternal::SHA1>& hasher)
+{
+    FileChunkInfo chunk;
+    chunk.offset = offset;
+    chunk.size = static_cast<Int>(size);
+    hasher->finalize(chunk.checksum);
+    chunks.push_back(chunk);
+    hasher.reset(new IceUtilInternal::SHA1);
+}
+
+}
+
+void
+IcePatch2Internal::getFileChunks(const string& pa, FileChunkInfoSeq& chunks)
+{
+    const string path = simplify(pa);
+
+    FILE* fp = IceUtilInternal::fopen(path, "rb");
+    if(!fp)
+    {
+        throw "cannot open `" + path + "' for reading:\n" + IceUtilInternal::lastErrorToString();
+    }
+
+    //
+    // The chunks are hashed in place in the read buffer, each chunk
+    // spans from the start of the buffer or the end of the previous
+    // chunk up to its boundary.
+    //
+    ByteSeq bytes(64 * 1024);
+    IceUtil::UniquePtr<IceUtilInternal::SHA1> hasher(new IceUtilInternal::SHA1);
+    Ice::Long offset = 0;
+    size_t size = 0;
+    unsigned int hash = 0;
+    size_t sz;
+    while((sz = fread(&bytes[0], 1, bytes.size(), fp)) > 0)
+    {
+        size_t start = 0;
+        for(size_t i = 0; i < sz; ++i)
+        {
+            ++size;
+            hash = (hash << 1) + gearTable[bytes[i]];
+            if((size >= minChunkSize && (hash & chunkMask) == 0) || size >= maxChunkSize)
+            {
+                hasher->update(&bytes[start], i + 1 - start);
+                addFileChunk(chunks, offset, size, hasher);
+                offset += size;
+                size = 0;
+                hash = 0;
+                start = i + 1;
+            }
+        }
+        if(start < sz)
+        {
+            hasher->update(&bytes[start], sz - start);
+        }
+    }
+
+    if(ferror(fp))
+    {
+        fclose(fp);
+        throw "cannot read from `" + path + "':\n" + IceUtilInternal::lastErrorToString();
+    }
+    fclose(fp);
+
+    if(size > 0)
+    {
+        addFileChunk(chunks, offset, size, hasher);
+    }
+}
+
+void
+IcePatch2Internal::saveFileChunks(const string& pa, const FileChunkInfoSeq& chunks)
+{
+    const string path = simplify(pa);
+    const string pathTemp = path + "temp";
+
+    FILE* fp = IceUtilInternal::fopen(pathTemp, "w");
+    if(!fp)
+    {
+        throw "cannot open `" + pathTemp + "' for writing:\n" + IceUtilInternal::lastErrorToString();
+    }
+
+    for(FileChunkInfoSeq::const_iterator p = chunks.begin(); p != chunks.end(); ++p)
+    {
+        if(fprintf(fp, "%s\t" ICE_INT64_FORMAT "\t%d\n", bytesToString(p->checksum).c_str(), p->offset, p->size) < 0)
+        {
+            fclose(fp);
+            throw "error writing `" + pathTemp + "':\n" + IceUtilInternal::lastErrorToString();
+        }
+    }
+    fclose(fp);
+
+    rename(pathTemp, path);
+}
+
+bool
+IcePatch2Internal::loadFileChunks(const string& pa, FileChunkInfoSeq& chunks)
+{
+    const string path = simplify(pa);
+
+    FILE* fp = IceUtilInternal::fopen(path, "r");
+    if(!fp)
+    {
+        return false;
+    }
+
+    char buf[BUFSIZ];
+    while(fgets(buf, static_cast<int>(sizeof(buf)), fp) != 0)
+    {
+        istringstream is(buf);
+        string checksum;
+        FileChunkInfo chunk;
+        if(!(is >> checksum >> chunk.offset >> chunk.size))
+        {
+            fclose(fp);
+            throw "invalid chunk in `" + path + "'";
+        }
+        chunk.checksum = stringToBytes(checksum);
+        chunks.push_back(chunk);
+    }
+    fclose(fp);
+    return true;
+}
+
+namespace
+{
+
+//
+// A regular file whose checksum, compressed file and chunks are
+// computed once the walk of the directory is completed.
+//
+struct FileInfoTask
+{
+    size_t index; // The index of the file info in the sequence.
+    string path;
+    string relPath;
+    IceUtilInternal::structstat buf;
+    bool doCompress;
+    bool doZstd;
+};
+
+struct GetFileInfoSeqState
+{
+    GetFileInfoSeqState() : zstd(false), incremental(false), summaryTime(0)
+    {
+    }
+
+    bool zstd;
+    bool incremental;
+    map<string, LargeFileInfo> previous; // The file infos of the previous summary.
+    time_t summaryTime; // The modification time of the previous summary.
+    vector<FileInfoTask> tasks;
+};
+
+bool
+isChunksUpToDate(const string& path, const IceUtilInternal::structstat& buf, int compress)
+{
+    if(compress == 0 || buf.st_size < minChunkedFileSize)
+    {
+        return true;
+    }
+
+    IceUtilInternal::structstat bufChunks;
+    return IceUtilInternal::stat(path + ".chunks", &bufChunks) != -1 && buf.st_mtime < bufChunks.st_mtime;
+}
+
+void
+computeFileInfo(const FileInfoTask& task, int compress, LargeFileInfo& info)
+{
+    const string& path = task.path;
+    const string& relPath = info.path;
+    const IceUtilInternal::structstat& buf = task.buf;
+    const bool doCompress = task.doCompress;
+    const string pathBZ2 = path + ".bz2";
+    IceUtilInternal::structstat bufBZ2;
+
+    ByteSeq bytesSHA;
+
+    if(relPath.size() + buf.st_size == 0)
+    {
+        bytesSHA.resize(20);
+        fill(bytesSHA.begin(), bytesSHA.end(), 0);
+    }
+    else
+    {
+        IceUtilInternal::SHA1 hasher;
+        if(relPath.size() != 0)
+        {
+            hasher.update(reinterpret_cast<const IceUtil::Byte*>(relPath.c_str()), relPath.size());
+        }
+
+        if(buf.st_size != 0)
+        {
+#ifdef ICE_PATCH2_HAS_ZSTD
+            const string pathZstdTemp = path + ".zsttemp";
+            IceUtil::UniquePtr<ZstdWriter> zstdWriter;
+            if(task.doZstd)
+            {
+                zstdWriter.reset(new ZstdWriter(pathZstdTemp));
+            }
+#endif
+
+            int fd = IceUtilInternal::open(path.c_str(), O_BINARY|O_RDONLY);
+            if(fd == -1)
+            {
+                throw "cannot open `" + path + "' for reading:\n" + IceUtilInternal::lastErrorToString();
+            }
+
+            const string pathBZ2Temp = path + ".bz2temp";
+            FILE* stdioFile = 0;
+            int bzError = 0;
+            BZFILE* bzFile = 0;
+            if(doCompress)
+            {
+                stdioFile = IceUtilInternal::fopen(simplify(pathBZ2Temp), "wb");
+                if(!stdioFile)
+                {
+                    IceUtilInternal::close(fd);
+                    throw "cannot open `" + pathBZ2Temp + "' for writing:\n" + IceUtilInternal::lastErrorToString();
+                }
+
+                bzFile = BZ2_bzWriteOpen(&bzError, stdioFile, 5, 0, 0);
+                if(bzError != BZ_OK)
+                {
+                    string ex = "BZ2_bzWriteOpen failed";
+                    if(bzError == BZ_IO_ERROR)
+                    {
+                    ex += string(": ") + IceUtilInternal::lastErrorToString();
+                    }
+                    fclose(stdioFile);
+                    IceUtilInternal::close(fd);
+                    throw ex;
+                }
+            }
+
+            long bytesLeft = buf.st_size;
+            while(bytesLeft > 0)
+            {
+                ByteSeq bytes(min(bytesLeft, 1024l*1024));
+                if(
+#if defined(_MSC_VER)
+                    _read(fd, &bytes[0], static_cast<unsigned int>(bytes.size()))
+#else
+                    read(fd, &bytes[0], static_cast<unsigned int>(bytes.size()))
+#endif
+                    == -1)
+                {
+                    if(doCompress)
+                    {
+                        fclose(stdioFile);
+                    }
+
+                    IceUtilInternal::close(fd);
+                    throw "cannot read from `" + path + "':\n" + IceUtilInternal::lastErrorToString();
+                }
+                bytesLeft -= static_cast<unsigned int>(bytes.size());
+                if(doCompress)
+                {
+                    BZ2_bzWrite(&bzError, bzFile, const_cast<Byte*>(&bytes[0]), static_cast<int>(bytes.size()));
+                    if(bzError != BZ_OK)
+                    {
+                        string ex = "BZ2_bzWrite failed";
+                        if(bzError == BZ_IO_ERROR)
+                        {
+                            ex += string(": ") + IceUtilInternal::lastErrorToString();
+                        }
+                        BZ2_bzWriteClose(&bzError, bzFile, 0, 0, 0);
+                        fclose(stdioFile);
+                        IceUtilInternal::close(fd);
+                        throw ex;
+                    }
+                }
+
+                hasher.update(reinterpret_cast<IceUtil::Byte*>(&bytes[0]), bytes.size());
+
+#ifdef ICE_PATCH2_HAS_ZSTD
+                if(zstdWriter.get())
+                {
+                    try
+                    {
+                        zstdWriter->write(&bytes[0], bytes.size());
+                    }
+                    catch(...)
+                    {
+                        if(doCompress)
+                        {
+                            BZ2_bzWriteClose(&bzError, bzFile, 0, 0, 0);
+                            fclose(stdioFile);
+                        }
+                        IceUtilInternal::close(fd);
+                        throw;
+                    }
+                }
+#endif
+            }
+
+            IceUtilInternal::close(fd);
+
+            if(doCompress)
+            {
+                BZ2_bzWriteClose(&bzError, bzFile, 0, 0, 0);
+                if(bzError != BZ_OK)
+                {
+                    string ex = "BZ2_bzWriteClose failed";
+                    if(bzError == BZ_IO_ERROR)
+                    {
+                        ex += string(": ") + IceUtilInternal::lastErrorToString();
+                    }
+                    fclose(stdioFile);
+                    throw ex;
+                }
+
+                fclose(stdioFile);
+
+                rename(pathBZ2Temp, pathBZ2);
+
+                if(IceUtilInternal::stat(pathBZ2, &bufBZ2) == -1)
+                {
+                    throw "cannot stat `" + pathBZ2 + "':\n" + IceUtilInternal::lastErrorToString();
+                }
+
+                info.size = bufBZ2.st_size;
+            }
+
+#ifdef ICE_PATCH2_HAS_ZSTD
+            if(zstdWriter.get())
+            {
+                zstdWriter->close();
+                rename(pathZstdTemp, path + ".zst");
+            }
+#endif
+
+            //
+            // Remove the Zstandard-compressed file if it wasn't
+            // compressed again along with the bzip2-compressed file,
+            // it might be stale.
+            //
+            if(doCompress && !task.doZstd)
+            {
+                IceUtilInternal::remove(path + ".zst"); // We ignore errors, the file might not exist.
+            }
+
+            //
+            // Compute the chunks of the large files along with
+            // their compressed file, clients use the chunks to
+            // only download the updated parts of the file.
+            //
+            if(compress > 0 && buf.st_size >= minChunkedFileSize)
+            {
+                const string pathChunks = path + ".chunks";
+                IceUtilInternal::structstat bufChunks;
+                if(doCompress || IceUtilInternal::stat(pathChunks, &bufChunks) == -1 ||
+                   buf.st_mtime >= bufChunks.st_mtime)
+                {
+                    FileChunkInfoSeq chunks;
+                    getFileChunks(path, chunks);
+                    saveFileChunks(pathChunks, chunks);
+                }
+            }
+            else if(compress > 0)
+            {
+                IceUtilInternal::remove(path + ".chunks"); // We ignore errors, the file might not exist.
+            }
+        }
+        hasher.finalize(bytesSHA);
+    }
+
+    info.checksum.swap(bytesSHA);
+}
+
+//
+// The tasks shared by the threads computing the checksums, each
+// thread takes the next task until all the tasks are completed, one
+// of them failed or the computation is interrupted. The progress is
+// reported to the callback as the tasks complete.
+//
+class FileInfoTaskQueue : public IceUtil::Mutex
+{
+public:
+
+    FileInfoTaskQueue(const vector<FileInfoTask>& tasks, int compress, GetFileInfoSeqCB* cb,
+                      LargeFileInfoSeq& infoSeq) :
+        _tasks(tasks),
+        _compress(compress),
+        _cb(cb),
+        _infoSeq(infoSeq),
+        _next(0),
+        _interrupted(false)
+    {
+    }
+
+    void
+    run()
+    {
+        while(true)
+        {
+            size_t i;
+            {
+                IceUtil::Mutex::Lock sync(*this);
+                if(_next == _tasks.size() || _interrupted || !_exception.empty())
+                {
+                    return;
+                }
+                i = _next++;
+            }
+
+            const FileInfoTask& task = _tasks[i];
+            try
+            {
+                computeFileInfo(task, _compress, _infoSeq[task.index]);
+            }
+            catch(const string& ex)
+            {
+                IceUtil::Mutex::Lock sync(*this);
+                if(_exception.empty())
+                {
+                    _exception = ex;
+                }
+                return;
+            }
+
+            if(_cb)
+            {
+                IceUtil::Mutex::Lock sync(*this);
+                if(_interrupted)
+                {
+                    return;
+                }
+                if((task.doCompress && !_cb->compress(task.relPath)) || !_cb->checksum(task.relPath))
+                {
+                    _interrupted = true;
+                    return;
+                }
+            }
+        }
+    }
+
+    void
+    interrupt()
+    {
+        IceUtil::Mutex::Lock sync(*this);
+        _interrupted = true;
+    }
+
+    bool
+    interrupted() const
+    {
+        IceUtil::Mutex::Lock sync(*this);
+        return _interrupted;
+    }
+
+    void
+    throwException() const
+    {
+        if(!_exception.empty())
+        {
+            throw _exception;
+        }
+    }
+
+private:
+
+    const vector<FileInfoTask>& _tasks;
+    const int _compress;
+    GetFileInfoSeqCB* _cb;
+    LargeFileInfoSeq& _infoSeq;
+    size_t _next;
+    bool _interrupted;
+    string _exception;
+};
+
+class FileInfoThread : public IceUtil::Thread
+{
+public:
+
+    FileInfoThread(FileInfoTaskQueue& queue) : _queue(queue)
+    {
+    }
+
+    virtual void
+    run()
+    {
+        _queue.run();
+    }
+
+private:
+
+    FileInfoTaskQueue& _queue;
+};
+typedef IceUtil::Handle<FileInfoThread> FileInfoThreadPtr;
+
+//
+// The threads running the tasks of the queue. The threads which are
+// still running when the computation unwinds on an exception are
+// interrupted and joined, they use the queue.
+//
+class FileInfoThreads
+{
+public:
+
+    FileInfoThreads(FileInfoTaskQueue& queue) : _queue(queue)
+    {
+    }
+
+    ~FileInfoThreads()
+    {
+        if(!_threads.empty())
+        {
+            _queue.interrupt();
+            join();
+        }
+    }
+
+    void
+    start(size_t count)
+    {
+        for(size_t i = 0; i < count; ++i)
+        {
+            FileInfoThreadPtr thread = new FileInfoThread(_queue);
+            thread->start();
+            _threads.push_back(thread);
+        }
+    }
+
+    void
+    join()
+    {
+        for(vector<FileInfoThreadPtr>::const_iterator p = _threads.begin(); p != _threads.end(); ++p)
+        {
+            (*p)->getThreadControl().join();
+        }
+        _threads.clear();
+    }
+
+private:
+
+    FileInfoTaskQueue& _queue;
+    vector<FileInfoThreadPtr> _threads;
+};
+
+//
+// Returns false if the computation was interrupted by the callback.
+//
+bool
+computeFileInfos(const vector<FileInfoTask>& tasks, int compress, int threads, GetFileInfoSeqCB* cb,
+                 LargeFileInfoSeq& infoSeq)
+{
+    FileInfoTaskQueue queue(tasks, compress, cb, infoSeq);
+
+    FileInfoThreads workers(queue);
+    if(threads > 1 && tasks.size() > 1)
+    {
+        workers.start(min(static_cast<size_t>(threads), tasks.size()) - 1);
+    }
+
+    queue.run();
+    workers.join();
+
+    queue.throwException();
+    return !queue.interrupted();
+}
+
+bool
 getFileInfoSeqInternal(const string& basePath, const string& relPath, int compress, GetFileInfoSeqCB* cb,
-                       LargeFileInfoSeq& infoSeq)
+                       LargeFileInfoSeq& infoSeq, GetFileInfoSeqState& state)
 {
     if(relPath == checksumFile || relPath == logFile)
     {
@@ -836,7 +1700,7 @@ getFileInfoSeqInternal(const string& basePath, const string& relPath, int compre
             StringSeq content = readDirectory(path);
             for(StringSeq::const_iterator p = content.begin(); p != content.end() ; ++p)
             {
-                if(!getFileInfoSeqInternal(basePath, simplify(relPath + '/' + *p), compress, cb, infoSeq))
+                if(!getFileInfoSeqInternal(basePath, simplify(relPath + '/' + *p), compress, cb, infoSeq, state))
                 {
                     return false;
                 }
@@ -865,11 +1729,6 @@ getFileInfoSeqInternal(const string& basePath, const string& relPath, int compre
                 //
                 if(compress >= 2 || IceUtilInternal::stat(pathBZ2, &bufBZ2) == -1 || buf.st_mtime >= bufBZ2.st_mtime)
                 {
-                    if(cb && !cb->compress(relPath))
-                    {
-                        return false;
-                    }
-
                     doCompress = true;
                 }
                 else
@@ -878,134 +1737,44 @@ getFileInfoSeqInternal(const string& basePath, const string& relPath, int compre
                 }
             }
 
-            if(cb && !cb->checksum(relPath))
+            bool doZstd = false;
+            if(state.zstd && buf.st_size != 0 && compress > 0)
             {
-                return false;
+                IceUtilInternal::structstat bufZstd;
+                doZstd = doCompress || IceUtilInternal::stat(path + ".zst", &bufZstd) == -1 ||
+                    buf.st_mtime >= bufZstd.st_mtime;
             }
 
-            ByteSeq bytesSHA;
-
-            if(relPath.size() + buf.st_size == 0)
-            {
-                bytesSHA.resize(20);
-                fill(bytesSHA.begin(), bytesSHA.end(), 0);
-            }
-            else
+            //
+            // Reuse the checksum of the previous summary if the file
+            // and its compressed file didn't change since the summary
+            // was saved.
+            //
+            if(state.incremental && !doCompress && !doZstd && buf.st_mtime < state.summaryTime)
             {
-                IceUtilInternal::SHA1 hasher;
-                if(relPath.size() != 0)
+                map<string, LargeFileInfo>::const_iterator p = state.previous.find(relPath);
+                if(p != state.previous.end() && p->second.size == info.size &&
+                   p->second.executable == info.executable && isChunksUpToDate(path, buf, compress))
                 {
-                    hasher.update(reinterpret_cast<const IceUtil::Byte*>(relPath.c_str()), relPath.size());
+                    info.checksum = p->second.checksum;
+                    infoSeq.push_back(info);
+                    return true;
                 }
-
-                if(buf.st_size != 0)
-                {
-                    int fd = IceUtilInternal::open(path.c_str(), O_BINARY|O_RDONLY);
-                    if(fd == -1)
-                    {
-                        throw "cannot open `" + path + "' for reading:\n" + IceUtilInternal::lastErrorToString();
-                    }
-
-                    const string pathBZ2Temp = path + ".bz2temp";
-                    FILE* stdioFile = 0;
-                    int bzError = 0;
-                    BZFILE* bzFile = 0;
-                    if(doCompress)
-                    {
-                        stdioFile = IceUtilInternal::fopen(simplify(pathBZ2Temp), "wb");
-                        if(!stdioFile)
-                        {
-                            IceUtilInternal::close(fd);
-                            throw "cannot open `" + pathBZ2Temp + "' for writing:\n" + IceUtilInternal::lastErrorToString();
-                        }
-
-                        bzFile = BZ2_bzWriteOpen(&bzError, stdioFile, 5, 0, 0);
-                        if(bzError != BZ_OK)
-                        {
-                            string ex = "BZ2_bzWriteOpen failed";
-                            if(bzError == BZ_IO_ERROR)
-                            {
-                            ex += string(": ") + IceUtilInternal::lastErrorToString();
-                            }
-                            fclose(stdioFile);
-                            IceUtilInternal::close(fd);
-                            throw ex;
-                        }
-                    }
-
-                    long bytesLeft = buf.st_size;
-                    while(bytesLeft > 0)
-                    {
-                        ByteSeq bytes(min(bytesLeft, 1024l*1024));
-                        if(
-#if defined(_MSC_VER)
-                            _read(fd, &bytes[0], static_cast<unsigned int>(bytes.size()))
-#else
-                            read(fd, &bytes[0], static_cast<unsigned int>(bytes.size()))
-#endif
-                            == -1)
-                        {
-                            if(doCompress)
-                            {
-                                fclose(stdioFile);
-                            }
-
-                            IceUtilInternal::close(fd);
-                            throw "cannot read from `" + path + "':\n" + IceUtilInternal::lastErrorToString();
-                        }
-                        bytesLeft -= static_cast<unsigned int>(bytes.size());
-                        if(doCompress)
-                        {
-                            BZ2_bzWrite(&bzError, bzFile, const_cast<Byte*>(&bytes[0]), static_cast<int>(bytes.size()));
-                            if(bzError != BZ_OK)
-                            {
-                                string ex = "BZ2_bzWrite failed";
-                                if(bzError == BZ_IO_ERROR)
-                                {
-                                    ex += string(": ") + IceUtilInternal::lastErrorToString();
-                                }
-                                BZ2_bzWriteClose(&bzError, bzFile, 0, 0, 0);
-                                fclose(stdioFile);
-                                IceUtilInternal::close(fd);
-                                throw ex;
-                            }
-                        }
-
-                        hasher.update(reinterpret_cast<IceUtil::Byte*>(&bytes[0]), bytes.size());
-                    }
-
-                    IceUtilInternal::close(fd);
-
-                    if(doCompress)
-                    {
-                        BZ2_bzWriteClose(&bzError, bzFile, 0, 0, 0);
-                        if(bzError != BZ_OK)
-                        {
-                            string ex = "BZ2_bzWriteClose failed";
-                            if(bzError == BZ_IO_ERROR)
-                            {
-                                ex += string(": ") + IceUtilInternal::lastErrorToString();
-                            }
-                            fclose(stdioFile);
-                            throw ex;
-                        }
-
-                        fclose(stdioFile);
-
-                        rename(pathBZ2Temp, pathBZ2);
-
-                        if(IceUtilInternal::stat(pathBZ2, &bufBZ2) == -1)
-                        {
-                            throw "cannot stat `" + pathBZ2 + "':\n" + IceUtilInternal::lastErrorToString();
-                        }
-
-                        info.size = bufBZ2.st_size;
-                    }
-                }
-                hasher.finalize(bytesSHA);
             }
 
-            info.checksum.swap(bytesSHA);
+            //
+            // The checksum is computed once the walk of the directory
+            // is completed, possibly by several threads. The progress
+            // is reported to the callback once it's computed.
+            //
+            FileInfoTask task;
+            task.index = infoSeq.size();
+            task.path = path;
+            task.relPath = relPath;
+            task.buf = buf;
+            task.doCompress = doCompress;
+            task.doZstd = doZstd;
+            state.tasks.push_back(task);
 
             infoSeq.push_back(info);
         }
@@ -1023,19 +1792,57 @@ IcePatch2Internal::GetFileInfoSeqCB::~GetFileInfoSeqCB()
 
 bool
 IcePatch2Internal::getFileInfoSeq(const string& basePath, int compress, GetFileInfoSeqCB* cb,
-                                  LargeFileInfoSeq& infoSeq)
+                                  LargeFileInfoSeq& infoSeq, int threads, bool incremental, bool zstd)
 {
-    return getFileInfoSeqSubDir(basePath, ".", compress, cb, infoSeq);
+    return getFileInfoSeqSubDir(basePath, ".", compress, cb, infoSeq, threads, incremental, zstd);
 }
 
 bool
 IcePatch2Internal::getFileInfoSeqSubDir(const string& basePa, const string& relPa, int compress, GetFileInfoSeqCB* cb,
-                                        LargeFileInfoSeq& infoSeq)
+                                        LargeFileInfoSeq& infoSeq, int threads, bool incremental, bool zstd)
 {
     const string basePath = simplify(basePa);
     const string relPath = simplify(relPa);
 
-    if(!getFileInfoSeqInternal(basePath, relPath, compress, cb, infoSeq))
+    if(zstd && !hasZstd())
+    {
+        throw string("Zstandard support is not available");
+    }
+
+    GetFileInfoSeqState state;
+    state.zstd = zstd;
+    if(incremental)
+    {
+        IceUtilInternal::structstat buf;
+        if(IceUtilInternal::stat(simplify(basePath + '/' + checksumFile), &buf) != -1)
+        {
+            LargeFileInfoSeq previous;
+            try
+            {
+                loadFileInfoSeq(basePath, previous);
+                for(LargeFileInfoSeq::const_iterator p = previous.begin(); p != previous.end(); ++p)
+                {
+                    state.previous.insert(make_pair(p->path, *p));
+                }
+                state.incremental = true;
+                state.summaryTime = buf.st_mtime;
+            }
+            catch(const string&)
+            {
+                // Ignore, the checksums of all the files are computed.
+            }
+        }
+    }
+
+    if(!getFileInfoSeqInternal(basePath, relPath, compress, cb, infoSeq, state))
+    {
+        return false;
+    }
+
+    //
+    // Compute the checksums of the new or updated files.
+    //
+    if(!computeFileInfos(state.tasks, compress, threads, cb, infoSeq))
     {
         return false;
     }
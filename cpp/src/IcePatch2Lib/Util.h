@@ -49,8 +49,28 @@ ICE_PATCH2_API void createDirectoryRecursive(const std::string&);
 ICE_PATCH2_API void compressBytesToFile(const std::string&, const Ice::ByteSeq&, Ice::Int);
 ICE_PATCH2_API void decompressFile(const std::string&);
 
+//
+// The files can also be compressed with Zstandard, which is much
+// faster to decompress than bzip2, if the IcePatch2 library is built
+// with Zstandard support. The Zstandard-compressed files are saved
+// with the ".zst" suffix.
+//
+ICE_PATCH2_API bool hasZstd();
+ICE_PATCH2_API void decompressFileZstd(const std::string&);
+
 ICE_PATCH2_API void setFileFlags(const std::string&, const IcePatch2::LargeFileInfo&);
 
+//
+// The content-defined chunks of a file. The chunks are only computed
+// for the files larger than minChunkedFileSize and saved with the
+// ".chunks" suffix.
+//
+ICE_PATCH2_API extern const Ice::Long minChunkedFileSize;
+
+ICE_PATCH2_API void getFileChunks(const std::string&, IcePatch2::FileChunkInfoSeq&);
+ICE_PATCH2_API void saveFileChunks(const std::string&, const IcePatch2::FileChunkInfoSeq&);
+ICE_PATCH2_API bool loadFileChunks(const std::string&, IcePatch2::FileChunkInfoSeq&);
+
 struct FileInfoEqual : public std::binary_function<const IcePatch2::LargeFileInfo&, const IcePatch2::LargeFileInfo&, bool>
 {
     bool
@@ -163,9 +183,20 @@ public:
     virtual bool compress(const std::string&) = 0;
 };
 
-ICE_PATCH2_API bool getFileInfoSeq(const std::string&, int, GetFileInfoSeqCB*, IcePatch2::LargeFileInfoSeq&);
+//
+// Get the file infos of the files of the given directory. The
+// checksums, compressed files and chunks are computed by the given
+// number of threads, the callback is called once the checksum of a
+// file is computed. If incremental is true, the checksums of the
+// files which didn't change since the summary file was saved are
+// read from the summary file instead of being computed. If zstd is
+// true, the files are also compressed with Zstandard.
+//
+ICE_PATCH2_API bool getFileInfoSeq(const std::string&, int, GetFileInfoSeqCB*, IcePatch2::LargeFileInfoSeq&,
+                                   int = 1, bool = false, bool = false);
 
-ICE_PATCH2_API bool getFileInfoSeqSubDir(const std::string&, const std::string&, int, GetFileInfoSeqCB*, IcePatch2::LargeFileInfoSeq&);
+ICE_PATCH2_API bool getFileInfoSeqSubDir(const std::string&, const std::string&, int, GetFileInfoSeqCB*,
+                                         IcePatch2::LargeFileInfoSeq&, int = 1, bool = false, bool = false);
 
 ICE_PATCH2_API void saveFileInfoSeq(const std::string&, const IcePatch2::LargeFileInfoSeq&);
 
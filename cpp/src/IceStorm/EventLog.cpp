@@ -0,0 +1,703 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#include <IceStorm/EventLog.h>
+#include <IceUtil/FileUtil.h>
+#include <IceUtil/InputUtil.h>
+#include <IceUtil/StringConverter.h>
+#include <Ice/InputStream.h>
+#include <Ice/OutputStream.h>
+#include <Ice/LocalException.h>
+#include <Ice/Protocol.h>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#   include <sys/types.h>
+#   include <sys/stat.h>
+#   include <dirent.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+using namespace std;
+using namespace IceStorm;
+
+const string IceStorm::eventLogSequenceKey = "_seq";
+
+namespace
+{
+
+const string segmentSuffix = ".log";
+
+//
+// The size of a record header: the record size, the event sequence
+// number and the time the event was appended.
+//
+const size_t headerSize = sizeof(Ice::Int) + 2 * sizeof(Ice::Long);
+
+void
+throwFileException(const char* file, int line, const string& path)
+{
+    Ice::FileException ex(file, line);
+    ex.path = path;
+    ex.error = IceInternal::getSystemErrno();
+    throw ex;
+}
+
+vector<string>
+readSegments(const string& path)
+{
+    vector<string> names;
+#ifdef _WIN32
+    const wstring pattern = IceUtil::stringToWstring(path + "\\*" + segmentSuffix,
+                                                     IceUtil::getProcessStringConverter());
+    WIN32_FIND_DATAW data;
+    HANDLE h = FindFirstFileW(pattern.c_str(), &data);
+    if(h == INVALID_HANDLE_VALUE)
+    {
+        if(GetLastError() != ERROR_FILE_NOT_FOUND)
+        {
+            throwFileException(__FILE__, __LINE__, path);
+        }
+        return names;
+    }
+    do
+    {
+        names.push_back(IceUtil::wstringToString(data.cFileName, IceUtil::getProcessStringConverter()));
+    }
+    while(FindNextFileW(h, &data));
+    FindClose(h);
+#else
+    DIR* dir = opendir(path.c_str());
+    if(!dir)
+    {
+        throwFileException(__FILE__, __LINE__, path);
+    }
+    struct dirent* entry;
+    while((entry = readdir(dir)) != 0)
+    {
+        string name = entry->d_name;
+        if(name.size() > segmentSuffix.size() &&
+           name.compare(name.size() - segmentSuffix.size(), segmentSuffix.size(), segmentSuffix) == 0)
+        {
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+#endif
+    return names;
+}
+
+class SyncTask : public IceUtil::TimerTask
+{
+public:
+
+    SyncTask(const EventLogPtr& log) : _log(log)
+    {
+    }
+
+    virtual void
+    runTimerTask()
+    {
+        _log->sync();
+    }
+
+private:
+
+    const EventLogPtr _log;
+};
+
+}
+
+//
+// A segment file. The segment holds a sequence of records, each record
+// is made of the record size, the event sequence number, the time the
+// event was appended and the marshaled event. The first record with a
+// null size marks the end of the segment.
+//
+class EventLog::Segment : public IceUtil::Shared
+{
+public:
+
+    Segment(const Ice::CommunicatorPtr&, const string&, Ice::Long, size_t);
+    ~Segment();
+
+    bool append(const Ice::CommunicatorPtr&, Ice::Long, Ice::Long, const EventDataPtr&, size_t&);
+    Ice::Long read(const Ice::CommunicatorPtr&, Ice::Long, size_t, EventDataSeq&) const;
+
+    void sync(bool);
+    void close();
+    void remove();
+
+    Ice::Long first() const { return _first; }
+    Ice::Long next() const { return _next; }
+    Ice::Long lastTime() const { return _lastTime; }
+    size_t capacity() const { return _capacity; }
+    bool empty() const { return _next == _first; }
+
+private:
+
+    void recover(const Ice::CommunicatorPtr&);
+    void syncNoSync(bool);
+
+    const string _path;
+    const Ice::Long _first;
+#ifdef _WIN32
+    HANDLE _file;
+    HANDLE _mapping;
+#else
+    int _fd;
+#endif
+    Ice::Byte* _data;
+    size_t _capacity;
+    size_t _size; // The size of the records.
+    Ice::Long _next; // The sequence number of the next record.
+    Ice::Long _lastTime; // The time of the last record.
+    std::vector<size_t> _offsets; // The offset of each record, indexed by its sequence number minus _first.
+
+    //
+    // Serializes the synchronization of the mapping with its removal,
+    // the sync task synchronizes the active segment without holding
+    // the log mutex.
+    //
+    IceUtil::Mutex _syncMutex;
+};
+
+//
+// Create a new segment with the given capacity or, if the capacity
+// is 0, open and recover an existing segment.
+//
+EventLog::Segment::Segment(const Ice::CommunicatorPtr& communicator, const string& path, Ice::Long first,
+                           size_t capacity) :
+    _path(path),
+    _first(first),
+#ifdef _WIN32
+    _file(INVALID_HANDLE_VALUE),
+    _mapping(0),
+#else
+    _fd(-1),
+#endif
+    _data(0),
+    _capacity(capacity),
+    _size(0),
+    _next(first),
+    _lastTime(0)
+{
+    try
+    {
+#ifdef _WIN32
+        const wstring wpath = IceUtil::stringToWstring(_path, IceUtil::getProcessStringConverter());
+        _file = CreateFileW(wpath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0,
+                            capacity > 0 ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+        if(_file == INVALID_HANDLE_VALUE)
+        {
+            throwFileException(__FILE__, __LINE__, _path);
+        }
+
+        LARGE_INTEGER size;
+        if(capacity > 0)
+        {
+            size.QuadPart = static_cast<LONGLONG>(capacity);
+            if(!SetFilePointerEx(_file, size, 0, FILE_BEGIN) || !SetEndOfFile(_file))
+            {
+                throwFileException(__FILE__, __LINE__, _path);
+            }
+        }
+        else
+        {
+            if(!GetFileSizeEx(_file, &size))
+            {
+                throwFileException(__FILE__, __LINE__, _path);
+            }
+            _capacity = static_cast<size_t>(size.QuadPart);
+        }
+
+        if(_capacity > 0)
+        {
+            _mapping = CreateFileMappingW(_file, 0, PAGE_READWRITE, 0, 0, 0);
+            if(!_mapping)
+            {
+                throwFileException(__FILE__, __LINE__, _path);
+            }
+            _data = static_cast<Ice::Byte*>(MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, 0));
+            if(!_data)
+            {
+                throwFileException(__FILE__, __LINE__, _path);
+            }
+        }
+#else
+        _fd = IceUtilInternal::open(_path, capacity > 0 ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR);
+        if(_fd < 0)
+        {
+            throwFileException(__FILE__, __LINE__, _path);
+        }
+
+        if(capacity > 0)
+        {
+            //
+            // The file is extended with zeros, the first record size
+            // is therefore null until a record is appended.
+            //
+            if(::ftruncate(_fd, static_cast<off_t>(capacity)) != 0)
+            {
+                throwFileException(__FILE__, __LINE__, _path);
+            }
+        }
+        else
+        {
+            IceUtilInternal::structstat buf;
+            if(::fstat(_fd, &buf) != 0)
+            {
+                throwFileException(__FILE__, __LINE__, _path);
+            }
+            _capacity = static_cast<size_t>(buf.st_size);
+        }
+
+        if(_capacity > 0)
+        {
+            void* data = ::mmap(0, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+            if(data == MAP_FAILED)
+            {
+                throwFileException(__FILE__, __LINE__, _path);
+            }
+            _data = static_cast<Ice::Byte*>(data);
+        }
+#endif
+
+        if(capacity == 0)
+        {
+            recover(communicator);
+        }
+    }
+    catch(...)
+    {
+        close();
+        throw;
+    }
+}
+
+EventLog::Segment::~Segment()
+{
+    close();
+}
+
+bool
+EventLog::Segment::append(const Ice::CommunicatorPtr& communicator, Ice::Long seq, Ice::Long time,
+                          const EventDataPtr& event, size_t& size)
+{
+    //
+    // Marshal the record in place at the end of the segment, the
+    // stream only allocates its own buffer if the record doesn't fit.
+    //
+    pair<const Ice::Byte*, const Ice::Byte*> p(_data + _size, _data + _capacity);
+    Ice::OutputStream stream(communicator, Ice::currentEncoding, p);
+    Ice::OutputStream::size_type pos = stream.startSize();
+    stream.write(seq);
+    stream.write(time);
+    stream.write(event);
+
+    size = stream.b.size();
+    if(size > _capacity - _size)
+    {
+        return false;
+    }
+
+    //
+    // Clear the size of the following record before setting the size
+    // of this record: recovery must not read the remains of a record
+    // that was only partially written before a crash.
+    //
+    if(_capacity - _size - size >= sizeof(Ice::Int))
+    {
+        memset(_data + _size + size, 0, sizeof(Ice::Int));
+    }
+    stream.endSize(pos);
+
+    _offsets.push_back(_size);
+    _size += size;
+    _next = seq + 1;
+    _lastTime = time;
+    return true;
+}
+
+Ice::Long
+EventLog::Segment::read(const Ice::CommunicatorPtr& communicator, Ice::Long from, size_t max,
+                        EventDataSeq& events) const
+{
+    Ice::Long last = -1;
+    if(_next <= from)
+    {
+        return last;
+    }
+
+    //
+    // Only the requested records are unmarshaled, the first one is
+    // found with the record offsets.
+    //
+    pair<const Ice::Byte*, const Ice::Byte*> p(_data, _data + _size);
+    Ice::InputStream stream(communicator, Ice::currentEncoding, p);
+    for(Ice::Long seq = from > _first ? from : _first; seq < _next && max > 0; ++seq, --max)
+    {
+        stream.pos(_offsets[static_cast<size_t>(seq - _first)] + headerSize);
+        EventDataPtr event;
+        stream.read(event);
+
+        ostringstream os;
+        os << seq;
+        event->context[eventLogSequenceKey] = os.str();
+        events.push_back(event);
+        last = seq;
+    }
+    return last;
+}
+
+void
+EventLog::Segment::sync(bool wait)
+{
+    IceUtil::Mutex::Lock sync(_syncMutex);
+    syncNoSync(wait);
+}
+
+void
+EventLog::Segment::syncNoSync(bool wait)
+{
+    if(!_data)
+    {
+        return;
+    }
+#ifdef _WIN32
+    FlushViewOfFile(_data, 0);
+    if(wait)
+    {
+        FlushFileBuffers(_file);
+    }
+#else
+    ::msync(_data, _capacity, wait ? MS_SYNC : MS_ASYNC);
+#endif
+}
+
+void
+EventLog::Segment::close()
+{
+    IceUtil::Mutex::Lock sync(_syncMutex);
+    syncNoSync(true);
+#ifdef _WIN32
+    if(_data)
+    {
+        UnmapViewOfFile(_data);
+    }
+    if(_mapping)
+    {
+        CloseHandle(_mapping);
+        _mapping = 0;
+    }
+    if(_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(_file);
+        _file = INVALID_HANDLE_VALUE;
+    }
+#else
+    if(_data)
+    {
+        ::munmap(_data, _capacity);
+    }
+    if(_fd >= 0)
+    {
+        IceUtilInternal::close(_fd);
+        _fd = -1;
+    }
+#endif
+    _data = 0;
+}
+
+void
+EventLog::Segment::remove()
+{
+    close();
+    IceUtilInternal::unlink(_path);
+}
+
+void
+EventLog::Segment::recover(const Ice::CommunicatorPtr& communicator)
+{
+    //
+    // Find the end of the segment. A record is valid if its size is
+    // set and if its sequence number follows the sequence number of
+    // the previous record.
+    //
+    pair<const Ice::Byte*, const Ice::Byte*> p(_data, _data + _capacity);
+    Ice::InputStream stream(communicator, Ice::currentEncoding, p);
+    while(_size + headerSize <= _capacity)
+    {
+        stream.pos(_size);
+
+        Ice::Int size;
+        Ice::Long seq;
+        Ice::Long time;
+        stream.read(size);
+        stream.read(seq);
+        stream.read(time);
+        if(size < static_cast<Ice::Int>(headerSize - sizeof(Ice::Int)) ||
+           static_cast<size_t>(size) > _capacity - _size - sizeof(Ice::Int) || seq != _next)
+        {
+            break;
+        }
+
+        _offsets.push_back(_size);
+        _size += static_cast<size_t>(size) + sizeof(Ice::Int);
+        _next = seq + 1;
+        _lastTime = time;
+    }
+}
+
+EventLog::EventLog(const Ice::CommunicatorPtr& communicator,
+                   const string& path,
+                   size_t segmentSize,
+                   Ice::Long retentionSize,
+                   const IceUtil::Time& retentionTime,
+                   const IceUtil::TimerPtr& timer,
+                   const IceUtil::Time& syncInterval) :
+    _communicator(communicator),
+    _path(path),
+    _segmentSize(segmentSize),
+    _retentionSize(retentionSize),
+    _retentionTime(retentionTime),
+    _timer(timer),
+    _closed(false),
+    _next(1),
+    _size(0)
+{
+    if(!IceUtilInternal::directoryExists(_path) && IceUtilInternal::mkdir(_path, 0777) != 0)
+    {
+        throwFileException(__FILE__, __LINE__, _path);
+    }
+
+    //
+    // Open the existing segments, events are appended to the last
+    // segment.
+    //
+    vector<string> names = readSegments(_path);
+    for(vector<string>::const_iterator p = names.begin(); p != names.end(); ++p)
+    {
+        Ice::Long first;
+        if(!IceUtilInternal::stringToInt64(p->substr(0, p->size() - segmentSuffix.size()), first))
+        {
+            continue;
+        }
+        SegmentPtr segment = new Segment(_communicator, _path + "/" + *p, first, 0);
+        _segments.insert(make_pair(first, segment));
+        _size += static_cast<Ice::Long>(segment->capacity());
+    }
+
+    if(!_segments.empty())
+    {
+        _active = _segments.rbegin()->second;
+        _next = _active->next();
+    }
+    trim(IceUtil::Time::now().toMilliSeconds());
+
+    if(_timer && syncInterval > IceUtil::Time())
+    {
+        //
+        // The sync task holds a reference to the log until the log is
+        // closed or destroyed.
+        //
+        __setNoDelete(true);
+        try
+        {
+            _syncTask = new SyncTask(this);
+            _timer->scheduleRepeated(_syncTask, syncInterval);
+        }
+        catch(...)
+        {
+            _syncTask = 0;
+            __setNoDelete(false);
+            throw;
+        }
+        __setNoDelete(false);
+    }
+}
+
+EventLog::~EventLog()
+{
+}
+
+Ice::Long
+EventLog::append(const EventDataSeq& events)
+{
+    IceUtil::Mutex::Lock sync(_mutex);
+    if(_closed)
+    {
+        return -1;
+    }
+
+    //
+    // The sequence numbers are stored in the records, the events
+    // shared with the subscribers aren't modified.
+    //
+    const Ice::Long first = _next;
+    const Ice::Long now = IceUtil::Time::now().toMilliSeconds();
+    for(EventDataSeq::const_iterator p = events.begin(); p != events.end(); ++p)
+    {
+        size_t size = 0;
+        if(!_active || !_active->append(_communicator, _next, now, *p, size))
+        {
+            roll(size);
+#ifndef NDEBUG
+            bool appended =
+#endif
+            _active->append(_communicator, _next, now, *p, size);
+            assert(appended);
+        }
+        ++_next;
+    }
+    trim(now);
+    return first;
+}
+
+Ice::Long
+EventLog::read(Ice::Long from, size_t max, EventDataSeq& events)
+{
+    IceUtil::Mutex::Lock sync(_mutex);
+    map<Ice::Long, SegmentPtr>::const_iterator p = _segments.upper_bound(from);
+    if(p != _segments.begin())
+    {
+        --p;
+    }
+    for(; p != _segments.end() && events.size() < max; ++p)
+    {
+        Ice::Long last = p->second->read(_communicator, from, max - events.size(), events);
+        if(last >= 0)
+        {
+            from = last + 1;
+        }
+    }
+    return events.size() < max ? _next : from;
+}
+
+void
+EventLog::sync()
+{
+    SegmentPtr active;
+    {
+        IceUtil::Mutex::Lock sync(_mutex);
+        active = _active;
+    }
+    if(active)
+    {
+        active->sync(true);
+    }
+}
+
+void
+EventLog::close()
+{
+    cancelSync();
+
+    IceUtil::Mutex::Lock sync(_mutex);
+    _closed = true;
+    for(map<Ice::Long, SegmentPtr>::const_iterator p = _segments.begin(); p != _segments.end(); ++p)
+    {
+        p->second->close();
+    }
+    _segments.clear();
+    _active = 0;
+}
+
+void
+EventLog::destroy()
+{
+    cancelSync();
+
+    IceUtil::Mutex::Lock sync(_mutex);
+    _closed = true;
+    for(map<Ice::Long, SegmentPtr>::const_iterator p = _segments.begin(); p != _segments.end(); ++p)
+    {
+        p->second->remove();
+    }
+    _segments.clear();
+    _active = 0;
+    IceUtilInternal::rmdir(_path);
+}
+
+void
+EventLog::cancelSync()
+{
+    IceUtil::TimerTaskPtr task;
+    {
+        IceUtil::Mutex::Lock sync(_mutex);
+        task = _syncTask;
+        _syncTask = 0;
+    }
+    if(task)
+    {
+        _timer->cancel(task);
+    }
+}
+
+string
+EventLog::segmentPath(Ice::Long first) const
+{
+    ostringstream os;
+    os << _path << '/' << setw(20) << setfill('0') << first << segmentSuffix;
+    return os.str();
+}
+
+void
+EventLog::roll(size_t size)
+{
+    if(_active)
+    {
+        if(_active->empty())
+        {
+            //
+            // The record doesn't fit in an empty segment, the segment
+            // is replaced with a segment large enough for the record.
+            //
+            _segments.erase(_active->first());
+            _size -= static_cast<Ice::Long>(_active->capacity());
+            _active->remove();
+        }
+        else
+        {
+            _active->sync(false);
+        }
+        _active = 0;
+    }
+
+    _active = new Segment(_communicator, segmentPath(_next), _next, max(_segmentSize, size));
+    _segments.insert(make_pair(_next, _active));
+    _size += static_cast<Ice::Long>(_active->capacity());
+}
+
+void
+EventLog::trim(Ice::Long now)
+{
+    //
+    // Remove the oldest segments, the active segment is never removed.
+    //
+    while(_segments.size() > 1)
+    {
+        SegmentPtr oldest = _segments.begin()->second;
+        if((_retentionSize <= 0 || _size <= _retentionSize) &&
+           (_retentionTime <= IceUtil::Time() || oldest->lastTime() >= now - _retentionTime.toMilliSeconds()))
+        {
+            break;
+        }
+        _segments.erase(_segments.begin());
+        _size -= static_cast<Ice::Long>(oldest->capacity());
+        oldest->remove();
+    }
+}
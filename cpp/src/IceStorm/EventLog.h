@@ -0,0 +1,109 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <IceStorm/IceStormInternal.h>
+#include <IceUtil/Mutex.h>
+#include <IceUtil/Timer.h>
+#include <map>
+
+namespace IceStorm
+{
+
+//
+// The context key holding the sequence number of an event recorded
+// in an event log. The sequence number is only set in the context of
+// the events sent to the subscribers with the replay QoS.
+//
+extern const std::string eventLogSequenceKey;
+
+//
+// An append-only log of the events published on a topic.
+//
+// The log is a directory of memory-mapped segment files named after
+// the sequence number of their first event. Events are marshaled in
+// place at the end of the active segment, a new segment is created
+// once the active segment is full. The oldest segments are removed
+// when the log exceeds its retention size or once their last event
+// is older than the retention time.
+//
+// The mapped segments are written back by the system, they survive a
+// crash of the process. The active segment is also synchronized with
+// the disk every sync interval, the events appended since the last
+// synchronization might be lost if the host crashes.
+//
+class EventLog : public IceUtil::Shared
+{
+public:
+
+    EventLog(const Ice::CommunicatorPtr&, const std::string&, size_t, Ice::Long, const IceUtil::Time&,
+             const IceUtil::TimerPtr&, const IceUtil::Time&);
+    ~EventLog();
+
+    //
+    // Append the events to the log, each event is assigned the next
+    // sequence number. Returns the sequence number of the first
+    // event or -1 if the log is closed.
+    //
+    Ice::Long append(const EventDataSeq&);
+
+    //
+    // Read up to the given number of events starting with the given
+    // sequence number, or with the oldest event if the log no longer
+    // holds this event. The sequence number of each event is set in
+    // its context. Returns the sequence number following the last
+    // event read.
+    //
+    Ice::Long read(Ice::Long, size_t, EventDataSeq&);
+
+    // Synchronize the active segment with the disk.
+    void sync();
+
+    // Close the log.
+    void close();
+
+    // Close the log and remove its files.
+    void destroy();
+
+private:
+
+    class Segment;
+    typedef IceUtil::Handle<Segment> SegmentPtr;
+
+    std::string segmentPath(Ice::Long) const;
+    void roll(size_t);
+    void trim(Ice::Long);
+    void cancelSync();
+
+    const Ice::CommunicatorPtr _communicator;
+    const std::string _path;
+    const size_t _segmentSize;
+    const Ice::Long _retentionSize;
+    const IceUtil::Time _retentionTime;
+    const IceUtil::TimerPtr _timer;
+
+    IceUtil::Mutex _mutex;
+
+    IceUtil::TimerTaskPtr _syncTask;
+
+    bool _closed;
+
+    // The segments indexed by the sequence number of their first event.
+    std::map<Ice::Long, SegmentPtr> _segments;
+    SegmentPtr _active; // The segment events are appended to.
+    Ice::Long _next; // The sequence number of the next event.
+    Ice::Long _size; // The size of the segment files.
+};
+typedef IceUtil::Handle<EventLog> EventLogPtr;
+
+} // End namespace IceStorm
+
+#endif
@@ -54,6 +54,7 @@ Client::usage()
         "-v, --version          Display version.\n"
         "--import FILE          Import database from FILE.\n"
         "--export FILE          Export database to FILE.\n"
+        "--compact DIR          Copy and compact the database environment to DIR.\n"
         "--dbhome DIR           Source or target database environment.\n"
         "--dbpath DIR           Source or target database environment.\n"
         "--mapsize VALUE        Set LMDB map size in MB (optional, import only).\n"
@@ -70,6 +71,7 @@ Client::run(int argc, char* argv[])
     opts.addOpt("d", "debug");
     opts.addOpt("", "import", IceUtilInternal::Options::NeedArg);
     opts.addOpt("", "export", IceUtilInternal::Options::NeedArg);
+    opts.addOpt("", "compact", IceUtilInternal::Options::NeedArg);
     opts.addOpt("", "dbhome", IceUtilInternal::Options::NeedArg);
     opts.addOpt("", "dbpath", IceUtilInternal::Options::NeedArg);
     opts.addOpt("", "mapsize", IceUtilInternal::Options::NeedArg);
@@ -104,9 +106,9 @@ Client::run(int argc, char* argv[])
         return EXIT_SUCCESS;
     }
 
-    if(!(opts.isSet("import") ^ opts.isSet("export")))
+    if((opts.isSet("import") ? 1 : 0) + (opts.isSet("export") ? 1 : 0) + (opts.isSet("compact") ? 1 : 0) != 1)
     {
-        cerr << argv[0] << ": either --import or --export must be set" << endl;
+        cerr << argv[0] << ": either --import, --export or --compact must be set" << endl;
         usage();
         return EXIT_FAILURE;
     }
@@ -120,7 +122,8 @@ Client::run(int argc, char* argv[])
 
     bool debug = opts.isSet("debug");
     bool import = opts.isSet("import");
-    string dbFile = opts.optArg(import ? "import" : "export");
+    bool compact = opts.isSet("compact");
+    string dbFile = opts.optArg(import ? "import" : (compact ? "compact" : "export"));
     string dbPath;
     if(opts.isSet("dbhome"))
     {
@@ -143,7 +146,30 @@ Client::run(int argc, char* argv[])
         dbContext.encoding.major = 1;
         dbContext.encoding.minor = 1;
 
-        if(import)
+        if(compact)
+        {
+            cout << "Compacting database from directory " << dbPath << " to directory " << dbFile << endl;
+
+            if(!IceUtilInternal::directoryExists(dbFile))
+            {
+                cerr << argv[0] << ": output directory does not exist: " << dbFile << endl;
+                return EXIT_FAILURE;
+            }
+
+            if(!IceUtilInternal::isEmptyDirectory(dbFile))
+            {
+                cerr << argv[0] << ": output directory is not empty: " << dbFile << endl;
+                return EXIT_FAILURE;
+            }
+
+            //
+            // The copy can be made while the database is in use.
+            //
+            IceDB::Env env(dbPath);
+            env.copy(dbFile, true);
+            env.close();
+        }
+        else if(import)
         {
             cout << "Importing database to directory " << dbPath << " from file " << dbFile << endl;
 
@@ -314,7 +340,7 @@ Client::run(int argc, char* argv[])
     }
     catch(const IceUtil::Exception& ex)
     {
-        cerr << argv[0] << ": " << (import ? "import" : "export") << " failed:\n" << ex << endl;
+        cerr << argv[0] << ": " << (import ? "import" : (compact ? "compact" : "export")) << " failed:\n" << ex << endl;
         return EXIT_FAILURE;
     }
 
@@ -12,11 +12,18 @@
 #include <IceStorm/Observers.h>
 #include <IceStorm/NodeI.h>
 #include <IceStorm/InstrumentationI.h>
+#include <IceStorm/EventLog.h>
 #include <IceUtil/Timer.h>
 
 #include <Ice/InstrumentationI.h>
 #include <Ice/Communicator.h>
 #include <Ice/Properties.h>
+#include <Ice/LocalException.h>
+#include <Ice/LoggerUtil.h>
+#include <IceUtil/FileUtil.h>
+#include <IceUtil/StringUtil.h>
+#include <iomanip>
+#include <algorithm>
 
 using namespace std;
 using namespace IceStorm;
@@ -44,6 +51,161 @@ TopicReaper::consumeReapedTopics()
     return reaped;
 }
 
+void
+PublishTask::run()
+{
+    try
+    {
+        publish();
+    }
+    catch(const std::exception& ex)
+    {
+        exception(ex);
+        return;
+    }
+    response();
+}
+
+PublishShard::PublishShard(const string& name, size_t queueSizeMax) :
+    IceUtil::Thread(name),
+    _queueSizeMax(queueSizeMax),
+    _destroyed(false)
+{
+}
+
+void
+PublishShard::queue(const PublishTaskPtr& task)
+{
+    {
+        Lock sync(*this);
+        while(!_destroyed && _tasks.size() >= _queueSizeMax)
+        {
+            wait();
+        }
+
+        if(!_destroyed)
+        {
+            if(_tasks.empty())
+            {
+                notifyAll();
+            }
+            _tasks.push_back(task);
+            return;
+        }
+    }
+
+    //
+    // The shard is destroyed, publish the events from the calling
+    // thread.
+    //
+    task->run();
+}
+
+void
+PublishShard::destroy()
+{
+    {
+        Lock sync(*this);
+        _destroyed = true;
+        notifyAll();
+    }
+    getThreadControl().join();
+}
+
+void
+PublishShard::run()
+{
+    while(true)
+    {
+        deque<PublishTaskPtr> tasks;
+        {
+            Lock sync(*this);
+            while(!_destroyed && _tasks.empty())
+            {
+                wait();
+            }
+
+            //
+            // Once destroyed, the remaining tasks are published before
+            // the thread exits.
+            //
+            if(_tasks.empty())
+            {
+                return;
+            }
+
+            if(_tasks.size() >= _queueSizeMax)
+            {
+                notifyAll(); // Wake up the publishers waiting for the queue to drain.
+            }
+            tasks.swap(_tasks);
+        }
+
+        for(deque<PublishTaskPtr>::const_iterator p = tasks.begin(); p != tasks.end(); ++p)
+        {
+            (*p)->run();
+        }
+    }
+}
+
+PublishDispatcher::PublishDispatcher(const string& name, int shards, int queueSizeMax, const string& partitionKey) :
+    _partitionKey(partitionKey)
+{
+    assert(shards > 0);
+    for(int i = 0; i < shards; ++i)
+    {
+        ostringstream os;
+        os << name << " publish shard " << i;
+        PublishShardPtr shard = new PublishShard(os.str(), static_cast<size_t>(max(queueSizeMax, 1)));
+        try
+        {
+            shard->start();
+        }
+        catch(const IceUtil::Exception&)
+        {
+            destroy();
+            throw;
+        }
+        _shards.push_back(shard);
+    }
+}
+
+void
+PublishDispatcher::dispatch(const string& topic, const Ice::Context& context, const PublishTaskPtr& task)
+{
+    //
+    // The shard is selected with the hash of the topic name and, if
+    // set, of the partition key value from the event context.
+    //
+    size_t hash = 0;
+    for(string::const_iterator p = topic.begin(); p != topic.end(); ++p)
+    {
+        hash = 5 * hash + static_cast<unsigned char>(*p);
+    }
+    if(!_partitionKey.empty())
+    {
+        Ice::Context::const_iterator q = context.find(_partitionKey);
+        if(q != context.end())
+        {
+            for(string::const_iterator p = q->second.begin(); p != q->second.end(); ++p)
+            {
+                hash = 5 * hash + static_cast<unsigned char>(*p);
+            }
+        }
+    }
+    _shards[hash % _shards.size()]->queue(task);
+}
+
+void
+PublishDispatcher::destroy()
+{
+    for(vector<PublishShardPtr>::const_iterator p = _shards.begin(); p != _shards.end(); ++p)
+    {
+        (*p)->destroy();
+    }
+    _shards.clear();
+}
+
 PersistentInstance::PersistentInstance(
     const string& instanceName,
     const string& name,
@@ -55,7 +217,23 @@ PersistentInstance::PersistentInstance(
     Instance(instanceName, name, communicator, publishAdapter, topicAdapter, nodeAdapter, nodeProxy),
     _dbLock(communicator->getProperties()->getPropertyWithDefault(name + ".LMDB.Path", name) + "/icedb.lock"),
     _dbEnv(communicator->getProperties()->getPropertyWithDefault(name + ".LMDB.Path", name), 2,
-           IceDB::getMapSize(communicator->getProperties()->getPropertyAsInt(name + ".LMDB.MapSize")))
+           IceDB::getMapSize(communicator->getProperties()->getPropertyAsInt(name + ".LMDB.MapSize")), 0,
+           static_cast<size_t>(max(communicator->getProperties()->getPropertyAsInt(name + ".LMDB.MapSizeMax"), 0))
+               * 1024 * 1024),
+    _groupCommit(new IceDB::GroupCommit(_dbEnv,
+                                        IceUtil::Time::milliSeconds(communicator->getProperties()->getPropertyAsInt(
+                                            name + ".LMDB.GroupCommitDelay")),
+                                        static_cast<size_t>(communicator->getProperties()->getPropertyAsIntWithDefault(
+                                            name + ".LMDB.GroupCommitSize", 100)))),
+    _eventLogPath(communicator->getProperties()->getProperty(name + ".EventLog.Path")),
+    _eventLogSegmentSize(static_cast<size_t>(communicator->getProperties()->getPropertyAsIntWithDefault(
+                                                 name + ".EventLog.SegmentSize", 16 * 1024)) * 1024), // 16MB
+    _eventLogRetentionSize(static_cast<Ice::Long>(communicator->getProperties()->getPropertyAsInt(
+                                                      name + ".EventLog.RetentionSize")) * 1024),
+    _eventLogRetentionTime(IceUtil::Time::seconds(communicator->getProperties()->getPropertyAsInt(
+                                                      name + ".EventLog.RetentionTime"))),
+    _eventLogSyncInterval(IceUtil::Time::milliSeconds(communicator->getProperties()->getPropertyAsIntWithDefault(
+                                                          name + ".EventLog.SyncInterval", 1000)))
 {
     try
     {
@@ -69,6 +247,20 @@ PersistentInstance::PersistentInstance(
         _subscriberMap = SubscriberMap(txn, "subscribers", dbContext, MDB_CREATE, compareSubscriberRecordKey);
 
         txn.commit();
+
+        if(!_eventLogPath.empty())
+        {
+            Ice::StringSeq topics = communicator->getProperties()->getPropertyAsList(name + ".EventLog.Topics");
+            _eventLogTopics.insert(topics.begin(), topics.end());
+
+            if(!IceUtilInternal::directoryExists(_eventLogPath) && IceUtilInternal::mkdir(_eventLogPath, 0777) != 0)
+            {
+                Ice::FileException ex(__FILE__, __LINE__);
+                ex.path = _eventLogPath;
+                ex.error = IceInternal::getSystemErrno();
+                throw ex;
+            }
+        }
     }
     catch(...)
     {
@@ -79,6 +271,35 @@ PersistentInstance::PersistentInstance(
     }
 }
 
+EventLogPtr
+PersistentInstance::createEventLog(const string& topic) const
+{
+    if(_eventLogPath.empty() || (!_eventLogTopics.empty() && _eventLogTopics.find(topic) == _eventLogTopics.end()))
+    {
+        return 0;
+    }
+
+    //
+    // The log directory name is the topic name with the characters
+    // other than letters, digits, `-' and `_' escaped.
+    //
+    ostringstream os;
+    os << _eventLogPath << '/';
+    for(string::const_iterator p = topic.begin(); p != topic.end(); ++p)
+    {
+        if(IceUtilInternal::isAlpha(*p) || IceUtilInternal::isDigit(*p) || *p == '-' || *p == '_')
+        {
+            os << *p;
+        }
+        else
+        {
+            os << '%' << hex << setw(2) << setfill('0') << static_cast<int>(static_cast<unsigned char>(*p)) << dec;
+        }
+    }
+    return new EventLog(communicator(), os.str(), _eventLogSegmentSize, _eventLogRetentionSize,
+                        _eventLogRetentionTime, timer(), _eventLogSyncInterval);
+}
+
 void
 PersistentInstance::destroy()
 {
@@ -110,6 +331,12 @@ Instance::Instance(
                                                    name + ".Flush.Timeout", 1000))), // default one second.
     // default one minute.
     _sendTimeout(communicator->getProperties()->getPropertyAsIntWithDefault(name + ".Send.Timeout", 60 * 1000)),
+    _linkFlushDelay(IceUtil::Time::microSeconds(communicator->getProperties()->getPropertyAsInt(
+                                                    name + ".Link.FlushDelay"))),
+    _linkBatchSizeMax(static_cast<size_t>(max(communicator->getProperties()->getPropertyAsInt(
+                                                  name + ".Link.BatchSizeMax"), 0))),
+    _linkOutstandingMax(max(communicator->getProperties()->getPropertyAsIntWithDefault(
+                                name + ".Link.OutstandingMax", 1), 1)),
     _topicReaper(new TopicReaper())
 {
     try
@@ -134,6 +361,20 @@ Instance::Instance(
         _batchFlusher = new IceUtil::Timer();
         _timer = new IceUtil::Timer();
 
+        //
+        // If publish shards are configured, events are published by
+        // the shard threads rather than by the publish object adapter
+        // threads.
+        //
+        int shards = properties->getPropertyAsInt(name + ".Dispatch.Shards");
+        if(shards > 0)
+        {
+            _publishDispatcher = new PublishDispatcher(name, shards,
+                                                       properties->getPropertyAsIntWithDefault(
+                                                           name + ".Dispatch.QueueSizeMax", 1000),
+                                                       properties->getProperty(name + ".Dispatch.PartitionKey"));
+        }
+
         //
         // If an Ice metrics observer is setup on the communicator, also
         // enable metrics for IceStorm.
@@ -269,6 +510,12 @@ Instance::topicReaper() const
     return _topicReaper;
 }
 
+PublishDispatcherPtr
+Instance::publishDispatcher() const
+{
+    return _publishDispatcher;
+}
+
 IceUtil::Time
 Instance::discardInterval() const
 {
@@ -287,9 +534,39 @@ Instance::sendTimeout() const
     return _sendTimeout;
 }
 
+IceUtil::Time
+Instance::linkFlushDelay() const
+{
+    return _linkFlushDelay;
+}
+
+size_t
+Instance::linkBatchSizeMax() const
+{
+    return _linkBatchSizeMax;
+}
+
+int
+Instance::linkOutstandingMax() const
+{
+    return _linkOutstandingMax;
+}
+
 void
 Instance::shutdown()
 {
+    //
+    // Once the publish adapter is destroyed no more events are
+    // queued, wait for the shards to publish the queued events. The
+    // shards are drained before the node is destroyed, the topics
+    // need the node to publish the events.
+    //
+    if(_publishDispatcher)
+    {
+        _publishAdapter->destroy();
+        _publishDispatcher->destroy();
+    }
+
     if(_node)
     {
         _node->destroy();
@@ -15,10 +15,16 @@
 #include <Ice/ObjectAdapterF.h>
 #include <Ice/PropertiesF.h>
 #include <IceUtil/Time.h>
+#include <IceUtil/Thread.h>
+#include <IceUtil/Monitor.h>
 #include <IceStorm/Election.h>
 #include <IceStorm/Instrumentation.h>
 #include <IceStorm/Util.h>
 
+#include <deque>
+#include <exception>
+#include <set>
+
 namespace IceUtil
 {
 
@@ -44,6 +50,9 @@ namespace IceStorm
 class TraceLevels;
 typedef IceUtil::Handle<TraceLevels> TraceLevelsPtr;
 
+class EventLog;
+typedef IceUtil::Handle<EventLog> EventLogPtr;
+
 class TopicReaper : public IceUtil::Shared, private IceUtil::Mutex
 {
 public:
@@ -57,6 +66,68 @@ private:
 };
 typedef IceUtil::Handle<TopicReaper> TopicReaperPtr;
 
+//
+// A task queued by a topic publisher on a publish dispatch shard. Once
+// the events are published, the task sends the response or the
+// exception to the publisher.
+//
+class PublishTask : public IceUtil::Shared
+{
+public:
+
+    void run();
+
+protected:
+
+    virtual void publish() = 0;
+    virtual void response() = 0;
+    virtual void exception(const std::exception&) = 0;
+};
+typedef IceUtil::Handle<PublishTask> PublishTaskPtr;
+
+class PublishShard : public IceUtil::Thread, private IceUtil::Monitor<IceUtil::Mutex>
+{
+public:
+
+    PublishShard(const std::string&, size_t);
+
+    void queue(const PublishTaskPtr&);
+    void destroy();
+
+    virtual void run();
+
+private:
+
+    const size_t _queueSizeMax;
+    std::deque<PublishTaskPtr> _tasks;
+    bool _destroyed;
+};
+typedef IceUtil::Handle<PublishShard> PublishShardPtr;
+
+//
+// The publish dispatcher publishes events on a fixed set of threads
+// (shards) instead of the publish object adapter threads. All the
+// events of a topic, or of a topic partition if a partition key is
+// configured, are published by the same shard to preserve ordering.
+// The shard queues are bounded, publishers wait when the queue of
+// their shard is full.
+//
+class PublishDispatcher : public IceUtil::Shared
+{
+public:
+
+    PublishDispatcher(const std::string&, int, int, const std::string&);
+
+    void dispatch(const std::string&, const Ice::Context&, const PublishTaskPtr&);
+    void destroy();
+
+private:
+
+    const std::string _partitionKey;
+    std::vector<PublishShardPtr> _shards;
+};
+typedef IceUtil::Handle<PublishDispatcher> PublishDispatcherPtr;
+
 class Instance : public IceUtil::Shared
 {
 public:
@@ -84,11 +155,16 @@ public:
     Ice::ObjectPrx publisherReplicaProxy() const;
     IceStorm::Instrumentation::TopicManagerObserverPtr observer() const;
     TopicReaperPtr topicReaper() const;
+    PublishDispatcherPtr publishDispatcher() const;
 
     IceUtil::Time discardInterval() const;
     IceUtil::Time flushInterval() const;
     int sendTimeout() const;
 
+    IceUtil::Time linkFlushDelay() const;
+    size_t linkBatchSizeMax() const;
+    int linkOutstandingMax() const;
+
     void shutdown();
     virtual void destroy();
 
@@ -105,6 +181,9 @@ private:
     const IceUtil::Time _discardInterval;
     const IceUtil::Time _flushInterval;
     const int _sendTimeout;
+    const IceUtil::Time _linkFlushDelay;
+    const size_t _linkBatchSizeMax;
+    const int _linkOutstandingMax;
     const Ice::ObjectPrx _topicReplicaProxy;
     const Ice::ObjectPrx _publisherReplicaProxy;
     const TopicReaperPtr _topicReaper;
@@ -112,6 +191,7 @@ private:
     IceStormElection::ObserversPtr _observers;
     IceUtil::TimerPtr _batchFlusher;
     IceUtil::TimerPtr _timer;
+    PublishDispatcherPtr _publishDispatcher;
     IceStorm::Instrumentation::TopicManagerObserverPtr _observer;
 
 
@@ -120,6 +200,8 @@ typedef IceUtil::Handle<Instance> InstancePtr;
 
 typedef IceDB::ReadWriteCursor<SubscriberRecordKey, SubscriberRecord, IceDB::IceContext, Ice::OutputStream>
         SubscriberMapRWCursor;
+typedef IceDB::ReadOnlyCursor<SubscriberRecordKey, SubscriberRecord, IceDB::IceContext, Ice::OutputStream>
+        SubscriberMapROCursor;
 
 class PersistentInstance : public Instance
 {
@@ -132,6 +214,10 @@ public:
     const IceDB::Env& dbEnv() const { return _dbEnv; }
     LLUMap lluMap() const { return _lluMap; }
     SubscriberMap subscriberMap() const { return _subscriberMap; }
+    IceDB::GroupCommitPtr groupCommit() const { return _groupCommit; }
+
+    // Returns 0 if the events of the topic aren't logged.
+    EventLogPtr createEventLog(const std::string&) const;
 
     virtual void destroy();
 
@@ -139,8 +225,16 @@ private:
 
     IceUtilInternal::FileLock _dbLock;
     IceDB::Env _dbEnv;
+    const IceDB::GroupCommitPtr _groupCommit;
     LLUMap _lluMap;
     SubscriberMap _subscriberMap;
+
+    const std::string _eventLogPath;
+    const size_t _eventLogSegmentSize;
+    const Ice::Long _eventLogRetentionSize;
+    const IceUtil::Time _eventLogRetentionTime;
+    const IceUtil::Time _eventLogSyncInterval;
+    std::set<std::string> _eventLogTopics;
 };
 typedef IceUtil::Handle<PersistentInstance> PersistentInstancePtr;
 
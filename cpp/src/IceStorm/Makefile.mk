@@ -16,7 +16,8 @@ $(project)_dependencies		:= IceStorm Ice
 IceStormService_targetdir	:= $(libdir)
 IceStormService_dependencies 	:= IceGrid Glacier2 IceBox IceDB
 IceStormService_libs		:= lmdb
-IceStormService_sources   	:= $(addprefix $(currentdir)/,Instance.cpp \
+IceStormService_sources   	:= $(addprefix $(currentdir)/,EventLog.cpp \
+							     Instance.cpp \
 							     InstrumentationI.cpp \
 							     NodeI.cpp \
 							     Observers.cpp \
@@ -15,10 +15,136 @@ using namespace std;
 using namespace IceStorm;
 using namespace IceStormElection;
 
+namespace
+{
+
+//
+// The state of the transfer of the topic content to a slave.
+//
+struct InitTransfer
+{
+    InitTransfer(int i, const ReplicaObserverPrx& o, const LogUpdate& l) :
+        id(i), observer(o), since(l), first(false), last(false), started(false) {}
+    int id;
+    ReplicaObserverPrx observer;
+    LogUpdate since;
+    string start;
+    bool first;
+    bool last;
+    bool started; // True once the first chunk is sent.
+    Ice::AsyncResultPtr result;
+};
+
+//
+// Transfer the topic content chunks to the slaves.
+//
+void
+initTransfers(vector<InitTransfer>& transfers, const LogUpdate& llu, const ReplicaPtr& replica,
+              const TraceLevelsPtr& traceLevels)
+{
+    bool more = true;
+    while(more)
+    {
+        more = false;
+        for(vector<InitTransfer>::iterator p = transfers.begin(); p != transfers.end(); ++p)
+        {
+            if(p->last)
+            {
+                continue;
+            }
+
+            try
+            {
+                LogUpdate tmp;
+                string next;
+                TopicContentChunk chunk = replica->getContentChunk(p->since, p->start, tmp, next);
+                if(chunk.first && traceLevels->replication > 0)
+                {
+                    Ice::Trace out(traceLevels->logger, traceLevels->replicationCat);
+                    out << "init " << p->id << ": ";
+                    if(chunk.full)
+                    {
+                        out << "transferring all topics";
+                    }
+                    else
+                    {
+                        out << "transferring topics updated since llu: "
+                            << p->since.generation << "/" << p->since.iteration;
+                    }
+                }
+                p->start = next;
+                p->first = chunk.first;
+                p->last = chunk.last;
+                p->result = p->observer->begin_initChunk(llu, chunk);
+                p->started = true;
+            }
+            catch(const Ice::Exception& ex)
+            {
+                if(traceLevels->replication > 0)
+                {
+                    Ice::Trace out(traceLevels->logger, traceLevels->replicationCat);
+                    out << "error calling init on " << p->id << ", exception: " << ex;
+                }
+                throw;
+            }
+        }
+
+        for(vector<InitTransfer>::iterator p = transfers.begin(); p != transfers.end(); ++p)
+        {
+            if(!p->result)
+            {
+                continue;
+            }
+
+            try
+            {
+                try
+                {
+                    p->observer->end_initChunk(p->result);
+                }
+                catch(const Ice::OperationNotExistException&)
+                {
+                    if(!p->first)
+                    {
+                        throw;
+                    }
+
+                    //
+                    // The slave doesn't support content chunks, send
+                    // all the topics at once.
+                    //
+                    LogUpdate tmp;
+                    TopicContentSeq content;
+                    replica->getContent(tmp, content);
+                    p->observer->init(llu, content);
+                    p->last = true;
+                }
+                p->result = 0;
+            }
+            catch(const Ice::Exception& ex)
+            {
+                if(traceLevels->replication > 0)
+                {
+                    Ice::Trace out(traceLevels->logger, traceLevels->replicationCat);
+                    out << "init on " << p->id << " failed with exception " << ex;
+                }
+                throw;
+            }
+            more = more || !p->last;
+        }
+    }
+}
+
+}
+
 Observers::Observers(const InstancePtr& instance) :
     _traceLevels(instance->traceLevels()),
-    _majority(0)
+    _majority(0),
+    _updatesMax(static_cast<size_t>(max(instance->communicator()->getProperties()->getPropertyAsIntWithDefault(
+                                            instance->serviceName() + ".Election.UpdateLogSize", 10000), 0)))
 {
+    _updatesBase.generation = -1;
+    _updatesBase.iteration = -1;
 }
 
 void
@@ -78,7 +204,7 @@ Observers::getReapedSlaves(std::vector<int>& d)
 }
 
 void
-Observers::init(const set<GroupNodeInfo>& slaves, const LogUpdate& llu, const TopicContentSeq& content)
+Observers::init(const set<GroupNodeInfo>& slaves, const LogUpdate& llu, const ReplicaPtr& replica)
 {
     {
         IceUtil::Mutex::Lock sync(_reapedMutex);
@@ -88,54 +214,103 @@ Observers::init(const set<GroupNodeInfo>& slaves, const LogUpdate& llu, const To
     Lock sync(*this);
     _observers.clear();
 
-    vector<ObserverInfo> observers;
-
+    vector<InitTransfer> transfers;
     for(set<GroupNodeInfo>::const_iterator p = slaves.begin(); p != slaves.end(); ++p)
     {
-        try
-        {
-            assert(p->observer);
-
-            ReplicaObserverPrx observer = ReplicaObserverPrx::uncheckedCast(p->observer);
-
-            Ice::AsyncResultPtr result = observer->begin_init(llu, content);
-            observers.push_back(ObserverInfo(p->id, observer, result));
-        }
-        catch(const Ice::Exception& ex)
-        {
-            if(_traceLevels->replication > 0)
-            {
-                Ice::Trace out(_traceLevels->logger, _traceLevels->replicationCat);
-                out << "error calling init on " << p->id << ", exception: " << ex;
-            }
-            throw;
-        }
+        assert(p->observer);
+        transfers.push_back(InitTransfer(p->id, ReplicaObserverPrx::uncheckedCast(p->observer), p->llu));
     }
 
-    for(vector<ObserverInfo>::iterator p = observers.begin(); p != observers.end(); ++p)
+    //
+    // Transfer the topic content to the slaves chunk by chunk. Each
+    // slave only gets the topics updated since its last log update
+    // unless the update log doesn't go back that far. If the transfer
+    // fails, the slaves which didn't apply their last chunk are told
+    // to abort the transfer, they otherwise keep their database
+    // transaction open until the next chunk times out.
+    //
+    try
     {
-        try
-        {
-            p->observer->end_init(p->result);
-            p->result = 0;
-        }
-        catch(const Ice::Exception& ex)
+        initTransfers(transfers, llu, replica, _traceLevels);
+    }
+    catch(const Ice::Exception&)
+    {
+        for(vector<InitTransfer>::const_iterator p = transfers.begin(); p != transfers.end(); ++p)
         {
-            if(_traceLevels->replication > 0)
+            if(p->started && (!p->last || p->result))
             {
-                Ice::Trace out(_traceLevels->logger, _traceLevels->replicationCat);
-                out << "init on " << p->id << " failed with exception " << ex;
+                try
+                {
+                    p->observer->begin_abortInit();
+                }
+                catch(const Ice::Exception&)
+                {
+                    // Ignore, the slave aborts the transfer once the next chunk times out.
+                }
             }
-            throw;
         }
+        throw;
     }
 
+    vector<ObserverInfo> observers;
+    for(vector<InitTransfer>::const_iterator p = transfers.begin(); p != transfers.end(); ++p)
+    {
+        observers.push_back(ObserverInfo(p->id, p->observer));
+    }
     _observers.swap(observers);
 }
 
+void
+Observers::resetUpdates(const LogUpdate& llu)
+{
+    IceUtil::Mutex::Lock sync(_updatesMutex);
+    _updates.clear();
+    _updatesBase = llu;
+}
+
+void
+Observers::logUpdate(const LogUpdate& llu)
+{
+    IceUtil::Mutex::Lock sync(_updatesMutex);
+    if(_updatesBase < llu)
+    {
+        _updates[llu];
+        trimUpdates();
+    }
+}
+
+void
+Observers::logUpdate(const LogUpdate& llu, const string& name)
+{
+    IceUtil::Mutex::Lock sync(_updatesMutex);
+    if(_updatesBase < llu)
+    {
+        _updates[llu].push_back(name);
+        trimUpdates();
+    }
+}
+
+bool
+Observers::getUpdatedTopics(const LogUpdate& llu, set<string>& topics)
+{
+    IceUtil::Mutex::Lock sync(_updatesMutex);
+    if(_updates.find(llu) == _updates.end() && (_updatesBase.generation < 0 || llu != _updatesBase))
+    {
+        return false;
+    }
+
+    for(map<LogUpdate, vector<string> >::const_iterator p = _updates.upper_bound(llu); p != _updates.end(); ++p)
+    {
+        topics.insert(p->second.begin(), p->second.end());
+    }
+    return true;
+}
+
 void
 Observers::createTopic(const LogUpdate& llu, const string& name)
 {
+    logUpdate(llu, name);
+
     Lock sync(*this);
     for(vector<ObserverInfo>::iterator p = _observers.begin(); p != _observers.end(); ++p)
     {
@@ -147,6 +322,8 @@ Observers::createTopic(const LogUpdate& llu, const string& name)
 void
 Observers::destroyTopic(const LogUpdate& llu, const string& id)
 {
+    logUpdate(llu, id);
+
     Lock sync(*this);
     for(vector<ObserverInfo>::iterator p = _observers.begin(); p != _observers.end(); ++p)
     {
@@ -159,6 +336,8 @@ Observers::destroyTopic(const LogUpdate& llu, const string& id)
 void
 Observers::addSubscriber(const LogUpdate& llu, const string& name, const SubscriberRecord& rec)
 {
+    logUpdate(llu, name);
+
     Lock sync(*this);
     for(vector<ObserverInfo>::iterator p = _observers.begin(); p != _observers.end(); ++p)
     {
@@ -170,6 +349,8 @@ Observers::addSubscriber(const LogUpdate& llu, const string& name, const Subscri
 void
 Observers::removeSubscriber(const LogUpdate& llu, const string& name, const Ice::IdentitySeq& id)
 {
+    logUpdate(llu, name);
+
     Lock sync(*this);
     for(vector<ObserverInfo>::iterator p = _observers.begin(); p != _observers.end(); ++p)
     {
@@ -178,6 +359,19 @@ Observers::removeSubscriber(const LogUpdate& llu, const string& name, const Ice:
     wait("removeSubscriber");
 }
 
+void
+Observers::trimUpdates()
+{
+    //
+    // Called with _updatesMutex locked.
+    //
+    while(_updates.size() > _updatesMax)
+    {
+        _updatesBase = _updates.begin()->first;
+        _updates.erase(_updates.begin());
+    }
+}
+
 void
 Observers::wait(const string& op)
 {
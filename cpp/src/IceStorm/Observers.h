@@ -42,16 +42,28 @@ public:
     bool check();
     void clear();
 
-    void init(const std::set<IceStormElection::GroupNodeInfo>&, const LogUpdate&, const TopicContentSeq&);
+    void init(const std::set<IceStormElection::GroupNodeInfo>&, const LogUpdate&, const ReplicaPtr&);
     void createTopic(const LogUpdate&, const std::string&);
     void destroyTopic(const LogUpdate&, const std::string&);
     void addSubscriber(const LogUpdate&, const std::string&, const IceStorm::SubscriberRecord&);
     void removeSubscriber(const LogUpdate&, const std::string&, const Ice::IdentitySeq&);
     void getReapedSlaves(std::vector<int>&);
 
+    //
+    // The update log records the topics updated by each log update
+    // to transfer only these topics to a replica which is behind.
+    //
+    void resetUpdates(const LogUpdate&);
+    void logUpdate(const LogUpdate&);
+    void logUpdate(const LogUpdate&, const std::string&);
+
+    // Returns false if the update log doesn't hold the given log update.
+    bool getUpdatedTopics(const LogUpdate&, std::set<std::string>&);
+
 private:
 
     void wait(const std::string&);
+    void trimUpdates();
 
     const IceStorm::TraceLevelsPtr _traceLevels;
     unsigned int _majority;
@@ -66,6 +78,11 @@ private:
     std::vector<ObserverInfo> _observers;
     IceUtil::Mutex _reapedMutex;
     std::vector<int> _reaped;
+
+    IceUtil::Mutex _updatesMutex;
+    const size_t _updatesMax;
+    LogUpdate _updatesBase; // The oldest log update of the update log.
+    std::map<LogUpdate, std::vector<std::string> > _updates;
 };
 typedef IceUtil::Handle<Observers> ObserversPtr;
 
@@ -43,6 +43,8 @@ public:
     virtual LogUpdate getLastLogUpdate() const = 0;
     virtual void sync(const Ice::ObjectPrx&) = 0;
     virtual void initMaster(const std::set<IceStormElection::GroupNodeInfo>&, const LogUpdate&) = 0;
+    virtual TopicContentChunk getContentChunk(const LogUpdate&, const std::string&, LogUpdate&, std::string&) = 0;
+    virtual void getContent(LogUpdate&, TopicContentSeq&) = 0;
     virtual Ice::ObjectPrx getObserver() const = 0;
     virtual Ice::ObjectPrx getSync() const = 0;
 };
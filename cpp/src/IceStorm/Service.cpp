@@ -491,6 +491,8 @@ ServiceI::validateProperties(const string& name, const PropertiesPtr& properties
         "Election.MasterTimeout",
         "Election.ElectionTimeout",
         "Election.ResponseTimeout",
+        "Election.SyncChunkSize",
+        "Election.UpdateLogSize",
         "Publish.AdapterId",
         "Publish.Endpoints",
         "Publish.Locator",
@@ -536,8 +538,23 @@ ServiceI::validateProperties(const string& name, const PropertiesPtr& properties
         "Trace.TopicManager",
         "Send.Timeout",
         "Discard.Interval",
+        "Dispatch.Shards",
+        "Dispatch.QueueSizeMax",
+        "Dispatch.PartitionKey",
+        "Link.FlushDelay",
+        "Link.BatchSizeMax",
+        "Link.OutstandingMax",
+        "EventLog.Path",
+        "EventLog.Topics",
+        "EventLog.SegmentSize",
+        "EventLog.RetentionSize",
+        "EventLog.RetentionTime",
+        "EventLog.SyncInterval",
         "LMDB.Path",
-        "LMDB.MapSize"
+        "LMDB.MapSize",
+        "LMDB.MapSizeMax",
+        "LMDB.GroupCommitDelay",
+        "LMDB.GroupCommitSize"
     };
 
     vector<string> unknownProps;
@@ -12,8 +12,13 @@
 #include <IceStorm/TraceLevels.h>
 #include <IceStorm/NodeI.h>
 #include <IceStorm/Util.h>
+#include <IceStorm/EventLog.h>
 #include <Ice/LoggerUtil.h>
+#include <IceUtil/StringUtil.h>
+#include <IceUtil/InputUtil.h>
+#include <climits>
 #include <iterator>
+#include <sstream>
 
 using namespace std;
 using namespace IceStorm;
@@ -96,6 +101,30 @@ toSubscriberState(Subscriber::SubscriberState s)
     }
 }
 
+//
+// The cookie of the requests sent to twoway subscribers and links,
+// the id of the request in the outstanding window.
+//
+class RequestCookie : public Ice::LocalObject
+{
+public:
+
+    RequestCookie(Ice::Long id) :
+        id(id)
+    {
+    }
+
+    const Ice::Long id;
+};
+typedef IceUtil::Handle<RequestCookie> RequestCookiePtr;
+
+Ice::Long
+requestId(const Ice::AsyncResultPtr& result)
+{
+    RequestCookiePtr cookie = RequestCookiePtr::dynamicCast(result->getCookie());
+    return cookie ? cookie->id : -1;
+}
+
 }
 
 // Each of the various Subscriber types.
@@ -106,7 +135,8 @@ class SubscriberBatch : public Subscriber
 {
 public:
 
-    SubscriberBatch(const InstancePtr&, const SubscriberRecord&, const Ice::ObjectPrx&, int, const Ice::ObjectPrx&);
+    SubscriberBatch(const InstancePtr&, const SubscriberRecord&, const Ice::ObjectPrx&, int, const EventFilterPtr&,
+                    const Ice::ObjectPrx&);
     ~SubscriberBatch();
 
     virtual void flush();
@@ -122,7 +152,6 @@ public:
 private:
 
     const Ice::ObjectPrx _obj;
-    const IceUtil::Time _interval;
 };
 typedef IceUtil::Handle<SubscriberBatch> SubscriberBatchPtr;
 
@@ -130,7 +159,8 @@ class SubscriberOneway : public Subscriber
 {
 public:
 
-    SubscriberOneway(const InstancePtr&, const SubscriberRecord&, const Ice::ObjectPrx&, int, const Ice::ObjectPrx&);
+    SubscriberOneway(const InstancePtr&, const SubscriberRecord&, const Ice::ObjectPrx&, int, const EventFilterPtr&,
+                     const Ice::ObjectPrx&);
     ~SubscriberOneway();
 
     virtual void flush();
@@ -151,7 +181,7 @@ class SubscriberTwoway : public Subscriber
 {
 public:
 
-    SubscriberTwoway(const InstancePtr&, const SubscriberRecord&, const Ice::ObjectPrx&, int, int,
+    SubscriberTwoway(const InstancePtr&, const SubscriberRecord&, const Ice::ObjectPrx&, int, int, const EventFilterPtr&,
                      const Ice::ObjectPrx&);
 
     virtual void flush();
@@ -169,16 +199,21 @@ public:
 
     virtual void flush();
 
+    void doFlush();
+
 private:
 
     const TopicLinkPrx _obj;
+    bool _flushDue; // True if the flush delay of the queued events expired.
 };
+typedef IceUtil::Handle<SubscriberLink> SubscriberLinkPtr;
 
+template<class T>
 class FlushTimerTask : public IceUtil::TimerTask
 {
 public:
 
-    FlushTimerTask(const SubscriberBatchPtr& subscriber) :
+    FlushTimerTask(const IceUtil::Handle<T>& subscriber) :
         _subscriber(subscriber)
     {
     }
@@ -191,20 +226,40 @@ public:
 
 private:
 
-    const SubscriberBatchPtr _subscriber;
+    const IceUtil::Handle<T> _subscriber;
 };
 
 }
 
+class Subscriber::RefillTask : public IceUtil::TimerTask
+{
+public:
+
+    RefillTask(const SubscriberPtr& subscriber) :
+        _subscriber(subscriber)
+    {
+    }
+
+    virtual void
+    runTimerTask()
+    {
+        _subscriber->refill();
+    }
+
+private:
+
+    const SubscriberPtr _subscriber;
+};
+
 SubscriberBatch::SubscriberBatch(
     const InstancePtr& instance,
     const SubscriberRecord& rec,
     const Ice::ObjectPrx& proxy,
     int retryCount,
+    const EventFilterPtr& filter,
     const Ice::ObjectPrx& obj) :
-    Subscriber(instance, rec, proxy, retryCount, 1),
-    _obj(obj),
-    _interval(instance->flushInterval())
+    Subscriber(instance, rec, proxy, retryCount, 1, filter),
+    _obj(obj)
 {
     assert(retryCount == 0);
 }
@@ -216,10 +271,25 @@ SubscriberBatch::~SubscriberBatch()
 void
 SubscriberBatch::flush()
 {
+    //
+    // Events are flushed once the flush delay expires or as soon as
+    // the size of the queued events reaches the maximum batch size.
+    //
+    bool full = _maxBatchBytes > 0 && _queuedBytes >= _maxBatchBytes;
     if(_outstanding == 0)
     {
         ++_outstanding;
-        _instance->batchFlusher()->schedule(new FlushTimerTask(this), _interval);
+        _flushTask = new FlushTimerTask<SubscriberBatch>(this);
+        _instance->batchFlusher()->schedule(_flushTask, full ? IceUtil::Time() : _flushDelay);
+        if(full)
+        {
+            _flushTask = 0;
+        }
+    }
+    else if(full && _flushTask && _instance->batchFlusher()->cancel(_flushTask))
+    {
+        _instance->batchFlusher()->schedule(_flushTask, IceUtil::Time());
+        _flushTask = 0;
     }
 }
 
@@ -227,7 +297,8 @@ void
 SubscriberBatch::doFlush()
 {
     IceUtil::Monitor<IceUtil::RecMutex>::Lock sync(_lock);
-    
+    _flushTask = 0;
+
     //
     // If the subscriber isn't online we're done.
     //
@@ -238,6 +309,8 @@ SubscriberBatch::doFlush()
 
     EventDataSeq v;
     v.swap(_events);
+    _queuedBytes = 0;
+    dequeued(v.size());
     assert(!v.empty());
     
     if(_observer)
@@ -278,6 +351,14 @@ SubscriberBatch::doFlush()
     {
         _lock.notify();
     }
+    else if(!_events.empty() && _outstanding == 0)
+    {
+        //
+        // The next events to replay were queued once the batch was
+        // sent synchronously.
+        //
+        flush();
+    }
     
     // This is significantly faster than the async version, but it can
     // block the calling thread. Bad news!
@@ -319,8 +400,9 @@ SubscriberOneway::SubscriberOneway(
     const SubscriberRecord& rec,
     const Ice::ObjectPrx& proxy,
     int retryCount,
+    const EventFilterPtr& filter,
     const Ice::ObjectPrx& obj) :
-    Subscriber(instance, rec, proxy, retryCount, 5),
+    Subscriber(instance, rec, proxy, retryCount, 5, filter),
     _obj(obj)
 {
     assert(retryCount == 0);
@@ -352,6 +434,8 @@ SubscriberOneway::flush()
         //
         EventDataPtr e = _events.front();
         _events.erase(_events.begin());
+        _queuedBytes -= e->data.size();
+        dequeued(1);
         if(_observer)
         {
             _observer->outstanding(1);
@@ -419,8 +503,9 @@ SubscriberTwoway::SubscriberTwoway(
     const Ice::ObjectPrx& proxy,
     int retryCount,
     int maxOutstanding,
+    const EventFilterPtr& filter,
     const Ice::ObjectPrx& obj) :
-    Subscriber(instance, rec, proxy, retryCount, maxOutstanding),
+    Subscriber(instance, rec, proxy, retryCount, maxOutstanding, filter),
     _obj(obj)
 {
 }
@@ -438,8 +523,8 @@ SubscriberTwoway::flush()
         return;
     }
 
-    // Send up to _maxOutstanding pending events.
-    while(_outstanding < _maxOutstanding && !_events.empty())
+    // Send up to the outstanding window size pending events.
+    while(_outstanding < _window.size() && !_events.empty())
     {
         //
         // Dequeue the head event, count one more outstanding AMI
@@ -447,7 +532,10 @@ SubscriberTwoway::flush()
         //
         EventDataPtr e = _events.front();
         _events.erase(_events.begin());
+        _queuedBytes -= e->data.size();
+        dequeued(1);
         ++_outstanding;
+        Ice::Long id = _window.sent(1);
         if(_observer)
         {
             _observer->outstanding(1);
@@ -456,10 +544,12 @@ SubscriberTwoway::flush()
         try
         {
             _obj->begin_ice_invoke(e->op, e->mode, e->data, e->context,
-                                   Ice::newCallback(static_cast<Subscriber*>(this), &Subscriber::completed));
+                                   Ice::newCallback(static_cast<Subscriber*>(this), &Subscriber::completed),
+                                   new RequestCookie(id));
         }
         catch(const Ice::Exception& ex)
         {
+            _window.failed(id);
             error(true, ex);
             return;
         }
@@ -472,8 +562,9 @@ namespace
 SubscriberLink::SubscriberLink(
     const InstancePtr& instance,
     const SubscriberRecord& rec) :
-    Subscriber(instance, rec, 0, -1, 1),
-    _obj(TopicLinkPrx::uncheckedCast(rec.obj->ice_collocationOptimized(false)->ice_timeout(instance->sendTimeout())))
+    Subscriber(instance, rec, 0, -1, 1, 0),
+    _obj(TopicLinkPrx::uncheckedCast(rec.obj->ice_collocationOptimized(false)->ice_timeout(instance->sendTimeout()))),
+    _flushDue(false)
 {
 }
 
@@ -482,13 +573,36 @@ SubscriberLink::flush()
 {
     IceUtil::Monitor<IceUtil::RecMutex>::Lock sync(_lock);
     
-    if(_state != SubscriberStateOnline || _outstanding > 0)
+    if(_state != SubscriberStateOnline || _events.empty() || _outstanding >= _window.size())
     {
         return;
     }
 
+    //
+    // Wait for the flush delay to forward the events in a single
+    // request, unless the size of the queued events reaches the
+    // maximum batch size.
+    //
+    if(_flushDelay > IceUtil::Time() && !_flushDue && (_maxBatchBytes == 0 || _queuedBytes < _maxBatchBytes))
+    {
+        if(!_flushTask)
+        {
+            _flushTask = new FlushTimerTask<SubscriberLink>(this);
+            _instance->batchFlusher()->schedule(_flushTask, _flushDelay);
+        }
+        return;
+    }
+    if(_flushTask)
+    {
+        _instance->batchFlusher()->cancel(_flushTask);
+        _flushTask = 0;
+    }
+    _flushDue = false;
+
     EventDataSeq v;
     v.swap(_events);
+    _queuedBytes = 0;
+    dequeued(v.size());
 
     EventDataSeq::iterator p = v.begin();
     while(p != v.end())
@@ -512,23 +626,238 @@ SubscriberLink::flush()
 
     if(!v.empty())
     {
+        ++_outstanding;
+        Ice::Long id = _window.sent(static_cast<int>(v.size()));
         try
         {
-            ++_outstanding;
             if(_observer)
             {
                 _outstandingCount = static_cast<Ice::Int>(v.size());
                 _observer->outstanding(_outstandingCount);
             }
-            _obj->begin_forward(v, Ice::newCallback(static_cast<Subscriber*>(this), &Subscriber::completed));
+            _obj->begin_forward(v, Ice::newCallback(static_cast<Subscriber*>(this), &Subscriber::completed),
+                                new RequestCookie(id));
         }
         catch(const Ice::Exception& ex)
         {
+            _window.failed(id);
             error(true, ex);
         }
     }
 }
 
+void
+SubscriberLink::doFlush()
+{
+    IceUtil::Monitor<IceUtil::RecMutex>::Lock sync(_lock);
+    _flushTask = 0;
+    _flushDue = true;
+    flush();
+}
+
+}
+
+namespace
+{
+
+const string filterPrefix = "filter.";
+const string filterContextPrefix = "filter.context.";
+
+//
+// The maximum number of logged events read at once by a replaying
+// subscriber.
+//
+const size_t replayPageSize = 1000;
+
+string
+getQoS(const QoS& qos, const string& name)
+{
+    QoS::const_iterator p = qos.find(name);
+    return p != qos.end() ? p->second : string();
+}
+
+int
+getQoSInt(const QoS& qos, const string& name, int def = 0)
+{
+    QoS::const_iterator p = qos.find(name);
+    return p != qos.end() ? atoi(p->second.c_str()) : def;
+}
+
+//
+// Returns true if the QoS is set, raises BadQoS if its value isn't an
+// integer greater or equal to the given minimum.
+//
+bool
+checkQoSInt(const QoS& qos, const string& name, int min)
+{
+    QoS::const_iterator p = qos.find(name);
+    if(p == qos.end())
+    {
+        return false;
+    }
+
+    Ice::Long value;
+    if(!IceUtilInternal::stringToInt64(p->second, value) || value < min || value > INT_MAX)
+    {
+        throw BadQoS("invalid " + name + ": " + p->second);
+    }
+    return true;
+}
+
+bool
+matchPattern(const string& value, const string& pattern)
+{
+    if(pattern == "*")
+    {
+        return true;
+    }
+    if(value.empty() || pattern.empty())
+    {
+        return value == pattern;
+    }
+    return IceUtilInternal::match(value, pattern, true);
+}
+
+void
+checkPattern(const string& name, const string& pattern)
+{
+    string::size_type pos = pattern.find('*');
+    if(pos != string::npos && pattern.find('*', pos + 1) != string::npos)
+    {
+        throw BadQoS("invalid " + name + " QoS: `" + pattern + "' contains more than one wildcard");
+    }
+}
+
+}
+
+OutstandingWindow::OutstandingWindow(int min, int max) :
+    _min(std::min(min, max)),
+    _max(max),
+    _size(_min),
+    _samples(0),
+    _minRtt(-1),
+    _srtt(0),
+    _nextId(0)
+{
+}
+
+Ice::Long
+OutstandingWindow::sent(int count)
+{
+    _requests.insert(make_pair(_nextId, make_pair(IceUtil::Time::now(IceUtil::Time::Monotonic), count)));
+    return _nextId++;
+}
+
+int
+OutstandingWindow::completed(Ice::Long id)
+{
+    //
+    // The responses aren't necessarily received in the order the
+    // requests were sent, the round-trip time is the time of the
+    // given request.
+    //
+    map<Ice::Long, pair<IceUtil::Time, int> >::iterator p = _requests.find(id);
+    if(p == _requests.end())
+    {
+        return 1;
+    }
+
+    IceUtil::Int64 rtt = (IceUtil::Time::now(IceUtil::Time::Monotonic) - p->second.first).toMicroSeconds();
+    int count = p->second.second;
+    _requests.erase(p);
+    if(_min == _max)
+    {
+        return count;
+    }
+
+    if(_minRtt < 0)
+    {
+        _minRtt = rtt;
+        _srtt = rtt;
+    }
+    else
+    {
+        _minRtt = std::min(_minRtt, rtt);
+        _srtt = (7 * _srtt + rtt) / 8;
+    }
+
+    //
+    // Adjust the window once per window of responses.
+    //
+    if(++_samples >= _size)
+    {
+        _samples = 0;
+        if(_srtt < 2 * _minRtt + 1)
+        {
+            _size = std::min(_size + 1, _max);
+        }
+        else
+        {
+            _size = std::max(_size / 2, _min);
+        }
+    }
+    return count;
+}
+
+void
+OutstandingWindow::failed(Ice::Long id)
+{
+    _requests.erase(id);
+}
+
+EventFilterPtr
+EventFilter::create(const QoS& qos)
+{
+    EventFilterPtr filter;
+    for(QoS::const_iterator p = qos.lower_bound(filterPrefix);
+        p != qos.end() && p->first.compare(0, filterPrefix.size(), filterPrefix) == 0; ++p)
+    {
+        if(!filter)
+        {
+            filter = new EventFilter();
+        }
+
+        checkPattern(p->first, p->second);
+        if(p->first == "filter.op")
+        {
+            filter->_hasOp = true;
+            filter->_op = p->second;
+        }
+        else if(p->first.compare(0, filterContextPrefix.size(), filterContextPrefix) == 0 &&
+                p->first.size() > filterContextPrefix.size())
+        {
+            filter->_context.push_back(make_pair(p->first.substr(filterContextPrefix.size()), p->second));
+        }
+        else
+        {
+            throw BadQoS("invalid filter QoS: " + p->first);
+        }
+    }
+    return filter;
+}
+
+EventFilter::EventFilter() :
+    _hasOp(false)
+{
+}
+
+bool
+EventFilter::match(const EventDataPtr& event) const
+{
+    if(_hasOp && !matchPattern(event->op, _op))
+    {
+        return false;
+    }
+
+    for(vector<pair<string, string> >::const_iterator p = _context.begin(); p != _context.end(); ++p)
+    {
+        Ice::Context::const_iterator q = event->context.find(p->first);
+        if(q == event->context.end() || !matchPattern(q->second, p->second))
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
 SubscriberPtr
@@ -571,6 +900,14 @@ Subscriber::create(
                 throw BadQoS("invalid reliability: " + reliability);
             }
 
+            EventFilterPtr filter = EventFilter::create(rec.theQoS);
+
+            p = rec.theQoS.find("conflate");
+            if(p != rec.theQoS.end() && p->second.empty())
+            {
+                throw BadQoS("invalid conflate QoS: the context key is empty");
+            }
+
             //
             // Override the timeout.
             //
@@ -588,13 +925,31 @@ Subscriber::create(
                 //
                 newObj = rec.obj;
             }
+            //
+            // The flushDelayUs and maxBatchBytes QoS control the batching
+            // of the events sent to a batch subscriber, the maxOutstanding
+            // QoS is the maximum number of outstanding requests to a
+            // twoway subscriber.
+            //
+            bool batching = checkQoSInt(rec.theQoS, "flushDelayUs", 0);
+            batching = checkQoSInt(rec.theQoS, "maxBatchBytes", 0) || batching;
+            bool hasMaxOutstanding = checkQoSInt(rec.theQoS, "maxOutstanding", 1);
+            if(batching && !newObj->ice_isBatchOneway() && !newObj->ice_isBatchDatagram())
+            {
+                throw BadQoS("flushDelayUs and maxBatchBytes QoS require a batch proxy");
+            }
+            if(hasMaxOutstanding && (!newObj->ice_isTwoway() || reliability == "ordered"))
+            {
+                throw BadQoS("maxOutstanding QoS requires a twoway proxy without ordered reliability");
+            }
+
             if(reliability == "ordered")
             {
                 if(!newObj->ice_isTwoway())
                 {
                     throw BadQoS("ordered reliability requires a twoway proxy");
                 }
-                subscriber = new SubscriberTwoway(instance, rec, proxy, retryCount, 1, newObj);
+                subscriber = new SubscriberTwoway(instance, rec, proxy, retryCount, 1, filter, newObj);
             }
             else if(newObj->ice_isOneway() || newObj->ice_isDatagram())
             {
@@ -602,7 +957,7 @@ Subscriber::create(
                 {
                     throw BadQoS("non-zero retryCount QoS requires a twoway proxy");
                 }
-                subscriber = new SubscriberOneway(instance, rec, proxy, retryCount, newObj);
+                subscriber = new SubscriberOneway(instance, rec, proxy, retryCount, filter, newObj);
             }
             else if(newObj->ice_isBatchOneway() || newObj->ice_isBatchDatagram())
             {
@@ -610,12 +965,12 @@ Subscriber::create(
                 {
                     throw BadQoS("non-zero retryCount QoS requires a twoway proxy");
                 }
-                subscriber = new SubscriberBatch(instance, rec, proxy, retryCount, newObj);
+                subscriber = new SubscriberBatch(instance, rec, proxy, retryCount, filter, newObj);
             }
             else //if(newObj->ice_isTwoway())
             {
                 assert(newObj->ice_isTwoway());
-                subscriber = new SubscriberTwoway(instance, rec, proxy, retryCount, 5, newObj);
+                subscriber = new SubscriberTwoway(instance, rec, proxy, retryCount, 5, filter, newObj);
             }
             per->setSubscriber(subscriber);
         }
@@ -653,7 +1008,7 @@ Subscriber::record() const
 }
 
 bool
-Subscriber::queue(bool forwarded, const EventDataSeq& events)
+Subscriber::queue(bool forwarded, const EventDataSeq& events, Ice::Long seq)
 {
     IceUtil::Monitor<IceUtil::RecMutex>::Lock sync(_lock);
 
@@ -682,13 +1037,52 @@ Subscriber::queue(bool forwarded, const EventDataSeq& events)
     }
     
     case SubscriberStateOnline:
-        copy(events.begin(), events.end(), back_inserter(_events));
+    {
+        //
+        // Filtered out and conflated events aren't added to the
+        // queue and don't need to be flushed.
+        //
+        EventDataSeq::size_type count = 0;
+        for(EventDataSeq::size_type i = 0; i < events.size(); ++i)
+        {
+            EventDataPtr event = events[i];
+            if(seq > 0)
+            {
+                //
+                // Logged events are ignored while replaying and if
+                // they were already replayed. The event is shared
+                // with the other subscribers, its sequence number is
+                // set in the context of a copy.
+                //
+                Ice::Long eventSeq = seq + static_cast<Ice::Long>(i);
+                if(_replayLog || eventSeq < _replayEnd)
+                {
+                    continue;
+                }
+                if(_sequenced)
+                {
+                    ostringstream os;
+                    os << eventSeq;
+                    event = new EventData(event->op, event->mode, event->data, event->context);
+                    event->context[eventLogSequenceKey] = os.str();
+                }
+            }
+            if(push(event))
+            {
+                ++count;
+            }
+        }
+        if(count == 0)
+        {
+            break;
+        }
         if(_observer)
         {
-            _observer->queued(static_cast<Ice::Int>(events.size()));
+            _observer->queued(static_cast<Ice::Int>(count));
         }
         flush();
         break;
+    }
 
     case SubscriberStateError:
         return false;
@@ -700,6 +1094,184 @@ Subscriber::queue(bool forwarded, const EventDataSeq& events)
     return true;
 }
 
+void
+Subscriber::setReplay(const EventLogPtr& log, Ice::Long from)
+{
+    IceUtil::Monitor<IceUtil::RecMutex>::Lock sync(_lock);
+    _replayLog = log;
+    _replayNext = from;
+}
+
+void
+Subscriber::replay()
+{
+    {
+        IceUtil::Monitor<IceUtil::RecMutex>::Lock sync(_lock);
+        if(_state != SubscriberStateOnline || !_replayLog || _refilling)
+        {
+            return;
+        }
+        _refilling = true;
+    }
+    refill();
+}
+
+bool
+Subscriber::push(const EventDataPtr& event)
+{
+    //
+    // Events rejected by the subscriber filter are dropped here,
+    // they are never sent to the subscriber. Conflated events
+    // replace the queued event with the same key.
+    //
+    if((_filter && !_filter->match(event)) || (!_conflateKey.empty() && conflate(event)))
+    {
+        return false;
+    }
+    _events.push_back(event);
+    _queuedBytes += event->data.size();
+    return true;
+}
+
+bool
+Subscriber::conflate(const EventDataPtr& event)
+{
+    Ice::Context::const_iterator p = event->context.find(_conflateKey);
+    if(p == event->context.end())
+    {
+        return false;
+    }
+
+    //
+    // Replace the unsent event with the same key if there's one,
+    // otherwise record the position of the event about to be queued.
+    // The queue holds at most one event per key so its length is
+    // bounded by the number of keys.
+    //
+    map<string, EventDataSeq::size_type>::iterator q = _conflated.find(p->second);
+    if(q != _conflated.end() && q->second >= _dequeued)
+    {
+        EventDataPtr& e = _events[q->second - _dequeued];
+        _queuedBytes += event->data.size() - e->data.size();
+        e = event;
+        return true;
+    }
+    _conflated[p->second] = _dequeued + _events.size();
+    return false;
+}
+
+void
+Subscriber::dequeued(EventDataSeq::size_type count)
+{
+    //
+    // Called once count events are removed from the front of the
+    // queue. The conflated positions are reset once the queue is
+    // empty, this also drops the positions of the sent events.
+    //
+    if(_events.empty())
+    {
+        _conflated.clear();
+        _dequeued = 0;
+    }
+    else
+    {
+        _dequeued += count;
+    }
+
+    //
+    // Read the next page of events to replay once the queued events
+    // are sent. The page is read from the timer thread, the caller
+    // holds the subscriber lock.
+    //
+    if(_replayLog && _events.empty() && _state == SubscriberStateOnline && !_refilling)
+    {
+        _refilling = true;
+        try
+        {
+            _instance->timer()->schedule(new RefillTask(this), IceUtil::Time());
+        }
+        catch(const IceUtil::Exception&)
+        {
+            // The timer is destroyed, the service is shutting down.
+            _refilling = false;
+        }
+    }
+}
+
+void
+Subscriber::refill()
+{
+    IceUtil::Monitor<IceUtil::RecMutex>::Lock sync(_lock);
+    assert(_refilling);
+
+    //
+    // Events rejected by the filter aren't queued, keep reading until
+    // some events are queued or until the replay caught up with the
+    // log.
+    //
+    while(_replayLog && _events.empty() && _state == SubscriberStateOnline)
+    {
+        EventLogPtr log = _replayLog;
+        const Ice::Long from = _replayNext;
+        EventDataSeq events;
+        Ice::Long next = -1;
+
+        sync.release();
+        try
+        {
+            next = log->read(from, replayPageSize, events);
+        }
+        catch(const Ice::Exception& ex)
+        {
+            Ice::Warning out(_instance->traceLevels()->logger);
+            out << _rec.topicName << ": unable to read the event log: " << ex;
+        }
+        sync.acquire();
+
+        if(!_replayLog)
+        {
+            break; // The events left to replay were discarded while reading the log.
+        }
+        else if(next < 0)
+        {
+            _replayLog = 0;
+            _replayEnd = _replayNext;
+        }
+        else if(events.size() < replayPageSize)
+        {
+            //
+            // The replay caught up with the log, the logged events
+            // are now queued when they are published.
+            //
+            _replayLog = 0;
+            _replayEnd = next;
+        }
+        else
+        {
+            _replayNext = next;
+        }
+
+        EventDataSeq::size_type count = 0;
+        for(EventDataSeq::const_iterator p = events.begin(); p != events.end(); ++p)
+        {
+            if(push(*p))
+            {
+                ++count;
+            }
+        }
+        if(count > 0 && _observer)
+        {
+            _observer->queued(static_cast<Ice::Int>(count));
+        }
+    }
+
+    _refilling = false;
+    if(!_events.empty())
+    {
+        flush();
+    }
+}
+
 bool
 Subscriber::reap()
 {
@@ -765,7 +1337,7 @@ Subscriber::error(bool dec, const Ice::Exception& e)
     {
         // Decrement the _outstanding count.
         --_outstanding;
-        assert(_outstanding >= 0 && _outstanding < _maxOutstanding);
+        assert(_outstanding >= 0);
     }
 
     // A hard error is an ObjectNotExistException or
@@ -827,12 +1399,18 @@ Subscriber::error(bool dec, const Ice::Exception& e)
         _next = now + _instance->discardInterval();
         ++_currentRetry;
         _events.clear();
+        _queuedBytes = 0;
+        _replayLog = 0; // The events left to replay are discarded as well.
+        dequeued(0);
         setState(SubscriberStateOffline);
     }
     // Errored out.
     else if(_state < SubscriberStateError)
     {
         _events.clear();
+        _queuedBytes = 0;
+        _replayLog = 0; // The events left to replay are discarded as well.
+        dequeued(0);
         setState(SubscriberStateError);
         
         TraceLevelsPtr traceLevels = _instance->traceLevels();
@@ -866,10 +1444,11 @@ Subscriber::completed(const Ice::AsyncResultPtr& result)
 
         // Decrement the _outstanding count.
         --_outstanding;
-        assert(_outstanding >= 0 && _outstanding < _maxOutstanding);
+        assert(_outstanding >= 0);
+        int count = _window.completed(requestId(result));
         if(_observer)
         {
-            _observer->delivered(_outstandingCount);
+            _observer->delivered(count);
         }
         
         //
@@ -889,6 +1468,8 @@ Subscriber::completed(const Ice::AsyncResultPtr& result)
     }
     catch(const Ice::LocalException& ex)
     {
+        IceUtil::Monitor<IceUtil::RecMutex>::Lock sync(_lock);
+        _window.failed(requestId(result));
         error(true, ex);
     }
 }
@@ -929,17 +1510,33 @@ Subscriber::Subscriber(
     const SubscriberRecord& rec,
     const Ice::ObjectPrx& proxy,
     int retryCount,
-    int maxOutstanding) :
+    int maxOutstanding,
+    const EventFilterPtr& filter) :
     _instance(instance),
     _rec(rec),
     _retryCount(retryCount),
     _maxOutstanding(maxOutstanding),
+    _filter(filter),
+    _conflateKey(getQoS(rec.theQoS, "conflate")),
+    _sequenced(rec.theQoS.find("replay") != rec.theQoS.end()),
+    _flushDelay(rec.link ? instance->linkFlushDelay() :
+                rec.theQoS.find("flushDelayUs") != rec.theQoS.end() ?
+                IceUtil::Time::microSeconds(getQoSInt(rec.theQoS, "flushDelayUs")) : instance->flushInterval()),
+    _maxBatchBytes(rec.link ? instance->linkBatchSizeMax() :
+                   static_cast<size_t>(getQoSInt(rec.theQoS, "maxBatchBytes"))),
     _proxy(proxy),
     _proxyReplica(proxy),
     _shutdown(false),
     _state(SubscriberStateOnline),
     _outstanding(0),
     _outstandingCount(1),
+    _queuedBytes(0),
+    _dequeued(0),
+    _replayNext(0),
+    _replayEnd(0),
+    _refilling(false),
+    _window(rec.link ? OutstandingWindow(maxOutstanding, instance->linkOutstandingMax()) :
+            OutstandingWindow(maxOutstanding, getQoSInt(rec.theQoS, "maxOutstanding", maxOutstanding))),
     _currentRetry(0)
 {
     if(_proxy && _instance->publisherReplicaProxy())
@@ -15,6 +15,7 @@
 #include <IceStorm/Instrumentation.h>
 #include <Ice/ObserverHelper.h>
 #include <IceUtil/RecMutex.h>
+#include <IceUtil/Timer.h>
 
 namespace IceStorm
 {
@@ -25,6 +26,73 @@ typedef IceUtil::Handle<Instance> InstancePtr;
 class Subscriber;
 typedef IceUtil::Handle<Subscriber> SubscriberPtr;
 
+class EventFilter;
+typedef IceUtil::Handle<EventFilter> EventFilterPtr;
+
+class EventLog;
+typedef IceUtil::Handle<EventLog> EventLogPtr;
+
+//
+// A filter on the events sent to a subscriber. The filter is set
+// with the filter.op and filter.context.<key> QoS, the value of each
+// QoS is a pattern which either matches exactly or, if it contains a
+// `*' wildcard, matches any value with the given prefix and suffix.
+// An event is sent to the subscriber only if all the patterns match.
+//
+class EventFilter : public IceUtil::Shared
+{
+public:
+
+    // Returns 0 if the QoS doesn't specify a filter.
+    static EventFilterPtr create(const QoS&);
+
+    bool match(const EventDataPtr&) const;
+
+private:
+
+    EventFilter();
+
+    bool _hasOp;
+    std::string _op;
+    std::vector<std::pair<std::string, std::string> > _context;
+};
+
+//
+// The window of outstanding requests of a subscriber. The window
+// grows from its minimum size up to its maximum size while the
+// round-trip time of the requests stays close to the lowest observed
+// round-trip time. It's halved once requests start to queue up and
+// the round-trip time doubles.
+//
+class OutstandingWindow
+{
+public:
+
+    OutstandingWindow(int, int);
+
+    int size() const { return _size; }
+
+    // Record a request sent with the given number of events and return its id.
+    Ice::Long sent(int);
+
+    // Record the response of the given request and return its number of events.
+    int completed(Ice::Long);
+
+    // Record the failure of the given request.
+    void failed(Ice::Long);
+
+private:
+
+    const int _min;
+    const int _max;
+    int _size;
+    int _samples;
+    IceUtil::Int64 _minRtt; // In microseconds, -1 until the first response.
+    IceUtil::Int64 _srtt; // The smoothed round-trip time, in microseconds.
+    Ice::Long _nextId; // The id of the next request.
+    std::map<Ice::Long, std::pair<IceUtil::Time, int> > _requests; // The outstanding requests indexed by id.
+};
+
 class Subscriber : public IceUtil::Shared
 {
 public:
@@ -37,8 +105,24 @@ public:
     Ice::Identity id() const; // Return the id of the subscriber.
     IceStorm::SubscriberRecord record() const; // Get the subscriber record.
 
-    // Returns false if the subscriber should be reaped.
-    bool queue(bool, const EventDataSeq&);
+    //
+    // Returns false if the subscriber should be reaped. The sequence
+    // number is the sequence number of the first event if the events
+    // are logged, -1 otherwise.
+    //
+    bool queue(bool, const EventDataSeq&, Ice::Long = -1);
+
+    //
+    // Replay the logged events starting with the given sequence
+    // number. setReplay is called before the subscriber is added to
+    // the topic, the subscriber then ignores the logged events it's
+    // given until the replay catches up with the log. replay queues
+    // the first page of events, the next pages are read from the log
+    // as the subscriber sends the queued events. The log is never read
+    // with the subscriber lock held.
+    //
+    void setReplay(const EventLogPtr&, Ice::Long);
+    void replay();
     bool reap();
     void resetIfReaped();
     bool errored() const;
@@ -66,14 +150,26 @@ public:
 protected:
 
     void setState(SubscriberState);
+    bool push(const EventDataPtr&);
+    bool conflate(const EventDataPtr&);
+    void dequeued(EventDataSeq::size_type);
+    void refill();
+
+    class RefillTask;
 
-    Subscriber(const InstancePtr&, const IceStorm::SubscriberRecord&, const Ice::ObjectPrx&, int, int);
+    Subscriber(const InstancePtr&, const IceStorm::SubscriberRecord&, const Ice::ObjectPrx&, int, int,
+               const EventFilterPtr&);
 
     // Immutable
     const InstancePtr _instance;
     const IceStorm::SubscriberRecord _rec; // The subscriber record.
     const int _retryCount; // The retryCount.
     const int _maxOutstanding; // The maximum number of oustanding events.
+    const EventFilterPtr _filter; // The event filter, if any.
+    const std::string _conflateKey; // The context key of conflated events, if any.
+    const bool _sequenced; // True if the sequence number of logged events is set in their context.
+    const IceUtil::Time _flushDelay; // The maximum delay before sending a batch of events.
+    const size_t _maxBatchBytes; // A batch is sent once its size reaches this limit, if not 0.
     const Ice::ObjectPrx _proxy; // The per subscriber object proxy, if any.
     const Ice::ObjectPrx _proxyReplica; // The replicated per subscriber object proxy, if any.
 
@@ -86,6 +182,23 @@ protected:
     int _outstanding; // The current number of outstanding responses.
     int _outstandingCount; // The current number of outstanding events when batching events (only used for metrics).
     EventDataSeq _events; // The queue of events to send.
+    size_t _queuedBytes; // The size of the data of the queued events.
+
+    //
+    // The queue position of the conflated event of each key. The
+    // positions are counted from the first event queued since the
+    // queue was last empty, _dequeued events were sent since then.
+    //
+    std::map<std::string, EventDataSeq::size_type> _conflated;
+    EventDataSeq::size_type _dequeued;
+
+    EventLogPtr _replayLog; // The log of the events to replay, while replaying.
+    Ice::Long _replayNext; // The sequence number of the next event to replay.
+    Ice::Long _replayEnd; // The logged events with a lower sequence number were replayed.
+    bool _refilling; // True if the next page of events to replay is being read.
+
+    OutstandingWindow _window; // The window of outstanding requests (twoway subscribers and links).
+    IceUtil::TimerTaskPtr _flushTask; // The pending batch flush, if any.
 
     // The next time to try sending a new event if we're offline.
     IceUtil::Time _next;
@@ -94,6 +207,17 @@ protected:
     IceInternal::ObserverHelperT<IceStorm::Instrumentation::SubscriberObserver> _observer;
 };
 
+//
+// A reference counted, copy-on-write list of subscribers. A topic
+// publishes to the list it holds at the time of the publish without
+// copying it, the list is copied on update only if a publish is
+// still using it.
+//
+class SubscriberList : public IceUtil::Shared, public std::vector<SubscriberPtr>
+{
+};
+typedef IceUtil::Handle<SubscriberList> SubscriberListPtr;
+
 bool operator==(const IceStorm::SubscriberPtr&, const Ice::Identity&);
 bool operator==(const IceStorm::Subscriber&, const IceStorm::Subscriber&);
 bool operator!=(const IceStorm::Subscriber&, const IceStorm::Subscriber&);
@@ -14,7 +14,9 @@
 #include <IceStorm/NodeI.h>
 #include <IceStorm/Observers.h>
 #include <IceStorm/Util.h>
+#include <IceStorm/EventLog.h>
 #include <Ice/LoggerUtil.h>
+#include <IceUtil/InputUtil.h>
 #include <algorithm>
 
 using namespace std;
@@ -32,11 +34,165 @@ logError(const Ice::CommunicatorPtr& com, const IceDB::LMDBException& ex)
     error << "LMDB error: " << ex;
 }
 
+//
+// Group commit operation adding a subscriber record.
+//
+class AddSubscriberOperation : public IceDB::GroupCommit::Operation
+{
+public:
+
+    AddSubscriberOperation(const SubscriberMap& subscriberMap, const LLUMap& lluMap,
+                           const SubscriberRecordKey& key, const SubscriberRecord& record) :
+        _subscriberMap(subscriberMap), _lluMap(lluMap), _key(key), _record(record)
+    {
+    }
+
+    virtual void
+    execute(const IceDB::ReadWriteTxn& txn)
+    {
+        _subscriberMap.put(txn, _key, _record);
+        _llu = getIncrementedLLU(txn, _lluMap);
+    }
+
+    const LogUpdate&
+    llu() const
+    {
+        return _llu;
+    }
+
+private:
+
+    SubscriberMap _subscriberMap;
+    LLUMap _lluMap;
+    const SubscriberRecordKey _key;
+    const SubscriberRecord _record;
+    LogUpdate _llu;
+};
+typedef IceUtil::Handle<AddSubscriberOperation> AddSubscriberOperationPtr;
+
+//
+// Group commit operation removing subscriber records.
+//
+class RemoveSubscribersOperation : public IceDB::GroupCommit::Operation
+{
+public:
+
+    RemoveSubscribersOperation(const SubscriberMap& subscriberMap, const LLUMap& lluMap,
+                               const Ice::Identity& topic, const Ice::IdentitySeq& ids) :
+        _subscriberMap(subscriberMap), _lluMap(lluMap), _topic(topic), _ids(ids), _found(false)
+    {
+    }
+
+    virtual void
+    execute(const IceDB::ReadWriteTxn& txn)
+    {
+        for(Ice::IdentitySeq::const_iterator id = _ids.begin(); id != _ids.end(); ++id)
+        {
+            SubscriberRecordKey key;
+            key.topic = _topic;
+            key.id = *id;
+
+            if(_subscriberMap.del(txn, key))
+            {
+                _found = true;
+            }
+        }
+
+        if(_found)
+        {
+            _llu = getIncrementedLLU(txn, _lluMap);
+        }
+    }
+
+    bool
+    found() const
+    {
+        return _found;
+    }
+
+    const LogUpdate&
+    llu() const
+    {
+        return _llu;
+    }
+
+private:
+
+    SubscriberMap _subscriberMap;
+    LLUMap _lluMap;
+    const Ice::Identity _topic;
+    const Ice::IdentitySeq _ids;
+    bool _found;
+    LogUpdate _llu;
+};
+typedef IceUtil::Handle<RemoveSubscribersOperation> RemoveSubscribersOperationPtr;
+
+//
+// Publish task used when publish shards are configured, the response
+// is sent to the publisher or to the topic link once the events are
+// published.
+//
+class TopicPublishTask : public PublishTask
+{
+public:
+
+    TopicPublishTask(const TopicImplPtr& topic, const EventDataSeq& events, const Ice::AMD_Object_ice_invokePtr& cb) :
+        _topic(topic), _events(events), _publishCB(cb)
+    {
+    }
+
+    TopicPublishTask(const TopicImplPtr& topic, const EventDataSeq& events, const AMD_TopicLink_forwardPtr& cb) :
+        _topic(topic), _events(events), _forwardCB(cb)
+    {
+    }
+
+protected:
+
+    virtual void
+    publish()
+    {
+        _topic->publish(_forwardCB != 0, _events);
+    }
+
+    virtual void
+    response()
+    {
+        if(_publishCB)
+        {
+            _publishCB->ice_response(true, Ice::ByteSeq());
+        }
+        else
+        {
+            _forwardCB->ice_response();
+        }
+    }
+
+    virtual void
+    exception(const std::exception& ex)
+    {
+        if(_publishCB)
+        {
+            _publishCB->ice_exception(ex);
+        }
+        else
+        {
+            _forwardCB->ice_exception(ex);
+        }
+    }
+
+private:
+
+    const TopicImplPtr _topic;
+    const EventDataSeq _events;
+    const Ice::AMD_Object_ice_invokePtr _publishCB;
+    const AMD_TopicLink_forwardPtr _forwardCB;
+};
+
 //
 // The servant has a 1-1 association with a topic. It is used to
 // receive events from Publishers.
 //
-class PublisherI : public Ice::BlobjectArray
+class PublisherI : public Ice::BlobjectArrayAsync
 {
 public:
 
@@ -45,10 +201,10 @@ public:
     {
     }
 
-    virtual bool
-    ice_invoke(const pair<const Ice::Byte*, const Ice::Byte*>& inParams,
-               Ice::ByteSeq&,
-               const Ice::Current& current)
+    virtual void
+    ice_invoke_async(const Ice::AMD_Object_ice_invokePtr& cb,
+                     const pair<const Ice::Byte*, const Ice::Byte*>& inParams,
+                     const Ice::Current& current)
     {
         // The publish call does a cached read.
         EventDataPtr event = new EventData(current.operation, current.mode, Ice::ByteSeq(), current.ctx);
@@ -62,9 +218,17 @@ public:
 
         EventDataSeq v;
         v.push_back(event);
-        _topic->publish(false, v);
 
-        return true;
+        PublishDispatcherPtr dispatcher = _instance->publishDispatcher();
+        if(dispatcher)
+        {
+            dispatcher->dispatch(_topic->getName(), current.ctx, new TopicPublishTask(_topic, v, cb));
+        }
+        else
+        {
+            _topic->publish(false, v);
+            cb->ice_response(true, Ice::ByteSeq());
+        }
     }
 
 private:
@@ -87,10 +251,19 @@ public:
     }
 
     virtual void
-    forward(const EventDataSeq& v, const Ice::Current& /*current*/)
+    forward_async(const AMD_TopicLink_forwardPtr& cb, const EventDataSeq& v, const Ice::Current& /*current*/)
     {
-        // The publish call does a cached read.
-        _impl->publish(true, v);
+        PublishDispatcherPtr dispatcher = _instance->publishDispatcher();
+        if(dispatcher)
+        {
+            dispatcher->dispatch(_impl->getName(), Ice::noExplicitContext, new TopicPublishTask(_impl, v, cb));
+        }
+        else
+        {
+            // The publish call does a cached read.
+            _impl->publish(true, v);
+            cb->ice_response();
+        }
     }
 
 private:
@@ -346,6 +519,7 @@ TopicImpl::TopicImpl(
     _instance(instance),
     _name(name),
     _id(id),
+    _subscribers(new SubscriberList),
     _destroyed(false),
     _lluMap(_instance->lluMap()),
     _subscriberMap(_instance->subscriberMap())
@@ -385,6 +559,16 @@ TopicImpl::TopicImpl(
             linkid.name = _name + ".link";
         }
 
+        try
+        {
+            _eventLog = _instance->createEventLog(_name);
+        }
+        catch(const Ice::Exception& ex)
+        {
+            Ice::Warning out(_instance->traceLevels()->logger);
+            out << _name << ": unable to open the event log: " << ex;
+        }
+
         _publisherPrx = _instance->publishAdapter()->add(new PublisherI(this, instance), pubid);
         _linkPrx = TopicLinkPrx::uncheckedCast(
             _instance->publishAdapter()->add(new TopicLinkI(this, instance), linkid));
@@ -413,7 +597,7 @@ TopicImpl::TopicImpl(
                 // subscribers.
                 //
                 SubscriberPtr subscriber = Subscriber::create(_instance, *p);
-                _subscribers.push_back(subscriber);
+                subscribersForUpdate().push_back(subscriber);
             }
             catch(const Ice::Exception& ex)
             {
@@ -531,7 +715,7 @@ TopicImpl::subscribeAndGetPublisher(const QoS& qos, const Ice::ObjectPrx& obj)
 
             }
             out << " subscriptions: ";
-            trace(out, _instance, _subscribers);
+            trace(out, _instance, *_subscribers);
         }
     }
 
@@ -545,39 +729,73 @@ TopicImpl::subscribeAndGetPublisher(const QoS& qos, const Ice::ObjectPrx& obj)
     record.link = false;
     record.cost = 0;
 
-    vector<SubscriberPtr>::iterator p = find(_subscribers.begin(), _subscribers.end(), record.id);
-    if(p != _subscribers.end())
+    vector<SubscriberPtr>::iterator p = find(_subscribers->begin(), _subscribers->end(), record.id);
+    if(p != _subscribers->end() || _adding.find(record.id) != _adding.end())
     {
         throw AlreadySubscribed();
     }
 
-    LogUpdate llu;
+    //
+    // The replay QoS is the sequence number of the first logged event
+    // to send to the subscriber before the events published after the
+    // subscription.
+    //
+    Ice::Long replay = -1;
+    QoS::const_iterator q = qos.find("replay");
+    if(q != qos.end())
+    {
+        if(!_eventLog)
+        {
+            throw BadQoS("replay requires an event log for topic `" + _name + "'");
+        }
+        if(!IceUtilInternal::stringToInt64(q->second, replay) || replay < 0)
+        {
+            throw BadQoS("invalid replay: " + q->second);
+        }
+    }
 
+    //
+    // The subscriber is created first to validate its QoS, it's
+    // destroyed if its record can't be added.
+    //
     SubscriberPtr subscriber = Subscriber::create(_instance, record);
+    LogUpdate llu;
     try
     {
-        IceDB::ReadWriteTxn txn(_instance->dbEnv());
-
-        SubscriberRecordKey key;
-        key.topic = _id;
-        key.id = subscriber->id();
-
-        _subscriberMap.put(txn, key, record);
-
-        llu = getIncrementedLLU(txn, _lluMap);
-
-        txn.commit();
+        llu = addSubscriber(sync, record);
     }
-    catch(const IceDB::LMDBException& ex)
+    catch(...)
     {
-        logError(_instance->communicator(), ex);
-        throw; // will become UnknownException in caller
+        subscriber->destroy();
+        throw;
+    }
+
+    //
+    // The subscriber ignores the logged events published once it's
+    // added until its replay catches up with the end of the log, the
+    // replay reads them from the log instead.
+    //
+    if(replay >= 0)
+    {
+        subscriber->setReplay(_eventLog, replay);
     }
 
-    _subscribers.push_back(subscriber);
+    subscribersForUpdate().push_back(subscriber);
 
     _instance->observers()->addSubscriber(llu, _name, record);
 
+    sync.release();
+
+    //
+    // Queue the first page of logged events without the subscribers
+    // mutex locked, the next pages are read once the subscriber has
+    // sent the previous ones.
+    //
+    if(replay >= 0)
+    {
+        subscriber->replay();
+    }
+
     return subscriber->proxy();
 }
 
@@ -605,14 +823,14 @@ TopicImpl::unsubscribe(const Ice::ObjectPrx& subscriber)
         if(traceLevels->topic > 1)
         {
             out << " endpoints: " << IceStormInternal::describeEndpoints(subscriber);
-            trace(out, _instance, _subscribers);
+            trace(out, _instance, *_subscribers);
         }
     }
 
     IceUtil::Mutex::Lock sync(_subscribersMutex);
     Ice::IdentitySeq ids;
     ids.push_back(id);
-    removeSubscribers(ids);
+    removeSubscribers(sync, ids);
 }
 
 TopicLinkPrx
@@ -653,8 +871,8 @@ TopicImpl::link(const TopicPrx& topic, Ice::Int cost)
     record.link = true;
     record.cost = cost;
 
-    vector<SubscriberPtr>::iterator p = find(_subscribers.begin(), _subscribers.end(), record.id);
-    if(p != _subscribers.end())
+    vector<SubscriberPtr>::iterator p = find(_subscribers->begin(), _subscribers->end(), record.id);
+    if(p != _subscribers->end() || _adding.find(record.id) != _adding.end())
     {
         string name = IceStormInternal::identityToTopicName(id);
         LinkExists ex;
@@ -662,31 +880,19 @@ TopicImpl::link(const TopicPrx& topic, Ice::Int cost)
         throw ex;
     }
 
-    LogUpdate llu;
-
     SubscriberPtr subscriber = Subscriber::create(_instance, record);
-
+    LogUpdate llu;
     try
     {
-        IceDB::ReadWriteTxn txn(_instance->dbEnv());
-
-        SubscriberRecordKey key;
-        key.topic = _id;
-        key.id = id;
-
-        _subscriberMap.put(txn, key, record);
-
-        llu = getIncrementedLLU(txn, _lluMap);
-
-        txn.commit();
+        llu = addSubscriber(sync, record);
     }
-    catch(const IceDB::LMDBException& ex)
+    catch(...)
     {
-        logError(_instance->communicator(), ex);
-        throw; // will become UnknownException in caller
+        subscriber->destroy();
+        throw;
     }
 
-    _subscribers.push_back(subscriber);
+    subscribersForUpdate().push_back(subscriber);
 
     _instance->observers()->addSubscriber(llu, _name, record);
 }
@@ -702,8 +908,8 @@ TopicImpl::unlink(const TopicPrx& topic)
 
     Ice::Identity id = topic->ice_getIdentity();
 
-    vector<SubscriberPtr>::const_iterator p = find(_subscribers.begin(), _subscribers.end(), id);
-    if(p == _subscribers.end())
+    vector<SubscriberPtr>::const_iterator p = find(_subscribers->begin(), _subscribers->end(), id);
+    if(p == _subscribers->end())
     {
         string name = IceStormInternal::identityToTopicName(id);
         TraceLevelsPtr traceLevels = _instance->traceLevels();
@@ -727,7 +933,7 @@ TopicImpl::unlink(const TopicPrx& topic)
 
     Ice::IdentitySeq ids;
     ids.push_back(id);
-    removeSubscribers(ids);
+    removeSubscribers(sync, ids);
 }
 
 void
@@ -750,7 +956,7 @@ TopicImpl::reap(const Ice::IdentitySeq& ids)
         }
     }
 
-    removeSubscribers(ids);
+    removeSubscribers(sync, ids);
 }
 
 void
@@ -760,11 +966,16 @@ TopicImpl::shutdown()
     _servant = 0;
 
     // Shutdown each subscriber. This waits for the event queues to drain.
-    for(vector<SubscriberPtr>::const_iterator p = _subscribers.begin(); p != _subscribers.end(); ++p)
+    for(vector<SubscriberPtr>::const_iterator p = _subscribers->begin(); p != _subscribers->end(); ++p)
     {
         (*p)->shutdown();
     }
 
+    if(_eventLog)
+    {
+        _eventLog->close();
+    }
+
     _observer.detach();
 }
 
@@ -774,7 +985,7 @@ TopicImpl::getLinkInfoSeq() const
     IceUtil::Mutex::Lock sync(_subscribersMutex);
 
     LinkInfoSeq seq;
-    for(vector<SubscriberPtr>::const_iterator p = _subscribers.begin(); p != _subscribers.end(); ++p)
+    for(vector<SubscriberPtr>::const_iterator p = _subscribers->begin(); p != _subscribers->end(); ++p)
     {
         SubscriberRecord record = (*p)->record();
         if(record.link && !(*p)->errored())
@@ -795,7 +1006,7 @@ TopicImpl::getSubscribers() const
     IceUtil::Mutex::Lock sync(_subscribersMutex);
 
     Ice::IdentitySeq subscribers;
-    for(vector<SubscriberPtr>::const_iterator p = _subscribers.begin(); p != _subscribers.end(); ++p)
+    for(vector<SubscriberPtr>::const_iterator p = _subscribers->begin(); p != _subscribers->end(); ++p)
     {
         subscribers.push_back((*p)->id());
     }
@@ -834,7 +1045,7 @@ TopicImpl::getContent() const
 
     TopicContent content;
     content.id = _id;
-    for(vector<SubscriberPtr>::const_iterator p = _subscribers.begin(); p != _subscribers.end(); ++p)
+    for(vector<SubscriberPtr>::const_iterator p = _subscribers->begin(); p != _subscribers->end(); ++p)
     {
         // Don't return errored subscribers (subscribers that have
         // errored out, but not reaped due to a failure with the
@@ -858,8 +1069,9 @@ TopicImpl::update(const SubscriberRecordSeq& records)
     // exist.
 
     {
-        vector<SubscriberPtr>::iterator p = _subscribers.begin();
-        while(p != _subscribers.end())
+        vector<SubscriberPtr>& subscribers = subscribersForUpdate();
+        vector<SubscriberPtr>::iterator p = subscribers.begin();
+        while(p != subscribers.end())
         {
             SubscriberRecordSeq::const_iterator q;
             for(q = records.begin(); q != records.end(); ++q)
@@ -874,7 +1086,7 @@ TopicImpl::update(const SubscriberRecordSeq& records)
             if(q == records.end())
             {
                 (*p)->destroy();
-                p = _subscribers.erase(p);
+                p = subscribers.erase(p);
             }
             else
             {
@@ -888,17 +1100,17 @@ TopicImpl::update(const SubscriberRecordSeq& records)
     for(SubscriberRecordSeq::const_iterator p = records.begin(); p != records.end(); ++p)
     {
         vector<SubscriberPtr>::iterator q;
-        for(q = _subscribers.begin(); q != _subscribers.end(); ++q)
+        for(q = _subscribers->begin(); q != _subscribers->end(); ++q)
         {
             if((*q)->id() == p->id)
             {
                 break;
             }
         }
-        if(q == _subscribers.end())
+        if(q == _subscribers->end())
         {
             SubscriberPtr subscriber = Subscriber::create(_instance, *p);
-            _subscribers.push_back(subscriber);
+            subscribersForUpdate().push_back(subscriber);
         }
     }
 }
@@ -975,10 +1187,31 @@ TopicImpl::publish(bool forwarded, const EventDataSeq& events)
         CachedReadHelper unlock(_instance->node(), __FILE__, __LINE__);
 
         //
-        // Copy of the subscriber list so that event publishing can occur
-        // in parallel.
+        // The events are logged before getting the subscriber list
+        // and without the subscribers mutex locked. A subscriber
+        // added once the events are logged either reads them from the
+        // log or ignores them if it already read them.
         //
-        vector<SubscriberPtr> copy;
+        Ice::Long seq = -1;
+        if(_eventLog)
+        {
+            try
+            {
+                seq = _eventLog->append(events);
+            }
+            catch(const Ice::Exception& ex)
+            {
+                Ice::Warning out(_instance->traceLevels()->logger);
+                out << _name << ": unable to log events: " << ex;
+            }
+        }
+
+        //
+        // Reference the current subscriber list so that event
+        // publishing can occur in parallel. The list is copy-on-write
+        // so it won't be modified while we iterate over it.
+        //
+        SubscriberListPtr current;
         {
             IceUtil::Mutex::Lock sync(_subscribersMutex);
             if(_observer)
@@ -992,20 +1225,21 @@ TopicImpl::publish(bool forwarded, const EventDataSeq& events)
                     _observer->published();
                 }
             }
-            copy = _subscribers;
+            current = _subscribers;
         }
 
         //
         // Queue each event, gathering a list of those subscribers that
         // must be reaped.
         //
-        for(vector<SubscriberPtr>::const_iterator p = copy.begin(); p != copy.end(); ++p)
+        for(vector<SubscriberPtr>::const_iterator p = current->begin(); p != current->end(); ++p)
         {
-            if(!(*p)->queue(forwarded, events) && (*p)->reap())
+            if(!(*p)->queue(forwarded, events, seq) && (*p)->reap())
             {
                 reap.push_back((*p)->id());
             }
         }
+        current = 0; // Release the list to not force a copy on update.
 
         // If there are no subscribers in error then we're done.
         if(reap.empty())
@@ -1015,7 +1249,7 @@ TopicImpl::publish(bool forwarded, const EventDataSeq& events)
         if(!unlock.getMaster())
         {
             IceUtil::Mutex::Lock sync(_subscribersMutex);
-            removeSubscribers(reap);
+            removeSubscribers(sync, reap);
             return;
         }
         masterInternal = TopicInternalPrx::uncheckedCast(unlock.getMaster()->ice_identity(_id));
@@ -1063,8 +1297,8 @@ TopicImpl::observerAddSubscriber(const LogUpdate& llu, const SubscriberRecord& r
         out << " llu: " << llu.generation << "/" << llu.iteration;
     }
 
-    vector<SubscriberPtr>::iterator p = find(_subscribers.begin(), _subscribers.end(), record.id);
-    if(p != _subscribers.end())
+    vector<SubscriberPtr>::iterator p = find(_subscribers->begin(), _subscribers->end(), record.id);
+    if(p != _subscribers->end())
     {
         // If the subscriber is already in the database display a
         // diagnostic.
@@ -1099,7 +1333,7 @@ TopicImpl::observerAddSubscriber(const LogUpdate& llu, const SubscriberRecord& r
         throw; // will become UnknownException in caller
     }
 
-    _subscribers.push_back(subscriber);
+    subscribersForUpdate().push_back(subscriber);
 }
 
 void
@@ -1151,13 +1385,14 @@ TopicImpl::observerRemoveSubscriber(const LogUpdate& llu, const Ice::IdentitySeq
     // Then remove the subscriber from the subscribers list. If the
     // subscriber had a local failure and was removed from the
     // subscriber list it could already be gone. That's not a problem.
+    vector<SubscriberPtr>& subscribers = subscribersForUpdate();
     for(Ice::IdentitySeq::const_iterator id = ids.begin(); id != ids.end(); ++id)
     {
-        vector<SubscriberPtr>::iterator p = find(_subscribers.begin(), _subscribers.end(), *id);
-        if(p != _subscribers.end())
+        vector<SubscriberPtr>::iterator p = find(subscribers.begin(), subscribers.end(), *id);
+        if(p != subscribers.end())
         {
             (*p)->destroy();
-            _subscribers.erase(p);
+            subscribers.erase(p);
         }
     }
 }
@@ -1203,7 +1438,7 @@ void
 TopicImpl::updateSubscriberObservers()
 {
     IceUtil::Mutex::Lock sync(_subscribersMutex);
-    for(vector<SubscriberPtr>::const_iterator p = _subscribers.begin(); p != _subscribers.end(); ++p)
+    for(vector<SubscriberPtr>::const_iterator p = _subscribers->begin(); p != _subscribers->end(); ++p)
     {
         (*p)->updateObserver();
     }
@@ -1260,11 +1495,16 @@ TopicImpl::destroyInternal(const LogUpdate& origLLU, bool master)
     _instance->topicReaper()->add(_name);
 
     // Destroy each of the subscribers.
-    for(vector<SubscriberPtr>::const_iterator p = _subscribers.begin(); p != _subscribers.end(); ++p)
+    for(vector<SubscriberPtr>::const_iterator p = _subscribers->begin(); p != _subscribers->end(); ++p)
     {
         (*p)->destroy();
     }
-    _subscribers.clear();
+    _subscribers = new SubscriberList;
+
+    if(_eventLog)
+    {
+        _eventLog->destroy();
+    }
 
     _instance->topicAdapter()->remove(_id);
 
@@ -1273,46 +1513,103 @@ TopicImpl::destroyInternal(const LogUpdate& origLLU, bool master)
     return llu;
 }
 
-void
-TopicImpl::removeSubscribers(const Ice::IdentitySeq& ids)
+LogUpdate
+TopicImpl::addSubscriber(IceUtil::Mutex::Lock& sync, const SubscriberRecord& record)
 {
-    // First update the database
+    //
+    // Called with _subscribersMutex locked. The record is committed
+    // with the mutex released so that the commit can be merged with
+    // the commit of other subscriptions to this topic. The subscriber
+    // is reserved until then to reject concurrent subscriptions.
+    //
+    SubscriberRecordKey key;
+    key.topic = _id;
+    key.id = record.id;
+
+    _adding.insert(record.id);
+    sync.release();
 
     LogUpdate llu;
-    bool found = false;
     try
     {
-        IceDB::ReadWriteTxn txn(_instance->dbEnv());
-
-        for(Ice::IdentitySeq::const_iterator id = ids.begin(); id != ids.end(); ++id)
-        {
-            SubscriberRecordKey key;
-            key.topic = _id;
-            key.id = *id;
+        AddSubscriberOperationPtr op = new AddSubscriberOperation(_subscriberMap, _lluMap, key, record);
+        _instance->groupCommit()->execute(op);
+        llu = op->llu();
+    }
+    catch(const IceDB::LMDBException& ex)
+    {
+        sync.acquire();
+        _adding.erase(record.id);
+        logError(_instance->communicator(), ex);
+        throw; // will become UnknownException in caller
+    }
+    catch(...)
+    {
+        sync.acquire();
+        _adding.erase(record.id);
+        throw;
+    }
 
-            if(_subscriberMap.del(txn, key))
-            {
-                found = true;
-            }
-        }
+    sync.acquire();
+    _adding.erase(record.id);
 
-        if(found)
+    if(_destroyed)
+    {
+        //
+        // The topic records were removed while the record was
+        // committed, remove the record of the subscriber as well.
+        //
+        try
         {
-            llu = getIncrementedLLU(txn, _lluMap);
+            IceDB::ReadWriteTxn txn(_instance->dbEnv());
+            _subscriberMap.del(txn, key);
             txn.commit();
         }
-        else
+        catch(const IceDB::LMDBException& ex)
         {
-            txn.rollback();
+            logError(_instance->communicator(), ex);
+            throw; // will become UnknownException in caller
         }
+        throw Ice::ObjectNotExistException(__FILE__, __LINE__);
+    }
+    return llu;
+}
+
+void
+TopicImpl::removeSubscribers(IceUtil::Mutex::Lock& sync, const Ice::IdentitySeq& ids)
+{
+    //
+    // Called with _subscribersMutex locked. First update the database
+    // with the mutex released, so that the commit can be merged with
+    // the commit of other subscription updates to this topic.
+    //
+    sync.release();
+
+    LogUpdate llu;
+    bool found = false;
+    try
+    {
+        RemoveSubscribersOperationPtr op = new RemoveSubscribersOperation(_subscriberMap, _lluMap, _id, ids);
+        _instance->groupCommit()->execute(op);
+        found = op->found();
+        llu = op->llu();
     }
     catch(const IceDB::LMDBException& ex)
     {
+        sync.acquire();
         logError(_instance->communicator(), ex);
         throw; // will become UnknownException in caller
     }
+    catch(...)
+    {
+        sync.acquire();
+        throw;
+    }
+
+    sync.acquire();
 
-    if(found)
+    // If the topic was destroyed meanwhile, its subscribers were destroyed with it.
+    if(found && !_destroyed)
     {
         // Then remove the subscriber from the subscribers list. Its
         // possible that some of these subscribers have already been
@@ -1320,16 +1617,32 @@ TopicImpl::removeSubscribers(const Ice::IdentitySeq& ids)
         // replicas on the same subscriber). To avoid sending unnecessary
         // observer updates keep track of the observers that are actually
         // removed.
+        vector<SubscriberPtr>& subscribers = subscribersForUpdate();
         for(Ice::IdentitySeq::const_iterator id = ids.begin(); id != ids.end(); ++id)
         {
-            vector<SubscriberPtr>::iterator p = find(_subscribers.begin(), _subscribers.end(), *id);
-            if(p != _subscribers.end())
+            vector<SubscriberPtr>::iterator p = find(subscribers.begin(), subscribers.end(), *id);
+            if(p != subscribers.end())
             {
                 (*p)->destroy();
-                _subscribers.erase(p);
+                subscribers.erase(p);
             }
         }
 
         _instance->observers()->removeSubscriber(llu, _name, ids);
     }
 }
+
+vector<SubscriberPtr>&
+TopicImpl::subscribersForUpdate()
+{
+    //
+    // Must be called with _subscribersMutex locked. If a publish
+    // still references the subscriber list, we copy it before it's
+    // modified.
+    //
+    if(_subscribers->__getRef() > 1)
+    {
+        _subscribers = new SubscriberList(*_subscribers);
+    }
+    return *_subscribers;
+}
@@ -16,6 +16,7 @@
 #include <IceStorm/Util.h>
 #include <Ice/ObserverHelper.h>
 #include <list>
+#include <set>
 
 namespace IceStorm
 {
@@ -27,6 +28,12 @@ typedef IceUtil::Handle<PersistentInstance> PersistentInstancePtr;
 class Subscriber;
 typedef IceUtil::Handle<Subscriber> SubscriberPtr;
 
+class SubscriberList;
+typedef IceUtil::Handle<SubscriberList> SubscriberListPtr;
+
+class EventLog;
+typedef IceUtil::Handle<EventLog> EventLogPtr;
+
 class TopicImpl : public IceUtil::Shared
 {
 public:
@@ -71,7 +78,9 @@ public:
 private:
 
     IceStormElection::LogUpdate destroyInternal(const IceStormElection::LogUpdate&, bool);
-    void removeSubscribers(const Ice::IdentitySeq&);
+    IceStormElection::LogUpdate addSubscriber(IceUtil::Mutex::Lock&, const SubscriberRecord&);
+    void removeSubscribers(IceUtil::Mutex::Lock&, const Ice::IdentitySeq&);
+    std::vector<SubscriberPtr>& subscribersForUpdate();
 
     //
     // Immutable members.
@@ -98,7 +107,17 @@ private:
     // vector/list/map and although there was little difference vector
     // was the fastest of the three.
     //
-    std::vector<SubscriberPtr> _subscribers;
+    // The vector is copy-on-write, see subscribersForUpdate().
+    //
+    SubscriberListPtr _subscribers;
+
+    //
+    // The subscribers whose record is being committed, they're added
+    // to the subscriber list once committed.
+    //
+    std::set<Ice::Identity> _adding;
+
+    EventLogPtr _eventLog; // The log of published events, if any. Immutable once the topic is created.
 
     bool _destroyed; // Has this Topic been destroyed?
 
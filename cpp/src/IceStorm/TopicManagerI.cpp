@@ -34,6 +34,227 @@ logError(const Ice::CommunicatorPtr& com, const IceDB::LMDBException& ex)
     error << "LMDB error: " << ex;
 }
 
+//
+// Remove the topic place holder record and the subscriber records of
+// the given topic.
+//
+void
+removeTopicRecords(const IceDB::ReadWriteTxn& txn, SubscriberMap& subscriberMap, const Ice::Identity& topic)
+{
+    SubscriberRecordKey key;
+    key.topic = topic;
+
+    SubscriberMapRWCursor cursor(subscriberMap, txn);
+    if(cursor.find(key))
+    {
+        subscriberMap.del(txn, key);
+
+        SubscriberRecordKey k;
+        SubscriberRecord v;
+        while(cursor.get(k, v, MDB_NEXT) && k.topic == key.topic)
+        {
+            subscriberMap.del(txn, k);
+        }
+    }
+}
+
+//
+// Write a topic content chunk received by a replica: the topics of
+// the chunk replace the topics with the same identity, the removed
+// topics are erased and the first chunk of a full snapshot clears the
+// database.
+//
+void
+writeChunk(const IceDB::ReadWriteTxn& txn, SubscriberMap& subscriberMap, const TopicContentChunk& chunk)
+{
+    if(chunk.full && chunk.first)
+    {
+        subscriberMap.clear(txn);
+    }
+
+    for(Ice::IdentitySeq::const_iterator p = chunk.removed.begin(); p != chunk.removed.end(); ++p)
+    {
+        removeTopicRecords(txn, subscriberMap, *p);
+    }
+
+    for(TopicContentSeq::const_iterator p = chunk.content.begin(); p != chunk.content.end(); ++p)
+    {
+        removeTopicRecords(txn, subscriberMap, p->id);
+
+        SubscriberRecordKey key;
+        key.topic = p->id;
+        SubscriberRecord rec;
+        rec.link = false;
+        rec.cost = 0;
+
+        subscriberMap.put(txn, key, rec);
+
+        for(SubscriberRecordSeq::const_iterator q = p->records.begin(); q != p->records.end(); ++q)
+        {
+            SubscriberRecordKey key;
+            key.topic = p->id;
+            key.id = q->id;
+
+            subscriberMap.put(txn, key, *q);
+        }
+    }
+}
+
+//
+// The time a replica waits for the next topic content chunk before
+// aborting the transfer.
+//
+const IceUtil::Time chunkTimeout = IceUtil::Time::seconds(60);
+
+}
+
+namespace IceStorm
+{
+
+//
+// Writes the topic content chunks received by a replica in a single
+// read-write transaction, committed with the last chunk. The chunks
+// are dispatched by different threads and an LMDB read-write
+// transaction can't span threads, the transaction is owned by this
+// thread.
+//
+class ContentApplier : public IceUtil::Thread, public IceUtil::Monitor<IceUtil::Mutex>
+{
+public:
+
+    ContentApplier(const PersistentInstancePtr& instance) :
+        IceUtil::Thread("IceStorm content applier"),
+        _instance(instance),
+        _lluMap(instance->lluMap()),
+        _subscriberMap(instance->subscriberMap()),
+        _chunk(0),
+        _aborted(false),
+        _finished(false)
+    {
+    }
+
+    //
+    // Write the chunk and wait for it to be written, the last chunk is
+    // committed with the given log update. Raises the exception raised
+    // by the transaction if it failed.
+    //
+    void
+    apply(const LogUpdate& llu, const TopicContentChunk& chunk)
+    {
+        Lock sync(*this);
+        bool written = false;
+        if(!_finished)
+        {
+            _llu = llu;
+            _chunk = &chunk;
+            notifyAll();
+            while(_chunk && !_finished)
+            {
+                wait();
+            }
+            written = !_chunk;
+            _chunk = 0;
+        }
+
+        if(_exception.get())
+        {
+            _exception->ice_throw();
+        }
+        else if(!written)
+        {
+            throw ObserverInconsistencyException("topic content transfer aborted");
+        }
+    }
+
+    // Roll back the transaction.
+    void
+    abort()
+    {
+        Lock sync(*this);
+        _aborted = true;
+        notifyAll();
+    }
+
+    virtual void
+    run()
+    {
+        try
+        {
+            IceDB::ReadWriteTxn txn(_instance->dbEnv());
+
+            Lock sync(*this);
+            while(true)
+            {
+                const IceUtil::Time timeout = IceUtil::Time::now(IceUtil::Time::Monotonic) + chunkTimeout;
+                while(!_chunk && !_aborted)
+                {
+                    IceUtil::Time delay = timeout - IceUtil::Time::now(IceUtil::Time::Monotonic);
+                    if(delay <= IceUtil::Time() || !timedWait(delay))
+                    {
+                        throw ObserverInconsistencyException("timed out waiting for the next topic content chunk");
+                    }
+                }
+
+                if(_aborted)
+                {
+                    break; // The transaction is rolled back by its destructor.
+                }
+
+                writeChunk(txn, _subscriberMap, *_chunk);
+                const bool last = _chunk->last;
+                if(last)
+                {
+                    _lluMap.put(txn, lluDbKey, _llu);
+                    txn.commit();
+                }
+
+                _chunk = 0;
+                notifyAll();
+                if(last)
+                {
+                    break;
+                }
+            }
+        }
+        catch(const IceUtil::Exception& ex)
+        {
+            Lock sync(*this);
+            _exception.reset(ex.ice_clone());
+        }
+        catch(const std::exception& ex)
+        {
+            Lock sync(*this);
+            _exception.reset(new Ice::UnknownException(__FILE__, __LINE__, ex.what()));
+        }
+        catch(...)
+        {
+            Lock sync(*this);
+            _exception.reset(new Ice::UnknownException(__FILE__, __LINE__, "unknown c++ exception"));
+        }
+
+        Lock sync(*this);
+        _finished = true;
+        notifyAll();
+    }
+
+private:
+
+    const PersistentInstancePtr _instance;
+    LLUMap _lluMap;
+    SubscriberMap _subscriberMap;
+
+    LogUpdate _llu;
+    const TopicContentChunk* _chunk; // The chunk to write, if any.
+    bool _aborted;
+    bool _finished;
+    IceUtil::UniquePtr<IceUtil::Exception> _exception;
+};
+
+}
+
+namespace
+{
+
 class TopicManagerI : public TopicManagerInternal
 {
 public:
@@ -149,6 +370,21 @@ public:
         _impl->observerInit(llu, content);
     }
 
+    virtual void initChunk(const LogUpdate& llu, const TopicContentChunk& chunk, const Ice::Current&)
+    {
+        NodeIPtr node = _instance->node();
+        if(node)
+        {
+            node->checkObserverInit(llu.generation);
+        }
+        _impl->observerInitChunk(llu, chunk);
+    }
+
+    virtual void abortInit(const Ice::Current&)
+    {
+        _impl->observerAbortInit();
+    }
+
     virtual void createTopic(const LogUpdate& llu, const string& name, const Ice::Current&)
     {
         try
@@ -241,6 +477,12 @@ public:
         _impl->getContent(llu, content);
     }
 
+    virtual TopicContentChunk getContentChunk(const LogUpdate& since, const string& start, LogUpdate& llu,
+                                              string& next, const Ice::Current&)
+    {
+        return _impl->getContentChunk(since, start, llu, next);
+    }
+
 private:
 
     const TopicManagerImplPtr _impl;
@@ -251,7 +493,10 @@ private:
 TopicManagerImpl::TopicManagerImpl(const PersistentInstancePtr& instance) :
     _instance(instance),
     _lluMap(instance->lluMap()),
-    _subscriberMap(instance->subscriberMap())
+    _subscriberMap(instance->subscriberMap()),
+    _chunkSize(static_cast<size_t>(max(instance->communicator()->getProperties()->getPropertyAsIntWithDefault(
+                                           instance->serviceName() + ".Election.SyncChunkSize", 1000), 1))),
+    _initFull(false)
 {
     try
     {
@@ -414,6 +659,12 @@ TopicManagerImpl::observerInit(const LogUpdate& llu, const TopicContentSeq& cont
 {
     Lock sync(*this);
 
+    //
+    // A chunked transfer which didn't complete holds a read-write
+    // transaction, it's rolled back before the content is written.
+    //
+    abortApplier();
+
     TraceLevelsPtr traceLevels = _instance->traceLevels();
     if(traceLevels->topicMgr > 0)
     {
@@ -525,6 +776,156 @@ TopicManagerImpl::observerInit(const LogUpdate& llu, const TopicContentSeq& cont
     }
     // Clear the set of observers.
     _instance->observers()->clear();
+
+    // The update log starts over with the new content.
+    _instance->observers()->resetUpdates(llu);
+}
+
+void
+TopicManagerImpl::observerInitChunk(const LogUpdate& llu, const TopicContentChunk& chunk)
+{
+    Lock sync(*this);
+
+    if(chunk.first)
+    {
+        abortApplier();
+        _applier = new ContentApplier(_instance);
+        _applier->start();
+        _initFull = chunk.full;
+        _initUpdated.clear();
+        _initRemoved.clear();
+    }
+    else if(!_applier)
+    {
+        throw ObserverInconsistencyException("unexpected topic content chunk");
+    }
+
+    //
+    // The chunks are written as they are received in a single
+    // transaction committed with the last chunk to not leave the
+    // replica with a partial state if the transfer fails. Only the
+    // names of the topics are kept until the last chunk.
+    //
+    try
+    {
+        _applier->apply(llu, chunk);
+    }
+    catch(const IceDB::LMDBException& ex)
+    {
+        abortApplier();
+        logError(_instance->communicator(), ex);
+        throw; // will become UnknownException in caller
+    }
+    catch(...)
+    {
+        abortApplier();
+        throw;
+    }
+
+    for(TopicContentSeq::const_iterator p = chunk.content.begin(); p != chunk.content.end(); ++p)
+    {
+        _initUpdated.insert(identityToTopicName(p->id));
+    }
+    for(Ice::IdentitySeq::const_iterator p = chunk.removed.begin(); p != chunk.removed.end(); ++p)
+    {
+        _initRemoved.insert(identityToTopicName(*p));
+    }
+    if(!chunk.last)
+    {
+        return;
+    }
+
+    _applier->getThreadControl().join();
+    _applier = 0;
+
+    TraceLevelsPtr traceLevels = _instance->traceLevels();
+    if(traceLevels->topicMgr > 0)
+    {
+        Ice::Trace out(traceLevels->logger, traceLevels->topicMgrCat);
+        out << (_initFull ? "init" : "init with updated topics");
+        for(set<string>::const_iterator p = _initUpdated.begin(); p != _initUpdated.end(); ++p)
+        {
+            out << " topic: " << *p;
+        }
+        for(set<string>::const_iterator p = _initRemoved.begin(); p != _initRemoved.end(); ++p)
+        {
+            out << " removed topic: " << *p;
+        }
+    }
+
+    //
+    // Now that the database is updated, destroy the topics which were
+    // removed and reload the updated topics from the database. Note
+    // that destroying a topic doesn't remove anything from the
+    // database since we've already synced up the db state.
+    //
+    map<string, TopicImplPtr>::iterator p = _topics.begin();
+    while(p != _topics.end())
+    {
+        bool removed;
+        if(_initFull)
+        {
+            removed = _initUpdated.find(p->first) == _initUpdated.end();
+        }
+        else
+        {
+            removed = _initRemoved.find(p->first) != _initRemoved.end();
+        }
+
+        if(removed)
+        {
+            p->second->observerDestroyTopic(llu);
+            _topics.erase(p++);
+        }
+        else
+        {
+            ++p;
+        }
+    }
+
+    for(set<string>::const_iterator q = _initUpdated.begin(); q != _initUpdated.end(); ++q)
+    {
+        reloadTopic(llu, *q);
+    }
+
+    if(_initFull)
+    {
+        // The update log starts over with the new content.
+        _instance->observers()->resetUpdates(llu);
+    }
+    else
+    {
+        for(set<string>::const_iterator q = _initRemoved.begin(); q != _initRemoved.end(); ++q)
+        {
+            _instance->observers()->logUpdate(llu, *q);
+        }
+        for(set<string>::const_iterator q = _initUpdated.begin(); q != _initUpdated.end(); ++q)
+        {
+            _instance->observers()->logUpdate(llu, *q);
+        }
+        _instance->observers()->logUpdate(llu);
+    }
+    _initUpdated.clear();
+    _initRemoved.clear();
+
+    // Clear the set of observers.
+    _instance->observers()->clear();
+}
+
+void
+TopicManagerImpl::observerAbortInit()
+{
+    Lock sync(*this);
+
+    TraceLevelsPtr traceLevels = _instance->traceLevels();
+    if(_applier && traceLevels->topicMgr > 0)
+    {
+        Ice::Trace out(traceLevels->logger, traceLevels->topicMgrCat);
+        out << "init aborted";
+    }
+    abortApplier();
+    _initUpdated.clear();
+    _initRemoved.clear();
 }
 
 void
@@ -560,6 +961,7 @@ TopicManagerImpl::observerCreateTopic(const LogUpdate& llu, const string& name)
     }
 
     installTopic(name, id, true);
+    _instance->observers()->logUpdate(llu, name);
 }
 
 void
@@ -575,6 +977,7 @@ TopicManagerImpl::observerDestroyTopic(const LogUpdate& llu, const string& name)
     q->second->observerDestroyTopic(llu);
 
     _topics.erase(q);
+    _instance->observers()->logUpdate(llu, name);
 }
 
 void
@@ -593,6 +996,7 @@ TopicManagerImpl::observerAddSubscriber(const LogUpdate& llu, const string& name
         topic = q->second;
     }
     topic->observerAddSubscriber(llu, record);
+    _instance->observers()->logUpdate(llu, name);
 }
 
 void
@@ -611,6 +1015,7 @@ TopicManagerImpl::observerRemoveSubscriber(const LogUpdate& llu, const string& n
         topic = q->second;
     }
     topic->observerRemoveSubscriber(llu, id);
+    _instance->observers()->logUpdate(llu, name);
 }
 
 void
@@ -640,6 +1045,77 @@ TopicManagerImpl::getContent(LogUpdate& llu, TopicContentSeq& content)
     }
 }
 
+TopicContentChunk
+TopicManagerImpl::getContentChunk(const LogUpdate& since, const string& start, LogUpdate& llu, string& next)
+{
+    Lock sync(*this);
+
+    reap();
+
+    TopicContentChunk chunk;
+    set<string> updated;
+    chunk.full = !_instance->observers()->getUpdatedTopics(since, updated);
+    chunk.first = start.empty();
+    chunk.last = true;
+
+    //
+    // The chunk holds the topics starting with the given topic in the
+    // topic name order, up to the maximum number of records of a
+    // chunk. If the update log holds the given log update, only the
+    // topics updated since are returned.
+    //
+    size_t count = 0;
+    if(chunk.full)
+    {
+        for(map<string, TopicImplPtr>::const_iterator p = _topics.lower_bound(start); p != _topics.end(); ++p)
+        {
+            if(count >= _chunkSize)
+            {
+                next = p->first;
+                chunk.last = false;
+                break;
+            }
+            chunk.content.push_back(p->second->getContent());
+            count += chunk.content.back().records.size() + 1;
+        }
+    }
+    else
+    {
+        for(set<string>::const_iterator p = updated.lower_bound(start); p != updated.end(); ++p)
+        {
+            if(count >= _chunkSize)
+            {
+                next = *p;
+                chunk.last = false;
+                break;
+            }
+            map<string, TopicImplPtr>::const_iterator q = _topics.find(*p);
+            if(q != _topics.end())
+            {
+                chunk.content.push_back(q->second->getContent());
+                count += chunk.content.back().records.size() + 1;
+            }
+            else
+            {
+                chunk.removed.push_back(nameToIdentity(_instance, *p));
+                ++count;
+            }
+        }
+    }
+
+    try
+    {
+        IceDB::ReadOnlyTxn txn(_instance->dbEnv());
+        _lluMap.get(txn, lluDbKey, llu);
+    }
+    catch(const IceDB::LMDBException& ex)
+    {
+        logError(_instance->communicator(), ex);
+        throw; // will become UnknownException in caller
+    }
+    return chunk;
+}
+
 LogUpdate
 TopicManagerImpl::getLastLogUpdate() const
 {
@@ -663,11 +1139,54 @@ TopicManagerImpl::sync(const Ice::ObjectPrx& master)
 {
     TopicManagerSyncPrx sync = TopicManagerSyncPrx::uncheckedCast(master);
 
-    LogUpdate llu;
-    TopicContentSeq content;
-    sync->getContent(llu, content);
+    //
+    // Retrieve the topics updated since our last log update chunk by
+    // chunk, the master sends all the topics if it can't figure out
+    // the updated topics.
+    //
+    LogUpdate since = getLastLogUpdate();
+    string start;
+    TopicContentChunk chunk;
+    try
+    {
+        do
+        {
+            LogUpdate llu;
+            string next;
+            try
+            {
+                chunk = sync->getContentChunk(since, start, llu, next);
+            }
+            catch(const Ice::OperationNotExistException&)
+            {
+                if(!start.empty())
+                {
+                    throw;
+                }
 
-    observerInit(llu, content);
+                //
+                // The master doesn't support content chunks, retrieve
+                // all the topics at once.
+                //
+                TopicContentSeq content;
+                sync->getContent(llu, content);
+                observerInit(llu, content);
+                return;
+            }
+            observerInitChunk(llu, chunk);
+            start = next;
+        }
+        while(!chunk.last);
+    }
+    catch(...)
+    {
+        //
+        // Roll back the chunks written so far, the transaction would
+        // otherwise remain open until the next chunk times out.
+        //
+        observerAbortInit();
+        throw;
+    }
 }
 
 void
@@ -677,8 +1196,6 @@ TopicManagerImpl::initMaster(const set<GroupNodeInfo>& slaves, const LogUpdate&
 
     reap();
 
-    TopicContentSeq content;
-
     // Update the database llu. This prevents the following case:
     //
     // Three replicas 1, 2, 3. 3 is the master. It accepts a change
@@ -692,16 +1209,8 @@ TopicManagerImpl::initMaster(const set<GroupNodeInfo>& slaves, const LogUpdate&
     //
     try
     {
-        content.clear();
-
         IceDB::ReadWriteTxn txn(_instance->dbEnv());
 
-        for(map<string, TopicImplPtr>::const_iterator p = _topics.begin(); p != _topics.end(); ++p)
-        {
-            TopicContent rec = p->second->getContent();
-            content.push_back(rec);
-        }
-
         _lluMap.put(txn, lluDbKey, llu);
 
         txn.commit();
@@ -711,9 +1220,11 @@ TopicManagerImpl::initMaster(const set<GroupNodeInfo>& slaves, const LogUpdate&
         logError(_instance->communicator(), ex);
         throw; // will become UnknownException in caller
     }
+    _instance->observers()->logUpdate(llu);
 
-    // Now initialize the observers.
-    _instance->observers()->init(slaves, llu, content);
+    // Now initialize the observers, the observers retrieve the topic
+    // content with getContentChunk.
+    _instance->observers()->init(slaves, llu, this);
 }
 
 Ice::ObjectPrx
@@ -752,6 +1263,8 @@ TopicManagerImpl::shutdown()
 {
     Lock sync(*this);
 
+    abortApplier();
+
     for(map<string, TopicImplPtr>::const_iterator p = _topics.begin(); p != _topics.end(); ++p)
     {
         p->second->shutdown();
@@ -846,3 +1359,71 @@ TopicManagerImpl::installTopic(const string& name, const Ice::Identity& id, bool
     _instance->topicAdapter()->add(topicImpl->getServant(), id);
     return topicImpl->proxy();
 }
+
+void
+TopicManagerImpl::abortApplier()
+{
+    //
+    // Called with mutex locked.
+    //
+    if(_applier)
+    {
+        _applier->abort();
+        _applier->getThreadControl().join();
+        _applier = 0;
+    }
+}
+
+void
+TopicManagerImpl::reloadTopic(const LogUpdate& llu, const string& name)
+{
+    //
+    // Called with 'this' mutex locked.
+    //
+    Ice::Identity id = nameToIdentity(_instance, name);
+    SubscriberRecordSeq records;
+    bool found = false;
+    try
+    {
+        IceDB::ReadOnlyTxn txn(_instance->dbEnv());
+
+        SubscriberRecordKey key;
+        key.topic = id;
+
+        SubscriberMapROCursor cursor(_subscriberMap, txn);
+        if(cursor.find(key))
+        {
+            found = true;
+
+            SubscriberRecordKey k;
+            SubscriberRecord v;
+            while(cursor.get(k, v, MDB_NEXT) && k.topic == id)
+            {
+                records.push_back(v);
+            }
+        }
+    }
+    catch(const IceDB::LMDBException& ex)
+    {
+        logError(_instance->communicator(), ex);
+        throw; // will become UnknownException in caller
+    }
+
+    map<string, TopicImplPtr>::iterator p = _topics.find(name);
+    if(!found)
+    {
+        if(p != _topics.end())
+        {
+            p->second->observerDestroyTopic(llu);
+            _topics.erase(p);
+        }
+    }
+    else if(p == _topics.end())
+    {
+        installTopic(name, id, true, records);
+    }
+    else
+    {
+        p->second->update(records);
+    }
+}
@@ -31,6 +31,9 @@ typedef IceUtil::Handle<PersistentInstance> PersistentInstancePtr;
 class TopicImpl;
 typedef IceUtil::Handle<TopicImpl> TopicImplPtr;
 
+class ContentApplier;
+typedef IceUtil::Handle<ContentApplier> ContentApplierPtr;
+
 //
 // TopicManager implementation.
 //
@@ -50,6 +53,8 @@ public:
 
     // Observer methods.
     void observerInit(const IceStormElection::LogUpdate&, const IceStormElection::TopicContentSeq&);
+    void observerInitChunk(const IceStormElection::LogUpdate&, const IceStormElection::TopicContentChunk&);
+    void observerAbortInit();
     void observerCreateTopic(const IceStormElection::LogUpdate&, const std::string&);
     void observerDestroyTopic(const IceStormElection::LogUpdate&, const std::string&);
     void observerAddSubscriber(const IceStormElection::LogUpdate&, const std::string&,
@@ -57,12 +62,14 @@ public:
     void observerRemoveSubscriber(const IceStormElection::LogUpdate&, const std::string&, const Ice::IdentitySeq&);
 
     // Sync methods.
-    void getContent(IceStormElection::LogUpdate&, IceStormElection::TopicContentSeq&);
+    virtual void getContent(IceStormElection::LogUpdate&, IceStormElection::TopicContentSeq&);
 
     // Replica methods.
     virtual IceStormElection::LogUpdate getLastLogUpdate() const;
     virtual void sync(const Ice::ObjectPrx&);
     virtual void initMaster(const std::set<IceStormElection::GroupNodeInfo>&, const IceStormElection::LogUpdate&);
+    virtual IceStormElection::TopicContentChunk getContentChunk(const IceStormElection::LogUpdate&, const std::string&,
+                                                                IceStormElection::LogUpdate&, std::string&);
     virtual Ice::ObjectPrx getObserver() const;
     virtual Ice::ObjectPrx getSync() const;
 
@@ -77,6 +84,9 @@ private:
     void updateTopicObservers();
     void updateSubscriberObservers();
 
+    void reloadTopic(const IceStormElection::LogUpdate&, const std::string&);
+    void abortApplier();
+
     TopicPrx installTopic(const std::string&, const Ice::Identity&, bool,
                           const IceStorm::SubscriberRecordSeq& = IceStorm::SubscriberRecordSeq());
 
@@ -92,6 +102,19 @@ private:
 
     LLUMap _lluMap;
     SubscriberMap _subscriberMap;
+
+    // The maximum number of subscriber records of a content chunk.
+    const size_t _chunkSize;
+
+    //
+    // The writer of the content chunks received by the observer and
+    // the names of the topics updated and removed by the chunks
+    // written so far.
+    //
+    ContentApplierPtr _applier;
+    bool _initFull;
+    std::set<std::string> _initUpdated;
+    std::set<std::string> _initRemoved;
 };
 typedef IceUtil::Handle<TopicManagerImpl> TopicManagerImplPtr;
 
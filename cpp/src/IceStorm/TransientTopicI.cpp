@@ -24,23 +24,86 @@ using namespace std;
 namespace
 {
 
+//
+// Publish task used when publish shards are configured, the response
+// is sent to the publisher or to the topic link once the events are
+// published.
+//
+class TransientTopicPublishTask : public PublishTask
+{
+public:
+
+    TransientTopicPublishTask(const TransientTopicImplPtr& impl, const EventDataSeq& events,
+                              const Ice::AMD_Object_ice_invokePtr& cb) :
+        _impl(impl), _events(events), _publishCB(cb)
+    {
+    }
+
+    TransientTopicPublishTask(const TransientTopicImplPtr& impl, const EventDataSeq& events,
+                              const AMD_TopicLink_forwardPtr& cb) :
+        _impl(impl), _events(events), _forwardCB(cb)
+    {
+    }
+
+protected:
+
+    virtual void
+    publish()
+    {
+        _impl->publish(_forwardCB != 0, _events);
+    }
+
+    virtual void
+    response()
+    {
+        if(_publishCB)
+        {
+            _publishCB->ice_response(true, Ice::ByteSeq());
+        }
+        else
+        {
+            _forwardCB->ice_response();
+        }
+    }
+
+    virtual void
+    exception(const std::exception& ex)
+    {
+        if(_publishCB)
+        {
+            _publishCB->ice_exception(ex);
+        }
+        else
+        {
+            _forwardCB->ice_exception(ex);
+        }
+    }
+
+private:
+
+    const TransientTopicImplPtr _impl;
+    const EventDataSeq _events;
+    const Ice::AMD_Object_ice_invokePtr _publishCB;
+    const AMD_TopicLink_forwardPtr _forwardCB;
+};
+
 //
 // The servant has a 1-1 association with a topic. It is used to
 // receive events from Publishers.
 //
-class TransientPublisherI : public Ice::BlobjectArray
+class TransientPublisherI : public Ice::BlobjectArrayAsync
 {
 public:
 
-    TransientPublisherI(const TransientTopicImplPtr& impl) :
-        _impl(impl)
+    TransientPublisherI(const TransientTopicImplPtr& impl, const InstancePtr& instance) :
+        _impl(impl), _instance(instance)
     {
     }
 
-    virtual bool
-    ice_invoke(const pair<const Ice::Byte*, const Ice::Byte*>& inParams,
-               Ice::ByteSeq&,
-               const Ice::Current& current)
+    virtual void
+    ice_invoke_async(const Ice::AMD_Object_ice_invokePtr& cb,
+                     const pair<const Ice::Byte*, const Ice::Byte*>& inParams,
+                     const Ice::Current& current)
     {
         // Use cached reads.
         EventDataPtr event = new EventData(
@@ -58,14 +121,23 @@ public:
 
         EventDataSeq v;
         v.push_back(event);
-        _impl->publish(false, v);
 
-        return true;
+        PublishDispatcherPtr dispatcher = _instance->publishDispatcher();
+        if(dispatcher)
+        {
+            dispatcher->dispatch(_impl->getName(current), current.ctx, new TransientTopicPublishTask(_impl, v, cb));
+        }
+        else
+        {
+            _impl->publish(false, v);
+            cb->ice_response(true, Ice::ByteSeq());
+        }
     }
 
 private:
 
     const TransientTopicImplPtr _impl;
+    const InstancePtr _instance;
 };
 
 //
@@ -76,20 +148,31 @@ class TransientTopicLinkI : public TopicLink
 {
 public:
 
-    TransientTopicLinkI(const TransientTopicImplPtr& impl) :
-        _impl(impl)
+    TransientTopicLinkI(const TransientTopicImplPtr& impl, const InstancePtr& instance) :
+        _impl(impl), _instance(instance)
     {
     }
 
     virtual void
-    forward(const EventDataSeq& v, const Ice::Current& /*current*/)
+    forward_async(const AMD_TopicLink_forwardPtr& cb, const EventDataSeq& v, const Ice::Current& current)
     {
-        _impl->publish(true, v);
+        PublishDispatcherPtr dispatcher = _instance->publishDispatcher();
+        if(dispatcher)
+        {
+            dispatcher->dispatch(_impl->getName(current), Ice::noExplicitContext,
+                                 new TransientTopicPublishTask(_impl, v, cb));
+        }
+        else
+        {
+            _impl->publish(true, v);
+            cb->ice_response();
+        }
     }
 
 private:
 
     const TransientTopicImplPtr _impl;
+    const InstancePtr _instance;
 };
 
 }
@@ -101,6 +184,7 @@ TransientTopicImpl::TransientTopicImpl(
     _instance(instance),
     _name(name),
     _id(id),
+    _subscribers(new SubscriberList),
     _destroyed(false)
 {
     //
@@ -130,8 +214,9 @@ TransientTopicImpl::TransientTopicImpl(
         linkid.name = _name + ".link";
     }
 
-    _publisherPrx = _instance->publishAdapter()->add(new TransientPublisherI(this), pubid);
-    _linkPrx = TopicLinkPrx::uncheckedCast(_instance->publishAdapter()->add(new TransientTopicLinkI(this), linkid));
+    _publisherPrx = _instance->publishAdapter()->add(new TransientPublisherI(this, _instance), pubid);
+    _linkPrx = TopicLinkPrx::uncheckedCast(_instance->publishAdapter()->add(new TransientTopicLinkI(this, _instance),
+                                                                            linkid));
 }
 
 TransientTopicImpl::~TransientTopicImpl()
@@ -248,17 +333,18 @@ TransientTopicImpl::subscribe(const QoS& origQoS, const Ice::ObjectPrx& obj, con
     record.link = false;
     record.cost = 0;
 
-    vector<SubscriberPtr>::iterator p = find(_subscribers.begin(), _subscribers.end(), record.id);
-    if(p != _subscribers.end())
+    vector<SubscriberPtr>& subscribers = subscribersForUpdate();
+    vector<SubscriberPtr>::iterator p = find(subscribers.begin(), subscribers.end(), record.id);
+    if(p != subscribers.end())
     {
         // If we already have this subscriber remove it from our
         // subscriber list and remove it from the database.
         (*p)->destroy();
-        _subscribers.erase(p);
+        subscribers.erase(p);
     }
 
     SubscriberPtr subscriber = Subscriber::create(_instance, record);
-    _subscribers.push_back(subscriber);
+    subscribers.push_back(subscriber);
 }
 
 Ice::ObjectPrx
@@ -307,14 +393,14 @@ TransientTopicImpl::subscribeAndGetPublisher(const QoS& qos, const Ice::ObjectPr
     record.link = false;
     record.cost = 0;
 
-    vector<SubscriberPtr>::iterator p = find(_subscribers.begin(), _subscribers.end(), record.id);
-    if(p != _subscribers.end())
+    vector<SubscriberPtr>::iterator p = find(_subscribers->begin(), _subscribers->end(), record.id);
+    if(p != _subscribers->end())
     {
         throw AlreadySubscribed();
     }
 
     SubscriberPtr subscriber = Subscriber::create(_instance, record);
-    _subscribers.push_back(subscriber);
+    subscribersForUpdate().push_back(subscriber);
 
     return subscriber->proxy();
 }
@@ -349,11 +435,12 @@ TransientTopicImpl::unsubscribe(const Ice::ObjectPrx& subscriber, const Ice::Cur
     // First remove the subscriber from the subscribers list. Note
     // that its possible that the subscriber isn't in the list, but is
     // in the database if the subscriber was locally reaped.
-    vector<SubscriberPtr>::iterator p = find(_subscribers.begin(), _subscribers.end(), id);
-    if(p != _subscribers.end())
+    vector<SubscriberPtr>& subscribers = subscribersForUpdate();
+    vector<SubscriberPtr>::iterator p = find(subscribers.begin(), subscribers.end(), id);
+    if(p != subscribers.end())
     {
         (*p)->destroy();
-        _subscribers.erase(p);
+        subscribers.erase(p);
     }
 }
 
@@ -390,8 +477,8 @@ TransientTopicImpl::link(const TopicPrx& topic, Ice::Int cost, const Ice::Curren
     record.link = true;
     record.cost = cost;
 
-    vector<SubscriberPtr>::iterator p = find(_subscribers.begin(), _subscribers.end(), record.id);
-    if(p != _subscribers.end())
+    vector<SubscriberPtr>::iterator p = find(_subscribers->begin(), _subscribers->end(), record.id);
+    if(p != _subscribers->end())
     {
         string name = IceStormInternal::identityToTopicName(id);
         LinkExists ex;
@@ -400,7 +487,7 @@ TransientTopicImpl::link(const TopicPrx& topic, Ice::Int cost, const Ice::Curren
     }
 
     SubscriberPtr subscriber = Subscriber::create(_instance, record);
-    _subscribers.push_back(subscriber);
+    subscribersForUpdate().push_back(subscriber);
 }
 
 void
@@ -414,8 +501,8 @@ TransientTopicImpl::unlink(const TopicPrx& topic, const Ice::Current&)
 
     Ice::Identity id = topic->ice_getIdentity();
 
-    vector<SubscriberPtr>::iterator p = find(_subscribers.begin(), _subscribers.end(), id);
-    if(p == _subscribers.end())
+    vector<SubscriberPtr>::const_iterator p = find(_subscribers->begin(), _subscribers->end(), id);
+    if(p == _subscribers->end())
     {
         string name = IceStormInternal::identityToTopicName(id);
         TraceLevelsPtr traceLevels = _instance->traceLevels();
@@ -440,11 +527,12 @@ TransientTopicImpl::unlink(const TopicPrx& topic, const Ice::Current&)
     // Remove the subscriber from the subscribers list. Note
     // that its possible that the subscriber isn't in the list, but is
     // in the database if the subscriber was locally reaped.
-    p = find(_subscribers.begin(), _subscribers.end(), id);
-    if(p != _subscribers.end())
+    vector<SubscriberPtr>& subscribers = subscribersForUpdate();
+    vector<SubscriberPtr>::iterator q = find(subscribers.begin(), subscribers.end(), id);
+    if(q != subscribers.end())
     {
-        (*p)->destroy();
-        _subscribers.erase(p);
+        (*q)->destroy();
+        subscribers.erase(q);
     }
 }
 
@@ -453,7 +541,7 @@ TransientTopicImpl::getLinkInfoSeq(const Ice::Current&) const
 {
     Lock sync(*this);
     LinkInfoSeq seq;
-    for(vector<SubscriberPtr>::const_iterator p = _subscribers.begin(); p != _subscribers.end(); ++p)
+    for(vector<SubscriberPtr>::const_iterator p = _subscribers->begin(); p != _subscribers->end(); ++p)
     {
         SubscriberRecord record = (*p)->record();
         if(record.link && !(*p)->errored())
@@ -474,7 +562,7 @@ TransientTopicImpl::getSubscribers(const Ice::Current&) const
     IceUtil::Mutex::Lock sync(*this);
 
     Ice::IdentitySeq subscribers;
-    for(vector<SubscriberPtr>::const_iterator p = _subscribers.begin(); p != _subscribers.end(); ++p)
+    for(vector<SubscriberPtr>::const_iterator p = _subscribers->begin(); p != _subscribers->end(); ++p)
     {
         subscribers.push_back((*p)->id());
     }
@@ -510,11 +598,11 @@ TransientTopicImpl::destroy(const Ice::Current&)
     }
 
     // Destroy all of the subscribers.
-    for(vector<SubscriberPtr>::const_iterator p = _subscribers.begin(); p != _subscribers.end(); ++p)
+    for(vector<SubscriberPtr>::const_iterator p = _subscribers->begin(); p != _subscribers->end(); ++p)
     {
         (*p)->destroy();
     }
-    _subscribers.clear();
+    _subscribers = new SubscriberList;
 }
 
 void
@@ -540,13 +628,14 @@ void
 TransientTopicImpl::publish(bool forwarded, const EventDataSeq& events)
 {
     //
-    // Copy of the subscriber list so that event publishing can occur
-    // in parallel.
+    // Reference the current subscriber list so that event publishing
+    // can occur in parallel. The list is copy-on-write so it won't be
+    // modified while we iterate over it.
     //
-    vector<SubscriberPtr> copy;
+    SubscriberListPtr current;
     {
         Lock sync(*this);
-        copy = _subscribers;
+        current = _subscribers;
     }
 
     //
@@ -554,7 +643,7 @@ TransientTopicImpl::publish(bool forwarded, const EventDataSeq& events)
     // must be reaped.
     //
     vector<Ice::Identity> e;
-    for(vector<SubscriberPtr>::const_iterator p = copy.begin(); p != copy.end(); ++p)
+    for(vector<SubscriberPtr>::const_iterator p = current->begin(); p != current->end(); ++p)
     {
         if(!(*p)->queue(forwarded, events) && (*p)->reap())
         {
@@ -568,12 +657,14 @@ TransientTopicImpl::publish(bool forwarded, const EventDataSeq& events)
     //
     if(!e.empty())
     {
+        current = 0; // Release the list to not force a copy on update.
+
         Lock sync(*this);
         for(vector<Ice::Identity>::const_iterator ep = e.begin(); ep != e.end(); ++ep)
         {
             //
             // Its possible for the subscriber to already have been
-            // removed since the copy is iterated over outside of
+            // removed since the list is iterated over outside of
             // mutex protection.
             //
             // Note that although this could be quicker if we used a
@@ -585,15 +676,16 @@ TransientTopicImpl::publish(bool forwarded, const EventDataSeq& events)
             // error'd subscribers and remove it from the database on
             // the next reap.
             //
-            vector<SubscriberPtr>::iterator q = find(_subscribers.begin(), _subscribers.end(), *ep);
-            if(q != _subscribers.end())
+            vector<SubscriberPtr>& subscribers = subscribersForUpdate();
+            vector<SubscriberPtr>::iterator q = find(subscribers.begin(), subscribers.end(), *ep);
+            if(q != subscribers.end())
             {
                 SubscriberPtr subscriber = *q;
                 //
                 // Destroy the subscriber.
                 //
                 subscriber->destroy();
-                _subscribers.erase(q);
+                subscribers.erase(q);
             }
         }
     }
@@ -605,8 +697,23 @@ TransientTopicImpl::shutdown()
     Lock sync(*this);
 
     // Shutdown each subscriber. This waits for the event queues to drain.
-    for(vector<SubscriberPtr>::const_iterator p = _subscribers.begin(); p != _subscribers.end(); ++p)
+    for(vector<SubscriberPtr>::const_iterator p = _subscribers->begin(); p != _subscribers->end(); ++p)
     {
         (*p)->shutdown();
     }
 }
+
+vector<SubscriberPtr>&
+TransientTopicImpl::subscribersForUpdate()
+{
+    //
+    // Must be called with the mutex locked. If a publish still
+    // references the subscriber list, we copy it before it's
+    // modified.
+    //
+    if(_subscribers->__getRef() > 1)
+    {
+        _subscribers = new SubscriberList(*_subscribers);
+    }
+    return *_subscribers;
+}
@@ -22,6 +22,9 @@ typedef IceUtil::Handle<Instance> InstancePtr;
 class Subscriber;
 typedef IceUtil::Handle<Subscriber> SubscriberPtr;
 
+class SubscriberList;
+typedef IceUtil::Handle<SubscriberList> SubscriberListPtr;
+
 class TransientTopicImpl : public TopicInternal, public IceUtil::Mutex
 {
 public:
@@ -52,6 +55,8 @@ public:
 
 private:
 
+    std::vector<SubscriberPtr>& subscribersForUpdate();
+
     //
     // Immutable members.
     //
@@ -69,7 +74,9 @@ private:
     // vector/list/map and although there was little difference vector
     // was the fastest of the three.
     //
-    std::vector<SubscriberPtr> _subscribers;
+    // The vector is copy-on-write, see subscribersForUpdate().
+    //
+    SubscriberListPtr _subscribers;
 
     bool _destroyed; // Has this Topic been destroyed?
 };
@@ -0,0 +1,140 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#include <Ice/Application.h>
+#include <Glacier2/Router.h>
+#include <Glacier2/Metrics.h>
+#include <Backend.h>
+#include <TestCommon.h>
+
+using namespace std;
+using namespace Ice;
+using namespace Test;
+
+namespace
+{
+
+//
+// The router forwards 20 requests per second with bursts of 5
+// requests, see run.py.
+//
+const int rateLimit = 20;
+const int burst = 5;
+
+//
+// Send the given number of requests without waiting for the replies
+// and return the time it took to get all the replies.
+//
+IceUtil::Time
+sendRequests(const BackendPrx& backend, int count)
+{
+    IceUtil::Time start = IceUtil::Time::now(IceUtil::Time::Monotonic);
+    vector<AsyncResultPtr> results;
+    for(int i = 0; i < count; ++i)
+    {
+        results.push_back(backend->begin_ice_ping());
+    }
+    for(vector<AsyncResultPtr>::const_iterator p = results.begin(); p != results.end(); ++p)
+    {
+        backend->end_ice_ping(*p);
+    }
+    return IceUtil::Time::now(IceUtil::Time::Monotonic) - start;
+}
+
+Glacier2::SessionMetricsPtr
+getSessionMetrics(const IceMX::MetricsAdminPrx& metrics)
+{
+    Ice::Long timestamp;
+    IceMX::MetricsView view = metrics->getMetricsView("View", timestamp);
+    IceMX::MetricsView::const_iterator p = view.find("Session");
+    test(p != view.end() && p->second.size() == 1);
+    Glacier2::SessionMetricsPtr sessionMetrics = Glacier2::SessionMetricsPtr::dynamicCast(p->second[0]);
+    test(sessionMetrics);
+    return sessionMetrics;
+}
+
+}
+
+class RateLimitClient : public Application
+{
+public:
+
+    virtual int run(int, char*[]);
+};
+
+int
+main(int argc, char* argv[])
+{
+#ifdef ICE_STATIC_LIBS
+    Ice::registerIceSSL();
+#endif
+
+    RateLimitClient app;
+    return app.main(argc, argv);
+}
+
+int
+RateLimitClient::run(int, char**)
+{
+    ObjectPrx routerBase = communicator()->stringToProxy("Glacier2/router:default -p 12347");
+    Glacier2::RouterPrx router = Glacier2::RouterPrx::checkedCast(routerBase);
+    test(router);
+    communicator()->setDefaultRouter(router);
+
+    Glacier2::SessionPrx session = router->createSession("userid", "abc123");
+    BackendPrx backend = BackendPrx::uncheckedCast(communicator()->stringToProxy("backend:tcp -p 12010"));
+
+    IceMX::MetricsAdminPrx metrics = IceMX::MetricsAdminPrx::checkedCast(
+        communicator()->stringToProxy("Glacier2/admin -f Metrics:tcp -h 127.0.0.1 -p 12348")->ice_router(0));
+    test(metrics);
+
+    cout << "testing requests within the burst... " << flush;
+    {
+        //
+        // Wait for the bucket to be full, the requests are forwarded
+        // right away.
+        //
+        IceUtil::ThreadControl::sleep(IceUtil::Time::milliSeconds(1000 * burst / rateLimit + 100));
+        sendRequests(backend, burst);
+        test(getSessionMetrics(metrics)->throttledClient == 0);
+    }
+    cout << "ok" << endl;
+
+    cout << "testing requests above the rate limit... " << flush;
+    {
+        //
+        // The bucket is empty, the requests are forwarded at the rate
+        // limit.
+        //
+        const int count = 20;
+        IceUtil::Time elapsed = sendRequests(backend, count);
+        test(elapsed >= IceUtil::Time::milliSeconds(1000 * (count - 1) / rateLimit - 100));
+        test(getSessionMetrics(metrics)->throttledClient > 0);
+    }
+    cout << "ok" << endl;
+
+    cout << "testing server and router shutdown... " << flush;
+    backend->shutdown();
+    communicator()->setDefaultRouter(0);
+    Ice::ProcessPrx process = Ice::ProcessPrx::checkedCast(
+        communicator()->stringToProxy("Glacier2/admin -f Process:tcp -h 127.0.0.1 -p 12348"));
+    test(process);
+    process->shutdown();
+    try
+    {
+        process->ice_ping();
+        test(false);
+    }
+    catch(const Ice::LocalException&)
+    {
+        cout << "ok" << endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,44 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#include <Ice/Application.h>
+#include <BackendI.h>
+
+using namespace std;
+using namespace Ice;
+using namespace Test;
+
+class BackendServer : public Application
+{
+public:
+
+    virtual int run(int, char*[]);
+};
+
+int
+main(int argc, char* argv[])
+{
+#ifdef ICE_STATIC_LIBS
+    Ice::registerIceSSL();
+#endif
+
+    BackendServer app;
+    return app.main(argc, argv);
+}
+
+int
+BackendServer::run(int, char**)
+{
+    communicator()->getProperties()->setProperty("BackendAdapter.Endpoints", "tcp -p 12010");
+    ObjectAdapterPtr adapter = communicator()->createObjectAdapter("BackendAdapter");
+    adapter->add(new BackendI, stringToIdentity("backend"));
+    adapter->activate();
+    communicator()->waitForShutdown();
+    return EXIT_SUCCESS;
+}
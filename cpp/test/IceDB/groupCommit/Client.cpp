@@ -0,0 +1,253 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#include <Ice/Ice.h>
+#include <IceDB/IceDB.h>
+#include <IceUtil/Thread.h>
+#include <TestCommon.h>
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+
+typedef IceDB::Dbi<string, int, IceDB::IceContext, Ice::OutputStream> StringIntMap;
+
+const int writers = 8;
+const int writes = 50;
+
+string
+keyOf(int writer, int i)
+{
+    ostringstream os;
+    os << writer << "." << i;
+    return os.str();
+}
+
+class PutOperation : public IceDB::GroupCommit::Operation
+{
+public:
+
+    PutOperation(const StringIntMap& map, const string& key, int value) :
+        _map(map), _key(key), _value(value)
+    {
+    }
+
+    virtual void
+    execute(const IceDB::ReadWriteTxn& txn)
+    {
+        _map.put(txn, _key, _value);
+    }
+
+private:
+
+    StringIntMap _map;
+    const string _key;
+    const int _value;
+};
+
+//
+// An operation failing with an exception which isn't an Ice
+// exception, its write must be rolled back.
+//
+class FailOperation : public IceDB::GroupCommit::Operation
+{
+public:
+
+    FailOperation(const StringIntMap& map, const string& key) :
+        _map(map), _key(key)
+    {
+    }
+
+    virtual void
+    execute(const IceDB::ReadWriteTxn& txn)
+    {
+        _map.put(txn, _key, -1);
+        throw runtime_error("operation failed");
+    }
+
+private:
+
+    StringIntMap _map;
+    const string _key;
+};
+
+class Writer : public IceUtil::Thread
+{
+public:
+
+    Writer(const IceDB::GroupCommitPtr& groupCommit, const StringIntMap& map, int id) :
+        _groupCommit(groupCommit), _map(map), _id(id), _failures(0)
+    {
+    }
+
+    virtual void
+    run()
+    {
+        for(int i = 0; i < writes; ++i)
+        {
+            if(i % 10 == 9)
+            {
+                try
+                {
+                    _groupCommit->execute(new FailOperation(_map, keyOf(_id, i)));
+                }
+                catch(const Ice::UnknownException&)
+                {
+                    ++_failures;
+                }
+            }
+            else
+            {
+                _groupCommit->execute(new PutOperation(_map, keyOf(_id, i), i));
+            }
+        }
+    }
+
+    int
+    failures() const
+    {
+        return _failures;
+    }
+
+private:
+
+    const IceDB::GroupCommitPtr _groupCommit;
+    const StringIntMap _map;
+    const int _id;
+    int _failures;
+};
+typedef IceUtil::Handle<Writer> WriterPtr;
+
+void
+writeAndCheck(const IceDB::Env& env, const StringIntMap& map, const IceDB::GroupCommitPtr& groupCommit)
+{
+    vector<WriterPtr> threads;
+    for(int i = 0; i < writers; ++i)
+    {
+        threads.push_back(new Writer(groupCommit, map, i));
+        threads.back()->start();
+    }
+    for(vector<WriterPtr>::const_iterator p = threads.begin(); p != threads.end(); ++p)
+    {
+        (*p)->getThreadControl().join();
+        test((*p)->failures() == writes / 10);
+    }
+
+    IceDB::ReadOnlyTxn txn(env);
+    for(int i = 0; i < writers; ++i)
+    {
+        for(int j = 0; j < writes; ++j)
+        {
+            int value;
+            if(j % 10 == 9)
+            {
+                test(!map.get(txn, keyOf(i, j), value));
+            }
+            else
+            {
+                test(map.get(txn, keyOf(i, j), value) && value == j);
+            }
+        }
+    }
+}
+
+}
+
+int
+run(int argc, char* argv[], const Ice::CommunicatorPtr& communicator)
+{
+    if(argc != 2)
+    {
+        cerr << "usage: " << argv[0] << " <db directory>" << endl;
+        return EXIT_FAILURE;
+    }
+
+    IceDB::Env env(argv[1], 1);
+
+    IceDB::IceContext ctx;
+    ctx.communicator = communicator;
+    ctx.encoding = Ice::currentEncoding;
+
+    StringIntMap map;
+    {
+        IceDB::ReadWriteTxn txn(env);
+        map = StringIntMap(txn, "test", ctx, MDB_CREATE);
+        txn.commit();
+    }
+
+    cout << "testing concurrent operations... " << flush;
+    {
+        writeAndCheck(env, map, new IceDB::GroupCommit(env, IceUtil::Time::milliSeconds(5), 10));
+    }
+    cout << "ok" << endl;
+
+    cout << "testing concurrent operations without commit delay... " << flush;
+    {
+        IceDB::ReadWriteTxn txn(env);
+        map.clear(txn);
+        txn.commit();
+
+        writeAndCheck(env, map, new IceDB::GroupCommit(env, IceUtil::Time(), 3));
+    }
+    cout << "ok" << endl;
+
+    cout << "testing failure of the only operation of a commit... " << flush;
+    {
+        IceDB::GroupCommitPtr groupCommit = new IceDB::GroupCommit(env, IceUtil::Time(), 1);
+        try
+        {
+            groupCommit->execute(new FailOperation(map, "failed"));
+            test(false);
+        }
+        catch(const Ice::UnknownException&)
+        {
+        }
+
+        //
+        // The next operations must still be committed.
+        //
+        groupCommit->execute(new PutOperation(map, "next", 1));
+
+        IceDB::ReadOnlyTxn txn(env);
+        int value;
+        test(!map.get(txn, "failed", value));
+        test(map.get(txn, "next", value) && value == 1);
+    }
+    cout << "ok" << endl;
+
+    return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char* argv[])
+{
+    int status;
+    Ice::CommunicatorPtr communicator;
+
+    try
+    {
+        communicator = Ice::initialize(argc, argv);
+        status = run(argc, argv, communicator);
+    }
+    catch(const IceUtil::Exception& ex)
+    {
+        cerr << ex << endl;
+        status = EXIT_FAILURE;
+    }
+
+    if(communicator)
+    {
+        communicator->destroy();
+    }
+
+    return status;
+}
@@ -0,0 +1,163 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#include <Ice/Ice.h>
+#include <IceDB/IceDB.h>
+#include <TestCommon.h>
+
+using namespace std;
+
+namespace
+{
+
+typedef IceDB::Dbi<Ice::Int, Ice::ByteSeq, IceDB::IceContext, Ice::OutputStream> BlobMap;
+
+const size_t mb = 1024 * 1024;
+
+size_t
+mapSize(const IceDB::Env& env)
+{
+    MDB_envinfo info;
+    test(mdb_env_info(env.menv(), &info) == MDB_SUCCESS);
+    return info.me_mapsize;
+}
+
+BlobMap
+openMap(const IceDB::Env& env, const IceDB::IceContext& ctx)
+{
+    IceDB::ReadWriteTxn txn(env);
+    BlobMap map(txn, "test", ctx, MDB_CREATE);
+    txn.commit();
+    return map;
+}
+
+//
+// Write the given number of records of the given size in a single
+// transaction, starting with the given key. The transaction is
+// retried while it fails with MDB_MAP_FULL, up to the given number of
+// attempts. Returns the number of failed attempts.
+//
+int
+write(const IceDB::Env& env, BlobMap& map, Ice::Int key, int count, size_t size, int attempts)
+{
+    const Ice::ByteSeq data(size, 1);
+    int failures = 0;
+    while(failures < attempts)
+    {
+        try
+        {
+            IceDB::ReadWriteTxn txn(env);
+            for(int i = 0; i < count; ++i)
+            {
+                map.put(txn, key + i, data);
+            }
+            txn.commit();
+            break;
+        }
+        catch(const IceDB::LMDBException& ex)
+        {
+            test(ex.error() == MDB_MAP_FULL);
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+}
+
+int
+run(int argc, char* argv[], const Ice::CommunicatorPtr& communicator)
+{
+    if(argc != 2)
+    {
+        cerr << "usage: " << argv[0] << " <db directory>" << endl;
+        return EXIT_FAILURE;
+    }
+
+    IceDB::IceContext ctx;
+    ctx.communicator = communicator;
+    ctx.encoding = Ice::currentEncoding;
+
+    size_t size;
+    {
+        IceDB::Env env(argv[1], 1, mb);
+        BlobMap map = openMap(env, ctx);
+        test(mapSize(env) == mb);
+
+        cout << "testing growth of a map filling up... " << flush;
+        {
+            //
+            // The map grows before each transaction once more than 80%
+            // of it is used, the small transactions never fill it.
+            //
+            for(Ice::Int i = 0; i < 400; ++i)
+            {
+                test(write(env, map, i, 1, 10 * 1024, 1) == 0);
+            }
+            test(mapSize(env) >= 4 * mb);
+        }
+        cout << "ok" << endl;
+
+        cout << "testing growth of a full map... " << flush;
+        {
+            //
+            // The transaction doesn't fit in the map which is less than
+            // 80% used. The map is doubled after each failure until the
+            // transaction fits.
+            //
+            size = mapSize(env);
+            test(write(env, map, 1000, 100, size / 50, 10) > 0);
+            test(mapSize(env) > size);
+            size = mapSize(env);
+
+            IceDB::ReadOnlyTxn txn(env);
+            Ice::ByteSeq data;
+            test(map.get(txn, 1099, data) && data.size() == size / 50);
+        }
+        cout << "ok" << endl;
+    }
+
+    cout << "testing maximum map size... " << flush;
+    {
+        IceDB::Env env(argv[1], 1, 0, 0, size);
+        BlobMap map = openMap(env, ctx);
+        test(mapSize(env) == size);
+
+        test(write(env, map, 2000, 100, size / 50, 3) == 3);
+        test(mapSize(env) == size);
+    }
+    cout << "ok" << endl;
+
+    return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char* argv[])
+{
+    int status;
+    Ice::CommunicatorPtr communicator;
+
+    try
+    {
+        communicator = Ice::initialize(argc, argv);
+        status = run(argc, argv, communicator);
+    }
+    catch(const IceUtil::Exception& ex)
+    {
+        cerr << ex << endl;
+        status = EXIT_FAILURE;
+    }
+
+    if(communicator)
+    {
+        communicator->destroy();
+    }
+
+    return status;
+}
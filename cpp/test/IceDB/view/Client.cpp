@@ -0,0 +1,194 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#include <Ice/Ice.h>
+#include <IceDB/IceDB.h>
+#include <TestCommon.h>
+
+using namespace std;
+
+namespace
+{
+
+typedef IceDB::Dbi<string, Ice::Identity, IceDB::IceContext, Ice::OutputStream> IdentityMap;
+typedef IceDB::Cursor<string, Ice::Identity, IceDB::IceContext, Ice::OutputStream> IdentityMapCursor;
+
+Ice::Identity
+identity(int i)
+{
+    ostringstream os;
+    os << "name" << i;
+    Ice::Identity id;
+    id.name = os.str();
+    id.category = i % 2 == 0 ? string() : "category";
+    return id;
+}
+
+string
+key(int i)
+{
+    ostringstream os;
+    os << "key" << i;
+    return os.str();
+}
+
+}
+
+int
+run(int argc, char* argv[], const Ice::CommunicatorPtr& communicator)
+{
+    if(argc != 2)
+    {
+        cerr << "usage: " << argv[0] << " <db directory>" << endl;
+        return EXIT_FAILURE;
+    }
+
+    IceDB::IceContext ctx;
+    ctx.communicator = communicator;
+    ctx.encoding = Ice::currentEncoding;
+
+    IceDB::Env env(argv[1], 1);
+    IdentityMap map;
+    {
+        IceDB::ReadWriteTxn txn(env);
+        map = IdentityMap(txn, "test", ctx, MDB_CREATE);
+        for(int i = 0; i < 10; ++i)
+        {
+            map.put(txn, key(i), identity(i));
+        }
+        txn.commit();
+    }
+
+    cout << "testing views... " << flush;
+    {
+        IceDB::ReadOnlyTxn txn(env);
+        IceDB::View view;
+        test(view.empty() && view.size() == 0);
+        test(!map.getView(txn, "unknown", view));
+        test(view.empty());
+
+        for(int i = 0; i < 10; ++i)
+        {
+            test(map.getView(txn, key(i), view));
+            test(!view.empty() && view.size() == static_cast<size_t>(view.end() - view.begin()));
+
+            //
+            // The view refers to the marshaled record.
+            //
+            Ice::OutputStream out(communicator, ctx.encoding);
+            out.write(identity(i));
+            test(view.size() == out.b.size());
+            test(equal(view.begin(), view.end(), out.b.begin()));
+        }
+    }
+    cout << "ok" << endl;
+
+    cout << "testing decoder... " << flush;
+    {
+        IceDB::ReadOnlyTxn txn(env);
+        IceDB::Decoder decoder(ctx);
+        IceDB::View view;
+
+        //
+        // The same decoder decodes all the views.
+        //
+        for(int i = 0; i < 10; ++i)
+        {
+            test(map.getView(txn, key(i), view));
+            Ice::Identity id;
+            decoder.decode(view, id);
+            test(id == identity(i));
+
+            Ice::Identity data;
+            test(map.get(txn, key(i), data) && data == id);
+        }
+
+        //
+        // Only unmarshal the leading member.
+        //
+        test(map.getView(txn, key(3), view));
+        string name;
+        decoder.start(view).read(name);
+        test(name == identity(3).name);
+
+        //
+        // Decode the views returned by a cursor.
+        //
+        IdentityMapCursor cursor(map, txn);
+        string k;
+        int count = 0;
+        while(cursor.getView(k, view, count == 0 ? MDB_FIRST : MDB_NEXT))
+        {
+            Ice::Identity id;
+            decoder.decode(view, id);
+            Ice::Identity data;
+            test(map.get(txn, k, data) && data == id);
+            ++count;
+        }
+        test(count == 10);
+        cursor.close();
+    }
+    cout << "ok" << endl;
+
+    cout << "testing decoder pool... " << flush;
+    {
+        IceDB::DecoderPool pool(ctx);
+        IceDB::Decoder* d1 = pool.acquire();
+        IceDB::Decoder* d2 = pool.acquire();
+        test(d1 && d2 && d1 != d2);
+        pool.release(d1);
+        pool.release(d2);
+
+        //
+        // The released decoders are reused.
+        //
+        {
+            IceDB::PooledDecoder decoder(pool);
+            test(&*decoder == d1 || &*decoder == d2);
+
+            IceDB::ReadOnlyTxn txn(env);
+            IceDB::View view;
+            test(map.getView(txn, key(5), view));
+            Ice::Identity id;
+            decoder->decode(view, id);
+            test(id == identity(5));
+        }
+        IceDB::Decoder* d3 = pool.acquire();
+        test(d3 == d1 || d3 == d2);
+        pool.release(d3);
+    }
+    cout << "ok" << endl;
+
+    return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char* argv[])
+{
+    int status;
+    Ice::CommunicatorPtr communicator;
+
+    try
+    {
+        communicator = Ice::initialize(argc, argv);
+        status = run(argc, argv, communicator);
+    }
+    catch(const IceUtil::Exception& ex)
+    {
+        cerr << ex << endl;
+        status = EXIT_FAILURE;
+    }
+
+    if(communicator)
+    {
+        communicator->destroy();
+    }
+
+    return status;
+}
@@ -0,0 +1,214 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#include <Ice/Ice.h>
+#include <IceGrid/IceGrid.h>
+#include <TestCommon.h>
+
+using namespace std;
+using namespace IceGrid;
+
+namespace
+{
+
+//
+// Get all the adapter ids matching the expression with pages of at
+// most max ids.
+//
+Ice::StringSeq
+getAllAdapterIds(const AdminPrx& admin, const string& expression, int max)
+{
+    Ice::StringSeq ids;
+    string after;
+    while(true)
+    {
+        Ice::StringSeq page = admin->getAdapterIdsPage(expression, after, max);
+        test(page.size() <= static_cast<size_t>(max));
+        ids.insert(ids.end(), page.begin(), page.end());
+        if(page.size() < static_cast<size_t>(max))
+        {
+            return ids;
+        }
+        after = page.back();
+    }
+}
+
+Ice::StringSeq
+getAllObjectIds(const AdminPrx& admin, const string& expression, int max)
+{
+    Ice::StringSeq ids;
+    string after;
+    while(true)
+    {
+        ObjectInfoSeq page = admin->getObjectInfosPage(expression, after, max);
+        test(page.size() <= static_cast<size_t>(max));
+        for(ObjectInfoSeq::const_iterator p = page.begin(); p != page.end(); ++p)
+        {
+            ids.push_back(Ice::identityToString(p->proxy->ice_getIdentity()));
+        }
+        if(page.size() < static_cast<size_t>(max))
+        {
+            return ids;
+        }
+        after = ids.back();
+    }
+}
+
+Ice::StringSeq
+toIds(const ObjectInfoSeq& infos)
+{
+    Ice::StringSeq ids;
+    for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+    {
+        ids.push_back(Ice::identityToString(p->proxy->ice_getIdentity()));
+    }
+    return ids;
+}
+
+}
+
+void
+allTests(const Ice::CommunicatorPtr& communicator)
+{
+    RegistryPrx registry = RegistryPrx::checkedCast(communicator->stringToProxy("TestIceGrid/Registry"));
+    test(registry);
+    AdminSessionPrx session = registry->createAdminSession("foo", "bar");
+    AdminPrx admin = session->getAdmin();
+
+    //
+    // The even adapter ids and object identities are registered with
+    // the database, the odd ones are application replica groups and
+    // well-known objects, the pages merge both.
+    //
+    Ice::StringSeq adapterIds;
+    Ice::StringSeq objectIds;
+    ReplicaGroupDescriptor objectGroup;
+    objectGroup.id = "PagingGroup";
+    objectGroup.loadBalancing = new RandomLoadBalancingPolicy();
+    objectGroup.loadBalancing->nReplicas = "0";
+    ApplicationDescriptor application;
+    application.name = "Paging";
+    Ice::LocatorRegistryPrx locatorRegistry = communicator->getDefaultLocator()->getRegistry();
+    for(int i = 0; i < 10; ++i)
+    {
+        ostringstream os;
+        os << i;
+        adapterIds.push_back("Paging." + os.str());
+        objectIds.push_back("paging/" + os.str());
+        if(i % 2 == 0)
+        {
+            locatorRegistry->setAdapterDirectProxy(adapterIds.back(),
+                                                   communicator->stringToProxy("dummy:tcp -h 127.0.0.1 -p 12345"));
+            admin->addObjectWithType(communicator->stringToProxy(objectIds.back() + ":tcp -h 127.0.0.1 -p 12345"),
+                                     "::Test");
+        }
+        else
+        {
+            ReplicaGroupDescriptor replicaGroup;
+            replicaGroup.id = adapterIds.back();
+            replicaGroup.loadBalancing = new RandomLoadBalancingPolicy();
+            replicaGroup.loadBalancing->nReplicas = "0";
+            application.replicaGroups.push_back(replicaGroup);
+
+            ObjectDescriptor object;
+            object.id = Ice::stringToIdentity(objectIds.back());
+            object.type = "::Test";
+            objectGroup.objects.push_back(object);
+        }
+    }
+    application.replicaGroups.push_back(objectGroup);
+    admin->addApplication(application);
+
+    cout << "testing adapter id pages... " << flush;
+    {
+        test(admin->getAdapterIdsPage("Paging.*", "", 0) == adapterIds);
+        test(getAllAdapterIds(admin, "Paging.*", 3) == adapterIds);
+        test(getAllAdapterIds(admin, "Paging.*", 1) == adapterIds);
+        test(getAllAdapterIds(admin, "Paging.*", 10) == adapterIds);
+
+        Ice::StringSeq page = admin->getAdapterIdsPage("Paging.*", "", 4);
+        test(Ice::StringSeq(adapterIds.begin(), adapterIds.begin() + 4) == page);
+        page = admin->getAdapterIdsPage("Paging.*", page.back(), 4);
+        test(Ice::StringSeq(adapterIds.begin() + 4, adapterIds.begin() + 8) == page);
+
+        //
+        // The cursor doesn't need to be an existing id.
+        //
+        page = admin->getAdapterIdsPage("Paging.*", "Paging.45", 0);
+        test(Ice::StringSeq(adapterIds.begin() + 5, adapterIds.end()) == page);
+        test(admin->getAdapterIdsPage("Paging.*", "Paging.9", 0).empty());
+        test(admin->getAdapterIdsPage("Paging.*", "Paging.99", 10).empty());
+        page = admin->getAdapterIdsPage("Paging.*", "A", 2);
+        test(Ice::StringSeq(adapterIds.begin(), adapterIds.begin() + 2) == page);
+
+        //
+        // The expressions with the wildcard in the middle or without
+        // wildcard.
+        //
+        page = admin->getAdapterIdsPage("Pag*.3", "", 0);
+        test(page.size() == 1 && page[0] == "Paging.3");
+        page = admin->getAdapterIdsPage("Paging.4", "", 0);
+        test(page.size() == 1 && page[0] == "Paging.4");
+        test(admin->getAdapterIdsPage("Paging.4", "Paging.4", 0).empty());
+        test(admin->getAdapterIdsPage("Unknown*", "", 0).empty());
+
+        page = admin->getAdapterIdsPage("Paging*", "", 0);
+        test(page.size() == adapterIds.size() + 1 && page.back() == "PagingGroup");
+
+        Ice::StringSeq all = admin->getAdapterIdsPage("", "", 0);
+        test(all == admin->getAllAdapterIds());
+        test(getAllAdapterIds(admin, "", 2) == all);
+    }
+    cout << "ok" << endl;
+
+    cout << "testing object info pages... " << flush;
+    {
+        test(toIds(admin->getObjectInfosPage("paging/*", "", 0)) == objectIds);
+        test(getAllObjectIds(admin, "paging/*", 3) == objectIds);
+        test(getAllObjectIds(admin, "paging/*", 1) == objectIds);
+        test(getAllObjectIds(admin, "paging/*", 10) == objectIds);
+
+        Ice::StringSeq page = toIds(admin->getObjectInfosPage("paging/*", "", 4));
+        test(Ice::StringSeq(objectIds.begin(), objectIds.begin() + 4) == page);
+        page = toIds(admin->getObjectInfosPage("paging/*", page.back(), 4));
+        test(Ice::StringSeq(objectIds.begin() + 4, objectIds.begin() + 8) == page);
+
+        page = toIds(admin->getObjectInfosPage("paging/*", "paging/45", 0));
+        test(Ice::StringSeq(objectIds.begin() + 5, objectIds.end()) == page);
+        test(admin->getObjectInfosPage("paging/*", "paging/9", 0).empty());
+
+        page = toIds(admin->getObjectInfosPage("pag*/3", "", 0));
+        test(page.size() == 1 && page[0] == "paging/3");
+        page = toIds(admin->getObjectInfosPage("paging/4", "", 0));
+        test(page.size() == 1 && page[0] == "paging/4");
+        test(admin->getObjectInfosPage("unknown*", "", 0).empty());
+
+        ObjectInfoSeq infos = admin->getObjectInfosPage("paging/*", "", 0);
+        for(ObjectInfoSeq::const_iterator p = infos.begin(); p != infos.end(); ++p)
+        {
+            test(p->type == "::Test");
+        }
+
+        Ice::StringSeq all = toIds(admin->getObjectInfosPage("", "", 0));
+        test(all.size() == admin->getAllObjectInfos("").size());
+        test(getAllObjectIds(admin, "", 2) == all);
+    }
+    cout << "ok" << endl;
+
+    admin->removeApplication("Paging");
+    for(size_t i = 0; i < adapterIds.size(); i += 2)
+    {
+        locatorRegistry->setAdapterDirectProxy(adapterIds[i], 0);
+        admin->removeObject(Ice::stringToIdentity(objectIds[i]));
+    }
+    test(admin->getAdapterIdsPage("Paging*", "", 0).empty());
+    test(admin->getObjectInfosPage("paging/*", "", 0).empty());
+
+    session->destroy();
+}
@@ -34,7 +34,7 @@ if TestUtil.appverifier:
     targets = [ TestUtil.getIceGridNode(), TestUtil.getIceGridRegistry(), router]
     TestUtil.setAppVerifierSettings(targets)
 
-registryProcs = IceGridAdmin.startIceGridRegistry(testdir)
+registryProcs = IceGridAdmin.startIceGridRegistry(testdir, True)
 nodeProc = IceGridAdmin.startIceGridNode(testdir)
 
 sys.stdout.write("starting glacier2... ")
@@ -248,6 +248,16 @@ except Exception as e:
 # admin.sendline('exit')
 # admin.waitTestSuccess(timeout=120)
 
+#
+# The client tests the adapter id and object info pages (there's no
+# client project for Windows).
+#
+if not TestUtil.isWin32():
+    client = os.path.join(testdir, TestUtil.getDefaultClientFile())
+    clientProc = TestUtil.startClient(client, IceGridAdmin.getDefaultLocatorProperty(), startReader = False)
+    clientProc.startReader()
+    clientProc.waitTestSuccess()
+
 sys.stdout.write("stopping glacier2... ")
 sys.stdout.flush()
 routerProc.kill(signal.SIGINT)
@@ -10,6 +10,7 @@
 #include <Ice/Ice.h>
 #include <IceGrid/IceGrid.h>
 #include <IceUtil/Thread.h>
+#include <IceUtil/Monitor.h>
 #include <TestCommon.h>
 #include <Test.h>
 
@@ -53,6 +54,58 @@ bool isLongLineEnd(const string& line)
     return line.size() > 1 && line[line.size() - 2] == 'b' && line[line.size() - 1] == 'c';
 }
 
+class FileObserverI : public FileObserver, public IceUtil::Monitor<IceUtil::Mutex>
+{
+public:
+
+    FileObserverI() : _batches(0)
+    {
+    }
+
+    virtual void
+    linesAdded(const Ice::StringSeq& lines, const Ice::Current&)
+    {
+        Lock sync(*this);
+        for(Ice::StringSeq::const_iterator p = lines.begin(); p != lines.end(); ++p)
+        {
+            if(p != lines.begin())
+            {
+                _text += '\n';
+            }
+            _text += *p;
+        }
+        ++_batches;
+        notifyAll();
+    }
+
+    string
+    waitForText(size_t size)
+    {
+        Lock sync(*this);
+        while(_text.size() < size)
+        {
+            if(!timedWait(IceUtil::Time::seconds(10)))
+            {
+                break;
+            }
+        }
+        return _text;
+    }
+
+    int
+    getBatches()
+    {
+        Lock sync(*this);
+        return _batches;
+    }
+
+private:
+
+    string _text;
+    int _batches;
+};
+typedef IceUtil::Handle<FileObserverI> FileObserverIPtr;
+
 }
 
 struct ProxyIdentityEqual : public std::binary_function<Ice::ObjectPrx,string,bool>
@@ -372,6 +425,99 @@ logTests(const Ice::CommunicatorPtr& comm, const AdminSessionPrx& session)
         test(false);
     }
 
+    try
+    {
+        //
+        // Read the file with small sizes, the reads stop in the middle
+        // of the lines or right before a line and continue from the
+        // position of the open file. The lines read must add up to the
+        // file contents, without skipped or duplicated data.
+        //
+        string path = testDir + "/log1.txt";
+        ofstream os(path.c_str(), ios_base::out | ios_base::trunc);
+        ostringstream contents;
+        for(int i = 0; i < 30; ++i)
+        {
+            contents << "line " << i << ' ' << string(static_cast<size_t>(i % 7) * 3, 'x') << '\n';
+        }
+        os << contents.str() << flush;
+
+        for(int size = 6; size < 48; ++size)
+        {
+            it = session->openServerLog("LogServer", path, -1);
+            string read;
+            bool eof = false;
+            for(int i = 0; !eof; ++i)
+            {
+                eof = it->read(size + (i % 3) * 4, lines);
+                for(Ice::StringSeq::const_iterator p = lines.begin(); p != lines.end(); ++p)
+                {
+                    if(p != lines.begin())
+                    {
+                        read += '\n';
+                    }
+                    read += *p;
+                }
+            }
+            test(read == contents.str());
+            test(it->read(size, lines) && lines.empty());
+            it->destroy();
+        }
+    }
+    catch(const FileNotAvailableException& ex)
+    {
+        cerr << ex.reason << endl;
+        test(false);
+    }
+
+    try
+    {
+        //
+        // Follow the file, the lines appended to the file are sent in
+        // batches to the observer. Once the file is no longer followed,
+        // the iterator reads the lines following the lines sent to the
+        // observer.
+        //
+        string path = testDir + "/log1.txt";
+        ofstream os(path.c_str(), ios_base::out | ios_base::trunc);
+        os << "line 0" << endl;
+
+        it = session->openServerLog("LogServer", path, -1);
+        test(it->read(1024, lines) && lines.size() == 2 && lines[0] == "line 0" && lines[1].empty());
+
+        Ice::ObjectAdapterPtr adapter = comm->createObjectAdapterWithEndpoints("FileObserver", "default");
+        FileObserverIPtr observer = new FileObserverI();
+        FileObserverPrx prx = FileObserverPrx::uncheckedCast(adapter->addWithUUID(observer));
+        adapter->activate();
+
+        it->follow(prx);
+        test(it->read(1024, lines) && lines.empty());
+
+        ostringstream contents;
+        for(int i = 1; i < 100; ++i)
+        {
+            contents << "line " << i << '\n';
+        }
+        os << contents.str() << flush;
+        test(observer->waitForText(contents.str().size()) == contents.str());
+        test(observer->getBatches() > 0 && observer->getBatches() < 99);
+
+        os << "line 100" << endl;
+        test(observer->waitForText(contents.str().size() + 9) == contents.str() + "line 100\n");
+
+        it->follow(0);
+        os << "line 101" << endl;
+        test(it->read(1024, lines) && lines.size() == 2 && lines[0] == "line 101" && lines[1].empty());
+        it->destroy();
+
+        adapter->destroy();
+    }
+    catch(const FileNotAvailableException& ex)
+    {
+        cerr << ex.reason << endl;
+        test(false);
+    }
+
     cout << "ok" << endl;
 }
 
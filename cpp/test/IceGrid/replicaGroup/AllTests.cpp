@@ -101,6 +101,101 @@ removeServer(const AdminPrx& admin, const string& id)
     }
 }
 
+void
+deployServer(const AdminPrx& admin, const string& templ, const string& node, const map<string, string>& params)
+{
+    ServerInstanceDescriptor desc;
+    desc._cpp_template = templ;
+    desc.parameterValues = params;
+    NodeUpdateDescriptor nodeUpdate;
+    nodeUpdate.name = node;
+    nodeUpdate.serverInstances.push_back(desc);
+    ApplicationUpdateDescriptor update;
+    update.name = "Test";
+    update.nodes.push_back(nodeUpdate);
+    try
+    {
+        admin->updateApplication(update);
+    }
+    catch(const DeploymentException& ex)
+    {
+        cerr << ex.reason << endl;
+        test(false);
+    }
+}
+
+void
+waitForServerState(const AdminPrx& admin, const string& id, ServerState state)
+{
+    int nRetry = 0;
+    while(admin->getServerState(id) != state && nRetry < 100)
+    {
+        IceUtil::ThreadControl::sleep(IceUtil::Time::milliSeconds(100));
+        ++nRetry;
+    }
+    test(admin->getServerState(id) == state);
+}
+
+void
+standbyTests(const Ice::CommunicatorPtr& comm, const AdminPrx& admin)
+{
+    cout << "testing standby replicas... " << flush;
+    {
+        //
+        // The registry activates up to 2 standby replicas, one for
+        // each on-demand activation of the replica group members.
+        //
+        map<string, string> params;
+        params["replicaGroup"] = "Ordered";
+        params["id"] = "Server1";
+        params["priority"] = "1";
+        deployServer(admin, "Server", "localnode", params);
+        params["id"] = "Server2";
+        params["priority"] = "2";
+        deployServer(admin, "Server", "localnode", params);
+        params["id"] = "Server3";
+        params["priority"] = "3";
+        deployServer(admin, "Server", "localnode", params);
+
+        TestIntfPrx obj = TestIntfPrx::uncheckedCast(comm->stringToProxy("Ordered"));
+        obj = obj->ice_locatorCacheTimeout(0);
+        obj = obj->ice_connectionCached(false);
+
+        //
+        // The on-demand activation of Server1 activates one standby
+        // replica.
+        //
+        test(obj->getReplicaId() == "Server1.ReplicatedAdapter");
+        waitForServerState(admin, "Server2", IceGrid::Active);
+        IceUtil::ThreadControl::sleep(IceUtil::Time::milliSeconds(500));
+        test(admin->getServerState("Server3") == IceGrid::Inactive);
+
+        //
+        // The standby replica is activated again when the replica
+        // group is resolved once it's deactivated.
+        //
+        admin->stopServer("Server2");
+        waitForServerState(admin, "Server2", IceGrid::Inactive);
+        IceUtil::ThreadControl::sleep(IceUtil::Time::milliSeconds(1100));
+        test(obj->getReplicaId() == "Server1.ReplicatedAdapter");
+        waitForServerState(admin, "Server2", IceGrid::Active);
+
+        //
+        // Another on-demand activation of Server1 activates a second
+        // standby replica.
+        //
+        admin->stopServer("Server1");
+        waitForServerState(admin, "Server1", IceGrid::Inactive);
+        test(obj->getReplicaId() == "Server1.ReplicatedAdapter");
+        waitForServerState(admin, "Server3", IceGrid::Active);
+
+        removeServer(admin, "Server1");
+        removeServer(admin, "Server2");
+        removeServer(admin, "Server3");
+    }
+    cout << "ok" << endl;
+}
+
 void
 allTests(const Ice::CommunicatorPtr& comm)
 {
@@ -117,6 +212,17 @@ allTests(const Ice::CommunicatorPtr& comm)
     AdminPrx admin = session->getAdmin();
     test(admin);
 
+    //
+    // The standby replicas are tested with a registry configured to
+    // activate standby replicas, the other tests don't expect them.
+    //
+    if(comm->getProperties()->getPropertyAsInt("Standby") > 0)
+    {
+        standbyTests(comm, admin);
+        session->destroy();
+        return;
+    }
+
     set<string> serverReplicaIds;
     serverReplicaIds.insert("Server1.ReplicatedAdapter");
     serverReplicaIds.insert("Server2.ReplicatedAdapter");
@@ -37,3 +37,10 @@ TestUtil.addAdditionalBinDirectories([os.path.join(os.getcwd(), TestUtil.getTest
 
 IceGridAdmin.iceGridTest("application.xml",
     "--Ice.RetryIntervals=\"0 50 100 250\"", "icebox.exe='%s' server.dir='%s'" % (TestUtil.getIceBox(), TestUtil.getTestDirectory("server")))
+
+#
+# Test the standby replicas with a registry configured to activate them.
+#
+IceGridAdmin.registryOptions += " --IceGrid.Registry.StandbyReplicas=2"
+IceGridAdmin.iceGridTest("application.xml",
+    "--Ice.RetryIntervals=\"0 50 100 250\" --Standby", "icebox.exe='%s' server.dir='%s'" % (TestUtil.getIceBox(), TestUtil.getTestDirectory("server")))
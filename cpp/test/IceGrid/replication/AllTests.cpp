@@ -776,6 +776,210 @@ allTests(const Ice::CommunicatorPtr& comm)
     }
     cout << "ok" << endl;
 
+    //
+    // Bulk object operations test:
+    //
+    // - slave1 is up for each operation, slave2 is down
+    // - ensure the objects are correctly replicated, the last object
+    //   of a bulk update updates the replica database serial
+    // - ensure a failed bulk operation doesn't change any registry
+    //
+    cout << "testing bulk object operations... " << flush;
+    {
+        ObjectInfoSeq objs;
+        Ice::ObjectProxySeq proxies;
+        Ice::IdentitySeq ids;
+        for(int i = 0; i < 50; ++i)
+        {
+            ostringstream os;
+            os << "bulk" << i;
+            ObjectInfo obj;
+            obj.proxy = comm->stringToProxy(os.str() + ":tcp -p 12345 -h 127.0.0.1");
+            obj.type = "::Hello";
+            objs.push_back(obj);
+            proxies.push_back(comm->stringToProxy(os.str() + ":tcp -p 12346 -h 127.0.0.1"));
+            ids.push_back(obj.proxy->ice_getIdentity());
+        }
+
+        try
+        {
+            slave1Admin->addObjects(objs);
+            test(false);
+        }
+        catch(const DeploymentException&)
+        {
+            // Slave can't modify the database
+        }
+        masterAdmin->addObjects(objs);
+
+        admin->startServer("Slave2");
+        slave2Admin = createAdminSession(slave2Locator, "Slave2");
+        for(ObjectInfoSeq::const_iterator p = objs.begin(); p != objs.end(); ++p)
+        {
+            test(masterAdmin->getObjectInfo(p->proxy->ice_getIdentity()) == *p);
+            test(slave1Admin->getObjectInfo(p->proxy->ice_getIdentity()) == *p);
+            test(slave2Admin->getObjectInfo(p->proxy->ice_getIdentity()) == *p);
+        }
+        slave2Admin->shutdown();
+        waitForServerState(admin, "Slave2", false);
+
+        ObjectInfoSeq failed;
+        failed.push_back(objs[0]);
+        failed.back().proxy = comm->stringToProxy("bulkFailed:tcp -p 12345 -h 127.0.0.1");
+        failed.push_back(objs[1]);
+        try
+        {
+            masterAdmin->addObjects(failed);
+            test(false);
+        }
+        catch(const ObjectExistsException&)
+        {
+        }
+        try
+        {
+            masterAdmin->getObjectInfo(failed[0].proxy->ice_getIdentity());
+            test(false);
+        }
+        catch(const ObjectNotRegisteredException&)
+        {
+        }
+        try
+        {
+            slave1Admin->getObjectInfo(failed[0].proxy->ice_getIdentity());
+            test(false);
+        }
+        catch(const ObjectNotRegisteredException&)
+        {
+        }
+
+        try
+        {
+            slave1Admin->updateObjects(proxies);
+            test(false);
+        }
+        catch(const DeploymentException&)
+        {
+            // Slave can't modify the database
+        }
+        masterAdmin->updateObjects(proxies);
+
+        admin->startServer("Slave2");
+        slave2Admin = createAdminSession(slave2Locator, "Slave2");
+        for(Ice::ObjectProxySeq::const_iterator p = proxies.begin(); p != proxies.end(); ++p)
+        {
+            test(masterAdmin->getObjectInfo((*p)->ice_getIdentity()).proxy == *p);
+            test(slave1Admin->getObjectInfo((*p)->ice_getIdentity()).proxy == *p);
+            test(slave2Admin->getObjectInfo((*p)->ice_getIdentity()).proxy == *p);
+        }
+        slave2Admin->shutdown();
+        waitForServerState(admin, "Slave2", false);
+
+        try
+        {
+            slave1Admin->removeObjects(ids);
+            test(false);
+        }
+        catch(const DeploymentException&)
+        {
+            // Slave can't modify the database
+        }
+        masterAdmin->removeObjects(ids);
+
+        admin->startServer("Slave2");
+        slave2Admin = createAdminSession(slave2Locator, "Slave2");
+        for(Ice::IdentitySeq::const_iterator p = ids.begin(); p != ids.end(); ++p)
+        {
+            try
+            {
+                masterAdmin->getObjectInfo(*p);
+                test(false);
+            }
+            catch(const ObjectNotRegisteredException&)
+            {
+            }
+            try
+            {
+                slave1Admin->getObjectInfo(*p);
+                test(false);
+            }
+            catch(const ObjectNotRegisteredException&)
+            {
+            }
+            try
+            {
+                slave2Admin->getObjectInfo(*p);
+                test(false);
+            }
+            catch(const ObjectNotRegisteredException&)
+            {
+            }
+        }
+        slave2Admin->shutdown();
+        waitForServerState(admin, "Slave2", false);
+    }
+    cout << "ok" << endl;
+
+    cout << "testing replica initialization with a truncated update log... " << flush;
+    {
+        //
+        // The master only keeps the 10000 most recent removals in its
+        // update log. A replica whose database serial is older than
+        // the first dropped removal must be fully initialized,
+        // otherwise it would keep the removed objects.
+        //
+        ObjectInfo removed;
+        removed.proxy = comm->stringToProxy("truncatedRemoved:tcp -p 12345 -h 127.0.0.1");
+        removed.type = "::Hello";
+
+        admin->startServer("Slave2");
+        slave2Admin = createAdminSession(slave2Locator, "Slave2");
+        masterAdmin->addObjectWithType(removed.proxy, removed.type);
+        test(slave2Admin->getObjectInfo(removed.proxy->ice_getIdentity()) == removed);
+        slave2Admin->shutdown();
+        waitForServerState(admin, "Slave2", false);
+
+        masterAdmin->removeObject(removed.proxy->ice_getIdentity());
+
+        ObjectInfoSeq objs;
+        Ice::IdentitySeq ids;
+        for(int i = 0; i < 10001; ++i)
+        {
+            ostringstream os;
+            os << "truncated" << i;
+            ObjectInfo obj;
+            obj.proxy = comm->stringToProxy(os.str() + ":tcp -p 12345 -h 127.0.0.1");
+            obj.type = "::Hello";
+            objs.push_back(obj);
+            ids.push_back(obj.proxy->ice_getIdentity());
+        }
+        masterAdmin->addObjects(objs);
+        masterAdmin->removeObjects(ids);
+
+        ObjectInfo added;
+        added.proxy = comm->stringToProxy("truncatedAdded:tcp -p 12345 -h 127.0.0.1");
+        added.type = "::Hello";
+        masterAdmin->addObjectWithType(added.proxy, added.type);
+
+        admin->startServer("Slave2");
+        slave2Admin = createAdminSession(slave2Locator, "Slave2");
+        try
+        {
+            slave2Admin->getObjectInfo(removed.proxy->ice_getIdentity());
+            test(false);
+        }
+        catch(const ObjectNotRegisteredException&)
+        {
+        }
+        test(slave2Admin->getObjectInfo(added.proxy->ice_getIdentity()) == added);
+        test(slave2Admin->getObjectInfosPage("truncated*", "", 0).size() == 1);
+        test(slave1Admin->getObjectInfosPage("truncated*", "", 0).size() == 1);
+
+        masterAdmin->removeObject(added.proxy->ice_getIdentity());
+        slave2Admin->shutdown();
+        waitForServerState(admin, "Slave2", false);
+    }
+    cout << "ok" << endl;
+
     params.clear();
     params["id"] = "Node1";
     instantiateServer(admin, "IceGridNode", params);
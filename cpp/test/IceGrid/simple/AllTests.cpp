@@ -8,6 +8,7 @@
 // **********************************************************************
 
 #include <IceUtil/IceUtil.h>
+#include <IceUtil/InputUtil.h>
 #include <Ice/Ice.h>
 #include <IceGrid/IceGrid.h>
 #include <TestCommon.h>
@@ -136,6 +137,89 @@ allTests(const Ice::CommunicatorPtr& communicator)
     }
     cout << "ok" << endl;
 
+    cout << "testing locator cache invalidation... " << flush;
+    {
+        IceGrid::RegistryPrx registry = IceGrid::RegistryPrx::checkedCast(
+            communicator->stringToProxy(communicator->getDefaultLocator()->ice_getIdentity().category + "/Registry"));
+        IceGrid::AdminSessionPrx session = registry->createAdminSession("foo", "bar");
+        IceGrid::AdminPrx admin = session->getAdmin();
+        Ice::LocatorPrx defaultLocator = communicator->getDefaultLocator();
+
+        //
+        // Well-known object updates and removals must be visible to
+        // the next lookup even though the proxy is cached.
+        //
+        Ice::ObjectPrx prx = communicator->stringToProxy("cacheObject:tcp -h 127.0.0.1 -p 12345");
+        admin->addObjectWithType(prx, "::Test");
+        defaultLocator->findObjectById(prx->ice_getIdentity());
+        Ice::ObjectPrx found = defaultLocator->findObjectById(prx->ice_getIdentity());
+        test(found->ice_getEndpoints()[0]->toString().find("-p 12345") != string::npos);
+
+        admin->updateObject(communicator->stringToProxy("cacheObject:tcp -h 127.0.0.1 -p 12346"));
+        found = defaultLocator->findObjectById(prx->ice_getIdentity());
+        test(found->ice_getEndpoints()[0]->toString().find("-p 12346") != string::npos);
+
+        admin->removeObject(prx->ice_getIdentity());
+        try
+        {
+            defaultLocator->findObjectById(prx->ice_getIdentity());
+            test(false);
+        }
+        catch(const Ice::ObjectNotFoundException&)
+        {
+        }
+
+        //
+        // Same for the adapter direct proxies.
+        //
+        Ice::LocatorRegistryPrx locatorRegistry = defaultLocator->getRegistry();
+        locatorRegistry->setAdapterDirectProxy("cacheAdapter", communicator->stringToProxy("dummy:tcp -h 127.0.0.1 -p 12345"));
+        defaultLocator->findAdapterById("cacheAdapter");
+        found = defaultLocator->findAdapterById("cacheAdapter");
+        test(found->ice_getEndpoints()[0]->toString().find("-p 12345") != string::npos);
+
+        locatorRegistry->setAdapterDirectProxy("cacheAdapter", communicator->stringToProxy("dummy:tcp -h 127.0.0.1 -p 12346"));
+        found = defaultLocator->findAdapterById("cacheAdapter");
+        test(found->ice_getEndpoints()[0]->toString().find("-p 12346") != string::npos);
+
+        admin->removeAdapter("cacheAdapter");
+        try
+        {
+            defaultLocator->findAdapterById("cacheAdapter");
+            test(false);
+        }
+        catch(const Ice::AdapterNotFoundException&)
+        {
+        }
+
+        //
+        // The repeated lookups are served from the cache of the
+        // registries which answered them.
+        //
+        Ice::Long hits = 0;
+        Ice::StringSeq names = admin->getAllRegistryNames();
+        for(Ice::StringSeq::const_iterator p = names.begin(); p != names.end(); ++p)
+        {
+            Ice::PropertiesAdminPrx stats =
+                Ice::PropertiesAdminPrx::uncheckedCast(admin->getRegistryAdmin(*p), "LocatorCache");
+            Ice::PropertyDict props = stats->getPropertiesForPrefix("IceGrid.Registry.LocatorCache.");
+            test(props.size() == 4);
+            hits += IceUtilInternal::strToInt64(props["IceGrid.Registry.LocatorCache.Hits"].c_str(), 0, 0);
+            try
+            {
+                stats->setProperties(Ice::PropertyDict());
+                test(false);
+            }
+            catch(const Ice::OperationNotExistException&)
+            {
+            }
+        }
+        test(hits > 0);
+
+        session->destroy();
+    }
+    cout << "ok" << endl;
+
     cout << "shutting down server... " << flush;
     obj->shutdown();
     cout << "ok" << endl;
@@ -62,6 +62,87 @@ hasProperty(const CommunicatorDescriptorPtr& desc, const string& name, const str
     return false;
 }
 
+class NodeObserverI : public NodeObserver, public IceUtil::Monitor<IceUtil::Mutex>
+{
+public:
+
+    NodeObserverI() : _initialized(false)
+    {
+    }
+
+    virtual void
+    nodeInit(const NodeDynamicInfoSeq&, const Ice::Current&)
+    {
+        Lock sync(*this);
+        _initialized = true;
+        notifyAll();
+    }
+
+    virtual void
+    nodeUp(const NodeDynamicInfo&, const Ice::Current&)
+    {
+    }
+
+    virtual void
+    nodeDown(const string&, const Ice::Current&)
+    {
+    }
+
+    virtual void
+    updateServer(const string&, const ServerDynamicInfo& info, const Ice::Current&)
+    {
+        Lock sync(*this);
+        _servers[info.id] = info;
+        ++_updates[info.id];
+        notifyAll();
+    }
+
+    virtual void
+    updateAdapter(const string&, const AdapterDynamicInfo&, const Ice::Current&)
+    {
+    }
+
+    void
+    waitForInit()
+    {
+        Lock sync(*this);
+        while(!_initialized)
+        {
+            test(timedWait(IceUtil::Time::seconds(10)));
+        }
+    }
+
+    //
+    // Wait for the given server to be enabled or disabled and return
+    // the number of updates received for this server.
+    //
+    int
+    waitForEnabled(const string& id, bool enabled)
+    {
+        Lock sync(*this);
+        map<string, ServerDynamicInfo>::const_iterator p;
+        while((p = _servers.find(id)) == _servers.end() || p->second.enabled != enabled)
+        {
+            test(timedWait(IceUtil::Time::seconds(10)));
+        }
+        return _updates[id];
+    }
+
+    int
+    getUpdates(const string& id)
+    {
+        Lock sync(*this);
+        return _updates[id];
+    }
+
+private:
+
+    bool _initialized;
+    map<string, ServerDynamicInfo> _servers;
+    map<string, int> _updates;
+};
+typedef IceUtil::Handle<NodeObserverI> NodeObserverIPtr;
+
 void
 allTests(const Ice::CommunicatorPtr& communicator)
 {
@@ -1308,5 +1389,212 @@ allTests(const Ice::CommunicatorPtr& communicator)
         cout << "ok" << endl;
     }
 
+    {
+        cout << "testing deployment of more servers than the deployment parallelism... " << flush;
+
+        //
+        // The registry sends at most IceGrid.Registry.DeploymentParallelism
+        // (16 by default) load or destroy commands to a node at a time,
+        // the other commands are queued.
+        //
+        const int count = 40;
+        ApplicationDescriptor parallelApp;
+        parallelApp.name = "ParallelApp";
+        for(int i = 0; i < count; ++i)
+        {
+            ostringstream os;
+            os << "Parallel" << i;
+            ServerDescriptorPtr server = new ServerDescriptor();
+            server->id = os.str();
+            server->exe = properties->getProperty("ServerDir") + "/server";
+            server->pwd = ".";
+            server->applicationDistrib = false;
+            server->allocatable = false;
+            addProperty(server, "Ice.Admin.Endpoints", "tcp -h 127.0.0.1");
+            parallelApp.nodes["localnode"].servers.push_back(server);
+        }
+
+        try
+        {
+            admin->addApplication(parallelApp);
+        }
+        catch(const DeploymentException& ex)
+        {
+            cerr << ex.reason << endl;
+            test(false);
+        }
+
+        //
+        // Replace the first half of the servers: the destroy commands
+        // of the removed servers are queued with the load commands of
+        // the added servers.
+        //
+        ApplicationUpdateDescriptor update;
+        update.name = "ParallelApp";
+        NodeUpdateDescriptor nodeUpdate;
+        nodeUpdate.name = "localnode";
+        for(int i = 0; i < count / 2; ++i)
+        {
+            nodeUpdate.removeServers.push_back(parallelApp.nodes["localnode"].servers[i]->id);
+            ServerDescriptorPtr server = ServerDescriptorPtr::dynamicCast(
+                parallelApp.nodes["localnode"].servers[i]->ice_clone());
+            server->id += "-new";
+            nodeUpdate.servers.push_back(server);
+        }
+        update.nodes.push_back(nodeUpdate);
+        try
+        {
+            admin->updateApplication(update);
+        }
+        catch(const DeploymentException& ex)
+        {
+            cerr << ex.reason << endl;
+            test(false);
+        }
+
+        Ice::StringSeq ids;
+        for(int i = 0; i < count; ++i)
+        {
+            ostringstream os;
+            os << "Parallel" << i;
+            ids.push_back(i < count / 2 ? os.str() + "-new" : os.str());
+        }
+
+        //
+        // All the servers must be loaded, the state of a server is
+        // only available once it's loaded on the node.
+        //
+        for(Ice::StringSeq::const_iterator p = ids.begin(); p != ids.end(); ++p)
+        {
+            int retry = 0;
+            while(true)
+            {
+                try
+                {
+                    test(admin->getServerState(*p) == Inactive);
+                    break;
+                }
+                catch(const DeploymentException&)
+                {
+                    test(++retry < 100);
+                    IceUtil::ThreadControl::sleep(IceUtil::Time::milliSeconds(100));
+                }
+            }
+        }
+        for(int i = 0; i < count / 2; ++i)
+        {
+            try
+            {
+                admin->getServerState(parallelApp.nodes["localnode"].servers[i]->id);
+                test(false);
+            }
+            catch(const ServerNotExistException&)
+            {
+            }
+        }
+
+        admin->startServer(ids.front());
+        test(admin->getServerState(ids.front()) == Active);
+        admin->stopServer(ids.front());
+
+        try
+        {
+            admin->removeApplication("ParallelApp");
+        }
+        catch(const DeploymentException& ex)
+        {
+            cerr << ex.reason << endl;
+            test(false);
+        }
+
+        cout << "ok" << endl;
+    }
+
+    {
+        cout << "testing node observer update batching... " << flush;
+
+        ApplicationDescriptor batchApp;
+        batchApp.name = "BatchApp";
+        ServerDescriptorPtr server = new ServerDescriptor();
+        server->id = "BatchServer";
+        server->exe = properties->getProperty("ServerDir") + "/server";
+        server->pwd = ".";
+        server->applicationDistrib = false;
+        server->allocatable = false;
+        addProperty(server, "Ice.Admin.Endpoints", "tcp -h 127.0.0.1");
+        batchApp.nodes["localnode"].servers.push_back(server);
+        try
+        {
+            admin->addApplication(batchApp);
+        }
+        catch(const DeploymentException& ex)
+        {
+            cerr << ex.reason << endl;
+            test(false);
+        }
+
+        int retry = 0;
+        while(true)
+        {
+            try
+            {
+                test(admin->getServerState("BatchServer") == Inactive);
+                break;
+            }
+            catch(const DeploymentException&)
+            {
+                test(++retry < 100);
+                IceUtil::ThreadControl::sleep(IceUtil::Time::milliSeconds(100));
+            }
+        }
+
+        Ice::ObjectAdapterPtr adapter = communicator->createObjectAdapter("");
+        NodeObserverIPtr observer = new NodeObserverI();
+        Ice::ObjectPrx prx = adapter->addWithUUID(observer);
+        adapter->activate();
+        session->ice_getConnection()->setAdapter(adapter);
+        session->setObserversByIdentity(Ice::Identity(), prx->ice_getIdentity(), Ice::Identity(), Ice::Identity(),
+                                        Ice::Identity());
+        observer->waitForInit();
+
+        //
+        // The registry is started with a 500ms batch delay: the
+        // observer is only sent the last state of the server for the
+        // changes received during the delay.
+        //
+        const int changes = 21;
+        for(int i = 0; i < changes; ++i)
+        {
+            admin->enableServer("BatchServer", i % 2 == 1);
+        }
+        test(!admin->isServerEnabled("BatchServer"));
+
+        int updates = observer->waitForEnabled("BatchServer", false);
+        test(updates > 0 && updates < changes);
+
+        //
+        // No intermediate state is published after the final state.
+        //
+        IceUtil::ThreadControl::sleep(IceUtil::Time::milliSeconds(1000));
+        test(observer->getUpdates("BatchServer") == updates);
+        test(observer->waitForEnabled("BatchServer", false) == updates);
+
+        admin->enableServer("BatchServer", true);
+        test(observer->waitForEnabled("BatchServer", true) == updates + 1);
+
+        adapter->destroy();
+        try
+        {
+            admin->removeApplication("BatchApp");
+        }
+        catch(const DeploymentException& ex)
+        {
+            cerr << ex.reason << endl;
+            test(false);
+        }
+
+        cout << "ok" << endl;
+    }
+
     session->destroy();
 }
@@ -34,6 +34,11 @@ if not os.path.exists(node2Dir):
 else:
     IceGridAdmin.cleanDbDir(node2Dir)
 
+#
+# Batch the node observer updates to test their coalescing.
+#
+IceGridAdmin.registryOptions += r' --IceGrid.Registry.NodeObserverBatchDelay=500'
+
 bindir = TestUtil.getCppBinDir()
 testdir = os.getcwd()
 serverdir = os.path.join(os.getcwd(), TestUtil.getTestDirectory("server"))
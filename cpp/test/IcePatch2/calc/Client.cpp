@@ -0,0 +1,263 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#include <Ice/Ice.h>
+#include <IceUtil/FileUtil.h>
+#include <IcePatch2Lib/Util.h>
+#include <TestCommon.h>
+
+using namespace std;
+using namespace IcePatch2;
+using namespace IcePatch2Internal;
+
+namespace
+{
+
+const int dirs = 4;
+const int filesPerDir = 10;
+
+//
+// Records the progress reported by getFileInfoSeq and interrupts it
+// after the given number of checksums, if not 0.
+//
+class ProgressCB : public GetFileInfoSeqCB
+{
+public:
+
+    ProgressCB(int interruptAfter = 0) :
+        _interruptAfter(interruptAfter), _reporting(false), _compressed(0)
+    {
+    }
+
+    virtual bool
+    remove(const string&)
+    {
+        return true;
+    }
+
+    virtual bool
+    checksum(const string& path)
+    {
+        test(!_reporting); // The progress must be reported by one thread at a time.
+        _reporting = true;
+        _checksums.push_back(path);
+        _reporting = false;
+        return _interruptAfter == 0 || static_cast<int>(_checksums.size()) < _interruptAfter;
+    }
+
+    virtual bool
+    compress(const string&)
+    {
+        test(!_reporting);
+        ++_compressed;
+        return true;
+    }
+
+    size_t checksums() const { return _checksums.size(); }
+    int compressed() const { return _compressed; }
+
+private:
+
+    const int _interruptAfter;
+    bool _reporting;
+    vector<string> _checksums;
+    int _compressed;
+};
+
+void
+writeFile(const string& path, size_t size, int seed)
+{
+    FILE* fp = IceUtilInternal::fopen(path, "wb");
+    test(fp);
+    Ice::ByteSeq bytes(size);
+    unsigned int x = static_cast<unsigned int>(seed) * 2654435761U + 1;
+    for(size_t i = 0; i < size; ++i)
+    {
+        x = x * 1103515245 + 12345;
+        bytes[i] = static_cast<Ice::Byte>(x >> 16);
+    }
+    if(size > 0)
+    {
+        test(fwrite(&bytes[0], size, 1, fp) == 1);
+    }
+    fclose(fp);
+}
+
+Ice::ByteSeq
+readFile(const string& path)
+{
+    FILE* fp = IceUtilInternal::fopen(path, "rb");
+    test(fp);
+    Ice::ByteSeq bytes;
+    Ice::Byte buf[4096];
+    size_t sz;
+    while((sz = fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+        bytes.insert(bytes.end(), buf, buf + sz);
+    }
+    fclose(fp);
+    return bytes;
+}
+
+bool
+exists(const string& path)
+{
+    IceUtilInternal::structstat buf;
+    return IceUtilInternal::stat(path, &buf) != -1;
+}
+
+}
+
+int
+run(int argc, char* argv[], const Ice::CommunicatorPtr&)
+{
+    if(argc != 2)
+    {
+        cerr << "usage: " << argv[0] << " <data directory>" << endl;
+        return EXIT_FAILURE;
+    }
+
+    const string dataDir = argv[1];
+
+    //
+    // Non-empty files of different sizes, one of them large enough to
+    // be chunked, and an empty file which isn't compressed.
+    //
+    int files = 0;
+    for(int i = 0; i < dirs; ++i)
+    {
+        ostringstream dir;
+        dir << dataDir << "/dir" << i;
+        createDirectory(dir.str());
+        for(int j = 0; j < filesPerDir; ++j)
+        {
+            ostringstream path;
+            path << dir.str() << "/file" << j;
+            writeFile(path.str(), (i * filesPerDir + j) * 1000 + 1, i * filesPerDir + j);
+            ++files;
+        }
+    }
+    writeFile(dataDir + "/large", static_cast<size_t>(minChunkedFileSize) + 100 * 1024, 0);
+    ++files;
+    writeFile(dataDir + "/empty", 0, 0);
+    ++files;
+
+    LargeFileInfoSeq infoSeq;
+    cout << "testing checksums computed by one thread... " << flush;
+    {
+        ProgressCB cb;
+        test(getFileInfoSeq(dataDir, 2, &cb, infoSeq, 1));
+        int regularFiles = 0;
+        for(LargeFileInfoSeq::const_iterator p = infoSeq.begin(); p != infoSeq.end(); ++p)
+        {
+            regularFiles += p->size >= 0 ? 1 : 0;
+        }
+        test(regularFiles == files);
+        test(static_cast<int>(cb.checksums()) == files);
+        test(cb.compressed() == files - 1);
+    }
+    cout << "ok" << endl;
+
+    cout << "testing checksums computed by several threads... " << flush;
+    {
+        ProgressCB cb;
+        LargeFileInfoSeq parallelInfoSeq;
+        test(getFileInfoSeq(dataDir, 2, &cb, parallelInfoSeq, 4));
+        test(parallelInfoSeq == infoSeq);
+        test(static_cast<int>(cb.checksums()) == files);
+        test(cb.compressed() == files - 1);
+
+        FileChunkInfoSeq chunks;
+        test(loadFileChunks(dataDir + "/large.chunks", chunks) && !chunks.empty());
+    }
+    cout << "ok" << endl;
+
+    cout << "testing interruption of the checksums... " << flush;
+    {
+        ProgressCB cb(3);
+        LargeFileInfoSeq interruptedInfoSeq;
+        test(!getFileInfoSeq(dataDir, 2, &cb, interruptedInfoSeq, 4));
+        test(cb.checksums() == 3);
+    }
+    cout << "ok" << endl;
+
+    cout << "testing Zstandard-compressed files... " << flush;
+    {
+        //
+        // A Zstandard-compressed file which isn't compressed again
+        // along with the bzip2-compressed file is removed, it might
+        // be stale.
+        //
+        writeFile(dataDir + "/dir0/file1.zst", 10, 0);
+        ProgressCB cb;
+        LargeFileInfoSeq zstdInfoSeq;
+        test(getFileInfoSeq(dataDir, 2, &cb, zstdInfoSeq, 4));
+        test(zstdInfoSeq == infoSeq);
+        test(!exists(dataDir + "/dir0/file1.zst"));
+
+        if(hasZstd())
+        {
+            zstdInfoSeq.clear();
+            test(getFileInfoSeq(dataDir, 2, &cb, zstdInfoSeq, 4, false, true));
+            test(zstdInfoSeq == infoSeq);
+            test(exists(dataDir + "/large.zst"));
+            test(!exists(dataDir + "/empty.zst"));
+
+            IcePatch2Internal::rename(dataDir + "/dir0/file1.zst", dataDir + "/copy.zst");
+            decompressFileZstd(dataDir + "/copy");
+            test(readFile(dataDir + "/copy") == readFile(dataDir + "/dir0/file1"));
+            IcePatch2Internal::remove(dataDir + "/copy");
+            IcePatch2Internal::remove(dataDir + "/copy.zst");
+        }
+    }
+    cout << "ok" << endl;
+
+    cout << "testing incremental checksums... " << flush;
+    {
+        saveFileInfoSeq(dataDir, infoSeq);
+
+        ProgressCB cb;
+        LargeFileInfoSeq incrementalInfoSeq;
+        test(getFileInfoSeq(dataDir, 1, &cb, incrementalInfoSeq, 4, true));
+        test(incrementalInfoSeq == infoSeq);
+    }
+    cout << "ok" << endl;
+
+    return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char* argv[])
+{
+    int status;
+    Ice::CommunicatorPtr communicator;
+
+    try
+    {
+        communicator = Ice::initialize(argc, argv);
+        status = run(argc, argv, communicator);
+    }
+    catch(const IceUtil::Exception& ex)
+    {
+        cerr << ex << endl;
+        status = EXIT_FAILURE;
+    }
+    catch(const string& ex)
+    {
+        cerr << ex << endl;
+        status = EXIT_FAILURE;
+    }
+
+    if(communicator)
+    {
+        communicator->destroy();
+    }
+
+    return status;
+}
@@ -0,0 +1,313 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#include <Ice/Ice.h>
+#include <IceUtil/FileUtil.h>
+#include <IcePatch2/ClientUtil.h>
+#include <IcePatch2Lib/Util.h>
+#include <TestCommon.h>
+
+using namespace std;
+using namespace IcePatch2;
+using namespace IcePatch2Internal;
+
+namespace
+{
+
+//
+// Forwards the requests to the file server and counts them, to check
+// which requests the patcher sends.
+//
+class Forwarder : public Ice::Blobject, public IceUtil::Mutex
+{
+public:
+
+    Forwarder(const Ice::ObjectPrx& target) :
+        _target(target), _rangeBytes(0)
+    {
+    }
+
+    virtual bool
+    ice_invoke(const vector<Ice::Byte>& inParams, vector<Ice::Byte>& outParams, const Ice::Current& current)
+    {
+        bool ok = _target->ice_invoke(current.operation, current.mode, inParams, outParams, current.ctx);
+
+        IceUtil::Mutex::Lock sync(*this);
+        ++_calls[current.operation];
+        if(current.operation == "getFileRange")
+        {
+            _rangeBytes += outParams.size();
+        }
+        return ok;
+    }
+
+    int
+    calls(const string& operation) const
+    {
+        IceUtil::Mutex::Lock sync(*this);
+        map<string, int>::const_iterator p = _calls.find(operation);
+        return p != _calls.end() ? p->second : 0;
+    }
+
+    size_t
+    rangeBytes() const
+    {
+        IceUtil::Mutex::Lock sync(*this);
+        return _rangeBytes;
+    }
+
+private:
+
+    const Ice::ObjectPrx _target;
+    map<string, int> _calls;
+    size_t _rangeBytes;
+};
+typedef IceUtil::Handle<Forwarder> ForwarderPtr;
+
+class Feedback : public PatcherFeedback
+{
+public:
+
+    virtual bool noFileSummary(const string&) { return true; }
+    virtual bool checksumStart() { return true; }
+    virtual bool checksumProgress(const string&) { return true; }
+    virtual bool checksumEnd() { return true; }
+    virtual bool fileListStart() { return true; }
+    virtual bool fileListProgress(Ice::Int) { return true; }
+    virtual bool fileListEnd() { return true; }
+    virtual bool patchStart(const string&, Ice::Long, Ice::Long, Ice::Long) { return true; }
+    virtual bool patchProgress(Ice::Long, Ice::Long, Ice::Long, Ice::Long) { return true; }
+    virtual bool patchEnd() { return true; }
+};
+
+Ice::ByteSeq
+readFile(const string& path)
+{
+    FILE* fp = IceUtilInternal::fopen(path, "rb");
+    test(fp);
+    Ice::ByteSeq bytes;
+    Ice::Byte buf[4096];
+    size_t sz;
+    while((sz = fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+        bytes.insert(bytes.end(), buf, buf + sz);
+    }
+    fclose(fp);
+    return bytes;
+}
+
+void
+writeFile(const string& path, const Ice::ByteSeq& bytes)
+{
+    FILE* fp = IceUtilInternal::fopen(path, "wb");
+    test(fp);
+    test(fwrite(&bytes[0], bytes.size(), 1, fp) == 1);
+    fclose(fp);
+}
+
+//
+// Change one byte in the middle of the chunk at the given relative
+// position of the given file. The value of the byte is chosen so that
+// the chunk boundaries don't change, only the checksum of this chunk
+// changes.
+//
+void
+edit(const string& path, double position)
+{
+    FileChunkInfoSeq chunks;
+    getFileChunks(path, chunks);
+    test(chunks.size() > 6);
+
+    Ice::ByteSeq bytes = readFile(path);
+    const FileChunkInfo& chunk = chunks[static_cast<size_t>(static_cast<double>(chunks.size()) * position)];
+    const size_t pos = static_cast<size_t>(chunk.offset) + chunk.size / 2;
+    const Ice::Byte original = bytes[pos];
+
+    for(int i = 1; i < 256; ++i)
+    {
+        bytes[pos] = static_cast<Ice::Byte>(original ^ i);
+        writeFile(path, bytes);
+
+        FileChunkInfoSeq newChunks;
+        getFileChunks(path, newChunks);
+        if(newChunks.size() != chunks.size())
+        {
+            continue;
+        }
+
+        int changed = 0;
+        bool sameOffsets = true;
+        for(FileChunkInfoSeq::size_type j = 0; j < chunks.size(); ++j)
+        {
+            sameOffsets = sameOffsets && newChunks[j].offset == chunks[j].offset;
+            changed += newChunks[j].checksum != chunks[j].checksum ? 1 : 0;
+        }
+        if(sameOffsets && changed == 1)
+        {
+            return;
+        }
+    }
+    test(false);
+}
+
+void
+patch(const Ice::CommunicatorPtr& communicator, const ForwarderPtr& forwarder, const string& dataDir)
+{
+    Ice::ObjectAdapterPtr adapter = communicator->createObjectAdapterWithEndpoints("Forwarder", "default");
+    FileServerPrx server = FileServerPrx::uncheckedCast(adapter->addWithUUID(forwarder));
+    adapter->activate();
+
+    PatcherPtr patcher = PatcherFactory::create(server, new Feedback, dataDir, false, 100, 1);
+    test(patcher->prepare());
+    test(patcher->patch(""));
+    patcher->finish();
+
+    adapter->destroy();
+}
+
+}
+
+int
+run(int argc, char* argv[], const Ice::CommunicatorPtr& communicator)
+{
+    const string command = argc == 4 ? argv[1] : "";
+    if(command != "edit" && command != "edits" && command != "patch" && command != "update" &&
+       command != "ranges" && command != "fallback" && command != "zstd")
+    {
+        cerr << "usage: " << argv[0] << " edit|edits|patch|update|ranges|fallback|zstd <server directory> "
+             << "<client directory>" << endl;
+        return EXIT_FAILURE;
+    }
+
+    const string serverDir = argv[2];
+    const string clientDir = argv[3];
+
+    if(command == "edit")
+    {
+        cout << "editing one byte of a large file... " << flush;
+        edit(serverDir + "/large", 0.5);
+        cout << "ok" << endl;
+        return EXIT_SUCCESS;
+    }
+    else if(command == "edits")
+    {
+        cout << "editing three chunks of a large file... " << flush;
+        edit(serverDir + "/large", 0.25);
+        edit(serverDir + "/large", 0.5);
+        edit(serverDir + "/large", 0.75);
+        cout << "ok" << endl;
+        return EXIT_SUCCESS;
+    }
+
+    ForwarderPtr forwarder = new Forwarder(communicator->stringToProxy("IcePatch2/server:default -p 12010"));
+
+    if(command == "patch")
+    {
+        cout << "patching an empty directory... " << flush;
+        patch(communicator, forwarder, clientDir);
+
+        //
+        // The client doesn't have the files, they are downloaded
+        // entirely.
+        //
+        test(forwarder->calls("getFileChunks") == 0);
+        test(forwarder->calls("getFileRange") == 0);
+        test(forwarder->calls("getLargeFileCompressed") > 0);
+    }
+    else if(command == "zstd")
+    {
+        cout << "patching a Zstandard-compressed file... " << flush;
+        patch(communicator, forwarder, clientDir);
+
+        //
+        // The new file is downloaded with its Zstandard-compressed
+        // file instead of its bzip2-compressed file.
+        //
+        test(forwarder->calls("getZstdFileSizes") == 1);
+        test(forwarder->calls("getFileZstd") > 0);
+        test(forwarder->calls("getLargeFileCompressed") == 0);
+        test(readFile(clientDir + "/new") == readFile(serverDir + "/new"));
+    }
+    else if(command == "ranges")
+    {
+        cout << "patching a file with several updated chunks... " << flush;
+        patch(communicator, forwarder, clientDir);
+
+        //
+        // The updated chunks aren't consecutive, they are downloaded
+        // with one range request each.
+        //
+        test(forwarder->calls("getFileChunks") == 1);
+        test(forwarder->calls("getFileRange") == 3);
+        test(forwarder->calls("getLargeFileCompressed") == 0);
+    }
+    else if(command == "fallback")
+    {
+        cout << "patching a file with no local chunk... " << flush;
+        patch(communicator, forwarder, clientDir);
+
+        //
+        // The chunks to download are larger than the compressed file,
+        // the compressed file is downloaded instead.
+        //
+        test(forwarder->calls("getFileChunks") == 1);
+        test(forwarder->calls("getFileRange") == 0);
+        test(forwarder->calls("getLargeFileCompressed") > 0);
+    }
+    else
+    {
+        cout << "patching a file with one updated chunk... " << flush;
+        patch(communicator, forwarder, clientDir);
+
+        //
+        // Only the updated chunk of the large file is downloaded,
+        // the local file is patched in place and not removed first.
+        //
+        test(forwarder->calls("getFileChunks") == 1);
+        test(forwarder->calls("getFileRange") == 1);
+        test(forwarder->rangeBytes() < 256 * 1024 + 1024);
+        test(forwarder->calls("getLargeFileCompressed") == 0);
+    }
+
+    test(readFile(clientDir + "/large") == readFile(serverDir + "/large"));
+    test(readFile(clientDir + "/small") == readFile(serverDir + "/small"));
+    cout << "ok" << endl;
+
+    return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char* argv[])
+{
+    int status;
+    Ice::CommunicatorPtr communicator;
+
+    try
+    {
+        communicator = Ice::initialize(argc, argv);
+        status = run(argc, argv, communicator);
+    }
+    catch(const IceUtil::Exception& ex)
+    {
+        cerr << ex << endl;
+        status = EXIT_FAILURE;
+    }
+    catch(const string& ex)
+    {
+        cerr << ex << endl;
+        status = EXIT_FAILURE;
+    }
+
+    if(communicator)
+    {
+        communicator->destroy();
+    }
+
+    return status;
+}
@@ -0,0 +1,101 @@
+#!/usr/bin/env python
+# **********************************************************************
+#
+# Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+#
+# This copy of Ice is licensed to you under the terms described in the
+# ICE_LICENSE file included in this distribution.
+#
+# **********************************************************************
+
+import os, sys, random, shutil, signal
+
+path = [ ".", "..", "../..", "../../..", "../../../.." ]
+head = os.path.dirname(sys.argv[0])
+if len(head) > 0:
+    path = [os.path.join(head, p) for p in path]
+path = [os.path.abspath(p) for p in path if os.path.exists(os.path.join(p, "scripts", "TestUtil.py")) ]
+if len(path) == 0:
+    raise RuntimeError("can't find toplevel directory!")
+sys.path.append(os.path.join(path[0], "scripts"))
+import TestUtil
+
+datadir = os.path.join(os.getcwd(), "data")
+serverdir = os.path.join(datadir, "server")
+clientdir = os.path.join(datadir, "client")
+client = os.path.join(os.getcwd(), TestUtil.getTestExecutable("client"))
+
+def icepatch2Calc(options = "", optional = False):
+    icePatch2Calc = os.path.join(TestUtil.getCppBinDir(), "icepatch2calc")
+    commandProc = TestUtil.spawn('"%s" -z %s "%s"' % (icePatch2Calc, options, serverdir))
+    if optional:
+        return commandProc.wait() == 0
+    commandProc.waitTestSuccess()
+    return True
+
+def icepatch2Server():
+    icePatch2Server = os.path.join(TestUtil.getCppBinDir(), "icepatch2server")
+    args = ' --IcePatch2.Endpoints="default -p 12010" --Ice.PrintAdapterReady=1 "%s"' % serverdir
+    return TestUtil.startServer(icePatch2Server, args, adapter="IcePatch2")
+
+def runClient(command):
+    clientProc = TestUtil.startClient(client, '%s "%s" "%s"' % (command, serverdir, clientdir))
+    clientProc.waitTestSuccess()
+
+def patch(command):
+    serverProc = icepatch2Server()
+    runClient(command)
+    serverProc.kill(signal.SIGINT)
+    serverProc.waitTestSuccess()
+
+if os.path.exists(datadir):
+    shutil.rmtree(datadir)
+os.makedirs(serverdir)
+os.makedirs(clientdir)
+
+#
+# A large file with random contents, which is chunked by icepatch2calc,
+# and a small file which isn't chunked.
+#
+r = random.Random(0)
+f = open(os.path.join(serverdir, "large"), "wb")
+f.write(bytearray(r.getrandbits(8) for i in range(2 * 1024 * 1024)))
+f.close()
+f = open(os.path.join(serverdir, "small"), "wb")
+f.write(b"small file")
+f.close()
+
+icepatch2Calc()
+patch("patch")
+
+runClient("edit")
+icepatch2Calc()
+patch("update")
+
+runClient("edits")
+icepatch2Calc()
+patch("ranges")
+
+#
+# A compressible large file with new contents: none of its chunks is
+# available locally and its compressed file is smaller than its chunks.
+#
+f = open(os.path.join(serverdir, "large"), "wb")
+f.write(bytearray(r.choice([97, 98, 99, 100]) for i in range(2 * 1024 * 1024)))
+f.close()
+icepatch2Calc()
+patch("fallback")
+
+#
+# The Zstandard files are only created if IcePatch2 is built with
+# Zstandard support.
+#
+f = open(os.path.join(serverdir, "new"), "wb")
+f.write(bytearray(r.getrandbits(8) for i in range(300 * 1024)))
+f.close()
+if icepatch2Calc("--zstd", optional = True):
+    patch("zstd")
+else:
+    print("Zstandard support is not available, skipping Zstandard test")
+
+shutil.rmtree(datadir)
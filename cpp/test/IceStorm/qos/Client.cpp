@@ -0,0 +1,549 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#include <Ice/Ice.h>
+#include <IceUtil/Random.h>
+#include <IceUtil/InputUtil.h>
+#include <IceStorm/IceStorm.h>
+#include <TestCommon.h>
+#include <Test.h>
+
+using namespace std;
+using namespace Ice;
+using namespace IceStorm;
+using namespace Test;
+
+namespace
+{
+
+const IceUtil::Time timeout = IceUtil::Time::seconds(60);
+
+//
+// Records the events received for each key, the dispatch of the
+// events is blocked until released.
+//
+class ConflateI : public Event, public IceUtil::Monitor<IceUtil::Mutex>
+{
+public:
+
+    ConflateI() :
+        _hold(true),
+        _count(0)
+    {
+    }
+
+    virtual void
+    pub(int value, const Current& current)
+    {
+        Lock sync(*this);
+        while(_hold)
+        {
+            wait();
+        }
+
+        Context::const_iterator p = current.ctx.find("key");
+        test(p != current.ctx.end());
+
+        //
+        // The events of a given key are received in order.
+        //
+        map<string, int>::const_iterator q = _last.find(p->second);
+        test(q == _last.end() || q->second < value);
+        _last[p->second] = value;
+        ++_count;
+        notifyAll();
+    }
+
+    void
+    release()
+    {
+        Lock sync(*this);
+        _hold = false;
+        notifyAll();
+    }
+
+    int
+    waitForLast(const map<string, int>& last)
+    {
+        Lock sync(*this);
+        while(_last != last)
+        {
+            if(!timedWait(timeout))
+            {
+                test(false);
+            }
+        }
+        return _count;
+    }
+
+private:
+
+    bool _hold;
+    int _count;
+    map<string, int> _last;
+};
+typedef IceUtil::Handle<ConflateI> ConflateIPtr;
+
+//
+// Counts the events received and the maximum number of events
+// dispatched at once. The dispatch of each event takes a random
+// time so that the responses are received out of order.
+//
+class WindowI : public Event, public IceUtil::Monitor<IceUtil::Mutex>
+{
+public:
+
+    WindowI() :
+        _count(0),
+        _dispatching(0),
+        _maxDispatching(0)
+    {
+    }
+
+    virtual void
+    pub(int, const Current&)
+    {
+        {
+            Lock sync(*this);
+            ++_dispatching;
+            _maxDispatching = max(_maxDispatching, _dispatching);
+        }
+
+        IceUtil::ThreadControl::sleep(IceUtil::Time::milliSeconds(IceUtilInternal::random(5)));
+
+        Lock sync(*this);
+        --_dispatching;
+        ++_count;
+        notifyAll();
+    }
+
+    int
+    waitForCount(int count)
+    {
+        Lock sync(*this);
+        while(_count < count)
+        {
+            if(!timedWait(timeout))
+            {
+                test(false);
+            }
+        }
+        test(_count == count);
+        return _maxDispatching;
+    }
+
+private:
+
+    int _count;
+    int _dispatching;
+    int _maxDispatching;
+};
+typedef IceUtil::Handle<WindowI> WindowIPtr;
+
+//
+// Records the sequence numbers of the events received.
+//
+class ReplayI : public Event, public IceUtil::Monitor<IceUtil::Mutex>
+{
+public:
+
+    ReplayI() :
+        _first(-1),
+        _last(-1)
+    {
+    }
+
+    virtual void
+    pub(int value, const Current& current)
+    {
+        Lock sync(*this);
+        Context::const_iterator p = current.ctx.find("_seq");
+        test(p != current.ctx.end());
+        Ice::Long seq;
+        test(IceUtilInternal::stringToInt64(p->second, seq));
+
+        //
+        // The events are published with their sequence number minus
+        // one as value. Each event is received once and in order.
+        //
+        test(value == seq - 1);
+        test(_last < 0 || seq == _last + 1);
+        if(_first < 0)
+        {
+            _first = seq;
+        }
+        _last = seq;
+        notifyAll();
+    }
+
+    Ice::Long
+    waitForLast(Ice::Long last)
+    {
+        Lock sync(*this);
+        while(_last < last)
+        {
+            if(!timedWait(timeout))
+            {
+                test(false);
+            }
+        }
+        test(_last == last);
+        return _first;
+    }
+
+private:
+
+    Ice::Long _first;
+    Ice::Long _last;
+};
+typedef IceUtil::Handle<ReplayI> ReplayIPtr;
+
+//
+// Counts the events received without a sequence number.
+//
+class LiveI : public Event, public IceUtil::Monitor<IceUtil::Mutex>
+{
+public:
+
+    LiveI() :
+        _count(0)
+    {
+    }
+
+    virtual void
+    pub(int, const Current& current)
+    {
+        Lock sync(*this);
+        test(current.ctx.find("_seq") == current.ctx.end());
+        ++_count;
+        notifyAll();
+    }
+
+    void
+    waitForCount(int count)
+    {
+        Lock sync(*this);
+        while(_count < count)
+        {
+            if(!timedWait(timeout))
+            {
+                test(false);
+            }
+        }
+        test(_count == count);
+    }
+
+private:
+
+    int _count;
+};
+typedef IceUtil::Handle<LiveI> LiveIPtr;
+
+void
+testConflate(const ObjectAdapterPtr& adapter, const TopicPrx& topic)
+{
+    cout << "testing conflation... " << flush;
+    ConflateIPtr servant = new ConflateI;
+    ObjectPrx subscriber = adapter->addWithUUID(servant);
+
+    QoS qos;
+    qos["conflate"] = "";
+    try
+    {
+        topic->subscribeAndGetPublisher(qos, subscriber);
+        test(false);
+    }
+    catch(const BadQoS&)
+    {
+    }
+
+    qos["conflate"] = "key";
+    topic->subscribeAndGetPublisher(qos, subscriber);
+
+    //
+    // The subscriber blocks the dispatch of the first event, at most
+    // 5 events are outstanding and the events queued in IceStorm are
+    // conflated to the last event of each key.
+    //
+    EventPrx publisher = EventPrx::uncheckedCast(topic->getPublisher()->ice_twoway());
+    map<string, int> last;
+    for(int i = 0; i < 1000; ++i)
+    {
+        ostringstream os;
+        os << i % 10;
+        Context ctx;
+        ctx["key"] = os.str();
+        publisher->pub(i, ctx);
+        last[os.str()] = i;
+    }
+    servant->release();
+
+    int count = servant->waitForLast(last);
+    test(count <= 5 + 10);
+
+    topic->unsubscribe(subscriber);
+    cout << "ok" << endl;
+}
+
+void
+testWindow(const ObjectAdapterPtr& adapter, const TopicPrx& topic)
+{
+    cout << "testing flow control... " << flush;
+    WindowIPtr servant = new WindowI;
+    ObjectPrx subscriber = adapter->addWithUUID(servant);
+
+    const char* invalid[] = { "0", "-1", "foo", "2147483648" };
+    for(size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i)
+    {
+        QoS qos;
+        qos["maxOutstanding"] = invalid[i];
+        try
+        {
+            topic->subscribeAndGetPublisher(qos, subscriber);
+            test(false);
+        }
+        catch(const BadQoS&)
+        {
+        }
+    }
+
+    try
+    {
+        QoS qos;
+        qos["maxOutstanding"] = "3";
+        topic->subscribeAndGetPublisher(qos, subscriber->ice_oneway());
+        test(false);
+    }
+    catch(const BadQoS&)
+    {
+    }
+
+    try
+    {
+        QoS qos;
+        qos["maxOutstanding"] = "3";
+        qos["reliability"] = "ordered";
+        topic->subscribeAndGetPublisher(qos, subscriber);
+        test(false);
+    }
+    catch(const BadQoS&)
+    {
+    }
+
+    try
+    {
+        QoS qos;
+        qos["flushDelayUs"] = "1000";
+        topic->subscribeAndGetPublisher(qos, subscriber);
+        test(false);
+    }
+    catch(const BadQoS&)
+    {
+    }
+
+    //
+    // The responses of the subscriber are received out of order,
+    // IceStorm never sends more than maxOutstanding events at once.
+    //
+    QoS qos;
+    qos["maxOutstanding"] = "3";
+    topic->subscribeAndGetPublisher(qos, subscriber);
+
+    EventPrx publisher = EventPrx::uncheckedCast(topic->getPublisher()->ice_twoway());
+    for(int i = 0; i < 200; ++i)
+    {
+        publisher->pub(i);
+    }
+    test(servant->waitForCount(200) <= 3);
+    topic->unsubscribe(subscriber);
+
+    //
+    // The events sent to a batch subscriber are flushed once the
+    // batch exceeds maxBatchBytes or after flushDelayUs.
+    //
+    servant = new WindowI;
+    subscriber = adapter->addWithUUID(servant)->ice_batchOneway();
+    qos.clear();
+    qos["flushDelayUs"] = "1000";
+    qos["maxBatchBytes"] = "256";
+    topic->subscribeAndGetPublisher(qos, subscriber);
+    for(int i = 0; i < 200; ++i)
+    {
+        publisher->pub(i);
+    }
+    servant->waitForCount(200);
+    topic->unsubscribe(subscriber);
+    cout << "ok" << endl;
+}
+
+void
+testPublish(const TopicPrx& topic, int count)
+{
+    cout << "publishing " << count << " events... " << flush;
+    EventPrx publisher = EventPrx::uncheckedCast(topic->getPublisher()->ice_twoway());
+    for(int i = 0; i < count; ++i)
+    {
+        publisher->pub(i);
+    }
+    cout << "ok" << endl;
+}
+
+void
+testReplay(const ObjectAdapterPtr& adapter, const TopicPrx& topic, Ice::Long last, bool trimmed)
+{
+    cout << "testing replay of " << (trimmed ? "trimmed" : "all") << " events... " << flush;
+
+    QoS qos;
+    qos["replay"] = "-1";
+    try
+    {
+        topic->subscribeAndGetPublisher(qos, adapter->addWithUUID(new ReplayI));
+        test(false);
+    }
+    catch(const BadQoS&)
+    {
+    }
+
+    LiveIPtr live = new LiveI;
+    ObjectPrx liveSubscriber = adapter->addWithUUID(live);
+    topic->subscribeAndGetPublisher(QoS(), liveSubscriber);
+
+    //
+    // The events published while the subscriber replays the log are
+    // received once, after the replayed events.
+    //
+    ReplayIPtr servant = new ReplayI;
+    ObjectPrx subscriber = adapter->addWithUUID(servant);
+    qos["replay"] = "1";
+    topic->subscribeAndGetPublisher(qos, subscriber);
+
+    EventPrx publisher = EventPrx::uncheckedCast(topic->getPublisher()->ice_twoway());
+    for(int i = 0; i < 100; ++i)
+    {
+        publisher->pub(static_cast<int>(last) + i);
+    }
+
+    Ice::Long first = servant->waitForLast(last + 100);
+    live->waitForCount(100);
+    if(trimmed)
+    {
+        test(first > 1);
+    }
+    else
+    {
+        test(first == 1);
+    }
+
+    topic->unsubscribe(subscriber);
+    topic->unsubscribe(liveSubscriber);
+    cout << "ok" << endl;
+}
+
+}
+
+int
+run(int argc, char* argv[], const CommunicatorPtr& communicator)
+{
+    PropertiesPtr properties = communicator->getProperties();
+    const char* managerProxyProperty = "IceStormAdmin.TopicManager.Default";
+    string managerProxy = properties->getProperty(managerProxyProperty);
+    if(managerProxy.empty())
+    {
+        cerr << argv[0] << ": property `" << managerProxyProperty << "' is not set" << endl;
+        return EXIT_FAILURE;
+    }
+
+    TopicManagerPrx manager = TopicManagerPrx::checkedCast(communicator->stringToProxy(managerProxy));
+    if(!manager)
+    {
+        cerr << argv[0] << ": `" << managerProxy << "' is not running" << endl;
+        return EXIT_FAILURE;
+    }
+
+    if(argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " conflate|window|publish count|replay last trimmed" << endl;
+        return EXIT_FAILURE;
+    }
+    string command = argv[1];
+
+    TopicPrx topic = manager->retrieve("qos");
+
+    //
+    // The conflation and replay tests rely on the events being
+    // dispatched in order, the adapter uses a single dispatch thread.
+    //
+    properties->setProperty("SubscriberAdapter.Endpoints", "default");
+    ObjectAdapterPtr adapter = communicator->createObjectAdapter("SubscriberAdapter");
+    adapter->activate();
+
+    if(command == "conflate")
+    {
+        testConflate(adapter, topic);
+    }
+    else if(command == "window")
+    {
+        //
+        // The flow control test dispatches the events concurrently.
+        //
+        properties->setProperty("WindowAdapter.Endpoints", "default");
+        properties->setProperty("WindowAdapter.ThreadPool.Size", "10");
+        ObjectAdapterPtr windowAdapter = communicator->createObjectAdapter("WindowAdapter");
+        windowAdapter->activate();
+        testWindow(windowAdapter, topic);
+    }
+    else if(command == "publish" && argc == 3)
+    {
+        testPublish(topic, atoi(argv[2]));
+    }
+    else if(command == "replay" && argc == 4)
+    {
+        testReplay(adapter, topic, atoi(argv[2]), atoi(argv[3]) != 0);
+    }
+    else
+    {
+        cerr << argv[0] << ": invalid command `" << command << "'" << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char* argv[])
+{
+    int status;
+    CommunicatorPtr communicator;
+
+    try
+    {
+        communicator = initialize(argc, argv);
+        status = run(argc, argv, communicator);
+    }
+    catch(const Exception& ex)
+    {
+        cerr << ex << endl;
+        status = EXIT_FAILURE;
+    }
+
+    if(communicator)
+    {
+        try
+        {
+            communicator->destroy();
+        }
+        catch(const Exception& ex)
+        {
+            cerr << ex << endl;
+            status = EXIT_FAILURE;
+        }
+    }
+
+    return status;
+}
@@ -0,0 +1,97 @@
+#!/usr/bin/env python
+# **********************************************************************
+#
+# Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+#
+# This copy of Ice is licensed to you under the terms described in the
+# ICE_LICENSE file included in this distribution.
+#
+# **********************************************************************
+
+import os, sys, shutil
+
+path = [ ".", "..", "../..", "../../..", "../../../.." ]
+head = os.path.dirname(sys.argv[0])
+if len(head) > 0:
+    path = [os.path.join(head, p) for p in path]
+path = [os.path.abspath(p) for p in path if os.path.exists(os.path.join(p, "scripts", "TestUtil.py")) ]
+if len(path) == 0:
+    raise RuntimeError("can't find toplevel directory!")
+sys.path.append(os.path.join(path[0], "scripts"))
+import TestUtil, IceStormUtil
+
+client = os.path.join(os.getcwd(), TestUtil.getTestExecutable("client"))
+
+def runClient(icestorm, args):
+    clientProc = TestUtil.startClient(client, icestorm.reference() + " " + args, startReader = False)
+    clientProc.startReader()
+    clientProc.waitTestSuccess()
+
+def dotest(type, additional = ""):
+    icestorm = IceStormUtil.init(TestUtil.toplevel, os.getcwd(), type, additional=additional)
+    icestorm.start()
+
+    sys.stdout.write("creating topic... ")
+    sys.stdout.flush()
+    icestorm.admin("create qos")
+    print("ok")
+
+    runClient(icestorm, "conflate")
+    runClient(icestorm, "window")
+
+    sys.stdout.write("destroy topic... ")
+    sys.stdout.flush()
+    icestorm.admin("destroy qos")
+    print("ok")
+
+    icestorm.stop()
+
+dotest("persistent")
+dotest("transient")
+dotest("persistent", " --IceStorm.Dispatch.Shards=2")
+
+#
+# Test the replay of the event log. The log uses small segments so that
+# it's rolled many times, it's recovered when IceStorm is restarted and
+# trimmed once the retention size is set.
+#
+logDir = os.path.join(os.getcwd(), "log")
+if os.path.exists(logDir):
+    shutil.rmtree(logDir)
+
+eventLogArgs = ' --IceStorm.EventLog.Path="%s" --IceStorm.EventLog.SegmentSize=4' \
+               ' --IceStorm.EventLog.SyncInterval=100' % logDir
+
+icestorm = IceStormUtil.init(TestUtil.toplevel, os.getcwd(), "persistent", additional=eventLogArgs)
+icestorm.start()
+sys.stdout.write("creating topic... ")
+sys.stdout.flush()
+icestorm.admin("create qos")
+print("ok")
+runClient(icestorm, "publish 1500")
+runClient(icestorm, "replay 1500 0")
+icestorm.stop()
+
+sys.stdout.write("restarting icestorm service... ")
+sys.stdout.flush()
+icestorm.start(echo = False)
+print("ok")
+runClient(icestorm, "replay 1600 0")
+icestorm.stop()
+
+sys.stdout.write("restarting icestorm service with a retention size... ")
+sys.stdout.flush()
+icestorm.start(echo = False, additionalOptions = " --IceStorm.EventLog.RetentionSize=16")
+print("ok")
+runClient(icestorm, "replay 1700 1")
+
+sys.stdout.write("destroy topic... ")
+sys.stdout.flush()
+icestorm.admin("destroy qos")
+print("ok")
+icestorm.stop()
+
+if os.path.exists(logDir):
+    shutil.rmtree(logDir)
+
+sys.exit(0)
@@ -0,0 +1,191 @@
+// **********************************************************************
+//
+// Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+//
+// This copy of Ice is licensed to you under the terms described in the
+// ICE_LICENSE file included in this distribution.
+//
+// **********************************************************************
+
+#include <Ice/Ice.h>
+#include <IceStorm/IceStorm.h>
+#include <Shards.h>
+#include <TestCommon.h>
+
+using namespace std;
+using namespace Ice;
+using namespace IceStorm;
+using namespace Test;
+
+namespace
+{
+
+const int eventsPerKey = 500;
+const char* keys[] = { "a", "b", "c", "d" };
+const int nkeys = static_cast<int>(sizeof(keys) / sizeof(keys[0]));
+
+}
+
+class EventI : public Event, public IceUtil::Monitor<IceUtil::Mutex>
+{
+public:
+
+    EventI(const string& name) :
+        _name(name),
+        _count(0),
+        _failed(false)
+    {
+    }
+
+    virtual void
+    event(const string& key, int seq, const Current&)
+    {
+        Lock sync(*this);
+        int& last = _last[key];
+        if(seq != last)
+        {
+            cerr << endl << "received unordered event for `" << _name << "' and key `" << key << "': " << seq
+                 << " " << last;
+            _failed = true;
+        }
+        last = seq + 1;
+        if(++_count == eventsPerKey * nkeys)
+        {
+            notify();
+        }
+    }
+
+    void
+    waitForEvents()
+    {
+        Lock sync(*this);
+        while(_count < eventsPerKey * nkeys && !_failed)
+        {
+            if(!timedWait(IceUtil::Time::seconds(30)))
+            {
+                cerr << endl << "timed out waiting for the events of `" << _name << "': " << _count;
+                test(false);
+            }
+        }
+        test(!_failed);
+    }
+
+private:
+
+    const string _name;
+    map<string, int> _last;
+    int _count;
+    bool _failed;
+};
+typedef IceUtil::Handle<EventI> EventIPtr;
+
+int
+run(int, char* argv[], const CommunicatorPtr& communicator)
+{
+    PropertiesPtr properties = communicator->getProperties();
+    const char* managerProxyProperty = "IceStormAdmin.TopicManager.Default";
+    string managerProxy = properties->getProperty(managerProxyProperty);
+    if(managerProxy.empty())
+    {
+        cerr << argv[0] << ": property `" << managerProxyProperty << "' is not set" << endl;
+        return EXIT_FAILURE;
+    }
+
+    IceStorm::TopicManagerPrx manager = IceStorm::TopicManagerPrx::checkedCast(
+        communicator->stringToProxy(managerProxy));
+    if(!manager)
+    {
+        cerr << argv[0] << ": `" << managerProxy << "' is not running" << endl;
+        return EXIT_FAILURE;
+    }
+
+    ObjectAdapterPtr adapter = communicator->createObjectAdapterWithEndpoints("ShardsAdapter", "default");
+
+    //
+    // Events published on several topics are dispatched to different
+    // shards, the events with the same partition key of a topic must
+    // still be received in order.
+    //
+    vector<TopicPrx> topics;
+    vector<EventIPtr> subscribers;
+    for(int i = 0; i < 3; ++i)
+    {
+        ostringstream os;
+        os << "shards" << i;
+        TopicPrx topic = manager->create(os.str());
+        topics.push_back(topic);
+
+        subscribers.push_back(new EventI(os.str()));
+        IceStorm::QoS qos;
+        qos["reliability"] = "ordered";
+        topic->subscribeAndGetPublisher(qos, adapter->addWithUUID(subscribers.back()));
+    }
+    adapter->activate();
+
+    cout << "publishing events with partition keys... " << flush;
+    vector<EventPrx> publishers;
+    for(vector<TopicPrx>::const_iterator p = topics.begin(); p != topics.end(); ++p)
+    {
+        publishers.push_back(EventPrx::uncheckedCast((*p)->getPublisher()->ice_oneway()));
+    }
+    for(int seq = 0; seq < eventsPerKey; ++seq)
+    {
+        for(int k = 0; k < nkeys; ++k)
+        {
+            Ice::Context ctx;
+            ctx["key"] = keys[k];
+            for(vector<EventPrx>::const_iterator p = publishers.begin(); p != publishers.end(); ++p)
+            {
+                (*p)->event(keys[k], seq, ctx);
+            }
+        }
+    }
+    cout << "ok" << endl;
+
+    cout << "testing events ordering... " << flush;
+    for(vector<EventIPtr>::const_iterator p = subscribers.begin(); p != subscribers.end(); ++p)
+    {
+        (*p)->waitForEvents();
+    }
+    cout << "ok" << endl;
+
+    for(vector<TopicPrx>::const_iterator p = topics.begin(); p != topics.end(); ++p)
+    {
+        (*p)->destroy();
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char* argv[])
+{
+    int status;
+    CommunicatorPtr communicator;
+
+    try
+    {
+        communicator = initialize(argc, argv);
+        status = run(argc, argv, communicator);
+    }
+    catch(const Exception& ex)
+    {
+        cerr << ex << endl;
+        status = EXIT_FAILURE;
+    }
+
+    if(communicator)
+    {
+        try
+        {
+            communicator->destroy();
+        }
+        catch(const Exception& ex)
+        {
+            cerr << ex << endl;
+            status = EXIT_FAILURE;
+        }
+    }
+
+    return status;
+}
@@ -0,0 +1,47 @@
+#!/usr/bin/env python
+# **********************************************************************
+#
+# Copyright (c) 2003-2016 ZeroC, Inc. All rights reserved.
+#
+# This copy of Ice is licensed to you under the terms described in the
+# ICE_LICENSE file included in this distribution.
+#
+# **********************************************************************
+
+import os, sys
+
+path = [ ".", "..", "../..", "../../..", "../../../.." ]
+head = os.path.dirname(sys.argv[0])
+if len(head) > 0:
+    path = [os.path.join(head, p) for p in path]
+path = [os.path.abspath(p) for p in path if os.path.exists(os.path.join(p, "scripts", "TestUtil.py")) ]
+if len(path) == 0:
+    raise RuntimeError("can't find toplevel directory!")
+sys.path.append(os.path.join(path[0], "scripts"))
+import TestUtil, IceStormUtil
+
+client = os.path.join(os.getcwd(), TestUtil.getTestExecutable("client"))
+
+#
+# Use several shards with small queues, the events of the same topic
+# and partition key must still be received in order.
+#
+iceStormArgs = " --IceStorm.Dispatch.Shards=4" + \
+               " --IceStorm.Dispatch.PartitionKey=key" + \
+               " --IceStorm.Dispatch.QueueSizeMax=10" + \
+               " --IceStorm.Publish.ThreadPool.Size=1"
+
+def dotest(type):
+    icestorm = IceStormUtil.init(TestUtil.toplevel, os.getcwd(), type, additional=iceStormArgs)
+    icestorm.start()
+
+    clientProc = TestUtil.startClient(client, icestorm.reference(), startReader = False)
+    clientProc.startReader()
+    clientProc.waitTestSuccess()
+
+    icestorm.stop()
+
+dotest("persistent")
+dotest("transient")
+
+sys.exit(0)
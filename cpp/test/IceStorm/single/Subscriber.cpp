@@ -42,6 +42,11 @@ public:
         {
             cerr << endl << "expected twoway request";
         }
+        if(_name == "filtered out")
+        {
+            cerr << endl << "received event rejected by the subscriber filter";
+            test(false);
+        }
         if(_name == "twoway ordered" && i != _last)
         {
             cerr << endl << "received unordered event for `" << _name << "': " << i << " " << _last;
@@ -203,6 +208,14 @@ run(int, char* argv[], const CommunicatorPtr& communicator)
         subscriberIdentities.push_back(object->ice_getIdentity());
         topic->subscribeAndGetPublisher(qos, object);
     }
+    {
+        subscribers.push_back(new SingleI(communicator, "filtered")); // Filtered
+        IceStorm::QoS qos;
+        qos["filter.op"] = "ev*";
+        Ice::ObjectPrx object = adapter->addWithUUID(subscribers.back());
+        subscriberIdentities.push_back(object->ice_getIdentity());
+        topic->subscribeAndGetPublisher(qos, object);
+    }
     {
         // Use a separate adapter to ensure a separate connection is used for the subscriber
         // (otherwise, if multiple UDP subscribers use the same connection we might get high
@@ -226,6 +239,46 @@ run(int, char* argv[], const CommunicatorPtr& communicator)
         adpt->activate();
     }
 
+    //
+    // Events rejected by the filter are never sent to the subscriber.
+    //
+    SingleIPtr filteredOut = new SingleI(communicator, "filtered out");
+    {
+        IceStorm::QoS qos;
+        qos["filter.op"] = "event";
+        qos["filter.context.symbol"] = "ABC*";
+        Ice::ObjectPrx object = adapter->addWithUUID(filteredOut);
+        subscriberIdentities.push_back(object->ice_getIdentity());
+        topic->subscribeAndGetPublisher(qos, object);
+    }
+
+    //
+    // Test invalid filter QoS.
+    //
+    {
+        Ice::ObjectPrx object = adapter->addWithUUID(new SingleI(communicator, "invalid filter"));
+        try
+        {
+            IceStorm::QoS qos;
+            qos["filter.unknown"] = "event";
+            topic->subscribeAndGetPublisher(qos, object);
+            test(false);
+        }
+        catch(const IceStorm::BadQoS&)
+        {
+        }
+        try
+        {
+            IceStorm::QoS qos;
+            qos["filter.op"] = "*ven*";
+            topic->subscribeAndGetPublisher(qos, object);
+            test(false);
+        }
+        catch(const IceStorm::BadQoS&)
+        {
+        }
+    }
+
     adapter->activate();
 
     vector<Ice::Identity> ids = topic->getSubscribers();
@@ -39,8 +39,8 @@ if TestUtil.appverifier:
     targets = [TestUtil.getIceBox(), publisher, subscriber, TestUtil.getIceBoxAdmin(), TestUtil.getIceStormAdmin()]
     TestUtil.setAppVerifierSettings(targets, cwd = os.getcwd())
 
-def dotest(type):
-    icestorm = IceStormUtil.init(TestUtil.toplevel, os.getcwd(), type, additional=iceStormArgs)
+def dotest(type, additional = ""):
+    icestorm = IceStormUtil.init(TestUtil.toplevel, os.getcwd(), type, additional=iceStormArgs + additional)
     icestorm.start()
 
     sys.stdout.write("creating topic... ")
@@ -83,6 +83,12 @@ dotest("persistent")
 dotest("transient")
 dotest("replicated")
 
+#
+# Publish the events with publish dispatch shards.
+#
+dotest("persistent", " --IceStorm.Dispatch.Shards=2")
+dotest("transient", " --IceStorm.Dispatch.Shards=2")
+
 if TestUtil.appverifier:
     TestUtil.appVerifierAfterTestEnd([targets], cwd = os.getcwd())
 
@@ -589,6 +589,7 @@ public final class PropertyNames
         new Property("IceGrid\\.Node\\.CollocateRegistry", false, null),
         new Property("IceGrid\\.Node\\.Data", false, null),
         new Property("IceGrid\\.Node\\.DisableOnFailure", false, null),
+        new Property("IceGrid\\.Node\\.LoadUpdatePeriod", false, null),
         new Property("IceGrid\\.Node\\.Name", false, null),
         new Property("IceGrid\\.Node\\.Output", false, null),
         new Property("IceGrid\\.Node\\.ProcessorSocketCount", false, null),
@@ -710,6 +711,7 @@ public final class PropertyNames
         new Property("IceGrid\\.Registry\\.Client\\.MessageSizeMax", false, null),
         new Property("IceGrid\\.Registry\\.CryptPasswords", false, null),
         new Property("IceGrid\\.Registry\\.DefaultTemplates", false, null),
+        new Property("IceGrid\\.Registry\\.DeploymentParallelism", false, null),
         new Property("IceGrid\\.Registry\\.Discovery\\.ACM\\.Timeout", false, null),
         new Property("IceGrid\\.Registry\\.Discovery\\.ACM\\.Heartbeat", false, null),
         new Property("IceGrid\\.Registry\\.Discovery\\.ACM\\.Close", false, null),
@@ -789,8 +791,14 @@ public final class PropertyNames
         new Property("IceGrid\\.Registry\\.Internal\\.ThreadPool\\.ThreadIdleTime", false, null),
         new Property("IceGrid\\.Registry\\.Internal\\.ThreadPool\\.ThreadPriority", false, null),
         new Property("IceGrid\\.Registry\\.Internal\\.MessageSizeMax", false, null),
+        new Property("IceGrid\\.Registry\\.LMDB\\.GroupCommitDelay", false, null),
+        new Property("IceGrid\\.Registry\\.LMDB\\.GroupCommitSize", false, null),
         new Property("IceGrid\\.Registry\\.LMDB\\.MapSize", false, null),
+        new Property("IceGrid\\.Registry\\.LMDB\\.MapSizeMax", false, null),
         new Property("IceGrid\\.Registry\\.LMDB\\.Path", false, null),
+        new Property("IceGrid\\.Registry\\.LoadInfoTimeout", false, null),
+        new Property("IceGrid\\.Registry\\.LocatorCacheSize", false, null),
+        new Property("IceGrid\\.Registry\\.NodeObserverBatchDelay", false, null),
         new Property("IceGrid\\.Registry\\.NodeSessionTimeout", false, null),
         new Property("IceGrid\\.Registry\\.PermissionsVerifier\\.EndpointSelection", false, null),
         new Property("IceGrid\\.Registry\\.PermissionsVerifier\\.ConnectionCached", false, null),
@@ -892,6 +900,7 @@ public final class PropertyNames
         new Property("IceGrid\\.Registry\\.SSLPermissionsVerifier\\.CollocationOptimized", false, null),
         new Property("IceGrid\\.Registry\\.SSLPermissionsVerifier\\.Context\\.[^\\s]+", false, null),
         new Property("IceGrid\\.Registry\\.SSLPermissionsVerifier", false, null),
+        new Property("IceGrid\\.Registry\\.StandbyReplicas", false, null),
         new Property("IceGrid\\.Registry\\.Trace\\.Application", false, null),
         new Property("IceGrid\\.Registry\\.Trace\\.Adapter", false, null),
         new Property("IceGrid\\.Registry\\.Trace\\.Locator", false, null),
@@ -948,17 +957,22 @@ public final class PropertyNames
         new Property("IcePatch2\\.ThreadPool\\.ThreadPriority", false, null),
         new Property("IcePatch2\\.MessageSizeMax", false, null),
         new Property("IcePatch2\\.Directory", false, null),
+        new Property("IcePatch2\\.FileCacheSize", false, null),
         new Property("IcePatch2\\.InstanceName", false, null),
         null
     };
 
     public static final Property IcePatch2ClientProps[] = 
     {
+        new Property("IcePatch2Client\\.Chunks", false, null),
         new Property("IcePatch2Client\\.ChunkSize", false, null),
         new Property("IcePatch2Client\\.Directory", false, null),
+        new Property("IcePatch2Client\\.MaxInFlight", false, null),
+        new Property("IcePatch2Client\\.Parallelism", false, null),
         new Property("IcePatch2Client\\.Proxy", false, null),
         new Property("IcePatch2Client\\.Remove", false, null),
         new Property("IcePatch2Client\\.Thorough", false, null),
+        new Property("IcePatch2Client\\.Zstd", false, null),
         null
     };
 
@@ -1066,7 +1080,10 @@ public final class PropertyNames
         new Property("Glacier2\\.Client\\.MessageSizeMax", false, null),
         new Property("Glacier2\\.Client\\.AlwaysBatch", false, null),
         new Property("Glacier2\\.Client\\.Buffered", false, null),
+        new Property("Glacier2\\.Client\\.FairQueue\\.Quantum", false, null),
         new Property("Glacier2\\.Client\\.ForwardContext", false, null),
+        new Property("Glacier2\\.Client\\.RateLimit", false, null),
+        new Property("Glacier2\\.Client\\.RateLimit\\.Burst", false, null),
         new Property("Glacier2\\.Client\\.SleepTime", false, null),
         new Property("Glacier2\\.Client\\.Trace\\.Override", false, null),
         new Property("Glacier2\\.Client\\.Trace\\.Reject", false, null),
@@ -1141,7 +1158,10 @@ public final class PropertyNames
         new Property("Glacier2\\.Server\\.MessageSizeMax", false, null),
         new Property("Glacier2\\.Server\\.AlwaysBatch", false, null),
         new Property("Glacier2\\.Server\\.Buffered", false, null),
+        new Property("Glacier2\\.Server\\.FairQueue\\.Quantum", false, null),
         new Property("Glacier2\\.Server\\.ForwardContext", false, null),
+        new Property("Glacier2\\.Server\\.RateLimit", false, null),
+        new Property("Glacier2\\.Server\\.RateLimit\\.Burst", false, null),
         new Property("Glacier2\\.Server\\.SleepTime", false, null),
         new Property("Glacier2\\.Server\\.Trace\\.Override", false, null),
         new Property("Glacier2\\.Server\\.Trace\\.Request", false, null),